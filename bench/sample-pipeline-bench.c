@@ -0,0 +1,333 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+/*
+ * Measures the path of a sample from the link to a signal handler. The fake
+ * libeyelink_core produces samples at --rate, the real Eyelink-thread drains
+ * them and the main context emits them. The result is printed as one JSON
+ * object, so it can be compared from release to release.
+ */
+
+#include <geye.h>
+#include <fake-eyelink.h>
+#include <EyeLink/eye_data.h>
+#include <locale.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    GEyeEyetracker *et;
+    GMainLoop      *loop;
+    GError         *error;
+    guint64         handled;    // samples seen by the signal handlers
+    gint64          start;      // wall clock of the start of tracking in µs
+    gint64          cpu_start;  // process CPU time at the start in ns
+    gint64          elapsed;
+    gint64          cpu;
+} Bench;
+
+static gint     bench_rate = 1000;
+static gboolean bench_binocular = FALSE;
+static gdouble  bench_duration = 3.0;
+static gchar   *bench_latency_mode = NULL;
+static gchar   *bench_delivery = NULL;
+static gchar   *bench_output = NULL;
+
+static GOptionEntry bench_options[] = {
+    {"rate", 'r', 0, G_OPTION_ARG_INT, &bench_rate,
+     "The rate of the fake tracker in Hz", "HZ"},
+    {"binocular", 'b', 0, G_OPTION_ARG_NONE, &bench_binocular,
+     "Track both eyes instead of the left eye", NULL},
+    {"duration", 'd', 0, G_OPTION_ARG_DOUBLE, &bench_duration,
+     "The time to track in seconds", "S"},
+    {"latency-mode", 'l', 0, G_OPTION_ARG_STRING, &bench_latency_mode,
+     "sleep, hybrid or busy-poll", "MODE"},
+    {"delivery", 0, 0, G_OPTION_ARG_STRING, &bench_delivery,
+     "Comma separated sample deliveries, e.g. sample,binocular", "DELIVERY"},
+    {"output", 'o', 0, G_OPTION_ARG_FILENAME, &bench_output,
+     "Write the JSON to FILE instead of stdout", "FILE"},
+    {NULL}
+};
+
+static gint64
+cpu_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * G_GINT64_CONSTANT(1000000000) + ts.tv_nsec;
+}
+
+static gboolean
+parse_enum(GType type, const gchar *nick, gint *value)
+{
+    GEnumClass *klass = g_type_class_ref(type);
+    GEnumValue *found = g_enum_get_value_by_nick(klass, nick);
+
+    if (found)
+        *value = found->value;
+    g_type_class_unref(klass);
+    return found != NULL;
+}
+
+static gboolean
+parse_flags(GType type, const gchar *nicks, guint *value)
+{
+    GFlagsClass *klass = g_type_class_ref(type);
+    gchar **split = g_strsplit(nicks, ",", -1);
+    gboolean valid = TRUE;
+    gchar **nick;
+
+    *value = 0;
+    for (nick = split; *nick && valid; nick++) {
+        GFlagsValue *found = g_flags_get_value_by_nick(klass, g_strstrip(*nick));
+        if (found)
+            *value |= found->value;
+        else
+            valid = FALSE;
+    }
+    g_strfreev(split);
+    g_type_class_unref(klass);
+    return valid;
+}
+
+static void
+on_sample(GEyeEyetracker *et, GEyeSample *sample, gpointer data)
+{
+    Bench *bench = data;
+    (void) et;
+    (void) sample;
+    bench->handled++;
+}
+
+static void
+on_samples(GEyeEyetracker *et, GArray *samples, gpointer data)
+{
+    Bench *bench = data;
+    (void) et;
+    bench->handled += samples->len;
+}
+
+static void
+on_binocular_sample(GEyeEyetracker         *et,
+                    GEyeBinocularSample    *sample,
+                    gpointer                data)
+{
+    Bench *bench = data;
+    (void) et;
+    (void) sample;
+    bench->handled++;
+}
+
+static gboolean
+on_timeout(gpointer data)
+{
+    Bench *bench = data;
+
+    geye_eyetracker_stop_tracking(bench->et);
+    bench->elapsed = g_get_monotonic_time() - bench->start;
+    // Emit the samples still queued for the main context, so the counters,
+    // the latency statistics and the CPU time include them.
+    while (g_main_context_iteration(NULL, FALSE));
+    bench->cpu = cpu_time() - bench->cpu_start;
+    g_main_loop_quit(bench->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+on_connected(GEyeEyetracker *et, gboolean connected, gpointer data)
+{
+    Bench *bench = data;
+
+    if (!connected) {
+        g_set_error(&bench->error, GEYE_EYETRACKER_ERROR,
+                    GEYE_EYETRACKER_ERROR_UNABLE_TO_CONNECT,
+                    "The fake tracker didn't connect");
+        g_main_loop_quit(bench->loop);
+        return;
+    }
+
+    geye_eyetracker_reset_latency_stats(et);
+    bench->start = g_get_monotonic_time();
+    bench->cpu_start = cpu_time();
+    geye_eyetracker_start_tracking(et, &bench->error);
+    if (bench->error) {
+        g_main_loop_quit(bench->loop);
+        return;
+    }
+    g_timeout_add(bench_duration * 1000, on_timeout, bench);
+}
+
+static void
+append_stats(GString *json, GEyeEyetracker *et)
+{
+    GEnumClass *stages = g_type_class_ref(GEYE_TYPE_LATENCY_STAGE);
+    GEyeLatencyStats stats;
+    gint stage;
+
+    g_string_append(json, "  \"latency_us\": {\n");
+    for (stage = 0; stage < GEYE_LATENCY_N_STAGES; stage++) {
+        if (!geye_eyetracker_get_latency_stats(et, stage, &stats))
+            memset(&stats, 0, sizeof(stats));
+        g_string_append_printf(
+                json,
+                "    \"%s\": {\"count\": %" G_GUINT64_FORMAT
+                ", \"p50\": %" G_GINT64_FORMAT
+                ", \"p99\": %" G_GINT64_FORMAT
+                ", \"max\": %" G_GINT64_FORMAT "}%s\n",
+                g_enum_get_value(stages, stage)->value_nick,
+                stats.count, stats.p50, stats.p99, stats.max,
+                stage + 1 < GEYE_LATENCY_N_STAGES ? "," : ""
+                );
+    }
+    g_string_append(json, "  }\n");
+    g_type_class_unref(stages);
+}
+
+static gchar*
+bench_report(Bench *bench)
+{
+    GString *json = g_string_new("{\n");
+    guint drained, dispatched, dropped, max_drain;
+    gdouble seconds = bench->elapsed / (gdouble) G_USEC_PER_SEC;
+    gchar rate[G_ASCII_DTOSTR_BUF_SIZE], cost[G_ASCII_DTOSTR_BUF_SIZE];
+
+    g_object_get(bench->et,
+                 "samples-drained", &drained,
+                 "samples-dispatched", &dispatched,
+                 "samples-dropped", &dropped,
+                 "max-drain-time", &max_drain,
+                 NULL);
+
+    g_string_append(json, "  \"benchmark\": \"sample-pipeline\",\n");
+    g_string_append_printf(json, "  \"version\": \"%s\",\n", GEYE_BENCH_VERSION);
+    g_string_append_printf(json, "  \"rate\": %d,\n", bench_rate);
+    g_string_append_printf(json, "  \"eyes\": \"%s\",\n",
+                           bench_binocular ? "binocular" : "mono");
+    g_string_append_printf(json, "  \"latency_mode\": \"%s\",\n",
+                           bench_latency_mode ? bench_latency_mode : "default");
+    g_string_append_printf(json, "  \"delivery\": \"%s\",\n",
+                           bench_delivery ? bench_delivery : "default");
+    g_string_append_printf(json, "  \"duration_us\": %" G_GINT64_FORMAT ",\n",
+                           bench->elapsed);
+    g_string_append_printf(json, "  \"samples_drained\": %u,\n", drained);
+    g_string_append_printf(json, "  \"samples_dispatched\": %u,\n", dispatched);
+    g_string_append_printf(json, "  \"samples_dropped\": %u,\n", dropped);
+    g_string_append_printf(json, "  \"samples_handled\": %" G_GUINT64_FORMAT
+                           ",\n", bench->handled);
+    // Use the C locale for the doubles, JSON has no decimal comma.
+    g_ascii_formatd(rate, sizeof(rate), "%.1f",
+                    seconds > 0 ? drained / seconds : 0);
+    // The synthetic link runs in this process, so the CPU time per sample
+    // includes producing the samples, not only the pipeline.
+    g_ascii_formatd(cost, sizeof(cost), "%.1f",
+                    drained ? bench->cpu / (gdouble) drained : 0);
+    g_string_append_printf(json, "  \"throughput_hz\": %s,\n", rate);
+    g_string_append_printf(json, "  \"cpu_per_sample_ns\": %s,\n", cost);
+    g_string_append_printf(json, "  \"max_drain_time_us\": %u,\n", max_drain);
+    append_stats(json, bench->et);
+    g_string_append(json, "}\n");
+
+    return g_string_free(json, FALSE);
+}
+
+int main(int argc, char** argv)
+{
+    GOptionContext *context;
+    GError *error = NULL;
+    Bench bench = {0};
+    gint latency_mode;
+    guint delivery;
+    gchar *report;
+
+    setlocale(LC_ALL, "");
+
+    context = g_option_context_new("- benchmark the sample pipeline");
+    g_option_context_add_main_entries(context, bench_options, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("%s\n", error->message);
+        return 1;
+    }
+    g_option_context_free(context);
+    if (bench_rate <= 0 || bench_duration <= 0) {
+        g_printerr("The rate and duration must be positive\n");
+        return 1;
+    }
+
+    fake_eyelink_set_rate(bench_rate);
+    fake_eyelink_set_eye(bench_binocular ? BINOCULAR : LEFT_EYE);
+
+    bench.loop = g_main_loop_new(NULL, FALSE);
+    bench.et = GEYE_EYETRACKER(geye_eyelink_et_new());
+
+    if (bench_latency_mode) {
+        if (!parse_enum(GEYE_TYPE_LATENCY_MODE, bench_latency_mode,
+                        &latency_mode)) {
+            g_printerr("Unknown latency mode \"%s\"\n", bench_latency_mode);
+            return 1;
+        }
+        g_object_set(bench.et, "latency-mode", latency_mode, NULL);
+    }
+    if (bench_delivery) {
+        if (!parse_flags(GEYE_TYPE_SAMPLE_DELIVERY, bench_delivery,
+                         &delivery)) {
+            g_printerr("Unknown sample delivery \"%s\"\n", bench_delivery);
+            return 1;
+        }
+        g_object_set(bench.et, "sample-delivery", delivery, NULL);
+    }
+
+    g_signal_connect(bench.et, "connected", G_CALLBACK(on_connected), &bench);
+    g_signal_connect(bench.et, "sample", G_CALLBACK(on_sample), &bench);
+    g_signal_connect(bench.et, "samples", G_CALLBACK(on_samples), &bench);
+    g_signal_connect(
+            bench.et,
+            "binocular-sample",
+            G_CALLBACK(on_binocular_sample),
+            &bench
+            );
+
+    geye_eyetracker_connect(bench.et, &error);
+    if (!error)
+        g_main_loop_run(bench.loop);
+    else
+        bench.error = error;
+
+    if (bench.error) {
+        g_printerr("%s\n", bench.error->message);
+        return 1;
+    }
+
+    report = bench_report(&bench);
+    if (bench_output) {
+        if (!g_file_set_contents(bench_output, report, -1, &error)) {
+            g_printerr("%s\n", error->message);
+            return 1;
+        }
+    }
+    else
+        fputs(report, stdout);
+
+    g_free(report);
+    g_object_unref(bench.et);
+    g_main_loop_unref(bench.loop);
+    return 0;
+}
@@ -0,0 +1,1052 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "fake-eyelink.h"
+#include <EyeLink/core_expt.h>
+#include <EyeLink/eye_data.h>
+#include <EyeLink/eyelink.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#define FAKE_DEFAULT_RATE 1000
+#define FAKE_DEFAULT_FPS 30
+#define FAKE_IMAGE_WIDTH 192
+#define FAKE_IMAGE_HEIGHT 160
+#define FAKE_SCREEN_WIDTH 1920
+#define FAKE_SCREEN_HEIGHT 1080
+#define FAKE_PUPIL 1000.0
+// The start and end events of one step of the script for both eyes.
+#define FAKE_PENDING_SIZE 4
+#define FAKE_KEYS_SIZE 16
+#define FAKE_MAX_CALPOINTS 13
+// How long a calibration target is shown in ms.
+#define FAKE_TARGET_TIME 500
+// How often the setup polls for keys in µs.
+#define FAKE_SETUP_POLL 1000
+// The link_sample_data of a tracker that was just switched on.
+#define FAKE_LINK_SAMPLE_DATA "LEFT,RIGHT,GAZE,GAZERES,AREA,STATUS,HTARGET"
+
+// About two seconds of looking around on a 1920x1080 display.
+static const FakeEyelinkSegment fake_default_script[] = {
+    {FAKE_EYELINK_FIXATION, 300, 960, 540},
+    {FAKE_EYELINK_SACCADE,   40, 480, 270},
+    {FAKE_EYELINK_FIXATION, 250, 480, 270},
+    {FAKE_EYELINK_SACCADE,   50, 1440, 270},
+    {FAKE_EYELINK_FIXATION, 250, 1440, 270},
+    {FAKE_EYELINK_SACCADE,   45, 1440, 810},
+    {FAKE_EYELINK_FIXATION, 200, 1440, 810},
+    {FAKE_EYELINK_BLINK,    120, 0, 0},
+    {FAKE_EYELINK_FIXATION, 200, 1440, 810},
+    {FAKE_EYELINK_SACCADE,   50, 480, 810},
+    {FAKE_EYELINK_FIXATION, 250, 480, 810},
+    {FAKE_EYELINK_SACCADE,   40, 960, 540}
+};
+
+// The targets of HV13 as a fraction of the display, HV9 and HV5 are the
+// first 9 and 5 of them.
+static const gdouble fake_calpoints[FAKE_MAX_CALPOINTS][2] = {
+    {0.5, 0.5}, {0.5, 0.1}, {0.5, 0.9}, {0.1, 0.5}, {0.9, 0.5},
+    {0.1, 0.1}, {0.9, 0.1}, {0.1, 0.9}, {0.9, 0.9},
+    {0.3, 0.3}, {0.7, 0.3}, {0.3, 0.7}, {0.7, 0.7}
+};
+
+// H3 is a horizontal line.
+static const gdouble fake_calpoints_h3[3][2] = {
+    {0.5, 0.5}, {0.1, 0.5}, {0.9, 0.5}
+};
+
+typedef struct {
+    gint        type;
+    ALLD_DATA   data;
+} FakeItem;
+
+static struct {
+    GMutex              lock;
+
+    // configuration
+    guint               rate;
+    gint                eye;
+    FakeEyelinkSegment *script;
+    guint               n_segments;
+    gint                open_result;
+    guint               fps;
+    gboolean            manual;
+    gint64              manual_usec;
+    gint64              epoch;
+
+    // the link
+    gboolean            connected;
+    gboolean            recording;
+    gboolean            send_samples;
+    gboolean            send_events;
+    gdouble             start_ms;       // tracker time of the first sample
+    guint64             n_samples;      // the index of the next sample
+    guint               segment;
+    gdouble             segment_start;  // tracker time in ms
+    gboolean            segment_started;
+    gdouble             from_x, from_y; // the gaze at the start of segment
+    FakeItem            pending[FAKE_PENDING_SIZE];
+    guint               first_pending, n_pending;
+    FakeItem            current;
+
+    // setup
+    HOOKFCNS2           hooks;
+    gint                image_width, image_height;
+    gint                screen_width, screen_height;
+    guint               n_calpoints;
+    gboolean            horizontal;
+    gint                cal_result;
+    gboolean            cal_abort;
+    gchar               cal_message[64];
+    UINT16              keys[FAKE_KEYS_SIZE];
+    guint               first_key, n_keys;
+
+    guint64             samples_sent;
+    guint64             events_sent;
+    guint64             frames_sent;
+    gchar              *last_command;
+    gchar              *link_sample_data;
+    gchar              *reply;         // to eyelink_read_request()
+} fake;
+
+static void
+fake_init_defaults(void)
+{
+    fake.rate = FAKE_DEFAULT_RATE;
+    fake.eye = BINOCULAR;
+    fake.fps = FAKE_DEFAULT_FPS;
+    fake.open_result = OK_RESULT;
+    fake.image_width = FAKE_IMAGE_WIDTH;
+    fake.image_height = FAKE_IMAGE_HEIGHT;
+    fake.screen_width = FAKE_SCREEN_WIDTH;
+    fake.screen_height = FAKE_SCREEN_HEIGHT;
+    fake.n_calpoints = 9;
+    fake.cal_result = NO_REPLY;
+    if (!fake.link_sample_data)
+        fake.link_sample_data = g_strdup(FAKE_LINK_SAMPLE_DATA);
+}
+
+/*
+ * Takes the lock, the first time the defaults are set. This way the fake
+ * works without calling fake_eyelink_reset() first.
+ */
+static void
+fake_lock(void)
+{
+    static gsize initialized = 0;
+
+    if (g_once_init_enter(&initialized)) {
+        fake_init_defaults();
+        g_once_init_leave(&initialized, 1);
+    }
+    g_mutex_lock(&fake.lock);
+}
+
+static void
+fake_unlock(void)
+{
+    g_mutex_unlock(&fake.lock);
+}
+
+static const FakeEyelinkSegment*
+fake_segment(guint index)
+{
+    if (fake.script)
+        return &fake.script[index % fake.n_segments];
+    return &fake_default_script[index % G_N_ELEMENTS(fake_default_script)];
+}
+
+static gdouble
+fake_now_usec(void)
+{
+    if (fake.manual)
+        return fake.manual_usec;
+    if (!fake.epoch)
+        fake.epoch = g_get_monotonic_time();
+    return g_get_monotonic_time() - fake.epoch;
+}
+
+/* ************** the script ************** */
+
+static void
+fake_queue_event(gint type, gint eye, gdouble sttime, gdouble entime)
+{
+    const FakeEyelinkSegment *segment = fake_segment(fake.segment);
+    FakeItem *item;
+    DEVENT *event;
+    gdouble amplitude, duration;
+
+    g_assert(fake.n_pending < FAKE_PENDING_SIZE);
+    item = &fake.pending[
+        (fake.first_pending + fake.n_pending++) % FAKE_PENDING_SIZE
+    ];
+    memset(item, 0, sizeof(*item));
+    item->type = type;
+    event = &item->data.fe;
+    event->type = type;
+    event->eye = eye;
+    event->sttime = sttime;
+    event->entime = entime;
+    event->time = entime ? entime : sttime;
+    event->supd_x = event->eupd_x = FAKE_EYELINK_RESOLUTION;
+    event->supd_y = event->eupd_y = FAKE_EYELINK_RESOLUTION;
+
+    switch (type) {
+        case STARTFIX:
+        case ENDFIX:
+            event->gstx = event->genx = event->gavx = segment->x;
+            event->gsty = event->geny = event->gavy = segment->y;
+            event->sta = event->ena = event->ava = FAKE_PUPIL;
+            break;
+        case STARTSACC:
+        case ENDSACC:
+            event->gstx = fake.from_x;
+            event->gsty = fake.from_y;
+            if (type == STARTSACC)
+                break;
+            event->genx = segment->x;
+            event->geny = segment->y;
+            // The velocity of a raised cosine peaks at pi / 2 its average.
+            amplitude = hypot(segment->x - fake.from_x,
+                              segment->y - fake.from_y) /
+                        FAKE_EYELINK_RESOLUTION;
+            duration = (entime - sttime) / 1000.0;
+            event->avel = amplitude / duration;
+            event->pvel = event->avel * G_PI / 2;
+            break;
+        default:
+            event->gstx = event->genx = event->gavx = MISSING_DATA;
+            event->gsty = event->geny = event->gavy = MISSING_DATA;
+    }
+}
+
+static void
+fake_queue_events(gint start_type, gint end_type, gboolean start)
+{
+    const FakeEyelinkSegment *segment = fake_segment(fake.segment);
+    gdouble sttime = fake.segment_start;
+    gdouble entime = start ? 0 : sttime + segment->duration;
+    gint eye;
+
+    if (!fake.send_events)
+        return;
+
+    for (eye = LEFT_EYE; eye <= RIGHT_EYE; eye++)
+        if (fake.eye == BINOCULAR || fake.eye == eye)
+            fake_queue_event(start ? start_type : end_type, eye, sttime, entime);
+}
+
+static void
+fake_queue_segment_events(gboolean start)
+{
+    switch (fake_segment(fake.segment)->type) {
+        case FAKE_EYELINK_FIXATION:
+            fake_queue_events(STARTFIX, ENDFIX, start);
+            break;
+        case FAKE_EYELINK_SACCADE:
+            fake_queue_events(STARTSACC, ENDSACC, start);
+            break;
+        case FAKE_EYELINK_BLINK:
+            fake_queue_events(STARTBLINK, ENDBLINK, start);
+            break;
+    }
+}
+
+/*
+ * Moves the script one step towards time, it queues the events of that
+ * step. Returns FALSE when the script is already at time.
+ */
+static gboolean
+fake_script_step(gdouble time)
+{
+    const FakeEyelinkSegment *segment = fake_segment(fake.segment);
+
+    if (!fake.segment_started) {
+        fake.segment_started = TRUE;
+        fake_queue_segment_events(TRUE);
+        return TRUE;
+    }
+    if (time < fake.segment_start + segment->duration)
+        return FALSE;
+
+    fake_queue_segment_events(FALSE);
+    if (segment->type != FAKE_EYELINK_BLINK) {
+        fake.from_x = segment->x;
+        fake.from_y = segment->y;
+    }
+    fake.segment_start += segment->duration;
+    fake.segment++;
+    fake.segment_started = FALSE;
+    return TRUE;
+}
+
+static void
+fake_make_sample(gdouble time, DSAMPLE *sample)
+{
+    const FakeEyelinkSegment *segment = fake_segment(fake.segment);
+    gdouble x = segment->x, y = segment->y, u;
+    gboolean blink = segment->type == FAKE_EYELINK_BLINK;
+    gint eye;
+
+    if (segment->type == FAKE_EYELINK_SACCADE) {
+        u = (time - fake.segment_start) / segment->duration;
+        u = 0.5 - 0.5 * cos(G_PI * u);
+        x = fake.from_x + (segment->x - fake.from_x) * u;
+        y = fake.from_y + (segment->y - fake.from_y) * u;
+    }
+
+    memset(sample, 0, sizeof(*sample));
+    sample->time = time;
+    sample->type = SAMPLE_TYPE;
+    sample->flags = SAMPLE_TIMESTAMP | SAMPLE_GAZEXY | SAMPLE_GAZERES |
+                    SAMPLE_PUPILXY | SAMPLE_HREFXY | SAMPLE_PUPILSIZE |
+                    SAMPLE_STATUS;
+    sample->rx = sample->ry = FAKE_EYELINK_RESOLUTION;
+
+    for (eye = LEFT_EYE; eye <= RIGHT_EYE; eye++) {
+        if (fake.eye != BINOCULAR && fake.eye != eye) {
+            sample->gx[eye] = sample->gy[eye] = MISSING_DATA;
+            sample->px[eye] = sample->py[eye] = MISSING_DATA;
+            sample->hx[eye] = sample->hy[eye] = MISSING_DATA;
+            continue;
+        }
+        sample->flags |= eye == LEFT_EYE ? SAMPLE_LEFT : SAMPLE_RIGHT;
+        if (blink) {
+            sample->gx[eye] = sample->gy[eye] = MISSING_DATA;
+            sample->px[eye] = sample->py[eye] = MISSING_DATA;
+            sample->hx[eye] = sample->hy[eye] = MISSING_DATA;
+            continue;
+        }
+        sample->gx[eye] = x;
+        sample->gy[eye] = y;
+        sample->px[eye] = x / 10;
+        sample->py[eye] = y / 10;
+        sample->hx[eye] = (x - fake.screen_width / 2.0) * 10;
+        sample->hy[eye] = (y - fake.screen_height / 2.0) * 10;
+        sample->pa[eye] = FAKE_PUPIL;
+    }
+}
+
+/* ************** the control of the fake ************** */
+
+void
+fake_eyelink_reset(void)
+{
+    fake_lock();
+
+    g_clear_pointer(&fake.script, g_free);
+    fake.n_segments = 0;
+    g_clear_pointer(&fake.last_command, g_free);
+    g_clear_pointer(&fake.link_sample_data, g_free);
+    g_clear_pointer(&fake.reply, g_free);
+    fake.manual = FALSE;
+    fake.manual_usec = 0;
+    fake.epoch = 0;
+    fake.connected = fake.recording = FALSE;
+    fake.n_pending = fake.n_keys = 0;
+    fake.samples_sent = fake.events_sent = fake.frames_sent = 0;
+    fake.horizontal = FALSE;
+    fake.cal_abort = FALSE;
+    fake.cal_message[0] = '\0';
+    fake_init_defaults();
+
+    fake_unlock();
+}
+
+void
+fake_eyelink_set_rate(guint rate)
+{
+    g_return_if_fail(rate > 0);
+
+    fake_lock();
+    fake.rate = rate;
+    fake_unlock();
+}
+
+void
+fake_eyelink_set_eye(gint eye)
+{
+    g_return_if_fail(eye == LEFT_EYE || eye == RIGHT_EYE || eye == BINOCULAR);
+
+    fake_lock();
+    fake.eye = eye;
+    fake_unlock();
+}
+
+/*
+ * The script is played in a loop from the start of recording on. Without a
+ * script, or with n == 0, a default script is played.
+ */
+void
+fake_eyelink_set_script(const FakeEyelinkSegment *segments, guint n)
+{
+    guint i;
+
+    g_return_if_fail(n == 0 || segments);
+    for (i = 0; i < n; i++)
+        g_return_if_fail(segments[i].duration > 0);
+
+    fake_lock();
+    g_clear_pointer(&fake.script, g_free);
+    fake.n_segments = n;
+    if (n)
+        fake.script = g_memdup2(segments, n * sizeof(FakeEyelinkSegment));
+    fake_unlock();
+}
+
+/* The result of eyelink_open(), e.g. CONNECT_TIMEOUT_FAILED. */
+void
+fake_eyelink_set_open_result(gint result)
+{
+    fake_lock();
+    fake.open_result = result;
+    fake_unlock();
+}
+
+/* The rate of the camera frames during setup, 0 sends none. */
+void
+fake_eyelink_set_frame_rate(guint fps)
+{
+    fake_lock();
+    fake.fps = fps;
+    fake_unlock();
+}
+
+void
+fake_eyelink_set_manual_clock(gboolean manual)
+{
+    fake_lock();
+    if (manual && !fake.manual)
+        fake.manual_usec = fake_now_usec();
+    else if (!manual && fake.manual)
+        fake.epoch = g_get_monotonic_time() - fake.manual_usec;
+    fake.manual = manual;
+    fake_unlock();
+}
+
+void
+fake_eyelink_advance_clock(gint64 usec)
+{
+    g_return_if_fail(usec >= 0);
+
+    fake_lock();
+    g_warn_if_fail(fake.manual);
+    fake.manual_usec += usec;
+    fake_unlock();
+}
+
+gboolean
+fake_eyelink_is_recording(void)
+{
+    gboolean recording;
+
+    fake_lock();
+    recording = fake.recording;
+    fake_unlock();
+    return recording;
+}
+
+guint64
+fake_eyelink_get_samples_sent(void)
+{
+    guint64 n;
+
+    fake_lock();
+    n = fake.samples_sent;
+    fake_unlock();
+    return n;
+}
+
+guint64
+fake_eyelink_get_events_sent(void)
+{
+    guint64 n;
+
+    fake_lock();
+    n = fake.events_sent;
+    fake_unlock();
+    return n;
+}
+
+guint64
+fake_eyelink_get_frames_sent(void)
+{
+    guint64 n;
+
+    fake_lock();
+    n = fake.frames_sent;
+    fake_unlock();
+    return n;
+}
+
+/* The last command that was sent with eyecmd_printf(), free it. */
+gchar*
+fake_eyelink_dup_last_command(void)
+{
+    gchar *command;
+
+    fake_lock();
+    command = g_strdup(fake.last_command);
+    fake_unlock();
+    return command;
+}
+
+/* The current link_sample_data of the tracker, free it. */
+gchar*
+fake_eyelink_dup_link_sample_data(void)
+{
+    gchar *setting;
+
+    fake_lock();
+    setting = g_strdup(fake.link_sample_data);
+    fake_unlock();
+    return setting;
+}
+
+/* ************** the link ************** */
+
+INT16
+open_eyelink_connection(INT16 mode)
+{
+    INT16 result = OK_RESULT;
+
+    fake_lock();
+    // -1 only initializes the library, 1 opens a dummy connection.
+    if (mode == 0) {
+        result = fake.open_result;
+        fake.connected = result == OK_RESULT;
+    }
+    else if (mode == 1)
+        fake.connected = TRUE;
+    fake_unlock();
+
+    return result;
+}
+
+void
+close_eyelink_connection(void)
+{
+    fake_lock();
+    fake.connected = FALSE;
+    fake.recording = FALSE;
+    fake_unlock();
+}
+
+INT16
+set_eyelink_address(char *addr)
+{
+    return g_hostname_is_ip_address(addr) ? OK_RESULT : -1;
+}
+
+INT16
+eyelink_open(void)
+{
+    return open_eyelink_connection(0);
+}
+
+INT16
+eyelink_get_tracker_version(char *c)
+{
+    INT16 version = 0;
+
+    fake_lock();
+    c[0] = '\0';
+    if (fake.connected) {
+        strcpy(c, "FAKE 1.0");
+        version = 3;
+    }
+    fake_unlock();
+
+    return version;
+}
+
+double
+eyelink_tracker_double_usec(void)
+{
+    double usec;
+
+    fake_lock();
+    usec = fake_now_usec();
+    fake_unlock();
+
+    return usec;
+}
+
+INT16
+start_recording(INT16 file_samples,
+                INT16 file_events,
+                INT16 link_samples,
+                INT16 link_events)
+{
+    (void) file_samples;
+    (void) file_events;
+
+    fake_lock();
+    if (!fake.connected) {
+        fake_unlock();
+        return LINK_TERMINATED_RESULT;
+    }
+
+    fake.send_samples = link_samples != 0;
+    fake.send_events = link_events != 0;
+    fake.recording = fake.send_samples || fake.send_events;
+    if (fake.recording) {
+        fake.start_ms = fake_now_usec() / 1000.0;
+        fake.n_samples = 0;
+        fake.segment = 0;
+        fake.segment_start = fake.start_ms;
+        fake.segment_started = FALSE;
+        fake.from_x = fake_segment(0)->x;
+        fake.from_y = fake_segment(0)->y;
+        fake.n_pending = 0;
+    }
+    fake_unlock();
+
+    return OK_RESULT;
+}
+
+void
+set_offline_mode(void)
+{
+    fake_lock();
+    fake.recording = FALSE;
+    fake_unlock();
+}
+
+INT16
+eyelink_wait_for_block_start(UINT32 maxwait, INT16 samples, INT16 events)
+{
+    INT16 started;
+    (void) maxwait;
+
+    fake_lock();
+    started = fake.recording && (
+            (samples && fake.send_samples) || (events && fake.send_events)
+            );
+    fake_unlock();
+
+    return started;
+}
+
+INT16
+eyelink_eye_available(void)
+{
+    INT16 eye;
+
+    fake_lock();
+    eye = fake.eye;
+    fake_unlock();
+
+    return eye;
+}
+
+/*
+ * Hands out what is due at the tracker clock: the events of the script in
+ * front of the sample at the same time.
+ */
+INT16
+eyelink_get_next_data(void *buf)
+{
+    gint type = 0;
+    gdouble now, time;
+    (void) buf;
+
+    fake_lock();
+    now = fake_now_usec() / 1000.0;
+    while (fake.recording) {
+        if (fake.n_pending) {
+            fake.current = fake.pending[fake.first_pending];
+            fake.first_pending = (fake.first_pending + 1) % FAKE_PENDING_SIZE;
+            fake.n_pending--;
+            fake.events_sent++;
+            type = fake.current.type;
+            break;
+        }
+
+        time = fake.start_ms + fake.n_samples * 1000.0 / fake.rate;
+        if (time > now)
+            break;
+        if (fake_script_step(time))
+            continue;
+
+        fake.n_samples++;
+        if (fake.send_samples) {
+            fake.current.type = SAMPLE_TYPE;
+            fake_make_sample(time, &fake.current.data.fs);
+            fake.samples_sent++;
+            type = SAMPLE_TYPE;
+            break;
+        }
+    }
+    fake_unlock();
+
+    return type;
+}
+
+INT16
+eyelink_get_double_data(void *buf)
+{
+    INT16 type;
+
+    fake_lock();
+    memcpy(buf, &fake.current.data, sizeof(ALLD_DATA));
+    type = fake.current.type;
+    fake_unlock();
+
+    return type;
+}
+
+/*
+ * Takes note of the commands that change the fake, the others are only
+ * remembered.
+ */
+int
+eyecmd_printf(const char *fmt, ...)
+{
+    va_list args;
+    gchar *command;
+    gint left, top, right, bottom;
+    guint n;
+    int result = OK_RESULT;
+
+    va_start(args, fmt);
+    command = g_strdup_vprintf(fmt, args);
+    va_end(args);
+
+    fake_lock();
+    if (!fake.connected)
+        result = LINK_TERMINATED_RESULT;
+    else if (sscanf(command, "screen_pixel_coords = %d %d %d %d",
+                    &left, &top, &right, &bottom) == 4) {
+        fake.screen_width = right - left;
+        fake.screen_height = bottom - top;
+    }
+    else if (sscanf(command, "calibration_type = HV%u", &n) == 1) {
+        fake.n_calpoints = CLAMP(n, 1, FAKE_MAX_CALPOINTS);
+        fake.horizontal = FALSE;
+    }
+    else if (sscanf(command, "calibration_type = H%u", &n) == 1) {
+        fake.n_calpoints = CLAMP(n, 1, G_N_ELEMENTS(fake_calpoints_h3));
+        fake.horizontal = TRUE;
+    }
+    else if (g_str_has_prefix(command, "link_sample_data = ")) {
+        g_free(fake.link_sample_data);
+        fake.link_sample_data = g_strdup(
+                command + strlen("link_sample_data = ")
+                );
+    }
+    g_free(fake.last_command);
+    fake.last_command = command;
+    fake_unlock();
+
+    return result;
+}
+
+int
+eyemsg_printf(const char *fmt, ...)
+{
+    gboolean connected;
+    (void) fmt;
+
+    fake_lock();
+    connected = fake.connected;
+    fake_unlock();
+
+    return connected ? OK_RESULT : LINK_TERMINATED_RESULT;
+}
+
+/* ************** setup and calibration ************** */
+
+INT16
+setup_graphic_hook_functions_V2(HOOKFCNS2 *hooks)
+{
+    fake_lock();
+    fake.hooks = *hooks;
+    fake_unlock();
+
+    return OK_RESULT;
+}
+
+INT16
+eyelink_request_image(INT16 type, INT16 xsize, INT16 ysize)
+{
+    (void) type;
+
+    if (xsize <= 0 || ysize <= 0)
+        return -1;
+
+    fake_lock();
+    fake.image_width = xsize;
+    fake.image_height = ysize;
+    fake_unlock();
+
+    return OK_RESULT;
+}
+
+/* Only link_sample_data can be read, others don't get a reply. */
+INT16
+eyelink_read_request(char *text)
+{
+    INT16 result = OK_RESULT;
+
+    fake_lock();
+    g_clear_pointer(&fake.reply, g_free);
+    if (!fake.connected)
+        result = LINK_TERMINATED_RESULT;
+    else if (g_strcmp0(text, "link_sample_data") == 0)
+        fake.reply = g_strdup(fake.link_sample_data);
+    fake_unlock();
+
+    return result;
+}
+
+INT16
+eyelink_read_reply(char *buf)
+{
+    INT16 result = NO_REPLY;
+
+    fake_lock();
+    if (fake.reply) {
+        strcpy(buf, fake.reply);
+        g_clear_pointer(&fake.reply, g_free);
+        result = OK_RESULT;
+    }
+    fake_unlock();
+
+    return result;
+}
+
+void
+eyelink_set_tracker_setup_default(INT16 mode)
+{
+    (void) mode;
+}
+
+UINT16
+eyelink_send_keybutton(UINT16 code, UINT16 mods, INT16 state)
+{
+    (void) mods;
+
+    if (state != KB_PRESS)
+        return OK_RESULT;
+
+    fake_lock();
+    if (fake.n_keys < FAKE_KEYS_SIZE) {
+        fake.keys[(fake.first_key + fake.n_keys++) % FAKE_KEYS_SIZE] = code;
+    }
+    fake_unlock();
+
+    return OK_RESULT;
+}
+
+INT16
+eyelink_cal_result(void)
+{
+    INT16 result;
+
+    fake_lock();
+    result = fake.cal_result;
+    fake_unlock();
+
+    return result;
+}
+
+INT16
+eyelink_cal_message(char *msg)
+{
+    fake_lock();
+    strcpy(msg, fake.cal_message);
+    fake_unlock();
+
+    return OK_RESULT;
+}
+
+void
+exit_calibration(void)
+{
+    fake_lock();
+    fake.cal_abort = TRUE;
+    fake.cal_result = NO_REPLY;
+    fake_unlock();
+}
+
+/*
+ * Polls the hook for input, which may press keys with
+ * eyelink_send_keybutton(). Returns the oldest key pressed or 0.
+ */
+static UINT16
+fake_poll_key(const HOOKFCNS2 *hooks)
+{
+    InputEvent event;
+    UINT16 key = 0;
+
+    if (hooks->get_input_key_hook) {
+        memset(&event, 0, sizeof(event));
+        hooks->get_input_key_hook(hooks->userData, &event);
+    }
+
+    fake_lock();
+    if (fake.n_keys) {
+        key = fake.keys[fake.first_key];
+        fake.first_key = (fake.first_key + 1) % FAKE_KEYS_SIZE;
+        fake.n_keys--;
+    }
+    fake_unlock();
+
+    return key;
+}
+
+/* A dark pupil that moves in a circle over a gray eye. */
+static void
+fake_draw_frame(byte *pixels, gint width, gint height, guint64 frame)
+{
+    gdouble angle = 2 * G_PI * (frame % 60) / 60.0;
+    gdouble cx = width / 2.0 + width / 8.0 * cos(angle);
+    gdouble cy = height / 2.0 + height / 8.0 * sin(angle);
+    gdouble radius = height / 6.0;
+    gint x, y;
+
+    for (y = 0; y < height; y++) {
+        for (x = 0; x < width; x++) {
+            byte *pixel = pixels + (y * width + x) * 4;
+            gboolean pupil = hypot(x - cx, y - cy) < radius;
+            pixel[0] = pixel[1] = pixel[2] = pupil ? 16 : 160;
+            pixel[3] = 255;
+        }
+    }
+}
+
+/* Shows the targets one after the other, escape aborts. */
+static void
+fake_calibrate(const HOOKFCNS2 *hooks)
+{
+    gboolean aborted = FALSE;
+    guint n, i;
+    gint width, height;
+    const gdouble (*points)[2];
+
+    fake_lock();
+    n = fake.n_calpoints;
+    width = fake.screen_width;
+    height = fake.screen_height;
+    points = fake.horizontal ? fake_calpoints_h3 : fake_calpoints;
+    fake.cal_abort = FALSE;
+    fake.cal_result = NO_REPLY;
+    fake_unlock();
+
+    if (hooks->setup_cal_display_hook)
+        hooks->setup_cal_display_hook(hooks->userData);
+
+    for (i = 0; i < n && !aborted; i++) {
+        gint64 until = g_get_monotonic_time() + FAKE_TARGET_TIME * 1000;
+
+        if (hooks->draw_cal_target_hook)
+            hooks->draw_cal_target_hook(
+                    hooks->userData,
+                    points[i][0] * width,
+                    points[i][1] * height
+                    );
+        while (g_get_monotonic_time() < until) {
+            if (fake_poll_key(hooks) == ESC_KEY)
+                aborted = TRUE;
+            fake_lock();
+            aborted = aborted || fake.cal_abort;
+            fake_unlock();
+            if (aborted)
+                break;
+            g_usleep(FAKE_SETUP_POLL);
+        }
+        if (hooks->erase_cal_target_hook)
+            hooks->erase_cal_target_hook(hooks->userData);
+    }
+
+    if (hooks->clear_cal_display_hook)
+        hooks->clear_cal_display_hook(hooks->userData);
+    if (hooks->exit_cal_display_hook)
+        hooks->exit_cal_display_hook(hooks->userData);
+
+    fake_lock();
+    if (!aborted) {
+        fake.cal_result = OK_RESULT;
+        g_snprintf(fake.cal_message, sizeof(fake.cal_message),
+                   "calibration %s%u done", fake.horizontal ? "H" : "HV", n);
+    }
+    else
+        g_snprintf(fake.cal_message, sizeof(fake.cal_message),
+                   "calibration aborted");
+    fake_unlock();
+}
+
+/*
+ * Streams camera frames until escape is pressed, "c" and "v" start a
+ * calibration or validation.
+ */
+INT16
+do_tracker_setup(void)
+{
+    HOOKFCNS2 hooks;
+    gint width, height;
+    guint fps;
+    byte *pixels;
+    gint64 next_frame = g_get_monotonic_time();
+    guint64 frame = 0;
+    UINT16 key;
+
+    fake_lock();
+    if (!fake.connected) {
+        fake_unlock();
+        return LINK_TERMINATED_RESULT;
+    }
+    hooks = fake.hooks;
+    width = fake.image_width;
+    height = fake.image_height;
+    fps = fake.fps;
+    fake_unlock();
+
+    pixels = g_malloc(width * height * 4);
+    if (hooks.setup_image_display_hook)
+        hooks.setup_image_display_hook(hooks.userData, width, height);
+
+    while ((key = fake_poll_key(&hooks)) != ESC_KEY) {
+        gint64 now;
+
+        if (key == 'c' || key == 'v')
+            fake_calibrate(&hooks);
+
+        now = g_get_monotonic_time();
+        if (fps && hooks.draw_image && now >= next_frame) {
+            fake_draw_frame(pixels, width, height, frame++);
+            hooks.draw_image(hooks.userData, width, height, pixels);
+            fake_lock();
+            fake.frames_sent++;
+            fake_unlock();
+            next_frame = MAX(next_frame + G_USEC_PER_SEC / fps, now);
+        }
+        g_usleep(FAKE_SETUP_POLL);
+    }
+
+    if (hooks.exit_image_display_hook)
+        hooks.exit_image_display_hook(hooks.userData);
+    g_free(pixels);
+
+    return OK_RESULT;
+}
@@ -0,0 +1,88 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef FAKE_EYELINK_H
+#define FAKE_EYELINK_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * An in-process stand-in for libeyelink_core. Configure the build with
+ * -Dfake_eyelink=true and libgeye links this library instead of the one of
+ * the vendor, so the Eyelink-thread runs on any box without a tracker.
+ *
+ * The fake tracker connects right away. While recording it plays a script
+ * of fixations, saccades and blinks, it produces samples at a fixed rate
+ * and the matching start and end events on the link, ordered by their
+ * tracker time. During setup it streams camera frames to the image hooks
+ * and it presents calibration targets when "c" or "v" is pressed.
+ *
+ * The tracker clock either follows the monotonic clock of the host or it
+ * is manual. A manual clock only moves by fake_eyelink_advance_clock(),
+ * what is on the link is then fully determined by the script.
+ *
+ * The functions below may be called from any thread, the calls of
+ * libeyelink_core are made by the Eyelink-thread.
+ */
+
+typedef enum {
+    FAKE_EYELINK_FIXATION,
+    FAKE_EYELINK_SACCADE,
+    FAKE_EYELINK_BLINK
+} FakeEyelinkSegmentType;
+
+/*
+ * One step of the script. A fixation holds the gaze at x, y. A saccade
+ * moves it from where it was to x, y with a bell shaped velocity. During a
+ * blink the gaze is missing, x and y are ignored.
+ */
+typedef struct {
+    FakeEyelinkSegmentType  type;
+    gdouble                 duration;   // ms
+    gdouble                 x;
+    gdouble                 y;
+} FakeEyelinkSegment;
+
+// The angular resolution of the samples in pixels per degree.
+#define FAKE_EYELINK_RESOLUTION 35.0
+
+void    fake_eyelink_reset(void);
+
+void    fake_eyelink_set_rate(guint rate);
+void    fake_eyelink_set_eye(gint eye);
+void    fake_eyelink_set_script(const FakeEyelinkSegment *segments, guint n);
+void    fake_eyelink_set_open_result(gint result);
+void    fake_eyelink_set_frame_rate(guint fps);
+
+void    fake_eyelink_set_manual_clock(gboolean manual);
+void    fake_eyelink_advance_clock(gint64 usec);
+
+gboolean fake_eyelink_is_recording(void);
+guint64 fake_eyelink_get_samples_sent(void);
+guint64 fake_eyelink_get_events_sent(void);
+guint64 fake_eyelink_get_frames_sent(void);
+gchar*  fake_eyelink_dup_last_command(void);
+gchar*  fake_eyelink_dup_link_sample_data(void);
+
+G_END_DECLS
+
+#endif
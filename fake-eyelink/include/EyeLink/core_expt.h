@@ -0,0 +1,78 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+/*
+ * The experiment and graphics calls of libeyelink_core that libgeye uses,
+ * as implemented by the fake, see fake-eyelink.h.
+ */
+
+#ifndef FAKE_EYELINK_CORE_EXPT_H
+#define FAKE_EYELINK_CORE_EXPT_H
+
+#include "eyelink.h"
+
+typedef struct {
+    byte    type;
+    byte    state;
+    UINT16  key;
+    UINT16  modifier;
+    UINT16  unicode;
+} KeyInput;
+
+typedef union {
+    byte        type;
+    KeyInput    key;
+} InputEvent;
+
+typedef struct {
+    INT32   major;
+    INT32   minor;
+    void   *userData;
+    INT16 (*setup_cal_display_hook)(void *data);
+    INT16 (*exit_cal_display_hook)(void *data);
+    INT16 (*setup_image_display_hook)(void *data, INT16 width, INT16 height);
+    INT16 (*image_title_hook)(void *data, char *title);
+    INT16 (*draw_image)(void *data, INT16 width, INT16 height, byte *pixels);
+    INT16 (*exit_image_display_hook)(void *data);
+    INT16 (*erase_cal_target_hook)(void *data);
+    INT16 (*draw_cal_target_hook)(void *data, float x, float y);
+    INT16 (*play_target_beep_hook)(void *data, int type, char *message);
+    INT16 (*get_input_key_hook)(void *data, InputEvent *event);
+    INT16 (*alert_printf_hook)(void *data, const char *message);
+    INT16 (*clear_cal_display_hook)(void *data);
+    void   *reserved[32];
+} HOOKFCNS2;
+
+INT16   open_eyelink_connection(INT16 mode);
+void    close_eyelink_connection(void);
+INT16   set_eyelink_address(char *addr);
+INT16   start_recording(INT16 file_samples,
+                        INT16 file_events,
+                        INT16 link_samples,
+                        INT16 link_events);
+void    set_offline_mode(void);
+void    eyelink_set_tracker_setup_default(INT16 mode);
+INT16   do_tracker_setup(void);
+void    exit_calibration(void);
+int     eyecmd_printf(const char *fmt, ...);
+int     eyemsg_printf(const char *fmt, ...);
+INT16   setup_graphic_hook_functions_V2(HOOKFCNS2 *hooks);
+
+#endif
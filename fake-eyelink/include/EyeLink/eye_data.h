@@ -0,0 +1,131 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+/*
+ * The data types of the link, as far as libgeye uses them. This header
+ * replaces the one of the EyeLink SDK when the library is built with
+ * -Dfake_eyelink=true, see fake-eyelink.h.
+ */
+
+#ifndef FAKE_EYELINK_EYE_DATA_H
+#define FAKE_EYELINK_EYE_DATA_H
+
+typedef unsigned char   byte;
+typedef short           INT16;
+typedef unsigned short  UINT16;
+typedef int             INT32;
+typedef unsigned int    UINT32;
+
+#define MISSING_DATA -32768
+#define MISSING MISSING_DATA
+
+// Indices into the per eye arrays, and the eye of an event.
+#define LEFT_EYE 0
+#define RIGHT_EYE 1
+#define LEFT LEFT_EYE
+#define RIGHT RIGHT_EYE
+#define BINOCULAR 2
+
+// DSAMPLE.flags
+#define SAMPLE_LEFT 0x8000
+#define SAMPLE_RIGHT 0x4000
+#define SAMPLE_TIMESTAMP 0x2000
+#define SAMPLE_PUPILXY 0x1000
+#define SAMPLE_HREFXY 0x0800
+#define SAMPLE_GAZEXY 0x0400
+#define SAMPLE_GAZERES 0x0200
+#define SAMPLE_PUPILSIZE 0x0100
+#define SAMPLE_STATUS 0x0080
+
+// The types returned by eyelink_get_next_data().
+#define STARTBLINK 3
+#define ENDBLINK 4
+#define STARTSACC 5
+#define ENDSACC 6
+#define STARTFIX 7
+#define ENDFIX 8
+#define FIXUPDATE 9
+#define MESSAGEEVENT 24
+#define BUTTONEVENT 25
+#define INPUTEVENT 28
+#define LOST_DATA_EVENT 0x3F
+#define SAMPLE_TYPE 200
+
+typedef struct {
+    double  time;           // tracker time in ms
+    INT16   type;
+    UINT16  flags;
+    double  px[2], py[2];   // pupil position
+    double  hx[2], hy[2];   // head referenced position
+    double  pa[2];          // pupil size
+    double  gx[2], gy[2];   // gaze on the display in pixels
+    double  rx, ry;         // angular resolution in pixels per degree
+    UINT16  status;
+    UINT16  input;
+    UINT16  buttons;
+    INT16   htype;
+    INT16   hdata[8];
+    UINT16  errors;
+} DSAMPLE;
+
+typedef struct {
+    double  time;
+    INT16   type;
+    UINT16  read;
+    INT16   eye;
+    double  sttime, entime;
+    double  hstx, hsty;
+    double  gstx, gsty;
+    double  sta;
+    double  henx, heny;
+    double  genx, geny;
+    double  ena;
+    double  havx, havy;
+    double  gavx, gavy;
+    double  ava;
+    double  avel;
+    double  pvel;
+    double  svel, evel;
+    double  supd_x, eupd_x;
+    double  supd_y, eupd_y;
+    UINT16  status;
+} DEVENT;
+
+typedef struct {
+    UINT32  time;
+    INT16   type;
+    UINT16  length;
+    byte    text[260];
+} IMESSAGE;
+
+typedef struct {
+    UINT32  time;
+    INT16   type;
+    UINT16  data;
+} IOEVENT;
+
+typedef union {
+    DEVENT      fe;
+    IMESSAGE    im;
+    IOEVENT     io;
+    DSAMPLE     fs;
+} ALLD_DATA;
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+/*
+ * The link and tracker calls of libeyelink_core that libgeye uses, as
+ * implemented by the fake, see fake-eyelink.h.
+ */
+
+#ifndef FAKE_EYELINK_EYELINK_H
+#define FAKE_EYELINK_EYELINK_H
+
+#include "eye_data.h"
+
+#define OK_RESULT 0
+#define NO_REPLY 1000
+#define LINK_TERMINATED_RESULT -100
+#define LINK_INITIALIZE_FAILED -200
+#define CONNECT_TIMEOUT_FAILED -201
+#define WRONG_LINK_VERSION -202
+
+#define ENTER_KEY 0x000D
+#define ESC_KEY 0x001B
+#define F1_KEY 0x3B00
+#define KB_PRESS 10
+#define KB_RELEASE -1
+
+#define ELIMAGE_2 0
+#define ELIMAGE_16 1
+#define ELIMAGE_16P 2
+#define ELIMAGE_24 3
+#define ELIMAGE_128HV 4
+#define ELIMAGE_128HVX 5
+
+INT16   eyelink_open(void);
+INT16   eyelink_get_tracker_version(char *c);
+INT16   eyelink_get_next_data(void *buf);
+INT16   eyelink_get_double_data(void *buf);
+INT16   eyelink_eye_available(void);
+INT16   eyelink_wait_for_block_start(UINT32 maxwait, INT16 samples, INT16 events);
+double  eyelink_tracker_double_usec(void);
+UINT16  eyelink_send_keybutton(UINT16 code, UINT16 mods, INT16 state);
+INT16   eyelink_cal_result(void);
+INT16   eyelink_cal_message(char *msg);
+INT16   eyelink_request_image(INT16 type, INT16 xsize, INT16 ysize);
+INT16   eyelink_read_request(char *text);
+INT16   eyelink_read_reply(char *buf);
+
+#endif
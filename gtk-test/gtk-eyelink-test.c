@@ -24,9 +24,7 @@ typedef struct EyetrackerData {
     gboolean        is_calibrating;
     gboolean        is_cam_setup;
     gboolean        is_tracking;
-
-    GEyeSample     *leye_sample;
-    GEyeSample     *reye_sample;
+    guint           tick_id;        // redraws the gaze every frame.
 
     GtkWidget      *cal_button, *val_button, *setup_button, *tracking_toggle;
 
@@ -127,24 +125,14 @@ on_calpoint_stop(GEyeEyetracker* et, gpointer data)
     gtk_widget_queue_draw(testdata->darea);
 }
 
-void
-on_sample(GEyeEyetracker* et, const GEyeSample *sample, gpointer data)
+gboolean
+on_frame_tick(GtkWidget* widget, GdkFrameClock *clock, gpointer data)
 {
-    (void) et;
-    EyetrackerData *testdata = data;
-    testdata->is_tracking = TRUE;
-
-    if (sample->parent.eye == GEYE_LEFT) {
-        if (testdata->leye_sample)
-            geye_sample_free(testdata->leye_sample);
-        testdata->leye_sample = geye_sample_copy(sample);
-    }
-    else if (sample->parent.eye == GEYE_RIGHT) {
-        if (testdata->reye_sample)
-            geye_sample_free(testdata->reye_sample);
-        testdata->reye_sample = geye_sample_copy(sample);
-    }
-    gtk_widget_queue_draw(testdata->darea);
+    (void) clock;
+    (void) data;
+    // on_draw fetches the newest gaze itself.
+    gtk_widget_queue_draw(widget);
+    return G_SOURCE_CONTINUE;
 }
 
 gboolean
@@ -280,9 +268,21 @@ on_tracking_toggled(GtkWidget* tbutton, gpointer data)
             g_error_free(error);
             error = NULL;
         }
+        else if (!testdata->tick_id) {
+            testdata->is_tracking = TRUE;
+            testdata->tick_id = gtk_widget_add_tick_callback(
+                    testdata->darea, on_frame_tick, testdata, NULL
+                    );
+        }
     }
     else {
         geye_eyetracker_stop_tracking(testdata->et);
+        testdata->is_tracking = FALSE;
+        if (testdata->tick_id) {
+            gtk_widget_remove_tick_callback(testdata->darea, testdata->tick_id);
+            testdata->tick_id = 0;
+        }
+        gtk_widget_queue_draw(testdata->darea);
     }
 }
 
@@ -292,6 +292,8 @@ setup_eyelink()
     GEyeEyelinkEt *et;
 
     et = geye_eyelink_et_new();
+    // The gaze is drawn with geye_eyetracker_get_latest_sample().
+    g_object_set(et, "sample-delivery", GEYE_DELIVER_NONE, NULL);
     return GEYE_EYETRACKER(et);
 }
 
@@ -313,10 +315,6 @@ on_et_connected(GEyeEyetracker* et, gboolean connected, gpointer data)
                      "calpoint-stop",
                      G_CALLBACK(on_calpoint_stop),
                      data);
-    g_signal_connect(et,
-                     "sample",
-                     G_CALLBACK(on_sample),
-                     data);
 
     if (connected == TRUE) {
         gchar buffer[1024];
@@ -453,17 +451,16 @@ on_draw(GtkWidget* widget, cairo_t *cr, gpointer data) {
                     yellow);
     }
 
-    if (testdata->is_tracking) {
+    GEyeBinocularSample gaze;
+    if (testdata->is_tracking &&
+        geye_eyetracker_get_latest_sample(testdata->et, &gaze)) {
         gdouble radius = 20;
-        if (testdata->leye_sample) {
-            gdouble x = testdata->leye_sample->x;
-            gdouble y = testdata->leye_sample->y;
+        gdouble x, y;
+        if (geye_binocular_sample_get_eye(&gaze, GEYE_LEFT, &x, &y)) {
             fill_circle(cr, x, y, radius, red);
             stroke_circle(cr, x, y, radius, black);
         }
-        if (testdata->reye_sample) {
-            gdouble x = testdata->reye_sample->x;
-            gdouble y = testdata->reye_sample->y;
+        if (geye_binocular_sample_get_eye(&gaze, GEYE_RIGHT, &x, &y)) {
             fill_circle(cr, x, y, radius, green);
             stroke_circle(cr, x, y, radius, black);
         }
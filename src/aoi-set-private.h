@@ -0,0 +1,69 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GEYE_AOI_SET_PRIVATE_H
+#define GEYE_AOI_SET_PRIVATE_H
+
+#include "aoi-set.h"
+
+G_BEGIN_DECLS
+
+/*
+ * The part of GEyeAoiSet that is used by the thread that receives the
+ * samples. Once a set is sealed its areas don't change anymore, so that
+ * thread may look them up without a lock. Which areas contain the gaze is
+ * tracked by that thread only, so a set is attached to one eyetracker at a
+ * time.
+ */
+
+typedef void (*GEyeAoiFunc)(GEyeAoiSet *set,
+                            guint       aoi,
+                            gboolean    enter,
+                            gdouble     time,
+                            gdouble     dwell,
+                            gpointer    data);
+
+void        geye_aoi_set_seal(GEyeAoiSet *set);
+gboolean    geye_aoi_set_attach(GEyeAoiSet *set, gconstpointer owner);
+void        geye_aoi_set_detach(GEyeAoiSet *set);
+gboolean    geye_aoi_set_is_sealed(GEyeAoiSet *set);
+
+/* thread side */
+void        geye_aoi_set_update(GEyeAoiSet *set,
+                                gdouble     x,
+                                gdouble     y,
+                                gdouble     time,
+                                GEyeAoiFunc func,
+                                gpointer    data);
+void        geye_aoi_set_leave_all(GEyeAoiSet  *set,
+                                   gdouble      time,
+                                   GEyeAoiFunc  func,
+                                   gpointer     data);
+
+/* main context */
+void        geye_aoi_set_emit_enter(GEyeAoiSet *set, guint aoi, gdouble time);
+void        geye_aoi_set_emit_leave(GEyeAoiSet *set,
+                                    guint       aoi,
+                                    gdouble     time,
+                                    gdouble     dwell);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,685 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "aoi-set.h"
+#include "aoi-set-private.h"
+
+// Protects the owner of every set.
+G_LOCK_DEFINE_STATIC(aoi_attach);
+
+// The grid has at most this many cells along one side.
+#define AOI_GRID_MAX 64
+
+typedef struct {
+    GEyeAoiShape    shape;
+    gdouble         x0, y0, x1, y1;     // the bounding box
+    guint           first_point;        // polygons, into points
+    guint           n_points;
+} Aoi;
+
+struct _GEyeAoiSet {
+    GObject         parent;
+
+    GArray         *aois;           // Aoi
+    GArray         *points;         // x, y pairs of the polygons
+    gboolean        sealed;
+
+    /* The uniform grid, built when the set is sealed. */
+    gdouble         grid_x, grid_y;
+    gdouble         cell_width, cell_height;
+    guint           columns, rows;
+    guint          *cell_start;     // columns * rows + 1 offsets in cell_aois
+    guint          *cell_aois;
+
+    /*
+     * The eyetracker whose thread uses the set and the number of references
+     * it handed to that thread, see geye_aoi_set_attach(). aoi_attach lock.
+     */
+    gconstpointer   owner;
+    guint           users;
+
+    /* Thread only, which areas contain the gaze. */
+    guint          *inside;         // the areas that contain the gaze
+    guint           n_inside;
+    guint          *inside_pos;     // per area, its index in inside
+    gdouble        *enter_time;     // per area
+    guint          *hit_stamp;      // per area, the last update it was hit
+    guint           stamp;
+
+    /* Main context only. */
+    gdouble        *dwell;          // per area
+};
+
+G_DEFINE_TYPE(GEyeAoiSet, geye_aoi_set, G_TYPE_OBJECT)
+
+typedef enum {
+    AOI_ENTER,
+    AOI_LEAVE,
+    N_SIGNALS
+} GEyeAoiSetSignal;
+
+static guint aoi_set_signals[N_SIGNALS];
+
+GType
+geye_aoi_shape_get_type(void)
+{
+    static gsize shape_type = 0;
+
+    if (g_once_init_enter(&shape_type)) {
+        static const GEnumValue values[] = {
+            {GEYE_AOI_RECTANGLE, "GEYE_AOI_RECTANGLE", "rectangle"},
+            {GEYE_AOI_ELLIPSE, "GEYE_AOI_ELLIPSE", "ellipse"},
+            {GEYE_AOI_POLYGON, "GEYE_AOI_POLYGON", "polygon"},
+            {0, NULL, NULL}
+        };
+        GType type = g_enum_register_static("GEyeAoiShape", values);
+        g_once_init_leave(&shape_type, type);
+    }
+    return shape_type;
+}
+
+static void
+geye_aoi_set_init(GEyeAoiSet *self)
+{
+    self->aois = g_array_new(FALSE, FALSE, sizeof(Aoi));
+    self->points = g_array_new(FALSE, FALSE, sizeof(gdouble));
+}
+
+static void
+aoi_set_finalize(GObject *gobject)
+{
+    GEyeAoiSet *self = GEYE_AOI_SET(gobject);
+
+    g_array_unref(self->aois);
+    g_array_unref(self->points);
+    g_free(self->cell_start);
+    g_free(self->cell_aois);
+    g_free(self->inside);
+    g_free(self->inside_pos);
+    g_free(self->enter_time);
+    g_free(self->hit_stamp);
+    g_free(self->dwell);
+
+    G_OBJECT_CLASS(geye_aoi_set_parent_class)->finalize(gobject);
+}
+
+static void
+geye_aoi_set_class_init(GEyeAoiSetClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    object_class->finalize = aoi_set_finalize;
+
+    /**
+     * GEyeAoiSet::aoi-enter:
+     * @set: the set that contains the area
+     * @aoi: the index of the area
+     * @time: the time of the first sample inside the area
+     *
+     * The gaze entered an area of interest. Areas may overlap, then the
+     * gaze is in all of them.
+     */
+    aoi_set_signals[AOI_ENTER] = g_signal_new(
+            "aoi-enter",
+            GEYE_TYPE_AOI_SET,
+            G_SIGNAL_RUN_FIRST,
+            0,
+            NULL, NULL,
+            NULL,
+            G_TYPE_NONE,
+            2, G_TYPE_UINT, G_TYPE_DOUBLE
+            );
+
+    /**
+     * GEyeAoiSet::aoi-leave:
+     * @set: the set that contains the area
+     * @aoi: the index of the area
+     * @time: the time of the first sample outside the area
+     * @dwell: how long the gaze was inside the area, in seconds
+     *
+     * The gaze left an area of interest. The dwell time has been added
+     * to the total of geye_aoi_set_get_dwell_time() before this signal
+     * is emitted.
+     */
+    aoi_set_signals[AOI_LEAVE] = g_signal_new(
+            "aoi-leave",
+            GEYE_TYPE_AOI_SET,
+            G_SIGNAL_RUN_FIRST,
+            0,
+            NULL, NULL,
+            NULL,
+            G_TYPE_NONE,
+            3, G_TYPE_UINT, G_TYPE_DOUBLE, G_TYPE_DOUBLE
+            );
+}
+
+static guint
+aoi_set_add(GEyeAoiSet *set, const Aoi *aoi)
+{
+    g_array_append_vals(set->aois, aoi, 1);
+    return set->aois->len - 1;
+}
+
+static inline const Aoi*
+aoi_set_get(GEyeAoiSet *set, guint aoi)
+{
+    return &g_array_index(set->aois, Aoi, aoi);
+}
+
+static gboolean
+polygon_contains(GEyeAoiSet *set, const Aoi *aoi, gdouble x, gdouble y)
+{
+    const gdouble *p = &g_array_index(set->points, gdouble, aoi->first_point);
+    gboolean inside = FALSE;
+    guint i, j;
+
+    for (i = 0, j = aoi->n_points - 1; i < aoi->n_points; j = i++) {
+        gdouble xi = p[2 * i], yi = p[2 * i + 1];
+        gdouble xj = p[2 * j], yj = p[2 * j + 1];
+        if ((yi > y) != (yj > y) &&
+                x < (xj - xi) * (y - yi) / (yj - yi) + xi)
+            inside = !inside;
+    }
+    return inside;
+}
+
+static gboolean
+aoi_contains(GEyeAoiSet *set, const Aoi *aoi, gdouble x, gdouble y)
+{
+    gdouble dx, dy;
+
+    if (x < aoi->x0 || x >= aoi->x1 || y < aoi->y0 || y >= aoi->y1)
+        return FALSE;
+
+    switch (aoi->shape) {
+        case GEYE_AOI_RECTANGLE:
+            return TRUE;
+        case GEYE_AOI_ELLIPSE:
+            dx = (2 * x - aoi->x0 - aoi->x1) / (aoi->x1 - aoi->x0);
+            dy = (2 * y - aoi->y0 - aoi->y1) / (aoi->y1 - aoi->y0);
+            return dx * dx + dy * dy <= 1;
+        case GEYE_AOI_POLYGON:
+            return polygon_contains(set, aoi, x, y);
+        default:
+            g_assert_not_reached();
+    }
+    return FALSE;
+}
+
+static gint
+grid_column(GEyeAoiSet *set, gdouble x)
+{
+    return (gint) floor((x - set->grid_x) / set->cell_width);
+}
+
+static gint
+grid_row(GEyeAoiSet *set, gdouble y)
+{
+    return (gint) floor((y - set->grid_y) / set->cell_height);
+}
+
+/*
+ * Calls func for every cell that overlaps with the bounding box of aoi.
+ */
+static void
+grid_foreach_cell(GEyeAoiSet   *set,
+                  const Aoi    *aoi,
+                  void        (*func)(GEyeAoiSet *set, guint cell, guint aoi),
+                  guint         index)
+{
+    gint c0 = CLAMP(grid_column(set, aoi->x0), 0, (gint) set->columns - 1);
+    gint c1 = CLAMP(grid_column(set, aoi->x1), 0, (gint) set->columns - 1);
+    gint r0 = CLAMP(grid_row(set, aoi->y0), 0, (gint) set->rows - 1);
+    gint r1 = CLAMP(grid_row(set, aoi->y1), 0, (gint) set->rows - 1);
+    gint r, c;
+
+    for (r = r0; r <= r1; r++)
+        for (c = c0; c <= c1; c++)
+            func(set, r * set->columns + c, index);
+}
+
+static void
+grid_count(GEyeAoiSet *set, guint cell, guint aoi)
+{
+    (void) aoi;
+    set->cell_start[cell + 1]++;
+}
+
+static void
+grid_fill(GEyeAoiSet *set, guint cell, guint aoi)
+{
+    // cell_start[cell] is used as the fill pointer, it is restored after.
+    set->cell_aois[set->cell_start[cell]++] = aoi;
+}
+
+static void
+grid_build(GEyeAoiSet *set)
+{
+    guint n = set->aois->len, n_cells, i, side;
+    gdouble x0 = G_MAXDOUBLE, y0 = G_MAXDOUBLE;
+    gdouble x1 = -G_MAXDOUBLE, y1 = -G_MAXDOUBLE;
+
+    for (i = 0; i < n; i++) {
+        const Aoi *aoi = aoi_set_get(set, i);
+        x0 = MIN(x0, aoi->x0);
+        y0 = MIN(y0, aoi->y0);
+        x1 = MAX(x1, aoi->x1);
+        y1 = MAX(y1, aoi->y1);
+    }
+
+    // About one area per cell when they are spread evenly.
+    side = n > 0 ? CLAMP((guint) ceil(sqrt(n)), 1, AOI_GRID_MAX) : 1;
+    set->columns = set->rows = side;
+    set->grid_x = n > 0 ? x0 : 0;
+    set->grid_y = n > 0 ? y0 : 0;
+    set->cell_width = n > 0 && x1 > x0 ? (x1 - x0) / side : 1;
+    set->cell_height = n > 0 && y1 > y0 ? (y1 - y0) / side : 1;
+
+    n_cells = side * side;
+    set->cell_start = g_new0(guint, n_cells + 1);
+    for (i = 0; i < n; i++)
+        grid_foreach_cell(set, aoi_set_get(set, i), grid_count, i);
+    for (i = 0; i < n_cells; i++)
+        set->cell_start[i + 1] += set->cell_start[i];
+
+    set->cell_aois = g_new(guint, MAX(set->cell_start[n_cells], 1));
+    for (i = 0; i < n; i++)
+        grid_foreach_cell(set, aoi_set_get(set, i), grid_fill, i);
+    for (i = n_cells; i > 0; i--)
+        set->cell_start[i] = set->cell_start[i - 1];
+    set->cell_start[0] = 0;
+}
+
+/* ************************** thread side ********************************* */
+
+/*
+ * Builds the index and allocates what the thread needs, after this the set
+ * can't be changed anymore. Called in the main context when the set is
+ * attached to an eyetracker.
+ */
+void
+geye_aoi_set_seal(GEyeAoiSet *set)
+{
+    guint n, i;
+
+    g_return_if_fail(GEYE_IS_AOI_SET(set));
+
+    if (set->sealed)
+        return;
+
+    n = MAX(set->aois->len, 1);
+    grid_build(set);
+    set->inside = g_new(guint, n);
+    set->inside_pos = g_new(guint, n);
+    for (i = 0; i < n; i++)
+        set->inside_pos[i] = G_MAXUINT;
+    set->enter_time = g_new0(gdouble, n);
+    set->hit_stamp = g_new0(guint, n);
+    set->dwell = g_new0(gdouble, n);
+    set->sealed = TRUE;
+}
+
+/*
+ * Seals the set and registers a reference that owner hands to the thread
+ * that receives its samples. Which areas contain the gaze is stored in the
+ * set, so only the thread of one eyetracker may update it. Returns FALSE
+ * when the set is in use by another eyetracker. Called in the main context.
+ */
+gboolean
+geye_aoi_set_attach(GEyeAoiSet *set, gconstpointer owner)
+{
+    gboolean attached = TRUE;
+
+    g_return_val_if_fail(GEYE_IS_AOI_SET(set), FALSE);
+    g_return_val_if_fail(owner != NULL, FALSE);
+
+    geye_aoi_set_seal(set);
+
+    G_LOCK(aoi_attach);
+    if (set->users == 0)
+        set->owner = owner;
+    if (set->owner == owner)
+        set->users++;
+    else
+        attached = FALSE;
+    G_UNLOCK(aoi_attach);
+
+    if (!attached)
+        g_critical(
+                "%s: the set of areas of interest is attached to another "
+                "eyetracker",
+                G_STRFUNC
+                );
+    return attached;
+}
+
+/*
+ * Drops a reference that was registered by geye_aoi_set_attach(), once the
+ * thread doesn't use it anymore. When the last one is gone, the set may be
+ * attached to another eyetracker. It doesn't drop the object reference.
+ */
+void
+geye_aoi_set_detach(GEyeAoiSet *set)
+{
+    g_return_if_fail(GEYE_IS_AOI_SET(set));
+
+    G_LOCK(aoi_attach);
+    g_warn_if_fail(set->users > 0);
+    if (set->users > 0 && --set->users == 0)
+        set->owner = NULL;
+    G_UNLOCK(aoi_attach);
+}
+
+gboolean
+geye_aoi_set_is_sealed(GEyeAoiSet *set)
+{
+    g_return_val_if_fail(GEYE_IS_AOI_SET(set), FALSE);
+    return set->sealed;
+}
+
+static void
+aoi_leave(GEyeAoiSet *set, guint pos, gdouble time, GEyeAoiFunc func,
+          gpointer data)
+{
+    guint aoi = set->inside[pos];
+    guint last = set->inside[--set->n_inside];
+
+    set->inside[pos] = last;
+    set->inside_pos[last] = pos;
+    set->inside_pos[aoi] = G_MAXUINT;
+
+    func(set, aoi, FALSE, time, time - set->enter_time[aoi], data);
+}
+
+/*
+ * Looks up the areas that contain the gaze at (x, y) and calls func for
+ * every area that the gaze left or entered since the previous update, the
+ * leaves come first. Only the areas in the cell of the gaze are tested.
+ */
+void
+geye_aoi_set_update(GEyeAoiSet *set,
+                    gdouble     x,
+                    gdouble     y,
+                    gdouble     time,
+                    GEyeAoiFunc func,
+                    gpointer    data)
+{
+    gint column = grid_column(set, x);
+    gint row = grid_row(set, y);
+    guint first = 0, last = 0, i;
+
+    if (++set->stamp == 0) {
+        memset(set->hit_stamp, 0, sizeof(guint) * MAX(set->aois->len, 1));
+        set->stamp = 1;
+    }
+
+    if (column >= 0 && column < (gint) set->columns &&
+            row >= 0 && row < (gint) set->rows) {
+        guint cell = row * set->columns + column;
+        first = set->cell_start[cell];
+        last = set->cell_start[cell + 1];
+    }
+
+    for (i = first; i < last; i++) {
+        guint aoi = set->cell_aois[i];
+        if (aoi_contains(set, aoi_set_get(set, aoi), x, y))
+            set->hit_stamp[aoi] = set->stamp;
+    }
+
+    for (i = set->n_inside; i > 0; i--)
+        if (set->hit_stamp[set->inside[i - 1]] != set->stamp)
+            aoi_leave(set, i - 1, time, func, data);
+
+    for (i = first; i < last; i++) {
+        guint aoi = set->cell_aois[i];
+        if (set->hit_stamp[aoi] == set->stamp &&
+                set->inside_pos[aoi] == G_MAXUINT) {
+            set->inside_pos[aoi] = set->n_inside;
+            set->inside[set->n_inside++] = aoi;
+            set->enter_time[aoi] = time;
+            func(set, aoi, TRUE, time, 0, data);
+        }
+    }
+}
+
+/*
+ * Leaves all areas, e.g. when the set is detached or tracking stops.
+ */
+void
+geye_aoi_set_leave_all(GEyeAoiSet  *set,
+                       gdouble      time,
+                       GEyeAoiFunc  func,
+                       gpointer     data)
+{
+    while (set->n_inside > 0)
+        aoi_leave(set, set->n_inside - 1, time, func, data);
+}
+
+/* ************************** main context ******************************** */
+
+void
+geye_aoi_set_emit_enter(GEyeAoiSet *set, guint aoi, gdouble time)
+{
+    g_signal_emit(set, aoi_set_signals[AOI_ENTER], 0, aoi, time);
+}
+
+void
+geye_aoi_set_emit_leave(GEyeAoiSet *set, guint aoi, gdouble time, gdouble dwell)
+{
+    set->dwell[aoi] += dwell;
+    g_signal_emit(set, aoi_set_signals[AOI_LEAVE], 0, aoi, time, dwell);
+}
+
+/* ************************** public functions **************************** */
+
+/**
+ * geye_aoi_set_new:(constructor)
+ *
+ * Creates an empty set of areas of interest. Add the areas and attach it
+ * to an eyetracker with geye_eyetracker_set_aoi_set(), then the eyetracker
+ * tests every sample against the areas and the set emits
+ * #GEyeAoiSet::aoi-enter and #GEyeAoiSet::aoi-leave.
+ *
+ * Returns:(transfer full): a new GEyeAoiSet
+ */
+GEyeAoiSet*
+geye_aoi_set_new(void)
+{
+    return g_object_new(GEYE_TYPE_AOI_SET, NULL);
+}
+
+/**
+ * geye_aoi_set_add_rectangle:
+ * @set: a GEyeAoiSet that hasn't been attached yet
+ * @x: the left side
+ * @y: the top side
+ * @width: the width, it must be positive
+ * @height: the height, it must be positive
+ *
+ * Returns: the index of the new area, the areas are numbered in the order
+ *          in which they are added.
+ */
+guint
+geye_aoi_set_add_rectangle(GEyeAoiSet  *set,
+                           gdouble      x,
+                           gdouble      y,
+                           gdouble      width,
+                           gdouble      height)
+{
+    g_return_val_if_fail(GEYE_IS_AOI_SET(set), G_MAXUINT);
+    g_return_val_if_fail(!set->sealed, G_MAXUINT);
+    g_return_val_if_fail(width > 0 && height > 0, G_MAXUINT);
+
+    Aoi aoi = {
+        .shape = GEYE_AOI_RECTANGLE,
+        .x0 = x, .y0 = y, .x1 = x + width, .y1 = y + height
+    };
+    return aoi_set_add(set, &aoi);
+}
+
+/**
+ * geye_aoi_set_add_ellipse:
+ * @set: a GEyeAoiSet that hasn't been attached yet
+ * @center_x: the horizontal center
+ * @center_y: the vertical center
+ * @radius_x: the horizontal radius, it must be positive
+ * @radius_y: the vertical radius, it must be positive
+ *
+ * Returns: the index of the new area
+ */
+guint
+geye_aoi_set_add_ellipse(GEyeAoiSet    *set,
+                         gdouble        center_x,
+                         gdouble        center_y,
+                         gdouble        radius_x,
+                         gdouble        radius_y)
+{
+    g_return_val_if_fail(GEYE_IS_AOI_SET(set), G_MAXUINT);
+    g_return_val_if_fail(!set->sealed, G_MAXUINT);
+    g_return_val_if_fail(radius_x > 0 && radius_y > 0, G_MAXUINT);
+
+    Aoi aoi = {
+        .shape = GEYE_AOI_ELLIPSE,
+        .x0 = center_x - radius_x, .y0 = center_y - radius_y,
+        .x1 = center_x + radius_x, .y1 = center_y + radius_y
+    };
+    return aoi_set_add(set, &aoi);
+}
+
+/**
+ * geye_aoi_set_add_polygon:
+ * @set: a GEyeAoiSet that hasn't been attached yet
+ * @points:(array length=n_points): the x and y of the vertices after each
+ *         other, so it holds 2 * @n_points values.
+ * @n_points: the number of vertices, at least 3
+ *
+ * Returns: the index of the new area
+ */
+guint
+geye_aoi_set_add_polygon(GEyeAoiSet    *set,
+                         const gdouble *points,
+                         guint          n_points)
+{
+    guint i;
+
+    g_return_val_if_fail(GEYE_IS_AOI_SET(set), G_MAXUINT);
+    g_return_val_if_fail(!set->sealed, G_MAXUINT);
+    g_return_val_if_fail(points != NULL && n_points >= 3, G_MAXUINT);
+
+    Aoi aoi = {
+        .shape = GEYE_AOI_POLYGON,
+        .x0 = G_MAXDOUBLE, .y0 = G_MAXDOUBLE,
+        .x1 = -G_MAXDOUBLE, .y1 = -G_MAXDOUBLE,
+        .first_point = set->points->len,
+        .n_points = n_points
+    };
+    for (i = 0; i < n_points; i++) {
+        aoi.x0 = MIN(aoi.x0, points[2 * i]);
+        aoi.y0 = MIN(aoi.y0, points[2 * i + 1]);
+        aoi.x1 = MAX(aoi.x1, points[2 * i]);
+        aoi.y1 = MAX(aoi.y1, points[2 * i + 1]);
+    }
+    g_array_append_vals(set->points, points, 2 * n_points);
+    return aoi_set_add(set, &aoi);
+}
+
+/**
+ * geye_aoi_set_get_size:
+ * @set: a GEyeAoiSet
+ *
+ * Returns: the number of areas in the set
+ */
+guint
+geye_aoi_set_get_size(GEyeAoiSet *set)
+{
+    g_return_val_if_fail(GEYE_IS_AOI_SET(set), 0);
+    return set->aois->len;
+}
+
+/**
+ * geye_aoi_set_get_shape:
+ * @set: a GEyeAoiSet
+ * @aoi: the index of an area
+ *
+ * Returns: the shape of the area
+ */
+GEyeAoiShape
+geye_aoi_set_get_shape(GEyeAoiSet *set, guint aoi)
+{
+    g_return_val_if_fail(GEYE_IS_AOI_SET(set), GEYE_AOI_RECTANGLE);
+    g_return_val_if_fail(aoi < set->aois->len, GEYE_AOI_RECTANGLE);
+    return aoi_set_get(set, aoi)->shape;
+}
+
+/**
+ * geye_aoi_set_contains:
+ * @set: a GEyeAoiSet
+ * @aoi: the index of an area
+ * @x: the horizontal coordinate
+ * @y: the vertical coordinate
+ *
+ * Returns: TRUE if the area contains (x, y)
+ */
+gboolean
+geye_aoi_set_contains(GEyeAoiSet *set, guint aoi, gdouble x, gdouble y)
+{
+    g_return_val_if_fail(GEYE_IS_AOI_SET(set), FALSE);
+    g_return_val_if_fail(aoi < set->aois->len, FALSE);
+    return aoi_contains(set, aoi_set_get(set, aoi), x, y);
+}
+
+/**
+ * geye_aoi_set_get_dwell_time:
+ * @set: a GEyeAoiSet
+ * @aoi: the index of an area
+ *
+ * The time the gaze spent inside the area, summed over the visits that
+ * ended with #GEyeAoiSet::aoi-leave. A visit that is going on doesn't
+ * count yet.
+ *
+ * Returns: the dwell time in seconds
+ */
+gdouble
+geye_aoi_set_get_dwell_time(GEyeAoiSet *set, guint aoi)
+{
+    g_return_val_if_fail(GEYE_IS_AOI_SET(set), 0);
+    g_return_val_if_fail(aoi < set->aois->len, 0);
+
+    if (!set->dwell)
+        return 0;
+    return set->dwell[aoi];
+}
+
+/**
+ * geye_aoi_set_reset_dwell_times:
+ * @set: a GEyeAoiSet
+ *
+ * Sets the dwell time of all areas to 0.
+ */
+void
+geye_aoi_set_reset_dwell_times(GEyeAoiSet *set)
+{
+    g_return_if_fail(GEYE_IS_AOI_SET(set));
+
+    if (set->dwell)
+        memset(set->dwell, 0, sizeof(gdouble) * MAX(set->aois->len, 1));
+}
@@ -0,0 +1,91 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GEYE_AOI_SET_H
+#define GEYE_AOI_SET_H
+
+#include <glib-object.h>
+#include <gmodule.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GEyeAoiShape:
+ * @GEYE_AOI_RECTANGLE: an axis aligned rectangle
+ * @GEYE_AOI_ELLIPSE: an axis aligned ellipse
+ * @GEYE_AOI_POLYGON: a simple polygon, a point is inside according to the
+ *                    even-odd rule.
+ *
+ * The shape of an area of interest.
+ */
+typedef enum _GEyeAoiShape {
+    GEYE_AOI_RECTANGLE,
+    GEYE_AOI_ELLIPSE,
+    GEYE_AOI_POLYGON,
+} GEyeAoiShape;
+
+#define GEYE_TYPE_AOI_SHAPE geye_aoi_shape_get_type()
+G_MODULE_EXPORT GType
+geye_aoi_shape_get_type(void);
+
+#define GEYE_TYPE_AOI_SET geye_aoi_set_get_type()
+G_MODULE_EXPORT
+G_DECLARE_FINAL_TYPE(GEyeAoiSet, geye_aoi_set, GEYE, AOI_SET, GObject)
+
+G_MODULE_EXPORT GEyeAoiSet*
+geye_aoi_set_new(void);
+
+G_MODULE_EXPORT guint
+geye_aoi_set_add_rectangle(GEyeAoiSet  *set,
+                           gdouble      x,
+                           gdouble      y,
+                           gdouble      width,
+                           gdouble      height);
+
+G_MODULE_EXPORT guint
+geye_aoi_set_add_ellipse(GEyeAoiSet    *set,
+                         gdouble        center_x,
+                         gdouble        center_y,
+                         gdouble        radius_x,
+                         gdouble        radius_y);
+
+G_MODULE_EXPORT guint
+geye_aoi_set_add_polygon(GEyeAoiSet    *set,
+                         const gdouble *points,
+                         guint          n_points);
+
+G_MODULE_EXPORT guint
+geye_aoi_set_get_size(GEyeAoiSet *set);
+
+G_MODULE_EXPORT GEyeAoiShape
+geye_aoi_set_get_shape(GEyeAoiSet *set, guint aoi);
+
+G_MODULE_EXPORT gboolean
+geye_aoi_set_contains(GEyeAoiSet *set, guint aoi, gdouble x, gdouble y);
+
+G_MODULE_EXPORT gdouble
+geye_aoi_set_get_dwell_time(GEyeAoiSet *set, guint aoi);
+
+G_MODULE_EXPORT void
+geye_aoi_set_reset_dwell_times(GEyeAoiSet *set);
+
+G_END_DECLS
+
+#endif
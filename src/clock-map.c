@@ -0,0 +1,241 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "clock-map.h"
+
+/*
+ * The pairs are fitted with least squares over a window of the most recent
+ * pairs. Pairs that are taken shortly after each other mostly add noise to
+ * the slope, so a pair is only added to the window when at least
+ * CLOCK_MAP_INTERVAL_US have passed since the previous one. The fitted
+ * line goes through the mean of the window, that averages out the jitter
+ * of reading both clocks.
+ */
+#define CLOCK_MAP_WINDOW        64
+#define CLOCK_MAP_INTERVAL_US   100000
+
+/*
+ * The params are copied with plain loads and stores, the fences keep them
+ * between the two changes of the sequence number on the writer side and
+ * before the second read of it on the reader side. Without the builtin an
+ * atomic operation is a full barrier.
+ */
+#if defined(__GNUC__)
+#define CLOCK_MAP_RELEASE_FENCE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define CLOCK_MAP_ACQUIRE_FENCE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#else
+static gint clock_map_fence;
+#define CLOCK_MAP_RELEASE_FENCE() g_atomic_int_inc(&clock_map_fence)
+#define CLOCK_MAP_ACQUIRE_FENCE() g_atomic_int_inc(&clock_map_fence)
+#endif
+
+typedef struct {
+    gdouble     tracker_ref;    // tracker time in µs of the reference point
+    gint64      host_ref;       // host time in µs of the reference point
+    gdouble     slope;          // host µs per tracker µs
+} ClockMapParams;
+
+struct _GEyeClockMap {
+    /* only used by the updating thread */
+    gdouble     tracker[CLOCK_MAP_WINDOW];  // relative to the origin
+    gdouble     host[CLOCK_MAP_WINDOW];     // relative to the origin
+    guint       n_pairs;
+    guint       next;
+    gdouble     tracker_origin;
+    gint64      host_origin;
+    gdouble     slope;  // of the last fit
+
+    /* published to the readers, guarded by a sequence lock */
+    gint            seq;        // odd while the params are written
+    ClockMapParams  params;
+    gint            valid;
+};
+
+GEyeClockMap*
+geye_clock_map_new(void)
+{
+    GEyeClockMap *map = g_new0(GEyeClockMap, 1);
+    map->slope = 1.0;
+    return map;
+}
+
+void
+geye_clock_map_free(GEyeClockMap *map)
+{
+    g_free(map);
+}
+
+/**
+ * geye_clock_map_reset:
+ * @map: a GEyeClockMap
+ *
+ * Forgets all pairs, e.g. because the clock of the tracker was restarted.
+ * The mapping is invalid until the next update.
+ */
+void
+geye_clock_map_reset(GEyeClockMap *map)
+{
+    map->n_pairs = 0;
+    map->next = 0;
+    map->slope = 1.0;
+    g_atomic_int_set(&map->valid, FALSE);
+}
+
+static void
+clock_map_publish(GEyeClockMap *map, const ClockMapParams *params)
+{
+    g_atomic_int_inc(&map->seq);
+    CLOCK_MAP_RELEASE_FENCE();
+    map->params = *params;
+    CLOCK_MAP_RELEASE_FENCE();
+    g_atomic_int_inc(&map->seq);
+    g_atomic_int_set(&map->valid, TRUE);
+}
+
+static void
+clock_map_fit(GEyeClockMap *map)
+{
+    ClockMapParams params;
+    gdouble mean_t = 0, mean_h = 0, sxx = 0, sxy = 0;
+    guint i;
+
+    for (i = 0; i < map->n_pairs; i++) {
+        mean_t += map->tracker[i];
+        mean_h += map->host[i];
+    }
+    mean_t /= map->n_pairs;
+    mean_h /= map->n_pairs;
+
+    for (i = 0; i < map->n_pairs; i++) {
+        gdouble dt = map->tracker[i] - mean_t;
+        sxx += dt * dt;
+        sxy += dt * (map->host[i] - mean_h);
+    }
+
+    // The clocks run at nearly the same rate, a wild slope means the
+    // pairs are too close together or too noisy to tell.
+    if (sxx > 0) {
+        gdouble slope = sxy / sxx;
+        if (slope > 0.99 && slope < 1.01)
+            map->slope = slope;
+    }
+
+    params.tracker_ref = map->tracker_origin + mean_t;
+    params.host_ref = map->host_origin + (gint64) mean_h;
+    params.slope = map->slope;
+    clock_map_publish(map, &params);
+}
+
+/**
+ * geye_clock_map_update:
+ * @map: a GEyeClockMap
+ * @tracker_us: the time of the tracker in µs
+ * @host_us: the monotonic time of the host in µs at the same moment
+ *
+ * Adds a pair of clock readings to the estimate. This is cheap enough to
+ * be called every time the link with the tracker is drained. It must only
+ * be called from one thread.
+ */
+void
+geye_clock_map_update(GEyeClockMap *map, gdouble tracker_us, gint64 host_us)
+{
+    guint last;
+
+    if (map->n_pairs > 0) {
+        last = (map->next + CLOCK_MAP_WINDOW - 1) % CLOCK_MAP_WINDOW;
+        // The tracker clock went backwards, it has been restarted.
+        if (tracker_us - map->tracker_origin < map->tracker[last])
+            geye_clock_map_reset(map);
+    }
+
+    if (map->n_pairs == 0) {
+        map->tracker_origin = tracker_us;
+        map->host_origin = host_us;
+    }
+
+    last = (map->next + CLOCK_MAP_WINDOW - 1) % CLOCK_MAP_WINDOW;
+    if (map->n_pairs == 0 ||
+        host_us - map->host_origin - map->host[last] >= CLOCK_MAP_INTERVAL_US
+        ) {
+        map->tracker[map->next] = tracker_us - map->tracker_origin;
+        map->host[map->next] = host_us - map->host_origin;
+        map->next = (map->next + 1) % CLOCK_MAP_WINDOW;
+        if (map->n_pairs < CLOCK_MAP_WINDOW)
+            map->n_pairs++;
+        clock_map_fit(map);
+    }
+}
+
+static void
+clock_map_read(GEyeClockMap *map, ClockMapParams *params)
+{
+    gint seq;
+    do {
+        while ((seq = g_atomic_int_get(&map->seq)) & 1)
+            ;
+        *params = map->params;
+        CLOCK_MAP_ACQUIRE_FENCE();
+    } while (g_atomic_int_get(&map->seq) != seq);
+}
+
+gboolean
+geye_clock_map_is_valid(GEyeClockMap *map)
+{
+    return g_atomic_int_get(&map->valid);
+}
+
+/**
+ * geye_clock_map_to_host:
+ * @map: a GEyeClockMap
+ * @tracker_us: a time of the tracker in µs
+ *
+ * Returns: the corresponding monotonic time of the host in µs, or 0 when
+ *          the mapping isn't valid yet.
+ */
+gint64
+geye_clock_map_to_host(GEyeClockMap *map, gdouble tracker_us)
+{
+    ClockMapParams params;
+
+    if (!geye_clock_map_is_valid(map))
+        return 0;
+
+    clock_map_read(map, &params);
+    return params.host_ref +
+           (gint64) ((tracker_us - params.tracker_ref) * params.slope);
+}
+
+/**
+ * geye_clock_map_get_slope:
+ * @map: a GEyeClockMap
+ *
+ * Returns: the estimated number of host µs per tracker µs.
+ */
+gdouble
+geye_clock_map_get_slope(GEyeClockMap *map)
+{
+    ClockMapParams params;
+
+    if (!geye_clock_map_is_valid(map))
+        return 1.0;
+
+    clock_map_read(map, &params);
+    return params.slope;
+}
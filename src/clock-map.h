@@ -0,0 +1,55 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GEYE_CLOCK_MAP_H
+#define GEYE_CLOCK_MAP_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Estimates a linear mapping from the clock of an eyetracker to the
+ * monotonic clock of the host (g_get_monotonic_time()), from pairs of
+ * simultaneous readings of both clocks.
+ *
+ * One thread updates the mapping, any thread may use it to convert
+ * tracker time to host time without taking a lock.
+ */
+typedef struct _GEyeClockMap GEyeClockMap;
+
+GEyeClockMap*   geye_clock_map_new(void);
+void            geye_clock_map_free(GEyeClockMap *map);
+
+/* updating side */
+void            geye_clock_map_reset(GEyeClockMap *map);
+void            geye_clock_map_update(GEyeClockMap *map,
+                                      gdouble       tracker_us,
+                                      gint64        host_us);
+
+/* any thread */
+gboolean        geye_clock_map_is_valid(GEyeClockMap *map);
+gint64          geye_clock_map_to_host(GEyeClockMap *map,
+                                       gdouble       tracker_us);
+gdouble         geye_clock_map_get_slope(GEyeClockMap *map);
+
+G_END_DECLS
+
+#endif
@@ -39,6 +39,7 @@ geye_sample_new(GEyeEyeType eye, gdouble time, gdouble x, gdouble y)
     sample->parent.type = GEYE_EVENT_SAMPLE;
     sample->parent.eye  = eye;
     sample->parent.time = time;
+    sample->parent.tracker_time = 0;
     sample->x = x;
     sample->y = y;
 
@@ -62,3 +63,590 @@ geye_sample_copy(const GEyeSample* sample)
 G_DEFINE_BOXED_TYPE(GEyeSample, geye_sample,
                     geye_sample_copy, geye_sample_free)
 
+/**
+ * geye_binocular_sample_new:
+ * @eye: the eyes that were tracked.
+ * @valid: the eyes for which the coordinates are valid.
+ * @time: the time at which this event occured
+ * @left_x: the x coordinate of the left eye
+ * @left_y: the y coordinate of the left eye
+ * @right_x: the x coordinate of the right eye
+ * @right_y: the y coordinate of the right eye
+ *
+ * Create a new sample that contains both eyes.
+ *
+ * Returns:(transfer full): A new `GEyeBinocularSample`
+ */
+GEyeBinocularSample*
+geye_binocular_sample_new(GEyeEyeType   eye,
+                          GEyeEyeType   valid,
+                          gdouble       time,
+                          gdouble       left_x,
+                          gdouble       left_y,
+                          gdouble       right_x,
+                          gdouble       right_y)
+{
+    GEyeBinocularSample* sample = g_slice_new(GEyeBinocularSample);
+
+    sample->parent.type = GEYE_EVENT_SAMPLE;
+    sample->parent.eye  = eye;
+    sample->parent.time = time;
+    sample->parent.tracker_time = 0;
+    sample->valid   = valid & eye;
+    sample->left_x  = left_x;
+    sample->left_y  = left_y;
+    sample->right_x = right_x;
+    sample->right_y = right_y;
+
+    return sample;
+}
+
+void
+geye_binocular_sample_free(GEyeBinocularSample* sample)
+{
+    g_slice_free(GEyeBinocularSample, sample);
+}
+
+GEyeBinocularSample*
+geye_binocular_sample_copy(const GEyeBinocularSample* sample)
+{
+    g_return_val_if_fail(sample != NULL, NULL);
+
+    return g_slice_dup(GEyeBinocularSample, sample);
+}
+
+/**
+ * geye_binocular_sample_get_eye:
+ * @sample: a GEyeBinocularSample
+ * @eye: %GEYE_LEFT or %GEYE_RIGHT
+ * @x:(out)(optional): the x coordinate of @eye
+ * @y:(out)(optional): the y coordinate of @eye
+ *
+ * Obtain the coordinate of one eye.
+ *
+ * Returns: TRUE if @eye contains a valid coordinate in this sample.
+ */
+gboolean
+geye_binocular_sample_get_eye(const GEyeBinocularSample *sample,
+                              GEyeEyeType                eye,
+                              gdouble                   *x,
+                              gdouble                   *y)
+{
+    g_return_val_if_fail(sample != NULL, FALSE);
+    g_return_val_if_fail(eye == GEYE_LEFT || eye == GEYE_RIGHT, FALSE);
+
+    if (x)
+        *x = eye == GEYE_LEFT ? sample->left_x : sample->right_x;
+    if (y)
+        *y = eye == GEYE_LEFT ? sample->left_y : sample->right_y;
+
+    return (sample->valid & eye) != 0;
+}
+
+G_DEFINE_BOXED_TYPE(GEyeBinocularSample, geye_binocular_sample,
+                    geye_binocular_sample_copy, geye_binocular_sample_free)
+
+GType
+geye_sample_fields_get_type(void)
+{
+    static gsize fields_type = 0;
+
+    if (g_once_init_enter(&fields_type)) {
+        static const GFlagsValue values[] = {
+            {GEYE_SAMPLE_FIELD_NONE, "GEYE_SAMPLE_FIELD_NONE", "none"},
+            {GEYE_SAMPLE_FIELD_PUPIL, "GEYE_SAMPLE_FIELD_PUPIL", "pupil"},
+            {GEYE_SAMPLE_FIELD_HREF, "GEYE_SAMPLE_FIELD_HREF", "href"},
+            {GEYE_SAMPLE_FIELD_RAW, "GEYE_SAMPLE_FIELD_RAW", "raw"},
+            {GEYE_SAMPLE_FIELD_RESOLUTION,
+             "GEYE_SAMPLE_FIELD_RESOLUTION",
+             "resolution"},
+            {GEYE_SAMPLE_FIELD_STATUS, "GEYE_SAMPLE_FIELD_STATUS", "status"},
+            {GEYE_SAMPLE_FIELD_UNFILTERED,
+             "GEYE_SAMPLE_FIELD_UNFILTERED",
+             "unfiltered"},
+            {GEYE_SAMPLE_FIELD_VELOCITY,
+             "GEYE_SAMPLE_FIELD_VELOCITY",
+             "velocity"},
+            {GEYE_SAMPLE_FIELD_ACCELERATION,
+             "GEYE_SAMPLE_FIELD_ACCELERATION",
+             "acceleration"},
+            {0, NULL, NULL}
+        };
+        GType type = g_flags_register_static("GEyeSampleFields", values);
+        g_once_init_leave(&fields_type, type);
+    }
+    return fields_type;
+}
+
+GEyeExtendedSample*
+geye_extended_sample_copy(const GEyeExtendedSample *sample)
+{
+    g_return_val_if_fail(sample != NULL, NULL);
+
+    return g_slice_dup(GEyeExtendedSample, sample);
+}
+
+void
+geye_extended_sample_free(GEyeExtendedSample *sample)
+{
+    g_slice_free(GEyeExtendedSample, sample);
+}
+
+G_DEFINE_BOXED_TYPE(GEyeExtendedSample, geye_extended_sample,
+                    geye_extended_sample_copy, geye_extended_sample_free)
+
+/* The number of values of one eye. */
+static guint
+extended_eye_values(GEyeSampleFields fields)
+{
+    return 2 +
+        (fields & GEYE_SAMPLE_FIELD_PUPIL ? 1 : 0) +
+        (fields & GEYE_SAMPLE_FIELD_HREF ? 2 : 0) +
+        (fields & GEYE_SAMPLE_FIELD_RAW ? 2 : 0) +
+        (fields & GEYE_SAMPLE_FIELD_UNFILTERED ? 2 : 0) +
+        (fields & GEYE_SAMPLE_FIELD_VELOCITY ? 2 : 0) +
+        (fields & GEYE_SAMPLE_FIELD_ACCELERATION ? 2 : 0);
+}
+
+static guint
+extended_n_eyes(GEyeEyeType eyes)
+{
+    return (eyes & GEYE_LEFT ? 1 : 0) + (eyes & GEYE_RIGHT ? 1 : 0);
+}
+
+/*
+ * Returns the offset of a field of an eye in the values, or -1 when the
+ * eye wasn't tracked or the field isn't selected. The gaze is 0.
+ */
+static gint
+extended_eye_offset(const GEyeExtendedSample   *sample,
+                    GEyeEyeType                 eye,
+                    GEyeSampleFields            field)
+{
+    GEyeSampleFields fields = sample->fields;
+    gint offset = 2;
+
+    if (!(sample->parent.eye & eye) || (field && !(fields & field)))
+        return -1;
+
+    if (field > GEYE_SAMPLE_FIELD_PUPIL && fields & GEYE_SAMPLE_FIELD_PUPIL)
+        offset += 1;
+    if (field > GEYE_SAMPLE_FIELD_HREF && fields & GEYE_SAMPLE_FIELD_HREF)
+        offset += 2;
+    if (field > GEYE_SAMPLE_FIELD_RAW && fields & GEYE_SAMPLE_FIELD_RAW)
+        offset += 2;
+    if (field > GEYE_SAMPLE_FIELD_UNFILTERED &&
+            fields & GEYE_SAMPLE_FIELD_UNFILTERED)
+        offset += 2;
+    if (field > GEYE_SAMPLE_FIELD_VELOCITY &&
+            fields & GEYE_SAMPLE_FIELD_VELOCITY)
+        offset += 2;
+    if (field == GEYE_SAMPLE_FIELD_NONE)
+        offset = 0;
+
+    if (eye == GEYE_RIGHT && sample->parent.eye & GEYE_LEFT)
+        offset += extended_eye_values(fields);
+    return offset;
+}
+
+/*
+ * Returns the offset of the resolution or status, that follow the eyes.
+ */
+static gint
+extended_offset(const GEyeExtendedSample *sample, GEyeSampleFields field)
+{
+    GEyeSampleFields fields = sample->fields;
+    gint offset = extended_n_eyes(sample->parent.eye) *
+                  extended_eye_values(fields);
+
+    if (!(fields & field))
+        return -1;
+    if (field == GEYE_SAMPLE_FIELD_STATUS &&
+            fields & GEYE_SAMPLE_FIELD_RESOLUTION)
+        offset += 2;
+    return offset;
+}
+
+/**
+ * geye_extended_sample_get_n_values:
+ * @fields: the selected fields
+ * @eyes: the tracked eyes
+ *
+ * Returns: the number of values that a #GEyeExtendedSample with @fields
+ *          of @eyes carries.
+ */
+guint
+geye_extended_sample_get_n_values(GEyeSampleFields fields, GEyeEyeType eyes)
+{
+    return extended_n_eyes(eyes) * extended_eye_values(fields) +
+        (fields & GEYE_SAMPLE_FIELD_RESOLUTION ? 2 : 0) +
+        (fields & GEYE_SAMPLE_FIELD_STATUS ? 1 : 0);
+}
+
+/**
+ * geye_extended_sample_get_gaze:
+ * @sample: a GEyeExtendedSample
+ * @eye: %GEYE_LEFT or %GEYE_RIGHT
+ * @x:(out)(optional): the x coordinate of @eye
+ * @y:(out)(optional): the y coordinate of @eye
+ *
+ * Returns: TRUE if @eye contains a valid coordinate in this sample.
+ */
+gboolean
+geye_extended_sample_get_gaze(const GEyeExtendedSample *sample,
+                              GEyeEyeType               eye,
+                              gdouble                  *x,
+                              gdouble                  *y)
+{
+    gint offset;
+
+    g_return_val_if_fail(sample != NULL, FALSE);
+    g_return_val_if_fail(eye == GEYE_LEFT || eye == GEYE_RIGHT, FALSE);
+
+    offset = extended_eye_offset(sample, eye, GEYE_SAMPLE_FIELD_NONE);
+    if (offset < 0)
+        return FALSE;
+    if (x)
+        *x = sample->values[offset];
+    if (y)
+        *y = sample->values[offset + 1];
+    return (sample->valid & eye) != 0;
+}
+
+/**
+ * geye_extended_sample_get_pupil:
+ * @sample: a GEyeExtendedSample
+ * @eye: %GEYE_LEFT or %GEYE_RIGHT
+ * @size:(out)(optional): the size of the pupil of @eye
+ *
+ * Returns: TRUE if the sample has the pupil size of @eye.
+ */
+gboolean
+geye_extended_sample_get_pupil(const GEyeExtendedSample *sample,
+                               GEyeEyeType               eye,
+                               gdouble                  *size)
+{
+    gint offset;
+
+    g_return_val_if_fail(sample != NULL, FALSE);
+    g_return_val_if_fail(eye == GEYE_LEFT || eye == GEYE_RIGHT, FALSE);
+
+    offset = extended_eye_offset(sample, eye, GEYE_SAMPLE_FIELD_PUPIL);
+    if (offset < 0)
+        return FALSE;
+    if (size)
+        *size = sample->values[offset];
+    return TRUE;
+}
+
+/**
+ * geye_extended_sample_get_href:
+ * @sample: a GEyeExtendedSample
+ * @eye: %GEYE_LEFT or %GEYE_RIGHT
+ * @x:(out)(optional): the head referenced x position of @eye
+ * @y:(out)(optional): the head referenced y position of @eye
+ *
+ * Returns: TRUE if the sample has the HREF position of @eye.
+ */
+gboolean
+geye_extended_sample_get_href(const GEyeExtendedSample *sample,
+                              GEyeEyeType               eye,
+                              gdouble                  *x,
+                              gdouble                  *y)
+{
+    gint offset;
+
+    g_return_val_if_fail(sample != NULL, FALSE);
+    g_return_val_if_fail(eye == GEYE_LEFT || eye == GEYE_RIGHT, FALSE);
+
+    offset = extended_eye_offset(sample, eye, GEYE_SAMPLE_FIELD_HREF);
+    if (offset < 0)
+        return FALSE;
+    if (x)
+        *x = sample->values[offset];
+    if (y)
+        *y = sample->values[offset + 1];
+    return TRUE;
+}
+
+/**
+ * geye_extended_sample_get_raw:
+ * @sample: a GEyeExtendedSample
+ * @eye: %GEYE_LEFT or %GEYE_RIGHT
+ * @x:(out)(optional): the raw x position of the pupil of @eye
+ * @y:(out)(optional): the raw y position of the pupil of @eye
+ *
+ * Returns: TRUE if the sample has the raw position of @eye.
+ */
+gboolean
+geye_extended_sample_get_raw(const GEyeExtendedSample *sample,
+                             GEyeEyeType               eye,
+                             gdouble                  *x,
+                             gdouble                  *y)
+{
+    gint offset;
+
+    g_return_val_if_fail(sample != NULL, FALSE);
+    g_return_val_if_fail(eye == GEYE_LEFT || eye == GEYE_RIGHT, FALSE);
+
+    offset = extended_eye_offset(sample, eye, GEYE_SAMPLE_FIELD_RAW);
+    if (offset < 0)
+        return FALSE;
+    if (x)
+        *x = sample->values[offset];
+    if (y)
+        *y = sample->values[offset + 1];
+    return TRUE;
+}
+
+/**
+ * geye_extended_sample_get_unfiltered:
+ * @sample: a GEyeExtendedSample
+ * @eye: %GEYE_LEFT or %GEYE_RIGHT
+ * @x:(out)(optional): the x coordinate of @eye before it was smoothed
+ * @y:(out)(optional): the y coordinate of @eye before it was smoothed
+ *
+ * Returns: TRUE if the sample has the unfiltered gaze of @eye.
+ */
+gboolean
+geye_extended_sample_get_unfiltered(const GEyeExtendedSample *sample,
+                                    GEyeEyeType               eye,
+                                    gdouble                  *x,
+                                    gdouble                  *y)
+{
+    gint offset;
+
+    g_return_val_if_fail(sample != NULL, FALSE);
+    g_return_val_if_fail(eye == GEYE_LEFT || eye == GEYE_RIGHT, FALSE);
+
+    offset = extended_eye_offset(sample, eye, GEYE_SAMPLE_FIELD_UNFILTERED);
+    if (offset < 0)
+        return FALSE;
+    if (x)
+        *x = sample->values[offset];
+    if (y)
+        *y = sample->values[offset + 1];
+    return TRUE;
+}
+
+/**
+ * geye_extended_sample_get_velocity:
+ * @sample: a GEyeExtendedSample
+ * @eye: %GEYE_LEFT or %GEYE_RIGHT
+ * @vx:(out)(optional): the horizontal velocity of @eye in degrees per second
+ * @vy:(out)(optional): the vertical velocity of @eye in degrees per second
+ *
+ * The velocity is NAN until the differentiator has seen enough valid
+ * samples of @eye, or when the eyetracker didn't report the resolution.
+ *
+ * Returns: TRUE if the sample has the velocity of @eye.
+ */
+gboolean
+geye_extended_sample_get_velocity(const GEyeExtendedSample *sample,
+                                  GEyeEyeType               eye,
+                                  gdouble                  *vx,
+                                  gdouble                  *vy)
+{
+    gint offset;
+
+    g_return_val_if_fail(sample != NULL, FALSE);
+    g_return_val_if_fail(eye == GEYE_LEFT || eye == GEYE_RIGHT, FALSE);
+
+    offset = extended_eye_offset(sample, eye, GEYE_SAMPLE_FIELD_VELOCITY);
+    if (offset < 0)
+        return FALSE;
+    if (vx)
+        *vx = sample->values[offset];
+    if (vy)
+        *vy = sample->values[offset + 1];
+    return TRUE;
+}
+
+/**
+ * geye_extended_sample_get_acceleration:
+ * @sample: a GEyeExtendedSample
+ * @eye: %GEYE_LEFT or %GEYE_RIGHT
+ * @ax:(out)(optional): the horizontal acceleration of @eye in degrees per
+ *                      second²
+ * @ay:(out)(optional): the vertical acceleration of @eye in degrees per
+ *                      second²
+ *
+ * Like the velocity, the acceleration is NAN when it couldn't be computed.
+ *
+ * Returns: TRUE if the sample has the acceleration of @eye.
+ */
+gboolean
+geye_extended_sample_get_acceleration(const GEyeExtendedSample *sample,
+                                      GEyeEyeType               eye,
+                                      gdouble                  *ax,
+                                      gdouble                  *ay)
+{
+    gint offset;
+
+    g_return_val_if_fail(sample != NULL, FALSE);
+    g_return_val_if_fail(eye == GEYE_LEFT || eye == GEYE_RIGHT, FALSE);
+
+    offset = extended_eye_offset(sample, eye, GEYE_SAMPLE_FIELD_ACCELERATION);
+    if (offset < 0)
+        return FALSE;
+    if (ax)
+        *ax = sample->values[offset];
+    if (ay)
+        *ay = sample->values[offset + 1];
+    return TRUE;
+}
+
+/**
+ * geye_extended_sample_get_resolution:
+ * @sample: a GEyeExtendedSample
+ * @x:(out)(optional): the horizontal resolution in pixels per degree
+ * @y:(out)(optional): the vertical resolution in pixels per degree
+ *
+ * Returns: TRUE if the sample has the resolution.
+ */
+gboolean
+geye_extended_sample_get_resolution(const GEyeExtendedSample *sample,
+                                    gdouble                  *x,
+                                    gdouble                  *y)
+{
+    gint offset;
+
+    g_return_val_if_fail(sample != NULL, FALSE);
+
+    offset = extended_offset(sample, GEYE_SAMPLE_FIELD_RESOLUTION);
+    if (offset < 0)
+        return FALSE;
+    if (x)
+        *x = sample->values[offset];
+    if (y)
+        *y = sample->values[offset + 1];
+    return TRUE;
+}
+
+/**
+ * geye_extended_sample_get_status:
+ * @sample: a GEyeExtendedSample
+ * @status:(out)(optional): the status flags of the eyetracker
+ *
+ * Returns: TRUE if the sample has the status.
+ */
+gboolean
+geye_extended_sample_get_status(const GEyeExtendedSample *sample,
+                                guint                    *status)
+{
+    gint offset;
+
+    g_return_val_if_fail(sample != NULL, FALSE);
+
+    offset = extended_offset(sample, GEYE_SAMPLE_FIELD_STATUS);
+    if (offset < 0)
+        return FALSE;
+    if (status)
+        *status = (guint) sample->values[offset];
+    return TRUE;
+}
+
+GEyeFixation*
+geye_fixation_copy(const GEyeFixation *fixation)
+{
+    g_return_val_if_fail(fixation != NULL, NULL);
+
+    return g_slice_dup(GEyeFixation, fixation);
+}
+
+void
+geye_fixation_free(GEyeFixation *fixation)
+{
+    g_slice_free(GEyeFixation, fixation);
+}
+
+G_DEFINE_BOXED_TYPE(GEyeFixation, geye_fixation,
+                    geye_fixation_copy, geye_fixation_free)
+
+GEyeSaccade*
+geye_saccade_copy(const GEyeSaccade *saccade)
+{
+    g_return_val_if_fail(saccade != NULL, NULL);
+
+    return g_slice_dup(GEyeSaccade, saccade);
+}
+
+void
+geye_saccade_free(GEyeSaccade *saccade)
+{
+    g_slice_free(GEyeSaccade, saccade);
+}
+
+G_DEFINE_BOXED_TYPE(GEyeSaccade, geye_saccade,
+                    geye_saccade_copy, geye_saccade_free)
+
+GType
+geye_fixation_detection_get_type(void)
+{
+    static gsize detection_type = 0;
+
+    if (g_once_init_enter(&detection_type)) {
+        static const GEnumValue values[] = {
+            {GEYE_FIXATION_DETECTION_NONE,
+             "GEYE_FIXATION_DETECTION_NONE",
+             "none"},
+            {GEYE_FIXATION_DETECTION_VELOCITY,
+             "GEYE_FIXATION_DETECTION_VELOCITY",
+             "velocity"},
+            {GEYE_FIXATION_DETECTION_DISPERSION,
+             "GEYE_FIXATION_DETECTION_DISPERSION",
+             "dispersion"},
+            {0, NULL, NULL}
+        };
+        GType type = g_enum_register_static("GEyeFixationDetection", values);
+        g_once_init_leave(&detection_type, type);
+    }
+    return detection_type;
+}
+
+GType
+geye_smoothing_get_type(void)
+{
+    static gsize smoothing_type = 0;
+
+    if (g_once_init_enter(&smoothing_type)) {
+        static const GEnumValue values[] = {
+            {GEYE_SMOOTHING_NONE, "GEYE_SMOOTHING_NONE", "none"},
+            {GEYE_SMOOTHING_MOVING_AVERAGE,
+             "GEYE_SMOOTHING_MOVING_AVERAGE",
+             "moving-average"},
+            {GEYE_SMOOTHING_SAVITZKY_GOLAY,
+             "GEYE_SMOOTHING_SAVITZKY_GOLAY",
+             "savitzky-golay"},
+            {GEYE_SMOOTHING_ONE_EURO, "GEYE_SMOOTHING_ONE_EURO", "one-euro"},
+            {0, NULL, NULL}
+        };
+        GType type = g_enum_register_static("GEyeSmoothing", values);
+        g_once_init_leave(&smoothing_type, type);
+    }
+    return smoothing_type;
+}
+
+GType
+geye_differentiator_get_type(void)
+{
+    static gsize differentiator_type = 0;
+
+    if (g_once_init_enter(&differentiator_type)) {
+        static const GEnumValue values[] = {
+            {GEYE_DIFFERENTIATOR_TWO_POINT,
+             "GEYE_DIFFERENTIATOR_TWO_POINT",
+             "two-point"},
+            {GEYE_DIFFERENTIATOR_FIVE_POINT,
+             "GEYE_DIFFERENTIATOR_FIVE_POINT",
+             "five-point"},
+            {GEYE_DIFFERENTIATOR_SAVITZKY_GOLAY,
+             "GEYE_DIFFERENTIATOR_SAVITZKY_GOLAY",
+             "savitzky-golay"},
+            {0, NULL, NULL}
+        };
+        GType type = g_enum_register_static("GEyeDifferentiator", values);
+        g_once_init_leave(&differentiator_type, type);
+    }
+    return differentiator_type;
+}
@@ -50,6 +50,9 @@ typedef enum _GEyeEyeType{
  * @type: signals what event this is
  * @eye: tell which eye(s) this sample represents
  * @time: the time since some specific time in the past.
+ * @tracker_time: the time according to the clock of the eyetracker, in the
+ *                unit of the eyetracker, e.g. ms for an EyeLink. It is 0 when
+ *                unknown. See geye_eyetracker_tracker_to_host_time().
  *
  * This is something all events have together, they are of some type,
  * They relate to one eye or eg the average of both eyes, and they
@@ -59,6 +62,7 @@ typedef struct _GEyeEvent {
     GEyeEventType   type;
     GEyeEyeType     eye;
     gdouble         time;
+    gdouble         tracker_time;
 } GEyeEvent;
 
 /**
@@ -95,6 +99,324 @@ geye_sample_copy(const GEyeSample *sample);
 G_MODULE_EXPORT void
 geye_sample_free(GEyeSample *sample);
 
+/**
+ * GEyeBinocularSample:
+ * @parent: this is one kind of an eyevent, its eye member tells which eyes
+ *          were tracked.
+ * @valid: tells which of the eyes contain a valid coordinate, an eye may be
+ *         tracked, but missing in this sample, e.g. during a blink.
+ * @left_x: the x position of the left eye
+ * @left_y: the y position of the left eye
+ * @right_x: the x position of the right eye
+ * @right_y: the y position of the right eye
+ *
+ * This struct specifies where both eyes were measured at one time point.
+ */
+typedef struct _GEyeBinocularSample {
+    GEyeEvent       parent;
+    GEyeEyeType     valid;
+    gdouble         left_x;
+    gdouble         left_y;
+    gdouble         right_x;
+    gdouble         right_y;
+} GEyeBinocularSample;
+
+#define GEYE_TYPE_BINOCULAR_SAMPLE geye_binocular_sample_get_type()
+G_MODULE_EXPORT GType
+geye_binocular_sample_get_type(void);
+
+G_MODULE_EXPORT GEyeBinocularSample*
+geye_binocular_sample_new(GEyeEyeType   eye,
+                          GEyeEyeType   valid,
+                          gdouble       time,
+                          gdouble       left_x,
+                          gdouble       left_y,
+                          gdouble       right_x,
+                          gdouble       right_y);
+
+G_MODULE_EXPORT GEyeBinocularSample*
+geye_binocular_sample_copy(const GEyeBinocularSample *sample);
+
+G_MODULE_EXPORT void
+geye_binocular_sample_free(GEyeBinocularSample *sample);
+
+G_MODULE_EXPORT gboolean
+geye_binocular_sample_get_eye(const GEyeBinocularSample *sample,
+                              GEyeEyeType                eye,
+                              gdouble                   *x,
+                              gdouble                   *y);
+
+/**
+ * GEyeSampleFields:
+ * @GEYE_SAMPLE_FIELD_NONE: only the gaze, which every sample has.
+ * @GEYE_SAMPLE_FIELD_PUPIL: the size of the pupil, in the unit of the
+ *                           eyetracker, an area or a diameter.
+ * @GEYE_SAMPLE_FIELD_HREF: the head referenced position of the eye.
+ * @GEYE_SAMPLE_FIELD_RAW: the raw position of the pupil in the camera image.
+ * @GEYE_SAMPLE_FIELD_RESOLUTION: the angular resolution in pixels per degree
+ *                                at the gaze position.
+ * @GEYE_SAMPLE_FIELD_STATUS: the status flags of the eyetracker.
+ * @GEYE_SAMPLE_FIELD_UNFILTERED: the gaze before it was smoothed, see
+ *                                #GEyeEyelinkEt:smoothing.
+ * @GEYE_SAMPLE_FIELD_VELOCITY: the velocity of the gaze in degrees per
+ *                              second, see #GEyeEyelinkEt:differentiator.
+ * @GEYE_SAMPLE_FIELD_ACCELERATION: the acceleration of the gaze in degrees
+ *                                  per second².
+ *
+ * Selects the fields that a #GEyeExtendedSample carries in addition to the
+ * gaze.
+ */
+typedef enum _GEyeSampleFields {
+    GEYE_SAMPLE_FIELD_NONE          = 0,
+    GEYE_SAMPLE_FIELD_PUPIL         = 1 << 0,
+    GEYE_SAMPLE_FIELD_HREF          = 1 << 1,
+    GEYE_SAMPLE_FIELD_RAW           = 1 << 2,
+    GEYE_SAMPLE_FIELD_RESOLUTION    = 1 << 3,
+    GEYE_SAMPLE_FIELD_STATUS        = 1 << 4,
+    GEYE_SAMPLE_FIELD_UNFILTERED    = 1 << 5,
+    GEYE_SAMPLE_FIELD_VELOCITY      = 1 << 6,
+    GEYE_SAMPLE_FIELD_ACCELERATION  = 1 << 7,
+} GEyeSampleFields;
+
+#define GEYE_TYPE_SAMPLE_FIELDS geye_sample_fields_get_type()
+G_MODULE_EXPORT GType
+geye_sample_fields_get_type(void);
+
+/*
+ * The gaze, pupil, HREF, raw and unfiltered position, velocity and
+ * acceleration of two eyes, the resolution and the status.
+ */
+#define GEYE_EXTENDED_SAMPLE_MAX_VALUES 29
+
+/**
+ * GEyeExtendedSample:
+ * @parent: this is one kind of an eyevent, its eye member tells which eyes
+ *          were tracked.
+ * @valid: tells which of the eyes contain a valid gaze position.
+ * @fields: the fields in @values
+ * @values: the values of the selected fields only, packed. For every tracked
+ *          eye, left first, the gaze x and y, followed by the pupil size,
+ *          the HREF x and y, the raw x and y, the unfiltered x and y, the
+ *          velocity x and y and the acceleration x and y if selected.
+ *          After the eyes
+ *          the resolution x and y and the status follow if selected. Use
+ *          the accessors rather than computing the offsets yourself.
+ *
+ * A sample with the fields of #GEyeEyetracker:sample-fields.
+ */
+typedef struct _GEyeExtendedSample {
+    GEyeEvent           parent;
+    GEyeEyeType         valid;
+    GEyeSampleFields    fields;
+    gdouble             values[GEYE_EXTENDED_SAMPLE_MAX_VALUES];
+} GEyeExtendedSample;
+
+#define GEYE_TYPE_EXTENDED_SAMPLE geye_extended_sample_get_type()
+G_MODULE_EXPORT GType
+geye_extended_sample_get_type(void);
+
+G_MODULE_EXPORT GEyeExtendedSample*
+geye_extended_sample_copy(const GEyeExtendedSample *sample);
+
+G_MODULE_EXPORT void
+geye_extended_sample_free(GEyeExtendedSample *sample);
+
+G_MODULE_EXPORT guint
+geye_extended_sample_get_n_values(GEyeSampleFields fields, GEyeEyeType eyes);
+
+G_MODULE_EXPORT gboolean
+geye_extended_sample_get_gaze(const GEyeExtendedSample *sample,
+                              GEyeEyeType               eye,
+                              gdouble                  *x,
+                              gdouble                  *y);
+
+G_MODULE_EXPORT gboolean
+geye_extended_sample_get_pupil(const GEyeExtendedSample *sample,
+                               GEyeEyeType               eye,
+                               gdouble                  *size);
+
+G_MODULE_EXPORT gboolean
+geye_extended_sample_get_href(const GEyeExtendedSample *sample,
+                              GEyeEyeType               eye,
+                              gdouble                  *x,
+                              gdouble                  *y);
+
+G_MODULE_EXPORT gboolean
+geye_extended_sample_get_raw(const GEyeExtendedSample *sample,
+                             GEyeEyeType               eye,
+                             gdouble                  *x,
+                             gdouble                  *y);
+
+G_MODULE_EXPORT gboolean
+geye_extended_sample_get_unfiltered(const GEyeExtendedSample *sample,
+                                    GEyeEyeType               eye,
+                                    gdouble                  *x,
+                                    gdouble                  *y);
+
+G_MODULE_EXPORT gboolean
+geye_extended_sample_get_velocity(const GEyeExtendedSample *sample,
+                                  GEyeEyeType               eye,
+                                  gdouble                  *vx,
+                                  gdouble                  *vy);
+
+G_MODULE_EXPORT gboolean
+geye_extended_sample_get_acceleration(const GEyeExtendedSample *sample,
+                                      GEyeEyeType               eye,
+                                      gdouble                  *ax,
+                                      gdouble                  *ay);
+
+G_MODULE_EXPORT gboolean
+geye_extended_sample_get_resolution(const GEyeExtendedSample *sample,
+                                    gdouble                  *x,
+                                    gdouble                  *y);
+
+G_MODULE_EXPORT gboolean
+geye_extended_sample_get_status(const GEyeExtendedSample *sample,
+                                guint                    *status);
+
+/**
+ * GEyeFixation:
+ * @parent: the start of the fixation, its type is %GEYE_EVENT_FIX_START or
+ *          %GEYE_EVENT_FIX_END.
+ * @end_time: the time at which the fixation ended, in the same clock as
+ *            #GEyeEvent.time.
+ * @x: the average x position during the fixation
+ * @y: the average y position during the fixation
+ *
+ * A fixation as it was detected by the eyetracker. For a
+ * %GEYE_EVENT_FIX_START the fixation is still going on, then @end_time
+ * equals the start and @x and @y are the position at the start.
+ */
+typedef struct _GEyeFixation {
+    GEyeEvent       parent;
+    gdouble         end_time;
+    gdouble         x;
+    gdouble         y;
+} GEyeFixation;
+
+#define GEYE_TYPE_FIXATION geye_fixation_get_type()
+G_MODULE_EXPORT GType
+geye_fixation_get_type(void);
+
+G_MODULE_EXPORT GEyeFixation*
+geye_fixation_copy(const GEyeFixation *fixation);
+
+G_MODULE_EXPORT void
+geye_fixation_free(GEyeFixation *fixation);
+
+/**
+ * GEyeSaccade:
+ * @parent: the start of the saccade, its type is %GEYE_EVENT_SAC_START or
+ *          %GEYE_EVENT_SAC_END.
+ * @end_time: the time at which the saccade ended, in the same clock as
+ *            #GEyeEvent.time.
+ * @start_x: the x position at the start of the saccade
+ * @start_y: the y position at the start of the saccade
+ * @end_x: the x position at the end of the saccade
+ * @end_y: the y position at the end of the saccade
+ * @amplitude: the amplitude in degrees of visual angle
+ * @peak_velocity: the peak velocity in degrees per second
+ *
+ * A saccade as it was detected by the eyetracker. For a
+ * %GEYE_EVENT_SAC_START only the start is known, the other members equal
+ * the start or are 0.
+ */
+typedef struct _GEyeSaccade {
+    GEyeEvent       parent;
+    gdouble         end_time;
+    gdouble         start_x;
+    gdouble         start_y;
+    gdouble         end_x;
+    gdouble         end_y;
+    gdouble         amplitude;
+    gdouble         peak_velocity;
+} GEyeSaccade;
+
+#define GEYE_TYPE_SACCADE geye_saccade_get_type()
+G_MODULE_EXPORT GType
+geye_saccade_get_type(void);
+
+G_MODULE_EXPORT GEyeSaccade*
+geye_saccade_copy(const GEyeSaccade *saccade);
+
+G_MODULE_EXPORT void
+geye_saccade_free(GEyeSaccade *saccade);
+
+/**
+ * GEyeFixationDetection:
+ * @GEYE_FIXATION_DETECTION_NONE: fixations are not detected on the host.
+ * @GEYE_FIXATION_DETECTION_VELOCITY: a fixation lasts while the velocity
+ *                                    between consecutive samples stays below
+ *                                    a threshold (I-VT).
+ * @GEYE_FIXATION_DETECTION_DISPERSION: a fixation lasts while the dispersion
+ *                                      of its samples stays below a
+ *                                      threshold (I-DT).
+ *
+ * The algorithm with which fixations are detected from the samples on
+ * the host, rather than by the eyetracker.
+ */
+typedef enum _GEyeFixationDetection {
+    GEYE_FIXATION_DETECTION_NONE,
+    GEYE_FIXATION_DETECTION_VELOCITY,
+    GEYE_FIXATION_DETECTION_DISPERSION,
+} GEyeFixationDetection;
+
+#define GEYE_TYPE_FIXATION_DETECTION geye_fixation_detection_get_type()
+G_MODULE_EXPORT GType
+geye_fixation_detection_get_type(void);
+
+/**
+ * GEyeSmoothing:
+ * @GEYE_SMOOTHING_NONE: the gaze is delivered as the eyetracker measured it.
+ * @GEYE_SMOOTHING_MOVING_AVERAGE: the average of the last samples.
+ * @GEYE_SMOOTHING_SAVITZKY_GOLAY: a quadratic fitted to the last samples,
+ *                                 evaluated at the newest one. It smooths
+ *                                 less than the moving average, but keeps
+ *                                 up with saccades better.
+ * @GEYE_SMOOTHING_ONE_EURO: the 1€ filter, a low pass filter whose cutoff
+ *                           frequency rises with the velocity of the eye, so
+ *                           fixations are smoothed strongly and saccades
+ *                           hardly lag.
+ *
+ * The filter with which the gaze is smoothed on the host, before it is
+ * delivered. All are causal, they only use the current and past samples.
+ */
+typedef enum _GEyeSmoothing {
+    GEYE_SMOOTHING_NONE,
+    GEYE_SMOOTHING_MOVING_AVERAGE,
+    GEYE_SMOOTHING_SAVITZKY_GOLAY,
+    GEYE_SMOOTHING_ONE_EURO,
+} GEyeSmoothing;
+
+#define GEYE_TYPE_SMOOTHING geye_smoothing_get_type()
+G_MODULE_EXPORT GType
+geye_smoothing_get_type(void);
+
+/**
+ * GEyeDifferentiator:
+ * @GEYE_DIFFERENTIATOR_TWO_POINT: the difference with the previous sample,
+ *                                 without delay, but noisy.
+ * @GEYE_DIFFERENTIATOR_FIVE_POINT: the central difference over the last
+ *                                  five samples, which suppresses the noise
+ *                                  but describes the sample of two samples
+ *                                  ago.
+ * @GEYE_DIFFERENTIATOR_SAVITZKY_GOLAY: the derivatives of a quadratic fitted
+ *                                      to the last samples, at the newest
+ *                                      one.
+ *
+ * How the velocity and acceleration of the gaze are computed from the
+ * positions.
+ */
+typedef enum _GEyeDifferentiator {
+    GEYE_DIFFERENTIATOR_TWO_POINT,
+    GEYE_DIFFERENTIATOR_FIVE_POINT,
+    GEYE_DIFFERENTIATOR_SAVITZKY_GOLAY,
+} GEyeDifferentiator;
+
+#define GEYE_TYPE_DIFFERENTIATOR geye_differentiator_get_type()
+G_MODULE_EXPORT GType
+geye_differentiator_get_type(void);
+
 G_END_DECLS 
 
 #endif 
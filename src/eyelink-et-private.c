@@ -19,14 +19,36 @@
  */
 
 #include "eyelink-et-private.h"
+#include "aoi-set-private.h"
+#include "clock-map.h"
 #include "eye-event.h"
 #include "eyetracker-error.h"
+#include "fixation-detector.h"
+#include "gaze-filter.h"
+#include "gaze-velocity.h"
+#include "latency-histogram.h"
+#include "realtime.h"
+#include "recorder.h"
+#include "sample-broadcast.h"
+#include "sample-dispatch.h"
+#include "sample-ring.h"
+#include "sample-slot.h"
 #include <EyeLink/core_expt.h>
 #include <EyeLink/eye_data.h>
 #include <EyeLink/eyelink.h>
+#include <math.h>
 
 static const char* EYELINK_THREAD_NAME = "Eyelink-thread";
 static gsize       EYELINK_PIXEL_SIZE = 4; //RGBA
+static gint        EYELINK_LATENCY_WEIGHT = 16; // drains in the running average
+// How long the tracker may take to reply to eyelink_read_request() in µs.
+static gint64      EYELINK_READ_TIMEOUT = 500000;
+// The link_sample_data when the tracker doesn't tell.
+static const char* EYELINK_LINK_SAMPLE_DATA = "LEFT,RIGHT,GAZE,GAZERES,AREA,STATUS";
+
+// Handed to the Eyelink-thread when the set of areas of interest is detached.
+static gchar       eyelink_aoi_none;
+#define EYELINK_AOI_NONE ((gpointer) &eyelink_aoi_none)
 
 typedef enum {
     ET_STOP,
@@ -41,7 +63,14 @@ typedef enum {
     ET_STOP_SETUP,
     ET_SETUP_KEY,
     ET_CALIBRATE,
-    ET_VALIDATE
+    ET_VALIDATE,
+    ET_APPLY_REALTIME,
+    ET_CONFIGURE_FIXATIONS,
+    ET_CONFIGURE_SMOOTHING,
+    ET_CONFIGURE_VELOCITY,
+    ET_START_HOST_RECORDING,
+    ET_STOP_HOST_RECORDING,
+    ET_LOG_MESSAGE
 } ThreadMsgType;
 
 
@@ -50,6 +79,11 @@ typedef struct {
     union ThreadContent {
         InputEvent      event;
         guint           num_calpoints;
+        GEyeRecorder   *recorder;
+        struct {
+            gdouble     time;
+            gchar      *text;
+        } message;
     } content;
 } ThreadMsg;
 
@@ -58,7 +92,6 @@ et_send_message(GEyeEyelinkEt* self, ThreadMsg* msg) {
     g_async_queue_push(self->instance_to_thread, msg);
 }
 
-/*
 static ThreadMsg*
 et_receive_reply(GEyeEyelinkEt* self)
 {
@@ -66,6 +99,7 @@ et_receive_reply(GEyeEyelinkEt* self)
     return msg;
 }
 
+/*
 static ThreadMsg*
 et_receive_reply_timeout(GEyeEyelinkEt* self, guint64 timeout_us)
 {
@@ -148,42 +182,6 @@ error_info_free(gpointer data)
     g_free(info);
 }
 
-typedef struct sample_info {
-    GEyeEyetracker *et;
-    GEyeSample     *sample;
-} sample_info;
-
-/**
- * sample_info_create:
- * @et: the eyetracker on which the signal is to be emitted
- * @sample:(transfer full): the sample to be emmited
- *
- * Create a data holder to emit samples in the context in which
- * the eyetracker has been created.
- */
-static sample_info*
-sample_info_create(GEyeEyetracker* et, GEyeSample* sample) {
-    sample_info* ret = g_slice_new(sample_info);
-    ret->et = g_object_ref(et);
-    ret->sample = sample;
-    return ret;
-}
-
-/**
- * sample_info_free:
- * @info: a `sample_info` previously created with sample_info_create
- *
- * release the resources of a sample_info
- */
-static void
-sample_info_free(gpointer data)
-{
-    sample_info *info = data;
-    g_object_unref(info->et);
-    geye_sample_free(info->sample);
-    g_slice_free(sample_info, info);
-}
-
 static gint
 emit_connected(gpointer data)
 {
@@ -191,6 +189,7 @@ emit_connected(gpointer data)
     g_assert(g_main_context_is_owner(
             GEYE_EYELINK_ET(info->self)->main_context));
 
+    eyelink_et_watch_counters(GEYE_EYELINK_ET(info->self), info->connected);
     g_signal_emit_by_name(
             info->self,
             "connected", info->connected);
@@ -252,46 +251,635 @@ et_signal_error_printf(GEyeEyelinkEt* self, const gchar* format, ...)
     }
 }
 
-static gint
-emit_sample(gpointer data) {
-    sample_info* info = data;
-    g_assert(g_main_context_is_owner(
-                GEYE_EYELINK_ET(info->et)->main_context));
+/*
+ * Relates the clock of the tracker to the clock of the host. This is done
+ * once for every drain of the link, the samples are timed by the tracker.
+ */
+static void
+update_clock_map(GEyeEyelinkEt* self)
+{
+    geye_clock_map_update(
+            self->clock_map,
+            eyelink_tracker_double_usec(),
+            g_get_monotonic_time()
+            );
+}
 
-    g_signal_emit_by_name(info->et, "sample", info->sample);
-    return G_SOURCE_REMOVE;
+/*
+ * Converts a time of the tracker in ms to seconds since the creation of
+ * the eyetracker, the unit of GEyeEvent.time.
+ */
+static gdouble
+event_time(GEyeEyelinkEt* self, gdouble tracker_ms)
+{
+    gint64 host_us = geye_clock_map_to_host(self->clock_map, tracker_ms * 1000);
+    return (host_us - self->start_time) / (gdouble) G_USEC_PER_SEC;
 }
 
 static void
-send_sample_event(GEyeEyelinkEt* self, ALLD_DATA event, gdouble time)
+make_binocular_sample(const ALLD_DATA      *event,
+                      GEyeEyeType           used_eye,
+                      gdouble               time,
+                      GEyeBinocularSample  *out)
 {
-    if (self->main_context) {
-        sample_info *info = NULL;
-        GEyeSample *left = NULL, *right = NULL;
-        if (self->used_eye & GEYE_LEFT)
-            left = geye_sample_new(GEYE_LEFT, time, event.fs.gx[LEFT], event.fs.gy[LEFT]);
-        if (self->used_eye & GEYE_RIGHT)
-            right = geye_sample_new(GEYE_RIGHT, time, event.fs.gx[RIGHT], event.fs.gy[RIGHT]);
-
-        if (left) {
-            info = sample_info_create(GEYE_EYETRACKER(self), left);
-            g_main_context_invoke_full(
-                    self->main_context,
-                    G_PRIORITY_DEFAULT,
-                    emit_sample,
-                    info,
-                    sample_info_free);
+    GEyeBinocularSample sample = {
+        .parent = {
+            .type = GEYE_EVENT_SAMPLE,
+            .eye  = used_eye,
+            .time = time,
+            .tracker_time = event->fs.time
+        },
+        .valid   = GEYE_NONE,
+        .left_x  = event->fs.gx[LEFT],
+        .left_y  = event->fs.gy[LEFT],
+        .right_x = event->fs.gx[RIGHT],
+        .right_y = event->fs.gy[RIGHT]
+    };
+
+    if (event->fs.gx[LEFT] != MISSING_DATA && event->fs.gy[LEFT] != MISSING_DATA)
+        sample.valid |= GEYE_LEFT;
+    if (event->fs.gx[RIGHT] != MISSING_DATA && event->fs.gy[RIGHT] != MISSING_DATA)
+        sample.valid |= GEYE_RIGHT;
+    sample.valid &= used_eye;
+
+    *out = sample;
+}
+
+/*
+ * Sends a fixation to the signals and to the host recording, if any.
+ */
+static void
+dispatch_fixation(GEyeEyelinkEt *self, const GEyeFixation *fixation)
+{
+    if (self->recorder)
+        geye_recorder_fixation(self->recorder, fixation);
+    geye_sample_dispatch_fixation(self->dispatch, fixation);
+}
+
+/*
+ * Feeds a sample to the fixation detector of its eye, missing data ends
+ * the fixation.
+ */
+static void
+detect_fixations(GEyeEyelinkEt *self, const GEyeSample *sample, gboolean valid)
+{
+    GEyeFixationDetector *detector =
+        self->fixation_detectors[sample->parent.eye == GEYE_LEFT ? 0 : 1];
+    GEyeFixation events[GEYE_FIXATION_DETECTOR_MAX_EVENTS];
+    guint n = 0, i;
+
+    if (valid)
+        n = geye_fixation_detector_push(detector, sample, events);
+    else if (geye_fixation_detector_end(detector, &events[0]))
+        n = 1;
+
+    for (i = 0; i < n; i++)
+        dispatch_fixation(self, &events[i]);
+}
+
+static void
+aoi_dispatch(GEyeAoiSet    *set,
+             guint          aoi,
+             gboolean       enter,
+             gdouble        time,
+             gdouble        dwell,
+             gpointer       data)
+{
+    GEyeEyelinkEt *self = data;
+    geye_sample_dispatch_aoi(self->dispatch, set, aoi, enter, time, dwell);
+}
+
+/* The current time in the unit of GEyeEvent.time. */
+static gdouble
+now_time(GEyeEyelinkEt *self)
+{
+    return (g_get_monotonic_time() - self->start_time) / (gdouble) G_USEC_PER_SEC;
+}
+
+/*
+ * Picks up the set of areas of interest that was attached in the meantime.
+ * The gaze leaves the areas of the previous set and the reference of the
+ * thread on it is dropped in the main context, after its last events. As
+ * long as that doesn't fit in the dispatch, the new set waits.
+ */
+static void
+aoi_swap(GEyeEyelinkEt *self)
+{
+    gpointer next;
+
+    if (self->aoi_retired &&
+            geye_sample_dispatch_unref(self->dispatch, self->aoi_retired))
+        self->aoi_retired = NULL;
+
+    if (self->aoi_retired || !g_atomic_pointer_get(&self->aoi_pending))
+        return;
+
+    do {
+        next = g_atomic_pointer_get(&self->aoi_pending);
+    } while (!g_atomic_pointer_compare_and_exchange(
+                &self->aoi_pending, next, NULL)
+            );
+
+    if (self->aoi_current) {
+        geye_aoi_set_leave_all(
+                self->aoi_current, now_time(self), aoi_dispatch, self
+                );
+        geye_aoi_set_detach(self->aoi_current);
+        if (!geye_sample_dispatch_unref(self->dispatch, self->aoi_current))
+            self->aoi_retired = self->aoi_current;
+    }
+    self->aoi_current = next == EYELINK_AOI_NONE ? NULL : next;
+    geye_sample_dispatch_flush(self->dispatch);
+}
+
+/*
+ * Looks up the areas of interest that contain the gaze, that is the average
+ * of the valid eyes.
+ */
+static void
+detect_aois(GEyeEyelinkEt *self, const GEyeBinocularSample *sample)
+{
+    gdouble x = 0, y = 0;
+    guint n = 0;
+
+    if (sample->valid & GEYE_LEFT) {
+        x += sample->left_x;
+        y += sample->left_y;
+        n++;
+    }
+    if (sample->valid & GEYE_RIGHT) {
+        x += sample->right_x;
+        y += sample->right_y;
+        n++;
+    }
+    if (n == 0)
+        return;
+
+    geye_aoi_set_update(
+            self->aoi_current, x / n, y / n, sample->parent.time,
+            aoi_dispatch, self
+            );
+}
+
+/*
+ * Reports the end of the fixations that are going on, when no samples
+ * follow anymore.
+ */
+static void
+end_fixations(GEyeEyelinkEt* self)
+{
+    GEyeFixation event;
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(self->fixation_detectors); i++)
+        if (geye_fixation_detector_end(self->fixation_detectors[i], &event))
+            dispatch_fixation(self, &event);
+    geye_sample_dispatch_flush(self->dispatch);
+}
+
+/* The velocity and acceleration of the gaze of one eye, in degrees. */
+typedef struct {
+    gdouble velocity[2];
+    gdouble acceleration[2];
+} EyeMotion;
+
+/*
+ * Converters of the fields of an extended sample, they return the number
+ * of values. The generic one handles every combination of fields, the
+ * others the common ones without testing each field for every sample.
+ */
+typedef guint (*ExtendedConvert)(const DSAMPLE             *sample,
+                                 const GEyeBinocularSample *gaze,
+                                 const EyeMotion           *motion,
+                                 GEyeSampleFields           fields,
+                                 gdouble                   *values);
+
+static guint
+extended_convert_generic(const DSAMPLE             *sample,
+                         const GEyeBinocularSample *gaze,
+                         const EyeMotion           *motion,
+                         GEyeSampleFields           fields,
+                         gdouble                   *values)
+{
+    static const GEyeEyeType geye_eyes[] = {GEYE_LEFT, GEYE_RIGHT};
+    static const int eyelink_eyes[] = {LEFT, RIGHT};
+    const gdouble gaze_x[] = {gaze->left_x, gaze->right_x};
+    const gdouble gaze_y[] = {gaze->left_y, gaze->right_y};
+    guint n = 0, i;
+
+    for (i = 0; i < G_N_ELEMENTS(geye_eyes); i++) {
+        int eye = eyelink_eyes[i];
+        if (!(gaze->parent.eye & geye_eyes[i]))
+            continue;
+        values[n++] = gaze_x[i];
+        values[n++] = gaze_y[i];
+        if (fields & GEYE_SAMPLE_FIELD_PUPIL)
+            values[n++] = sample->pa[eye];
+        if (fields & GEYE_SAMPLE_FIELD_HREF) {
+            values[n++] = sample->hx[eye];
+            values[n++] = sample->hy[eye];
+        }
+        if (fields & GEYE_SAMPLE_FIELD_RAW) {
+            values[n++] = sample->px[eye];
+            values[n++] = sample->py[eye];
+        }
+        if (fields & GEYE_SAMPLE_FIELD_UNFILTERED) {
+            values[n++] = sample->gx[eye];
+            values[n++] = sample->gy[eye];
+        }
+        if (fields & GEYE_SAMPLE_FIELD_VELOCITY) {
+            values[n++] = motion[i].velocity[0];
+            values[n++] = motion[i].velocity[1];
         }
-        if (right) {
-            info = sample_info_create(GEYE_EYETRACKER(self), right);
-            g_main_context_invoke_full(
-                    self->main_context,
-                    G_PRIORITY_DEFAULT,
-                    emit_sample,
-                    info,
-                    sample_info_free);
+        if (fields & GEYE_SAMPLE_FIELD_ACCELERATION) {
+            values[n++] = motion[i].acceleration[0];
+            values[n++] = motion[i].acceleration[1];
         }
     }
+    if (fields & GEYE_SAMPLE_FIELD_RESOLUTION) {
+        values[n++] = sample->rx;
+        values[n++] = sample->ry;
+    }
+    if (fields & GEYE_SAMPLE_FIELD_STATUS)
+        values[n++] = sample->status;
+    return n;
+}
+
+/* GEYE_SAMPLE_FIELD_PUPIL, for pupillometry. */
+static guint
+extended_convert_pupil(const DSAMPLE               *sample,
+                       const GEyeBinocularSample   *gaze,
+                       const EyeMotion             *motion,
+                       GEyeSampleFields             fields,
+                       gdouble                     *values)
+{
+    guint n = 0;
+    (void) motion;
+    (void) fields;
+
+    if (gaze->parent.eye & GEYE_LEFT) {
+        values[n++] = gaze->left_x;
+        values[n++] = gaze->left_y;
+        values[n++] = sample->pa[LEFT];
+    }
+    if (gaze->parent.eye & GEYE_RIGHT) {
+        values[n++] = gaze->right_x;
+        values[n++] = gaze->right_y;
+        values[n++] = sample->pa[RIGHT];
+    }
+    return n;
+}
+
+/* GEYE_SAMPLE_FIELD_RESOLUTION, to convert the gaze to degrees. */
+static guint
+extended_convert_resolution(const DSAMPLE              *sample,
+                            const GEyeBinocularSample  *gaze,
+                            const EyeMotion            *motion,
+                            GEyeSampleFields            fields,
+                            gdouble                    *values)
+{
+    guint n = 0;
+    (void) motion;
+    (void) fields;
+
+    if (gaze->parent.eye & GEYE_LEFT) {
+        values[n++] = gaze->left_x;
+        values[n++] = gaze->left_y;
+    }
+    if (gaze->parent.eye & GEYE_RIGHT) {
+        values[n++] = gaze->right_x;
+        values[n++] = gaze->right_y;
+    }
+    values[n++] = sample->rx;
+    values[n++] = sample->ry;
+    return n;
+}
+
+static ExtendedConvert
+extended_converter(GEyeSampleFields fields)
+{
+    switch (fields) {
+        case GEYE_SAMPLE_FIELD_PUPIL:
+            return extended_convert_pupil;
+        case GEYE_SAMPLE_FIELD_RESOLUTION:
+            return extended_convert_resolution;
+        default:
+            return extended_convert_generic;
+    }
+}
+
+/*
+ * What the Eyelink-thread does with the samples, taken once for every drain
+ * of the link.
+ */
+typedef struct {
+    GEyeEyeType         used_eye;
+    guint               delivery;
+    gboolean            detect;
+    gboolean            smooth;
+    gboolean            differentiate;
+    GEyeSampleFields    fields;
+    ExtendedConvert     convert;
+} SampleOptions;
+
+static void
+send_extended_sample(GEyeEyelinkEt             *self,
+                     const ALLD_DATA           *event,
+                     const GEyeBinocularSample *binocular,
+                     const EyeMotion           *motion,
+                     const SampleOptions       *options)
+{
+    GEyeExtendedSample extended = {
+        .parent = binocular->parent,
+        .valid  = binocular->valid,
+        .fields = options->fields
+    };
+
+    options->convert(
+            &event->fs, binocular, motion, options->fields, extended.values
+            );
+    geye_sample_dispatch_extended(self->dispatch, &extended);
+}
+
+/*
+ * Smooths the gaze of one eye, missing data restarts the filter.
+ */
+static void
+smooth_eye(GEyeGazeFilter  *filter,
+           gboolean         valid,
+           gdouble          time,
+           gdouble         *x,
+           gdouble         *y)
+{
+    if (valid)
+        geye_gaze_filter_step(filter, time, x, y);
+    else
+        geye_gaze_filter_reset(filter);
+}
+
+static void
+smooth_sample(GEyeEyelinkEt *self, GEyeBinocularSample *sample)
+{
+    if (sample->parent.eye & GEYE_LEFT)
+        smooth_eye(self->gaze_filters[0],
+                   sample->valid & GEYE_LEFT,
+                   sample->parent.time,
+                   &sample->left_x,
+                   &sample->left_y);
+    if (sample->parent.eye & GEYE_RIGHT)
+        smooth_eye(self->gaze_filters[1],
+                   sample->valid & GEYE_RIGHT,
+                   sample->parent.time,
+                   &sample->right_x,
+                   &sample->right_y);
+}
+
+/*
+ * Differentiates the gaze of one eye and converts it to degrees with the
+ * resolution of the eyetracker, missing data restarts the differentiator.
+ */
+static void
+differentiate_eye(GEyeGazeVelocity *velocity,
+                  gboolean          valid,
+                  gdouble           time,
+                  gdouble           x,
+                  gdouble           y,
+                  const DSAMPLE    *sample,
+                  EyeMotion        *motion)
+{
+    gdouble rx = sample->rx > 0 ? sample->rx : NAN;
+    gdouble ry = sample->ry > 0 ? sample->ry : NAN;
+    gdouble v[2], a[2];
+
+    if (!valid) {
+        geye_gaze_velocity_reset(velocity);
+        v[0] = v[1] = a[0] = a[1] = NAN;
+    }
+    else
+        geye_gaze_velocity_push(velocity, time, x, y, v, a);
+
+    motion->velocity[0] = v[0] / rx;
+    motion->velocity[1] = v[1] / ry;
+    motion->acceleration[0] = a[0] / rx;
+    motion->acceleration[1] = a[1] / ry;
+}
+
+/*
+ * The velocity is computed from the timestamps of the eyetracker, they are
+ * free of the jitter of the host.
+ */
+static void
+differentiate_sample(GEyeEyelinkEt             *self,
+                     const DSAMPLE             *sample,
+                     const GEyeBinocularSample *binocular,
+                     EyeMotion                 *motion)
+{
+    gdouble time = sample->time / 1000.0;
+
+    if (binocular->parent.eye & GEYE_LEFT)
+        differentiate_eye(self->gaze_velocities[0],
+                          binocular->valid & GEYE_LEFT,
+                          time,
+                          binocular->left_x,
+                          binocular->left_y,
+                          sample,
+                          &motion[0]);
+    if (binocular->parent.eye & GEYE_RIGHT)
+        differentiate_eye(self->gaze_velocities[1],
+                          binocular->valid & GEYE_RIGHT,
+                          time,
+                          binocular->right_x,
+                          binocular->right_y,
+                          sample,
+                          &motion[1]);
+}
+
+/*
+ * Measures the link of a sample on the Eyelink-thread, the dispatch
+ * measures the stages in the main context from the time its batch was
+ * received. This doesn't read the clock, handle_events() does once per
+ * batch.
+ */
+static void
+measure_latency(GEyeEyelinkEt *self, gint64 sampled, gint64 received)
+{
+    if (sampled)
+        geye_latency_histogram_record(
+                self->latency[GEYE_LATENCY_LINK], received - sampled
+                );
+    geye_sample_dispatch_stamp(self->dispatch, sampled, received);
+}
+
+/*
+ * received is the host time at which eyelink_get_next_data() returned the
+ * first event of the batch of the sample.
+ */
+static void
+send_sample_event(GEyeEyelinkEt        *self,
+                  const ALLD_DATA      *event,
+                  gint64                received,
+                  const SampleOptions  *options)
+{
+    GEyeSample samples[2];
+    GEyeBinocularSample binocular;
+    EyeMotion motion[2];
+    GEyeEyeType used_eye = options->used_eye;
+    guint delivery = options->delivery;
+    guint n = 0, i;
+    // 0 while the clocks haven't been mapped yet.
+    gint64 sampled = geye_clock_map_to_host(
+            self->clock_map, event->fs.time * 1000
+            );
+    gdouble time = (sampled - self->start_time) / (gdouble) G_USEC_PER_SEC;
+
+    make_binocular_sample(event, used_eye, time, &binocular);
+    // The host recording keeps the gaze as it was measured.
+    if (self->recorder)
+        geye_recorder_sample(self->recorder, &binocular);
+    if (options->smooth)
+        smooth_sample(self, &binocular);
+    if (options->differentiate)
+        differentiate_sample(self, &event->fs, &binocular, motion);
+    geye_sample_slot_store(self->latest_sample, &binocular);
+    geye_sample_broadcast_push(self->broadcast, &binocular);
+    if (self->aoi_current)
+        detect_aois(self, &binocular);
+    measure_latency(self, sampled, received);
+
+    if (used_eye & GEYE_LEFT) {
+        samples[n].parent.type = GEYE_EVENT_SAMPLE;
+        samples[n].parent.eye  = GEYE_LEFT;
+        samples[n].parent.time = time;
+        samples[n].parent.tracker_time = event->fs.time;
+        samples[n].x = binocular.left_x;
+        samples[n].y = binocular.left_y;
+        n++;
+    }
+    if (used_eye & GEYE_RIGHT) {
+        samples[n].parent.type = GEYE_EVENT_SAMPLE;
+        samples[n].parent.eye  = GEYE_RIGHT;
+        samples[n].parent.time = time;
+        samples[n].parent.tracker_time = event->fs.time;
+        samples[n].x = binocular.right_x;
+        samples[n].y = binocular.right_y;
+        n++;
+    }
+
+    if (delivery & GEYE_DELIVER_BINOCULAR)
+        geye_sample_dispatch_binocular(self->dispatch, &binocular);
+    if (delivery & GEYE_DELIVER_EXTENDED)
+        send_extended_sample(self, event, &binocular, motion, options);
+
+    for (i = 0; i < n; i++) {
+        if (options->detect)
+            detect_fixations(
+                    self, &samples[i], binocular.valid & samples[i].parent.eye
+                    );
+        if (delivery & GEYE_DELIVER_PULL)
+            geye_sample_ring_push(self->sample_ring, &samples[i]);
+        if (delivery & GEYE_DELIVER_SAMPLES)
+            geye_sample_dispatch_batch_sample(self->dispatch, &samples[i]);
+        if (delivery & GEYE_DELIVER_SAMPLE)
+            geye_sample_dispatch_sample(self->dispatch, &samples[i]);
+    }
+}
+
+static GEyeEyeType
+event_eye(const DEVENT *event)
+{
+    return event->eye == LEFT_EYE ? GEYE_LEFT : GEYE_RIGHT;
+}
+
+static void
+send_fixation_event(GEyeEyelinkEt *self, const DEVENT *event, int type)
+{
+    GEyeFixation fixation = {
+        .parent = {
+            .eye  = event_eye(event),
+            .time = event_time(self, event->sttime),
+            .tracker_time = event->sttime
+        }
+    };
+
+    if (type == STARTFIX) {
+        fixation.parent.type = GEYE_EVENT_FIX_START;
+        fixation.end_time = fixation.parent.time;
+        fixation.x = event->gstx;
+        fixation.y = event->gsty;
+    }
+    else {
+        fixation.parent.type = GEYE_EVENT_FIX_END;
+        fixation.end_time = event_time(self, event->entime);
+        fixation.x = event->gavx;
+        fixation.y = event->gavy;
+    }
+
+    dispatch_fixation(self, &fixation);
+}
+
+/*
+ * The amplitude in degrees, the angular resolution (pixels per degree) at
+ * the start and end of the saccade is averaged to convert from pixels.
+ */
+static gdouble
+saccade_amplitude(const DEVENT *event)
+{
+    gdouble res_x = (event->supd_x + event->eupd_x) / 2.0;
+    gdouble res_y = (event->supd_y + event->eupd_y) / 2.0;
+
+    if (res_x <= 0 || res_y <= 0)
+        return 0;
+
+    return hypot((event->genx - event->gstx) / res_x,
+                 (event->geny - event->gsty) / res_y);
+}
+
+static void
+send_saccade_event(GEyeEyelinkEt *self, const DEVENT *event, int type)
+{
+    GEyeSaccade saccade = {
+        .parent = {
+            .eye  = event_eye(event),
+            .time = event_time(self, event->sttime),
+            .tracker_time = event->sttime
+        },
+        .start_x = event->gstx,
+        .start_y = event->gsty
+    };
+
+    if (type == STARTSACC) {
+        saccade.parent.type = GEYE_EVENT_SAC_START;
+        saccade.end_time = saccade.parent.time;
+        saccade.end_x = event->gstx;
+        saccade.end_y = event->gsty;
+    }
+    else {
+        saccade.parent.type = GEYE_EVENT_SAC_END;
+        saccade.end_time = event_time(self, event->entime);
+        saccade.end_x = event->genx;
+        saccade.end_y = event->geny;
+        saccade.amplitude = saccade_amplitude(event);
+        saccade.peak_velocity = event->pvel;
+    }
+
+    if (self->recorder)
+        geye_recorder_saccade(self->recorder, &saccade);
+    geye_sample_dispatch_saccade(self->dispatch, &saccade);
+}
+
+/*
+ * Clears and sets bits of the state word, only the Eyelink-thread may do so.
+ */
+static void
+eyelink_state_update(GEyeEyelinkEt* self, gint clear, gint set)
+{
+    gint old_state, new_state;
+    do {
+        old_state = g_atomic_int_get(&self->state);
+        new_state = (old_state & ~clear) | set;
+    } while (!g_atomic_int_compare_and_exchange(
+                &self->state, old_state, new_state)
+            );
 }
 
 static void
@@ -361,9 +949,10 @@ et_connect(GEyeEyelinkEt* self) {
         }
     }
 
-    self->connected = ret == 0;
-
-    if (self->connected) {
+    if (ret == 0) {
+        eyelink_state_update(self, 0, EYELINK_STATE_CONNECTED);
+        // The tracker might have restarted, so did its clock.
+        geye_clock_map_reset(self->clock_map);
         char eyelink_version_software[256];
         int type = eyelink_get_tracker_version(eyelink_version_software);
         char * tracker_info = g_strdup_printf(
@@ -391,14 +980,119 @@ et_connect(GEyeEyelinkEt* self) {
     }
 }
 
+/*
+ * Reads a setting of the tracker, returns NULL when the tracker doesn't
+ * reply in time. Free the result with g_free().
+ */
+static gchar*
+et_read_setting(const gchar* name)
+{
+    char reply[256];
+    gint64 deadline;
+
+    if (eyelink_read_request((char*) name) != OK_RESULT)
+        return NULL;
+
+    deadline = g_get_monotonic_time() + EYELINK_READ_TIMEOUT;
+    while (g_get_monotonic_time() < deadline) {
+        if (eyelink_read_reply(reply) == OK_RESULT)
+            return g_strdup(reply);
+        g_usleep(1000);
+    }
+    return NULL;
+}
+
+static gboolean
+link_sample_data_has(const gchar* setting, const gchar* field)
+{
+    gchar **fields = g_strsplit(setting, ",", -1);
+    gboolean found = FALSE;
+
+    for (gchar **f = fields; *f && !found; f++)
+        found = g_ascii_strcasecmp(g_strstrip(*f), field) == 0;
+
+    g_strfreev(fields);
+    return found;
+}
+
+/* Undoes et_configure_link_samples(). */
+static void
+et_restore_link_samples(GEyeEyelinkEt* self)
+{
+    gchar *setting = g_steal_pointer(&self->link_sample_data);
+    int result;
+
+    if (!setting)
+        return;
+
+    result = eyecmd_printf("link_sample_data = %s", setting);
+    if (result != OK_RESULT)
+        et_signal_error_printf(
+                self, "Unable to restore the sample data, eyecmd_printf "
+                "returned %d", result
+                );
+    g_free(setting);
+}
+
+/*
+ * Adds the sample fields that the extended samples need, but the default
+ * link_sample_data of the tracker lacks, to the setting of the
+ * application. The setting of the application is restored as soon as
+ * tracking starts without the need for them. The pupil size, resolution
+ * and status are part of the defaults.
+ */
+static void
+et_configure_link_samples(GEyeEyelinkEt* self)
+{
+    GEyeSampleFields fields = g_atomic_int_get(&self->sample_fields);
+    gboolean href, raw;
+    gchar *setting;
+    int result;
+
+    if (!(g_atomic_int_get(&self->sample_delivery) & GEYE_DELIVER_EXTENDED))
+        fields = GEYE_SAMPLE_FIELD_NONE;
+
+    if (!(fields & (GEYE_SAMPLE_FIELD_HREF | GEYE_SAMPLE_FIELD_RAW))) {
+        et_restore_link_samples(self);
+        return;
+    }
+
+    if (!self->link_sample_data) {
+        self->link_sample_data = et_read_setting("link_sample_data");
+        if (!self->link_sample_data)
+            self->link_sample_data = g_strdup(EYELINK_LINK_SAMPLE_DATA);
+    }
+    setting = self->link_sample_data;
+
+    href = fields & GEYE_SAMPLE_FIELD_HREF &&
+           !link_sample_data_has(setting, "HREF");
+    raw = fields & GEYE_SAMPLE_FIELD_RAW &&
+          !link_sample_data_has(setting, "PUPIL");
+    if (!href && !raw)
+        return;
+
+    result = eyecmd_printf(
+            "link_sample_data = %s%s%s",
+            setting,
+            href ? ",HREF" : "",
+            raw ? ",PUPIL" : ""
+            );
+    if (result != OK_RESULT)
+        et_signal_error_printf(
+                self, "Unable to select the sample data, eyecmd_printf "
+                "returned %d", result
+                );
+}
+
 static void
 et_disconnect(GEyeEyelinkEt* self)
 {
     g_rec_mutex_lock(&self->lock);
 
+    et_restore_link_samples(self);
     close_eyelink_connection();
 
-    self->connected = FALSE;
+    eyelink_state_update(self, ~0, 0);
     g_free(self->info);
     self->info = NULL;
 
@@ -406,7 +1100,7 @@ et_disconnect(GEyeEyelinkEt* self)
 
     if (self->main_context) {
         connect_info *connected = g_malloc0(sizeof(connect_info));
-        connected->connected = self->connected;
+        connected->connected = FALSE;
         connected->self = g_object_ref(self);
 
         g_main_context_invoke_full(
@@ -427,9 +1121,15 @@ et_start_tracking(GEyeEyelinkEt* self)
 
     g_rec_mutex_lock(&self->lock);
 
-    if (self->recording)
+    if (eyelink_state_get(self) & EYELINK_STATE_RECORDING)
         rec_samples = 1, rec_events =1;
 
+    et_configure_link_samples(self);
+    // Don't smooth the gaze of this run with that of the previous one.
+    geye_gaze_filter_reset(self->gaze_filters[0]);
+    geye_gaze_filter_reset(self->gaze_filters[1]);
+    geye_gaze_velocity_reset(self->gaze_velocities[0]);
+    geye_gaze_velocity_reset(self->gaze_velocities[1]);
     result = start_recording(rec_samples, rec_events, 1, 1);
     if (result != OK_RESULT) {
         g_critical("Unable to start tracking");
@@ -445,25 +1145,29 @@ et_start_tracking(GEyeEyelinkEt* self)
             char eyes_available[128];
             gsize sz = sizeof(eyes_available);
             int el_eye = eyelink_eye_available();
+            gint used_eye;
             switch (el_eye) {
                 case LEFT_EYE:
                     g_snprintf(eyes_available, sz, "LEFT");
-                    self->used_eye = GEYE_LEFT;
+                    used_eye = EYELINK_STATE_LEFT;
                     break;
                 case RIGHT_EYE:
                     g_snprintf(eyes_available, sz, "RIGHT");
-                    self->used_eye = GEYE_RIGHT;
+                    used_eye = EYELINK_STATE_RIGHT;
                     break;
                 case BINOCULAR:
                     g_snprintf(eyes_available, sz, "LEFT RIGHT");
-                    self->used_eye = GEYE_BINOCULAR;
+                    used_eye = EYELINK_STATE_EYES;
                     break;
                 default:
                     g_assert_not_reached();
             }
             // TODO log to eyelog instead.
-            g_print("EYE_USED %d %s", self->used_eye, eyes_available);
-            self->tracking = TRUE;
+            g_print("EYE_USED %d %s", eyelink_state_get_eye(used_eye),
+                    eyes_available);
+            eyelink_state_update(
+                    self, EYELINK_STATE_EYES, used_eye | EYELINK_STATE_TRACKING
+                    );
         }
         else {
             et_signal_error_printf(self, "%s: eyelink_wait_for_block_start() failed with: %d",
@@ -482,7 +1186,7 @@ et_stop_tracking(GEyeEyelinkEt* self)
 
     g_rec_mutex_lock(&self->lock);
 
-    if (self->recording)
+    if (eyelink_state_get(self) & EYELINK_STATE_RECORDING)
         rec_samples = 1, rec_events = 1;
 
     result = start_recording(rec_samples, rec_events, 0, 0);
@@ -490,7 +1194,12 @@ et_stop_tracking(GEyeEyelinkEt* self)
     if (result != OK_RESULT)
         g_critical("Unable to stop tracking");
     else
-        self->tracking = FALSE;
+        eyelink_state_update(self, EYELINK_STATE_TRACKING, 0);
+    if (self->aoi_current)
+        geye_aoi_set_leave_all(
+                self->aoi_current, now_time(self), aoi_dispatch, self
+                );
+    end_fixations(self);
 
     g_rec_mutex_unlock(&self->lock);
 }
@@ -502,14 +1211,14 @@ et_start_recording(GEyeEyelinkEt* self)
     gint16 track_samples = 0, track_events = 0;
 
     g_rec_mutex_lock(&self->lock);
-    if (self->tracking)
+    if (eyelink_state_get(self) & EYELINK_STATE_TRACKING)
         track_samples = 1, track_events = 1;
 
     ret = start_recording(1, 1, track_samples, track_events);
     if (ret != OK_RESULT)
         g_critical("Unable to start recording");
     else
-        self->recording = TRUE;
+        eyelink_state_update(self, 0, EYELINK_STATE_RECORDING);
 
     g_rec_mutex_unlock(&self->lock);
 }
@@ -522,14 +1231,14 @@ et_stop_recording(GEyeEyelinkEt* self)
 
     g_rec_mutex_lock(&self->lock);
 
-    if (self->tracking)
+    if (eyelink_state_get(self) & EYELINK_STATE_TRACKING)
         track_samples = 1, track_events = 1;
 
     ret = start_recording(0, 0, track_samples, track_events);
     if (ret != OK_RESULT)
         g_critical("Unable to stop recording");
     else
-        self->recording = TRUE;
+        eyelink_state_update(self, EYELINK_STATE_RECORDING, 0);
 
     g_rec_mutex_unlock(&self->lock);
 }
@@ -587,6 +1296,134 @@ et_calibrate(GEyeEyelinkEt* self)
     do_tracker_setup();
 }
 
+/*
+ * Applies the real-time properties to the Eyelink-thread itself. Whatever
+ * the system refuses is reported and the thread continues without it.
+ */
+static void
+et_apply_realtime(GEyeEyelinkEt* self)
+{
+    GError *error = NULL;
+
+    if (!geye_realtime_set_affinity(self->cpu_affinity, &error)) {
+        et_signal_error_printf(self, "%s", error->message);
+        g_clear_error(&error);
+    }
+
+    if (!geye_realtime_set_scheduling(
+                self->sched_policy, self->sched_priority, &error)) {
+        et_signal_error_printf(self, "%s", error->message);
+        g_clear_error(&error);
+    }
+
+    if (self->lock_memory) {
+        if (!geye_realtime_lock_memory(&error)) {
+            et_signal_error_printf(self, "%s", error->message);
+            g_clear_error(&error);
+        }
+        // Even without locked memory, this saves the first page faults.
+        geye_sample_ring_prefault(self->sample_ring);
+        geye_sample_dispatch_prefault(self->dispatch);
+        geye_sample_broadcast_prefault(self->broadcast);
+        geye_realtime_prefault_stack();
+    }
+}
+
+static void
+et_configure_fixations(GEyeEyelinkEt* self)
+{
+    GEyeFixationDetection method;
+    guint i;
+
+    g_rec_mutex_lock(&self->lock);
+    method = g_atomic_int_get(&self->fixation_detection);
+    for (i = 0; i < G_N_ELEMENTS(self->fixation_detectors); i++)
+        geye_fixation_detector_configure(
+                self->fixation_detectors[i],
+                method,
+                self->fixation_velocity,
+                self->fixation_dispersion,
+                self->fixation_duration / 1000.0
+                );
+    g_rec_mutex_unlock(&self->lock);
+}
+
+static void
+et_configure_smoothing(GEyeEyelinkEt* self)
+{
+    GEyeSmoothing method;
+    guint i;
+
+    g_rec_mutex_lock(&self->lock);
+    method = g_atomic_int_get(&self->smoothing);
+    for (i = 0; i < G_N_ELEMENTS(self->gaze_filters); i++)
+        geye_gaze_filter_configure(
+                self->gaze_filters[i],
+                method,
+                self->smoothing_window,
+                self->smoothing_min_cutoff,
+                self->smoothing_beta
+                );
+    g_rec_mutex_unlock(&self->lock);
+}
+
+static void
+et_configure_velocity(GEyeEyelinkEt* self)
+{
+    guint i;
+
+    g_rec_mutex_lock(&self->lock);
+    for (i = 0; i < G_N_ELEMENTS(self->gaze_velocities); i++)
+        geye_gaze_velocity_configure(
+                self->gaze_velocities[i],
+                self->differentiator,
+                self->differentiator_window
+                );
+    g_rec_mutex_unlock(&self->lock);
+}
+
+/*
+ * The recorder belongs to the Eyelink-thread from here on, until it is
+ * stopped.
+ */
+static void
+et_start_host_recording(GEyeEyelinkEt* self, GEyeRecorder* recorder)
+{
+    g_assert(self->recorder == NULL);
+    self->recorder = recorder;
+}
+
+/*
+ * Hands the last records to the writer and returns the recorder to the
+ * main thread, that waits for the reply to close it.
+ */
+static void
+et_stop_host_recording(GEyeEyelinkEt* self)
+{
+    ThreadMsg *reply = g_malloc0(sizeof(ThreadMsg));
+
+    if (self->recorder)
+        geye_recorder_flush(self->recorder);
+    reply->type = ET_STOP_HOST_RECORDING;
+    reply->content.recorder = self->recorder;
+    self->recorder = NULL;
+    g_async_queue_push(self->thread_to_instance, reply);
+}
+
+static void
+et_log_message(GEyeEyelinkEt* self, gdouble time, gchar* text)
+{
+    if (eyelink_state_get(self) & EYELINK_STATE_CONNECTED) {
+        if (eyemsg_printf("%s", text) != 0)
+            et_signal_error_printf(
+                    self, "Unable to log message \"%s\"", text
+                    );
+    }
+    if (self->recorder)
+        geye_recorder_message(self->recorder, time, text);
+    g_free(text);
+}
+
 static void
 handle_msg(GEyeEyelinkEt* self, ThreadMsg* msg)
 {
@@ -594,7 +1431,7 @@ handle_msg(GEyeEyelinkEt* self, ThreadMsg* msg)
     switch(type) {
         case ET_STOP:
             self->stop_thread = TRUE;
-            if (self->connected)
+            if (eyelink_state_get(self) & EYELINK_STATE_CONNECTED)
                 et_disconnect(self);
             break;
         case ET_CONNECT:
@@ -622,6 +1459,31 @@ handle_msg(GEyeEyelinkEt* self, ThreadMsg* msg)
         case ET_VALIDATE:
             et_calibrate(self);
             break;
+        case ET_APPLY_REALTIME:
+            et_apply_realtime(self);
+            break;
+        case ET_CONFIGURE_FIXATIONS:
+            et_configure_fixations(self);
+            break;
+        case ET_CONFIGURE_SMOOTHING:
+            et_configure_smoothing(self);
+            break;
+        case ET_CONFIGURE_VELOCITY:
+            et_configure_velocity(self);
+            break;
+        case ET_START_HOST_RECORDING:
+            et_start_host_recording(self, msg->content.recorder);
+            break;
+        case ET_STOP_HOST_RECORDING:
+            et_stop_host_recording(self);
+            break;
+        case ET_LOG_MESSAGE:
+            et_log_message(
+                    self,
+                    msg->content.message.time,
+                    msg->content.message.text
+                    );
+            break;
         case ET_STOP_SETUP:
         default:
             g_warning("Unexpected message type %d", type);
@@ -647,27 +1509,134 @@ monitor_main_thread(GEyeEyelinkEt* self, gboolean sleep)
     return FALSE;
 }
 
+/*
+ * Keeps a running average of the latency of the oldest sample of a drain.
+ */
+static void
+update_dispatch_latency(GEyeEyelinkEt* self, gint64 latency)
+{
+    gint average = g_atomic_int_get(&self->dispatch_latency);
+
+    latency = CLAMP(latency, 0, G_MAXINT);
+    if (average == 0)
+        average = latency;
+    else
+        average += (latency - average) / EYELINK_LATENCY_WEIGHT;
+    g_atomic_int_set(&self->dispatch_latency, average);
+}
+
+/*
+ * Drains the link, this runs without holding self->lock. What is needed
+ * from the state is taken once from the snapshot of the thread loop.
+ */
 static gboolean
-handle_events(GEyeEyelinkEt* self)
+handle_events(GEyeEyelinkEt* self, gint state)
 {
-    (void) self;
     gboolean received_something = FALSE;
     int event_type;
     ALLD_DATA event;
+    gint64 first_sample = 0, received = 0, drain_time;
+    guint n_samples = 0, n_events = 0;
+    SampleOptions options = {
+        .used_eye = eyelink_state_get_eye(state),
+        .delivery = g_atomic_int_get(&self->sample_delivery),
+        .detect   = g_atomic_int_get(&self->fixation_detection) !=
+                    GEYE_FIXATION_DETECTION_NONE,
+        .smooth   = g_atomic_int_get(&self->smoothing) != GEYE_SMOOTHING_NONE,
+        .fields   = g_atomic_int_get(&self->sample_fields)
+    };
+
+    options.differentiate = (options.fields & (
+            GEYE_SAMPLE_FIELD_VELOCITY | GEYE_SAMPLE_FIELD_ACCELERATION
+            )) != 0;
+
+    options.convert = extended_converter(options.fields);
+
     while ((event_type = eyelink_get_next_data(NULL)) != 0) {
-        gdouble ellapsed = g_timer_elapsed(self->timer, NULL);
+        // The clock is read once per batch, not for every sample.
+        if (!received_something) {
+            received = g_get_monotonic_time();
+            update_clock_map(self);
+        }
         received_something = TRUE;
         eyelink_get_double_data(&event);
         switch (event_type) {
             case SAMPLE_TYPE:
-                send_sample_event(self, event, ellapsed);
+                if (!first_sample)
+                    first_sample = geye_clock_map_to_host(
+                            self->clock_map, event.fs.time * 1000
+                            );
+                send_sample_event(self, &event, received, &options);
+                n_samples++;
+                break;
+            case STARTFIX:
+            case ENDFIX:
+                // The fixations of the host replace those of the tracker.
+                if (!options.detect)
+                    send_fixation_event(self, &event.fe, event_type);
+                break;
+            case STARTSACC:
+            case ENDSACC:
+                send_saccade_event(self, &event.fe, event_type);
+                break;
             default:
                 ;
         }
+        if (event_type != SAMPLE_TYPE)
+            n_events++;
+    }
+    if (received_something) {
+        gint64 queued;
+
+        geye_sample_dispatch_flush(self->dispatch);
+        geye_sample_ring_wake(self->sample_ring);
+        geye_sample_broadcast_publish(self->broadcast);
+        if (self->recorder)
+            geye_recorder_commit(self->recorder);
+
+        queued = g_get_monotonic_time();
+        geye_latency_histogram_record(
+                self->latency[GEYE_LATENCY_PROCESS], queued - received
+                );
+        if (first_sample)
+            update_dispatch_latency(self, queued - first_sample);
+        drain_time = MIN(queued - received, G_MAXUINT);
+        if (drain_time > self->max_drain_time)
+            EYELINK_COUNTER_SET(self->max_drain_time, drain_time);
+        EYELINK_COUNTER_ADD(self->samples_drained, n_samples);
+        EYELINK_COUNTER_ADD(self->events_parsed, n_events);
     }
     return received_something;
 }
 
+/*
+ * Decides according to the latency mode whether the Eyelink-thread may
+ * sleep, after it found nothing to read from the eyetracker.
+ */
+static gboolean
+eyelink_thread_may_sleep(GEyeEyelinkEt* self,
+                         gboolean       tracking,
+                         gint64        *idle_since)
+{
+    gint64 now;
+
+    if (!tracking)
+        return TRUE;
+
+    switch (g_atomic_int_get(&self->latency_mode)) {
+        case GEYE_LATENCY_MODE_BUSY_POLL:
+            return FALSE;
+        case GEYE_LATENCY_MODE_HYBRID:
+            now = g_get_monotonic_time();
+            if (*idle_since == 0)
+                *idle_since = now;
+            return now - *idle_since >= g_atomic_int_get(&self->spin_time);
+        case GEYE_LATENCY_MODE_SLEEP:
+        default:
+            return TRUE;
+    }
+}
+
 /* *********** eyelink hookv2 functions ************ */
 
 static gint16
@@ -816,6 +1785,7 @@ eyelink_hook_draw_image(
             dest[2] = src[0];
             dest[3] = 255; //src[4];
         }
+        EYELINK_COUNTER_ADD(self->frames_converted, 1);
         self->cb_image_data(GEYE_EYETRACKER(self),
                             width,
                             height,
@@ -887,6 +1857,16 @@ eyelink_hook_input_key(void* data, InputEvent* key_input)
                 msg = NULL;
                 self->quit_hooks = TRUE;
                 break;
+            case ET_APPLY_REALTIME:
+            case ET_CONFIGURE_FIXATIONS:
+            case ET_CONFIGURE_SMOOTHING:
+            case ET_CONFIGURE_VELOCITY:
+            case ET_START_HOST_RECORDING:
+            case ET_STOP_HOST_RECORDING:
+            case ET_LOG_MESSAGE:
+                // These don't depend on the mode, handle them right away.
+                handle_msg(self, msg);
+                break;
             default:
                 g_assert_not_reached();
         }
@@ -928,22 +1908,31 @@ eyelink_thread(gpointer data)
         g_critical("Unable to setup hook functions");
     }
 
+    gint64 idle_since = 0;
+
     while (!self->stop_thread) {
         gboolean didsomething = FALSE;
+        gint state = eyelink_state_get(self);
+        gboolean tracking = (state & EYELINK_STATE_TRACKING) != 0;
+
+        aoi_swap(self);
 
-        g_rec_mutex_lock(&self->lock);
-        if (self->tracking) {
+        if (tracking) {
             gboolean received_event;
-            received_event = handle_events(self);
+            received_event = handle_events(self, state);
             if (received_event)
                 didsomething = TRUE;
         }
-        g_rec_mutex_unlock(&self->lock);
 
-        if (didsomething)
+        if (didsomething) {
+            idle_since = 0;
             monitor_main_thread(self, FALSE);
+        }
         else
-            monitor_main_thread(self, TRUE);
+            monitor_main_thread(
+                    self,
+                    eyelink_thread_may_sleep(self, tracking, &idle_since)
+                    );
     }
 
     return NULL;
@@ -966,6 +1955,117 @@ eyelink_thread_stop(GEyeEyelinkEt* self)
     g_thread_join(self->eyelink_thread);
 }
 
+void
+eyelink_thread_apply_realtime(GEyeEyelinkEt* self)
+{
+    ThreadMsg* msg = g_malloc0(sizeof(ThreadMsg));
+    msg->type = ET_APPLY_REALTIME;
+    et_send_message(self, msg);
+}
+
+/*
+ * Hands a new set of areas of interest, or NULL, over to the Eyelink-thread,
+ * which picks it up at its next iteration. The thread holds its own
+ * reference on the set.
+ */
+void
+eyelink_thread_set_aoi_set(GEyeEyelinkEt* self, GEyeAoiSet* set)
+{
+    gpointer next = set ? g_object_ref(set) : EYELINK_AOI_NONE;
+    gpointer old;
+
+    do {
+        old = g_atomic_pointer_get(&self->aoi_pending);
+    } while (!g_atomic_pointer_compare_and_exchange(
+                &self->aoi_pending, old, next)
+            );
+
+    // The thread didn't pick up the previous set.
+    if (old && old != EYELINK_AOI_NONE) {
+        geye_aoi_set_detach(old);
+        g_object_unref(old);
+    }
+}
+
+/*
+ * Drops the references of the thread, once it has been stopped.
+ */
+void
+eyelink_thread_release_aoi_sets(GEyeEyelinkEt* self)
+{
+    gpointer pending = g_atomic_pointer_get(&self->aoi_pending);
+
+    if (pending && pending != EYELINK_AOI_NONE) {
+        geye_aoi_set_detach(pending);
+        g_object_unref(pending);
+    }
+    self->aoi_pending = NULL;
+    if (self->aoi_current)
+        geye_aoi_set_detach(self->aoi_current);
+    g_clear_object(&self->aoi_current);
+    g_clear_object(&self->aoi_retired);
+}
+
+void
+eyelink_thread_configure_fixations(GEyeEyelinkEt* self)
+{
+    ThreadMsg* msg = g_malloc0(sizeof(ThreadMsg));
+    msg->type = ET_CONFIGURE_FIXATIONS;
+    et_send_message(self, msg);
+}
+
+void
+eyelink_thread_configure_smoothing(GEyeEyelinkEt* self)
+{
+    ThreadMsg* msg = g_malloc0(sizeof(ThreadMsg));
+    msg->type = ET_CONFIGURE_SMOOTHING;
+    et_send_message(self, msg);
+}
+
+void
+eyelink_thread_configure_velocity(GEyeEyelinkEt* self)
+{
+    ThreadMsg* msg = g_malloc0(sizeof(ThreadMsg));
+    msg->type = ET_CONFIGURE_VELOCITY;
+    et_send_message(self, msg);
+}
+
+
+void
+eyelink_thread_start_host_recording(GEyeEyelinkEt *self,
+                                    GEyeRecorder  *recorder)
+{
+    ThreadMsg* msg = g_malloc0(sizeof(ThreadMsg));
+    msg->type = ET_START_HOST_RECORDING;
+    msg->content.recorder = recorder;
+    et_send_message(self, msg);
+}
+
+/*
+ * Returns once the Eyelink-thread has let go of the recorder, so that it
+ * may be closed.
+ */
+void
+eyelink_thread_stop_host_recording(GEyeEyelinkEt* self)
+{
+    ThreadMsg* msg = g_malloc0(sizeof(ThreadMsg));
+    msg->type = ET_STOP_HOST_RECORDING;
+    et_send_message(self, msg);
+
+    msg = et_receive_reply(self);
+    g_assert(msg->type == ET_STOP_HOST_RECORDING);
+    g_free(msg);
+}
+
+void
+eyelink_thread_log_message(GEyeEyelinkEt* self, const gchar* text)
+{
+    ThreadMsg* msg = g_malloc0(sizeof(ThreadMsg));
+    msg->type = ET_LOG_MESSAGE;
+    msg->content.message.time = now_time(self);
+    msg->content.message.text = g_strdup(text);
+    et_send_message(self, msg);
+}
 
 void
 eyelink_thread_connect(GEyeEyelinkEt* self, GError** error)
@@ -980,22 +2080,18 @@ void
 eyelink_thread_disconnect(GEyeEyelinkEt* self)
 {
     ThreadMsg* msg;
-    g_rec_mutex_lock(&self->lock);
-    if (self->connected){
+    if (eyelink_state_get(self) & EYELINK_STATE_CONNECTED){
         msg = g_malloc0(sizeof(ThreadMsg));
         msg->type = ET_DISCONNECT;
         et_send_message(self, msg);
     }
-    g_rec_mutex_unlock(&self->lock);
 }
 
 void eyelink_thread_start_tracking(GEyeEyelinkEt* self, GError** error)
 {
     ThreadMsg* msg;
 
-    g_rec_mutex_lock(&self->lock);
-
-    if (!self->connected) {
+    if (!(eyelink_state_get(self) & EYELINK_STATE_CONNECTED)) {
         g_set_error(error,
                     geye_eyetracker_error_quark(),
                     GEYE_EYETRACKER_ERROR_INCORRECT_MODE,
@@ -1006,32 +2102,24 @@ void eyelink_thread_start_tracking(GEyeEyelinkEt* self, GError** error)
         msg->type = ET_START_TRACKING;
         et_send_message(self, msg);
     }
-
-    g_rec_mutex_unlock(&self->lock);
 }
 
 void eyelink_thread_stop_tracking(GEyeEyelinkEt* self)
 {
     ThreadMsg* msg;
 
-    g_rec_mutex_lock(&self->lock);
-
-    if (self->connected) {
+    if (eyelink_state_get(self) & EYELINK_STATE_CONNECTED) {
         msg = g_malloc0(sizeof(ThreadMsg));
         msg->type = ET_STOP_TRACKING;
         et_send_message(self, msg);
     }
-
-    g_rec_mutex_unlock(&self->lock);
 }
 
 void eyelink_thread_start_recording(GEyeEyelinkEt* self, GError** error)
 {
     ThreadMsg* msg;
 
-    g_rec_mutex_lock(&self->lock);
-
-    if (!self->connected) {
+    if (!(eyelink_state_get(self) & EYELINK_STATE_CONNECTED)) {
         g_set_error(error,
                     geye_eyetracker_error_quark(),
                     GEYE_EYETRACKER_ERROR_INCORRECT_MODE,
@@ -1042,32 +2130,24 @@ void eyelink_thread_start_recording(GEyeEyelinkEt* self, GError** error)
         msg->type = ET_START_RECORDING;
         et_send_message(self, msg);
     }
-
-    g_rec_mutex_unlock(&self->lock);
 }
 
 void eyelink_thread_stop_recording(GEyeEyelinkEt* self)
 {
     ThreadMsg* msg;
 
-    g_rec_mutex_lock(&self->lock);
-
-    if (self->connected) {
+    if (eyelink_state_get(self) & EYELINK_STATE_CONNECTED) {
         msg = g_malloc0(sizeof(ThreadMsg));
         msg->type = ET_STOP_RECORDING;
         et_send_message(self, msg);
     }
-
-    g_rec_mutex_unlock(&self->lock);
 }
 
 void eyelink_thread_start_setup(GEyeEyelinkEt* self)
 {
     ThreadMsg* msg;
 
-    g_rec_mutex_lock(&self->lock);
-
-    if (self->connected) {
+    if (eyelink_state_get(self) & EYELINK_STATE_CONNECTED) {
         /* make the thread enter setup mode */
         msg = g_malloc0(sizeof(ThreadMsg));
         msg->type = ET_START_SETUP;
@@ -1083,8 +2163,6 @@ void eyelink_thread_start_setup(GEyeEyelinkEt* self)
     else {
         g_warning("Starting setup while not being connected.");
     }
-
-    g_rec_mutex_unlock(&self->lock);
 }
 
 void
@@ -1100,9 +2178,7 @@ eyelink_thread_calibrate(GEyeEyelinkEt* self, GError **error)
 {
     ThreadMsg *msg;
 
-    g_rec_mutex_lock(&self->lock);
-
-    if (!self->connected)
+    if (!(eyelink_state_get(self) & EYELINK_STATE_CONNECTED))
         g_set_error(
                 error,
                 geye_eyetracker_error_quark(),
@@ -1114,8 +2190,6 @@ eyelink_thread_calibrate(GEyeEyelinkEt* self, GError **error)
         et_send_message(self, msg);
         eyelink_thread_send_key_press(self, 'c', 0);
     }
-
-    g_rec_mutex_unlock(&self->lock);
 }
 
 void
@@ -1123,8 +2197,7 @@ eyelink_thread_validate(GEyeEyelinkEt* self, GError **error)
 {
     ThreadMsg *msg;
 
-    g_rec_mutex_lock(&self->lock);
-    if (!self->connected)
+    if (!(eyelink_state_get(self) & EYELINK_STATE_CONNECTED))
         g_set_error(
                 error,
                 geye_eyetracker_error_quark(),
@@ -1136,7 +2209,6 @@ eyelink_thread_validate(GEyeEyelinkEt* self, GError **error)
         et_send_message(self, msg);
         eyelink_thread_send_key_press(self, 'v', 0);
     }
-    g_rec_mutex_unlock(&self->lock);
 }
 
 void
@@ -1155,9 +2227,7 @@ eyelink_thread_send_key_press(GEyeEyelinkEt * self, guint16 key, guint modifiers
 {
     gboolean ret = FALSE;
 
-    g_rec_mutex_lock(&self->lock);
-
-    if (self->connected) {
+    if (eyelink_state_get(self) & EYELINK_STATE_CONNECTED) {
         ThreadMsg *msg = g_malloc0(sizeof(ThreadMsg));
         guint16 tkey = key; // translated key
 
@@ -1182,7 +2252,6 @@ eyelink_thread_send_key_press(GEyeEyelinkEt * self, guint16 key, guint modifiers
         g_async_queue_push(self->instance_to_thread, msg);
         ret = TRUE;
     }
-    g_rec_mutex_unlock(&self->lock);
 
     return ret;
 }
@@ -26,9 +26,69 @@
 
 G_BEGIN_DECLS
 
+/*
+ * The state of the eyetracker is published as one atomic word, so that the
+ * Eyelink-thread doesn't have to hold the lock while it drains the link and
+ * the public functions don't have to wait for it. Only the Eyelink-thread
+ * changes the state.
+ */
+typedef enum {
+    EYELINK_STATE_CONNECTED = 1 << 0,
+    EYELINK_STATE_TRACKING  = 1 << 1,
+    EYELINK_STATE_RECORDING = 1 << 2,
+    EYELINK_STATE_LEFT      = 1 << 3,   // the left eye is tracked
+    EYELINK_STATE_RIGHT     = 1 << 4,   // the right eye is tracked
+} EyelinkState;
+
+#define EYELINK_STATE_EYES (EYELINK_STATE_LEFT | EYELINK_STATE_RIGHT)
+
+/*
+ * The performance counters have a single writer, the Eyelink-thread, so a
+ * relaxed store suffices. Readers may see a slightly older value.
+ */
+#if defined(__GNUC__)
+#define EYELINK_COUNTER_SET(counter, value) \
+    __atomic_store_n(&(counter), (value), __ATOMIC_RELAXED)
+#else
+#define EYELINK_COUNTER_SET(counter, value) \
+    g_atomic_int_set(&(counter), (value))
+#endif
+
+#define EYELINK_COUNTER_ADD(counter, n) \
+    EYELINK_COUNTER_SET(counter, (counter) + (n))
+
+static inline gint
+eyelink_state_get(GEyeEyelinkEt *self)
+{
+    return g_atomic_int_get(&self->state);
+}
+
+static inline GEyeEyeType
+eyelink_state_get_eye(gint state)
+{
+    GEyeEyeType eye = GEYE_NONE;
+    if (state & EYELINK_STATE_LEFT)
+        eye |= GEYE_LEFT;
+    if (state & EYELINK_STATE_RIGHT)
+        eye |= GEYE_RIGHT;
+    return eye;
+}
+
+void     eyelink_et_watch_counters(GEyeEyelinkEt *self, gboolean connected);
 
 GThread* eyelink_thread_start(GEyeEyelinkEt *self);
 void     eyelink_thread_stop(GEyeEyelinkEt  *self);
+void     eyelink_thread_apply_realtime(GEyeEyelinkEt *self);
+void     eyelink_thread_configure_fixations(GEyeEyelinkEt *self);
+void     eyelink_thread_configure_smoothing(GEyeEyelinkEt *self);
+void     eyelink_thread_configure_velocity(GEyeEyelinkEt *self);
+void     eyelink_thread_set_aoi_set(GEyeEyelinkEt *self, GEyeAoiSet *set);
+void     eyelink_thread_release_aoi_sets(GEyeEyelinkEt *self);
+
+void     eyelink_thread_start_host_recording(GEyeEyelinkEt        *self,
+                                             struct _GEyeRecorder *recorder);
+void     eyelink_thread_stop_host_recording(GEyeEyelinkEt *self);
+void     eyelink_thread_log_message(GEyeEyelinkEt *self, const gchar *text);
 
 void     eyelink_thread_connect(GEyeEyelinkEt *self, GError **error);
 void     eyelink_thread_disconnect(GEyeEyelinkEt *self);
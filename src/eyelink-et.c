@@ -18,14 +18,98 @@
  * USA
  */
 
+#include "aoi-set-private.h"
+#include "clock-map.h"
 #include "eyelink-et.h"
 #include "eyelink-et-private.h"
 #include "eyetracker.h"
 #include "eyetracker-error.h"
+#include "fixation-detector.h"
+#include "gaze-filter.h"
+#include "gaze-velocity.h"
+#include "latency-histogram.h"
+#include "recorder.h"
+#include "sample-broadcast.h"
+#include "sample-dispatch.h"
+#include "sample-ring.h"
+#include "sample-slot.h"
+
+// Holds about 4 seconds of binocular samples at 2000 Hz.
+#define EYELINK_SAMPLE_RING_SIZE 16384
+// Records waiting to be emitted in the main context.
+#define EYELINK_DISPATCH_SIZE 8192
+// Every subscriber may lag about 2 seconds at 2000 Hz.
+#define EYELINK_BROADCAST_SIZE 4096
+// Changed performance counters are notified at most this often, in ms.
+#define EYELINK_COUNTER_INTERVAL 250
+
+// Spin 0.6 ms, a bit longer than the interval between samples at 2000 Hz.
+#define EYELINK_DEFAULT_SPIN_TIME 600
+// Host side fixation detection, about 30 °/s and 1.5 ° at 35 pixels/°.
+#define EYELINK_DEFAULT_FIXATION_VELOCITY 1000.0
+#define EYELINK_DEFAULT_FIXATION_DISPERSION 50.0
+#define EYELINK_DEFAULT_FIXATION_DURATION 100
+// The longest minimum duration of a fixation in ms, the window of the
+// detector holds it at 2000 Hz.
+#define EYELINK_MAX_FIXATION_DURATION 1000
+#define EYELINK_FIXATION_WINDOW_SIZE 2048
+// Smoothing of the gaze, the window holds 32 ms at 2000 Hz. The 1€ filter
+// is tuned as suggested by its authors for a pointer in pixels.
+#define EYELINK_MAX_SMOOTHING_WINDOW 64
+#define EYELINK_DEFAULT_SMOOTHING_WINDOW 5
+#define EYELINK_DEFAULT_SMOOTHING_MIN_CUTOFF 1.0
+#define EYELINK_DEFAULT_SMOOTHING_BETA 0.007
+// The Savitzky-Golay differentiator, 7 samples are 3.5 ms at 2000 Hz.
+#define EYELINK_MAX_DIFFERENTIATOR_WINDOW 64
+#define EYELINK_DEFAULT_DIFFERENTIATOR_WINDOW 7
+
+// Above most system threads, below the threaded interrupt handlers.
+#define EYELINK_DEFAULT_SCHED_PRIORITY 40
 
 static void
 geye_eyetracker_interface_init(GEyeEyetrackerInterface* iface);
 
+static gboolean
+eyelink_et_notify_counters(gpointer data);
+
+GType
+geye_latency_mode_get_type(void)
+{
+    static gsize mode_type = 0;
+
+    if (g_once_init_enter(&mode_type)) {
+        static const GEnumValue values[] = {
+            {GEYE_LATENCY_MODE_SLEEP, "GEYE_LATENCY_MODE_SLEEP", "sleep"},
+            {GEYE_LATENCY_MODE_HYBRID, "GEYE_LATENCY_MODE_HYBRID", "hybrid"},
+            {GEYE_LATENCY_MODE_BUSY_POLL,
+             "GEYE_LATENCY_MODE_BUSY_POLL",
+             "busy-poll"},
+            {0, NULL, NULL}
+        };
+        GType type = g_enum_register_static("GEyeLatencyMode", values);
+        g_once_init_leave(&mode_type, type);
+    }
+    return mode_type;
+}
+
+GType
+geye_sched_policy_get_type(void)
+{
+    static gsize policy_type = 0;
+
+    if (g_once_init_enter(&policy_type)) {
+        static const GEnumValue values[] = {
+            {GEYE_SCHED_POLICY_OTHER, "GEYE_SCHED_POLICY_OTHER", "other"},
+            {GEYE_SCHED_POLICY_FIFO, "GEYE_SCHED_POLICY_FIFO", "fifo"},
+            {GEYE_SCHED_POLICY_RR, "GEYE_SCHED_POLICY_RR", "rr"},
+            {0, NULL, NULL}
+        };
+        GType type = g_enum_register_static("GEyeSchedPolicy", values);
+        g_once_init_leave(&policy_type, type);
+    }
+    return policy_type;
+}
+
 G_DEFINE_TYPE_WITH_CODE(GEyeEyelinkEt,
                         geye_eyelink_et,
                         G_TYPE_OBJECT,
@@ -39,13 +123,96 @@ geye_eyelink_et_init(GEyeEyelinkEt* self)
     self->thread_to_instance    = g_async_queue_new_full(g_free);
 
     self->main_context          = g_main_context_ref_thread_default();
-    self->timer                 = g_timer_new();
+    self->start_time            = g_get_monotonic_time();
+    self->clock_map             = geye_clock_map_new();
+    self->latest_sample         = geye_sample_slot_new();
+    self->fixation_detectors[0] = geye_fixation_detector_new(
+            EYELINK_FIXATION_WINDOW_SIZE
+            );
+    self->fixation_detectors[1] = geye_fixation_detector_new(
+            EYELINK_FIXATION_WINDOW_SIZE
+            );
+    self->gaze_filters[0]       = geye_gaze_filter_new(
+            EYELINK_MAX_SMOOTHING_WINDOW
+            );
+    self->gaze_filters[1]       = geye_gaze_filter_new(
+            EYELINK_MAX_SMOOTHING_WINDOW
+            );
+    self->gaze_velocities[0]    = geye_gaze_velocity_new(
+            EYELINK_MAX_DIFFERENTIATOR_WINDOW
+            );
+    self->gaze_velocities[1]    = geye_gaze_velocity_new(
+            EYELINK_MAX_DIFFERENTIATOR_WINDOW
+            );
+    self->sample_ring           = geye_sample_ring_new(
+            EYELINK_SAMPLE_RING_SIZE, sizeof(GEyeSample)
+            );
+    self->dispatch              = geye_sample_dispatch_new(
+            GEYE_EYETRACKER(self), self->main_context, EYELINK_DISPATCH_SIZE
+            );
+    self->broadcast             = geye_sample_broadcast_new(
+            EYELINK_BROADCAST_SIZE
+            );
+    for (guint i = 0; i < GEYE_LATENCY_N_STAGES; i++)
+        self->latency[i]        = geye_latency_histogram_new();
+    geye_sample_dispatch_set_latency(
+            self->dispatch,
+            self->latency[GEYE_LATENCY_QUEUE],
+            self->latency[GEYE_LATENCY_TOTAL]
+            );
 
     g_rec_mutex_init(&self->lock);
     // keep this last, otherwise the queue might be NULL
     self->eyelink_thread        = eyelink_thread_start(self);
 }
 
+/*
+ * The counters only change while connected, so they are only watched
+ * while connected.
+ */
+static void
+eyelink_et_start_counters(GEyeEyelinkEt* self)
+{
+    if (self->counter_source)
+        return;
+
+    self->counter_source = g_timeout_source_new(EYELINK_COUNTER_INTERVAL);
+    g_source_set_callback(
+            self->counter_source, eyelink_et_notify_counters, self, NULL
+            );
+    g_source_set_name(self->counter_source, "GEyeEyelinkEt counters");
+    g_source_attach(self->counter_source, self->main_context);
+}
+
+static void
+eyelink_et_stop_counters(GEyeEyelinkEt* self)
+{
+    if (!self->counter_source)
+        return;
+
+    g_source_destroy(self->counter_source);
+    g_source_unref(self->counter_source);
+    self->counter_source = NULL;
+}
+
+/*
+ * Called in the main context when the Eyelink-thread reports that the
+ * connection changed, so a failed connect doesn't start the counters and
+ * the final drain of a disconnect is still notified.
+ */
+void
+eyelink_et_watch_counters(GEyeEyelinkEt* self, gboolean connected)
+{
+    if (connected) {
+        eyelink_et_start_counters(self);
+    }
+    else if (self->counter_source) {
+        // Don't miss the changes since the last interval.
+        eyelink_et_notify_counters(self);
+        eyelink_et_stop_counters(self);
+    }
+}
+
 static void
 eyelink_et_connect(GEyeEyetracker* self, GError** error)
 {
@@ -197,6 +364,178 @@ eyelink_et_send_key_press(GEyeEyetracker* et, guint16 key, guint modifiers)
     return TRUE;
 }
 
+static guint
+eyelink_et_read_samples(GEyeEyetracker *et,
+                        GEyeSample     *samples,
+                        guint           max_samples,
+                        gint64          timeout_us)
+{
+    GEyeEyelinkEt *self = GEYE_EYELINK_ET(et);
+    return geye_sample_ring_pop_timeout(
+            self->sample_ring, samples, max_samples, timeout_us
+            );
+}
+
+static guint
+eyelink_et_get_sample_overruns(GEyeEyetracker *et)
+{
+    GEyeEyelinkEt *self = GEYE_EYELINK_ET(et);
+    return geye_sample_ring_get_overruns(self->sample_ring);
+}
+
+static gint64
+eyelink_et_tracker_to_host_time(GEyeEyetracker* et, gdouble tracker_time)
+{
+    GEyeEyelinkEt *self = GEYE_EYELINK_ET(et);
+    // The EyeLink clock runs in ms.
+    return geye_clock_map_to_host(self->clock_map, tracker_time * 1000);
+}
+
+static gboolean
+eyelink_et_get_latest_sample(GEyeEyetracker* et, GEyeBinocularSample* sample)
+{
+    GEyeEyelinkEt *self = GEYE_EYELINK_ET(et);
+    return geye_sample_slot_load(self->latest_sample, sample);
+}
+
+static gboolean
+eyelink_et_get_latency_stats(GEyeEyetracker   *et,
+                             GEyeLatencyStage  stage,
+                             GEyeLatencyStats *stats)
+{
+    GEyeEyelinkEt *self = GEYE_EYELINK_ET(et);
+    geye_latency_histogram_get_stats(self->latency[stage], stats);
+    return TRUE;
+}
+
+static void
+eyelink_et_reset_latency_stats(GEyeEyetracker *et)
+{
+    GEyeEyelinkEt *self = GEYE_EYELINK_ET(et);
+    for (guint i = 0; i < GEYE_LATENCY_N_STAGES; i++)
+        geye_latency_histogram_reset(self->latency[i]);
+    g_atomic_int_set(&self->max_drain_time, 0);
+}
+
+static GEyeSubscriber*
+eyelink_et_subscribe(GEyeEyetracker    *et,
+                     guint              decimation,
+                     gdouble            interval,
+                     GError           **error)
+{
+    GEyeEyelinkEt *self = GEYE_EYELINK_ET(et);
+    return geye_sample_broadcast_subscribe(
+            self->broadcast, decimation, interval, error
+            );
+}
+
+static void
+eyelink_et_set_aoi_set(GEyeEyetracker* et, GEyeAoiSet* set)
+{
+    GEyeEyelinkEt *self = GEYE_EYELINK_ET(et);
+
+    if (set == self->aoi_set)
+        return;
+
+    if (set && !geye_aoi_set_attach(set, self))
+        return;
+    g_set_object(&self->aoi_set, set);
+    eyelink_thread_set_aoi_set(self, set);
+}
+
+static GEyeAoiSet*
+eyelink_et_get_aoi_set(GEyeEyetracker* et)
+{
+    return GEYE_EYELINK_ET(et)->aoi_set;
+}
+
+static void
+eyelink_et_log_message(GEyeEyetracker* et, const gchar* msg, GError** error)
+{
+    GEyeEyelinkEt *self = GEYE_EYELINK_ET(et);
+
+    if (!(eyelink_state_get(self) & EYELINK_STATE_CONNECTED) &&
+            !self->host_recorder) {
+        g_set_error(
+                error,
+                geye_eyetracker_error_quark(),
+                GEYE_EYETRACKER_ERROR_INCORRECT_MODE,
+                "Unable to log a message, the eyetracker isn't connected "
+                "and there is no host recording."
+                );
+        return;
+    }
+    eyelink_thread_log_message(self, msg);
+}
+
+static void
+eyelink_et_start_host_recording(GEyeEyetracker  *et,
+                                const gchar     *filename,
+                                GError         **error)
+{
+    GEyeEyelinkEt *self = GEYE_EYELINK_ET(et);
+    GEyeRecorder *recorder;
+    gchar *info;
+    gint64 start_time;
+
+    if (self->host_recorder) {
+        g_set_error(
+                error,
+                geye_eyetracker_error_quark(),
+                GEYE_EYETRACKER_ERROR_INCORRECT_MODE,
+                "The host recording has already been started."
+                );
+        return;
+    }
+
+    // The wall clock time that corresponds with GEyeEvent.time == 0.
+    start_time = g_get_real_time() - (g_get_monotonic_time() - self->start_time);
+
+    g_rec_mutex_lock(&self->lock);
+    info = g_strdup(self->info);
+    g_rec_mutex_unlock(&self->lock);
+
+    // Opening the file and starting the writer thread may take a while, the
+    // eyelink thread shouldn't wait for that.
+    recorder = geye_recorder_new(
+            filename,
+            info,
+            self->disp_width,
+            self->disp_height,
+            start_time,
+            error
+            );
+    g_free(info);
+    if (!recorder)
+        return;
+
+    g_rec_mutex_lock(&self->lock);
+    self->host_recorder = recorder;
+    g_rec_mutex_unlock(&self->lock);
+
+    eyelink_thread_start_host_recording(self, recorder);
+}
+
+static void
+eyelink_et_stop_host_recording(GEyeEyetracker* et, GError** error)
+{
+    GEyeEyelinkEt *self = GEYE_EYELINK_ET(et);
+
+    if (!self->host_recorder) {
+        g_set_error(
+                error,
+                geye_eyetracker_error_quark(),
+                GEYE_EYETRACKER_ERROR_INCORRECT_MODE,
+                "There is no host recording to stop."
+                );
+        return;
+    }
+
+    eyelink_thread_stop_host_recording(self);
+    geye_recorder_close(self->host_recorder, error);
+    self->host_recorder = NULL;
+}
+
 static void
 geye_eyetracker_interface_init(GEyeEyetrackerInterface* iface)
 {
@@ -211,6 +550,8 @@ geye_eyetracker_interface_init(GEyeEyetrackerInterface* iface)
     iface->start_recording  = eyelink_et_start_recording;
     iface->stop_recording   = eyelink_et_stop_recording;
 
+    iface->log_message      = eyelink_et_log_message;
+
     iface->start_setup      = eyelink_et_start_setup;
     iface->stop_setup       = eyelink_et_stop_setup;
 
@@ -228,6 +569,19 @@ geye_eyetracker_interface_init(GEyeEyetrackerInterface* iface)
     iface->set_image_data_cb = eyelink_et_set_image_data_cb;
 
     iface->send_key_press   = eyelink_et_send_key_press;
+
+    iface->read_samples         = eyelink_et_read_samples;
+    iface->get_sample_overruns  = eyelink_et_get_sample_overruns;
+    iface->tracker_to_host_time = eyelink_et_tracker_to_host_time;
+    iface->get_latest_sample    = eyelink_et_get_latest_sample;
+    iface->subscribe            = eyelink_et_subscribe;
+    iface->get_latency_stats    = eyelink_et_get_latency_stats;
+    iface->reset_latency_stats  = eyelink_et_reset_latency_stats;
+    iface->set_aoi_set          = eyelink_et_set_aoi_set;
+    iface->get_aoi_set          = eyelink_et_get_aoi_set;
+
+    iface->start_host_recording = eyelink_et_start_host_recording;
+    iface->stop_host_recording  = eyelink_et_stop_host_recording;
 }
 
 static void
@@ -239,6 +593,21 @@ eyelink_et_dispose(GObject* gobject)
     if (self->eyelink_thread)
         eyelink_thread_stop(self);
     self->eyelink_thread = NULL;
+    eyelink_thread_release_aoi_sets(self);
+    g_clear_object(&self->aoi_set);
+
+    // The thread is gone, so the recorder may be closed from here.
+    if (self->host_recorder) {
+        GError *error = NULL;
+        geye_recorder_flush(self->host_recorder);
+        if (!geye_recorder_close(self->host_recorder, &error)) {
+            g_warning("%s", error->message);
+            g_error_free(error);
+        }
+        self->host_recorder = self->recorder = NULL;
+    }
+
+    eyelink_et_stop_counters(self);
 
     if (self->thread_to_instance) {
         g_async_queue_unref(self->thread_to_instance);
@@ -250,24 +619,48 @@ eyelink_et_dispose(GObject* gobject)
         self->instance_to_thread = NULL;
     }
 
+    if (self->dispatch) {
+        geye_sample_dispatch_free(self->dispatch);
+        self->dispatch = NULL;
+    }
+
     if (self->main_context) {
         g_main_context_unref(self->main_context);
         self->main_context = NULL;
     }
 
-    if (self->timer) {
-        g_timer_destroy(self->timer);
-        self->timer = 0;
-    }
-
     G_OBJECT_CLASS(geye_eyelink_et_parent_class)->dispose(gobject);
 }
 
+static void
+eyelink_et_constructed(GObject* gobject)
+{
+    GEyeEyelinkEt* self = GEYE_EYELINK_ET(gobject);
+
+    // The construct properties are set now, let the thread apply them.
+    eyelink_thread_apply_realtime(self);
+
+    G_OBJECT_CLASS(geye_eyelink_et_parent_class)->constructed(gobject);
+}
+
 static void
 eyelink_et_finalize(GObject* gobject)
 {
     GEyeEyelinkEt* self = GEYE_EYELINK_ET(gobject);
     g_free(self->ip_address);
+    g_free(self->link_sample_data);
+    geye_sample_ring_free(self->sample_ring);
+    geye_clock_map_free(self->clock_map);
+    geye_sample_slot_free(self->latest_sample);
+    geye_sample_broadcast_unref(self->broadcast);
+    for (guint i = 0; i < GEYE_LATENCY_N_STAGES; i++)
+        geye_latency_histogram_free(self->latency[i]);
+    geye_fixation_detector_free(self->fixation_detectors[0]);
+    geye_fixation_detector_free(self->fixation_detectors[1]);
+    geye_gaze_filter_free(self->gaze_filters[0]);
+    geye_gaze_filter_free(self->gaze_filters[1]);
+    geye_gaze_velocity_free(self->gaze_velocities[0]);
+    geye_gaze_velocity_free(self->gaze_velocities[1]);
     g_rec_mutex_clear(&self->lock);
 
     G_OBJECT_CLASS(geye_eyelink_et_parent_class)->finalize(gobject);
@@ -277,16 +670,128 @@ typedef enum {
     PROP_NULL,
     PROP_SIMULATED,
     PROP_IP_ADDRESS,
+    PROP_LATENCY_MODE,
+    PROP_SPIN_TIME,
+    PROP_DISPATCH_LATENCY,
+    PROP_SCHED_POLICY,
+    PROP_SCHED_PRIORITY,
+    PROP_CPU_AFFINITY,
+    PROP_LOCK_MEMORY,
+    PROP_FIXATION_DETECTION,
+    PROP_FIXATION_VELOCITY,
+    PROP_FIXATION_DISPERSION,
+    PROP_FIXATION_DURATION,
+    PROP_SMOOTHING,
+    PROP_SMOOTHING_WINDOW,
+    PROP_SMOOTHING_MIN_CUTOFF,
+    PROP_SMOOTHING_BETA,
+    PROP_DIFFERENTIATOR,
+    PROP_DIFFERENTIATOR_WINDOW,
+    PROP_SAMPLES_DRAINED,
+    PROP_SAMPLES_DISPATCHED,
+    PROP_EVENTS_PARSED,
+    PROP_COMMAND_QUEUE_DEPTH,
+    PROP_FRAMES_CONVERTED,
+    PROP_MAX_DRAIN_TIME,
     N_PROPERTIES,
     PROP_CONNECTED,
     PROP_TRACKING,
     PROP_RECORDING,
     PROP_NUM_CALPOINTS,
-    PROP_TRACKER_INFO
+    PROP_TRACKER_INFO,
+    PROP_SAMPLE_DELIVERY,
+    PROP_SAMPLE_FIELDS,
+    PROP_DROP_POLICY,
+    PROP_SAMPLES_DROPPED
 } GEyeEyelinkEtProperty;
 
 static GParamSpec* obj_properties[N_PROPERTIES] = {NULL, };
 
+// The properties that are notified by eyelink_et_notify_counters().
+static const GEyeEyelinkEtProperty counter_properties[] = {
+    PROP_SAMPLES_DRAINED,
+    PROP_SAMPLES_DISPATCHED,
+    PROP_SAMPLES_DROPPED,
+    PROP_EVENTS_PARSED,
+    PROP_COMMAND_QUEUE_DEPTH,
+    PROP_FRAMES_CONVERTED,
+    PROP_MAX_DRAIN_TIME
+};
+
+// The specs of the counter properties, set by the class init.
+static GParamSpec* counter_pspecs[G_N_ELEMENTS(counter_properties)];
+static guint notify_signal_id;
+
+G_STATIC_ASSERT(
+        G_N_ELEMENTS(counter_properties) ==
+        G_N_ELEMENTS(((GEyeEyelinkEt*) NULL)->counters_notified)
+        );
+
+static guint
+eyelink_et_get_counter(GEyeEyelinkEt *self, GEyeEyelinkEtProperty property)
+{
+    GAsyncQueue *queue;
+
+    switch (property) {
+        case PROP_SAMPLES_DRAINED:
+            return g_atomic_int_get(&self->samples_drained);
+        case PROP_SAMPLES_DISPATCHED:
+            return self->dispatch ?
+                geye_sample_dispatch_get_dispatched(self->dispatch) : 0;
+        case PROP_SAMPLES_DROPPED:
+            return self->dispatch ?
+                geye_sample_dispatch_get_dropped(self->dispatch) : 0;
+        case PROP_EVENTS_PARSED:
+            return g_atomic_int_get(&self->events_parsed);
+        case PROP_COMMAND_QUEUE_DEPTH:
+            // Negative while the thread waits for a command.
+            queue = self->instance_to_thread;
+            return queue ? MAX(g_async_queue_length(queue), 0) : 0;
+        case PROP_FRAMES_CONVERTED:
+            return g_atomic_int_get(&self->frames_converted);
+        case PROP_MAX_DRAIN_TIME:
+            return g_atomic_int_get(&self->max_drain_time);
+        default:
+            g_return_val_if_reached(0);
+    }
+}
+
+/*
+ * Notifies the counters that changed since the previous time, so watching
+ * them doesn't cost a notification for every sample. GObject allocates to
+ * queue a notification even when nobody listens, so only the counters with
+ * a handler are notified; tracking then doesn't allocate at all.
+ */
+static gboolean
+eyelink_et_notify_counters(gpointer data)
+{
+    GEyeEyelinkEt *self = data;
+    GParamSpec *changed[G_N_ELEMENTS(counter_properties)];
+    guint i, n_changed = 0;
+
+    for (i = 0; i < G_N_ELEMENTS(counter_properties); i++) {
+        guint value = eyelink_et_get_counter(self, counter_properties[i]);
+        if (value == self->counters_notified[i])
+            continue;
+        self->counters_notified[i] = value;
+        if (g_signal_has_handler_pending(
+                    self,
+                    notify_signal_id,
+                    g_param_spec_get_name_quark(counter_pspecs[i]),
+                    TRUE))
+            changed[n_changed++] = counter_pspecs[i];
+    }
+    if (!n_changed)
+        return G_SOURCE_CONTINUE;
+
+    g_object_freeze_notify(G_OBJECT(self));
+    for (i = 0; i < n_changed; i++)
+        g_object_notify_by_pspec(G_OBJECT(self), changed[i]);
+    g_object_thaw_notify(G_OBJECT(self));
+
+    return G_SOURCE_CONTINUE;
+}
+
 static void
 geye_eyelink_et_set_property(GObject       *obj,
                              guint          property_id,
@@ -304,7 +809,106 @@ geye_eyelink_et_set_property(GObject       *obj,
         case PROP_IP_ADDRESS:
             geye_eyelink_et_set_ip_address(self, g_value_get_string(value));
             break;
+        case PROP_SAMPLE_DELIVERY:
+            g_atomic_int_set(&self->sample_delivery, g_value_get_flags(value));
+            break;
+        case PROP_SAMPLE_FIELDS:
+            // HREF and raw data are requested from the tracker when
+            // tracking starts.
+            g_atomic_int_set(&self->sample_fields, g_value_get_flags(value));
+            break;
+        case PROP_DROP_POLICY:
+            geye_sample_dispatch_set_policy(
+                    self->dispatch, g_value_get_enum(value)
+                    );
+            break;
+        case PROP_LATENCY_MODE:
+            g_atomic_int_set(&self->latency_mode, g_value_get_enum(value));
+            // The latency of the previous mode is meaningless now.
+            g_atomic_int_set(&self->dispatch_latency, 0);
+            break;
+        case PROP_SPIN_TIME:
+            g_atomic_int_set(&self->spin_time, g_value_get_uint(value));
+            break;
+        case PROP_SCHED_POLICY:
+            self->sched_policy = g_value_get_enum(value);
+            break;
+        case PROP_SCHED_PRIORITY:
+            self->sched_priority = g_value_get_int(value);
+            break;
+        case PROP_CPU_AFFINITY:
+            self->cpu_affinity = g_value_get_uint64(value);
+            break;
+        case PROP_LOCK_MEMORY:
+            self->lock_memory = g_value_get_boolean(value);
+            break;
+        case PROP_FIXATION_DETECTION:
+            g_atomic_int_set(
+                    &self->fixation_detection, g_value_get_enum(value)
+                    );
+            eyelink_thread_configure_fixations(self);
+            break;
+        case PROP_FIXATION_VELOCITY:
+            g_rec_mutex_lock(&self->lock);
+            self->fixation_velocity = g_value_get_double(value);
+            g_rec_mutex_unlock(&self->lock);
+            eyelink_thread_configure_fixations(self);
+            break;
+        case PROP_FIXATION_DISPERSION:
+            g_rec_mutex_lock(&self->lock);
+            self->fixation_dispersion = g_value_get_double(value);
+            g_rec_mutex_unlock(&self->lock);
+            eyelink_thread_configure_fixations(self);
+            break;
+        case PROP_FIXATION_DURATION:
+            g_rec_mutex_lock(&self->lock);
+            self->fixation_duration = g_value_get_uint(value);
+            g_rec_mutex_unlock(&self->lock);
+            eyelink_thread_configure_fixations(self);
+            break;
+        case PROP_SMOOTHING:
+            g_atomic_int_set(&self->smoothing, g_value_get_enum(value));
+            eyelink_thread_configure_smoothing(self);
+            break;
+        case PROP_SMOOTHING_WINDOW:
+            g_rec_mutex_lock(&self->lock);
+            self->smoothing_window = g_value_get_uint(value);
+            g_rec_mutex_unlock(&self->lock);
+            eyelink_thread_configure_smoothing(self);
+            break;
+        case PROP_SMOOTHING_MIN_CUTOFF:
+            g_rec_mutex_lock(&self->lock);
+            self->smoothing_min_cutoff = g_value_get_double(value);
+            g_rec_mutex_unlock(&self->lock);
+            eyelink_thread_configure_smoothing(self);
+            break;
+        case PROP_SMOOTHING_BETA:
+            g_rec_mutex_lock(&self->lock);
+            self->smoothing_beta = g_value_get_double(value);
+            g_rec_mutex_unlock(&self->lock);
+            eyelink_thread_configure_smoothing(self);
+            break;
+        case PROP_DIFFERENTIATOR:
+            g_rec_mutex_lock(&self->lock);
+            self->differentiator = g_value_get_enum(value);
+            g_rec_mutex_unlock(&self->lock);
+            eyelink_thread_configure_velocity(self);
+            break;
+        case PROP_DIFFERENTIATOR_WINDOW:
+            g_rec_mutex_lock(&self->lock);
+            self->differentiator_window = g_value_get_uint(value);
+            g_rec_mutex_unlock(&self->lock);
+            eyelink_thread_configure_velocity(self);
+            break;
         case PROP_SIMULATED:
+        case PROP_DISPATCH_LATENCY:
+        case PROP_SAMPLES_DRAINED:
+        case PROP_SAMPLES_DISPATCHED:
+        case PROP_SAMPLES_DROPPED:
+        case PROP_EVENTS_PARSED:
+        case PROP_COMMAND_QUEUE_DEPTH:
+        case PROP_FRAMES_CONVERTED:
+        case PROP_MAX_DRAIN_TIME:
         case PROP_CONNECTED:
         case PROP_TRACKER_INFO:
         case PROP_NULL:
@@ -320,20 +924,21 @@ geye_eyelink_et_get_property(GObject       *obj,
                              )
 {
     GEyeEyelinkEt* self = GEYE_EYELINK_ET(obj);
+    gint state = eyelink_state_get(self);
     g_rec_mutex_lock(&self->lock);
 
     switch((GEyeEyelinkEtProperty) property_id) {
         case PROP_CONNECTED:
-            g_value_set_boolean(value, self->connected);
+            g_value_set_boolean(value, (state & EYELINK_STATE_CONNECTED) != 0);
             break;
         case PROP_SIMULATED:
             g_value_set_boolean(value, geye_eyelink_et_get_simulated(self));
             break;
         case PROP_RECORDING:
-            g_value_set_boolean(value, self->recording);
+            g_value_set_boolean(value, (state & EYELINK_STATE_RECORDING) != 0);
             break;
         case PROP_TRACKING:
-            g_value_set_boolean(value, self->tracking);
+            g_value_set_boolean(value, (state & EYELINK_STATE_TRACKING) != 0);
             break;
         case PROP_NUM_CALPOINTS:
             g_value_set_uint(value, self->num_calpoints);
@@ -344,6 +949,82 @@ geye_eyelink_et_get_property(GObject       *obj,
         case PROP_TRACKER_INFO:
             g_value_set_string(value, self->info);
             break;
+        case PROP_SAMPLE_DELIVERY:
+            g_value_set_flags(value, g_atomic_int_get(&self->sample_delivery));
+            break;
+        case PROP_SAMPLE_FIELDS:
+            g_value_set_flags(value, g_atomic_int_get(&self->sample_fields));
+            break;
+        case PROP_DROP_POLICY:
+            g_value_set_enum(
+                    value,
+                    self->dispatch ?
+                        geye_sample_dispatch_get_policy(self->dispatch) :
+                        GEYE_DROP_NEWEST
+                    );
+            break;
+        case PROP_SAMPLES_DRAINED:
+        case PROP_SAMPLES_DISPATCHED:
+        case PROP_SAMPLES_DROPPED:
+        case PROP_EVENTS_PARSED:
+        case PROP_COMMAND_QUEUE_DEPTH:
+        case PROP_FRAMES_CONVERTED:
+        case PROP_MAX_DRAIN_TIME:
+            g_value_set_uint(value, eyelink_et_get_counter(self, property_id));
+            break;
+        case PROP_LATENCY_MODE:
+            g_value_set_enum(value, g_atomic_int_get(&self->latency_mode));
+            break;
+        case PROP_SPIN_TIME:
+            g_value_set_uint(value, g_atomic_int_get(&self->spin_time));
+            break;
+        case PROP_DISPATCH_LATENCY:
+            g_value_set_uint(value, g_atomic_int_get(&self->dispatch_latency));
+            break;
+        case PROP_SCHED_POLICY:
+            g_value_set_enum(value, self->sched_policy);
+            break;
+        case PROP_SCHED_PRIORITY:
+            g_value_set_int(value, self->sched_priority);
+            break;
+        case PROP_CPU_AFFINITY:
+            g_value_set_uint64(value, self->cpu_affinity);
+            break;
+        case PROP_LOCK_MEMORY:
+            g_value_set_boolean(value, self->lock_memory);
+            break;
+        case PROP_FIXATION_DETECTION:
+            g_value_set_enum(
+                    value, g_atomic_int_get(&self->fixation_detection)
+                    );
+            break;
+        case PROP_FIXATION_VELOCITY:
+            g_value_set_double(value, self->fixation_velocity);
+            break;
+        case PROP_FIXATION_DISPERSION:
+            g_value_set_double(value, self->fixation_dispersion);
+            break;
+        case PROP_FIXATION_DURATION:
+            g_value_set_uint(value, self->fixation_duration);
+            break;
+        case PROP_SMOOTHING:
+            g_value_set_enum(value, g_atomic_int_get(&self->smoothing));
+            break;
+        case PROP_SMOOTHING_WINDOW:
+            g_value_set_uint(value, self->smoothing_window);
+            break;
+        case PROP_SMOOTHING_MIN_CUTOFF:
+            g_value_set_double(value, self->smoothing_min_cutoff);
+            break;
+        case PROP_SMOOTHING_BETA:
+            g_value_set_double(value, self->smoothing_beta);
+            break;
+        case PROP_DIFFERENTIATOR:
+            g_value_set_enum(value, self->differentiator);
+            break;
+        case PROP_DIFFERENTIATOR_WINDOW:
+            g_value_set_uint(value, self->differentiator_window);
+            break;
         case PROP_NULL:
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, property_id, pspec);
@@ -355,6 +1036,9 @@ static void
 geye_eyelink_et_class_init(GEyeEyelinkEtClass* klass)
 {
     GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    guint i;
+
+    object_class->constructed = eyelink_et_constructed;
     object_class->dispose = eyelink_et_dispose;
     object_class->finalize = eyelink_et_finalize;
     object_class->get_property = geye_eyelink_et_get_property;
@@ -376,6 +1060,274 @@ geye_eyelink_et_class_init(GEyeEyelinkEtClass* klass)
             G_PARAM_READWRITE | G_PARAM_CONSTRUCT
             );
 
+    obj_properties[PROP_LATENCY_MODE] = g_param_spec_enum(
+            "latency-mode",
+            "Latency mode",
+            "How the Eyelink-thread waits for new data from the eyetracker.",
+            GEYE_TYPE_LATENCY_MODE,
+            GEYE_LATENCY_MODE_SLEEP,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+            );
+
+    obj_properties[PROP_SPIN_TIME] = g_param_spec_uint(
+            "spin-time",
+            "Spin time",
+            "How many µs the hybrid latency mode keeps polling before it "
+            "sleeps.",
+            0, G_USEC_PER_SEC,
+            EYELINK_DEFAULT_SPIN_TIME,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+            );
+
+    /**
+     * GEyeEyelinkEt:dispatch-latency:
+     *
+     * The running average of the time in µs between the moment the
+     * eyetracker took a sample and the moment the Eyelink-thread dispatched
+     * it, measured with the clock of the tracker mapped to the host. It
+     * includes the latency of the tracker and the link, the remainder
+     * depends on #GEyeEyelinkEt:latency-mode. It is reset when the
+     * latency-mode changes.
+     */
+    obj_properties[PROP_DISPATCH_LATENCY] = g_param_spec_uint(
+            "dispatch-latency",
+            "Dispatch latency",
+            "Average time in µs between taking and dispatching a sample.",
+            0, G_MAXUINT,
+            0,
+            G_PARAM_READABLE
+            );
+
+    /**
+     * GEyeEyelinkEt:sched-policy:
+     *
+     * The scheduling policy of the Eyelink-thread. The real-time policies
+     * keep the thread from being preempted by e.g. the compositor, but
+     * usually require privileges. When the system refuses, the
+     * #GEyeEyetracker::error signal is emitted and the thread keeps the
+     * default policy.
+     */
+    obj_properties[PROP_SCHED_POLICY] = g_param_spec_enum(
+            "sched-policy",
+            "Scheduling policy",
+            "The scheduling policy of the Eyelink-thread.",
+            GEYE_TYPE_SCHED_POLICY,
+            GEYE_SCHED_POLICY_OTHER,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY
+            );
+
+    obj_properties[PROP_SCHED_PRIORITY] = g_param_spec_int(
+            "sched-priority",
+            "Scheduling priority",
+            "The priority for the real-time scheduling policies, it is "
+            "clamped to the range of the policy.",
+            0, 99,
+            EYELINK_DEFAULT_SCHED_PRIORITY,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY
+            );
+
+    obj_properties[PROP_CPU_AFFINITY] = g_param_spec_uint64(
+            "cpu-affinity",
+            "CPU affinity",
+            "Bit n allows the Eyelink-thread to run on CPU n, 0 means any CPU.",
+            0, G_MAXUINT64,
+            0,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY
+            );
+
+    obj_properties[PROP_LOCK_MEMORY] = g_param_spec_boolean(
+            "lock-memory",
+            "Lock memory",
+            "Lock the memory of the process into RAM and prefault the "
+            "sample buffers.",
+            FALSE,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY
+            );
+
+    /**
+     * GEyeEyelinkEt:fixation-detection:
+     *
+     * Detect fixations from the samples on the host, for when the link
+     * doesn't carry the fixations of the eyetracker, e.g. in simulated mode.
+     * The fixations are emitted by the #GEyeEyetracker::fixation signal, the
+     * fixations of the eyetracker are ignored while this isn't
+     * %GEYE_FIXATION_DETECTION_NONE. The start of a fixation is emitted once
+     * it lasted #GEyeEyelinkEt:fixation-duration.
+     */
+    obj_properties[PROP_FIXATION_DETECTION] = g_param_spec_enum(
+            "fixation-detection",
+            "Fixation detection",
+            "The algorithm to detect fixations on the host.",
+            GEYE_TYPE_FIXATION_DETECTION,
+            GEYE_FIXATION_DETECTION_NONE,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+            );
+
+    obj_properties[PROP_FIXATION_VELOCITY] = g_param_spec_double(
+            "fixation-velocity",
+            "Fixation velocity",
+            "The velocity in pixels/s below which the gaze is fixating.",
+            0, G_MAXDOUBLE,
+            EYELINK_DEFAULT_FIXATION_VELOCITY,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+            );
+
+    obj_properties[PROP_FIXATION_DISPERSION] = g_param_spec_double(
+            "fixation-dispersion",
+            "Fixation dispersion",
+            "The horizontal plus vertical extent in pixels of the gaze below "
+            "which it is fixating.",
+            0, G_MAXDOUBLE,
+            EYELINK_DEFAULT_FIXATION_DISPERSION,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+            );
+
+    obj_properties[PROP_FIXATION_DURATION] = g_param_spec_uint(
+            "fixation-duration",
+            "Fixation duration",
+            "The minimum duration of a fixation in ms.",
+            0, EYELINK_MAX_FIXATION_DURATION,
+            EYELINK_DEFAULT_FIXATION_DURATION,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+            );
+
+    /**
+     * GEyeEyelinkEt:smoothing:
+     *
+     * Smooth the gaze on the host, before it is delivered by the signals,
+     * geye_eyetracker_read_samples() and the latest sample, and before
+     * fixations and areas of interest are detected. The host recording keeps
+     * the gaze as it was measured, the extended samples carry it with
+     * %GEYE_SAMPLE_FIELD_UNFILTERED. The filter may be changed while
+     * tracking, a change of the filter or its window starts it over.
+     */
+    obj_properties[PROP_SMOOTHING] = g_param_spec_enum(
+            "smoothing",
+            "Smoothing",
+            "The filter with which the gaze is smoothed on the host.",
+            GEYE_TYPE_SMOOTHING,
+            GEYE_SMOOTHING_NONE,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+            );
+
+    obj_properties[PROP_SMOOTHING_WINDOW] = g_param_spec_uint(
+            "smoothing-window",
+            "Smoothing window",
+            "The number of samples of the moving average and the "
+            "Savitzky-Golay filter, the latter uses at least 3.",
+            1, EYELINK_MAX_SMOOTHING_WINDOW,
+            EYELINK_DEFAULT_SMOOTHING_WINDOW,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+            );
+
+    obj_properties[PROP_SMOOTHING_MIN_CUTOFF] = g_param_spec_double(
+            "smoothing-min-cutoff",
+            "Smoothing minimum cutoff",
+            "The cutoff frequency in Hz of the 1€ filter when the eye is "
+            "still, lower smooths the fixations more.",
+            0.001, 1000.0,
+            EYELINK_DEFAULT_SMOOTHING_MIN_CUTOFF,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+            );
+
+    obj_properties[PROP_SMOOTHING_BETA] = g_param_spec_double(
+            "smoothing-beta",
+            "Smoothing beta",
+            "How fast the cutoff frequency of the 1€ filter rises with the "
+            "velocity of the eye in pixels per second, higher lags less.",
+            0.0, 1000.0,
+            EYELINK_DEFAULT_SMOOTHING_BETA,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+            );
+
+    /**
+     * GEyeEyelinkEt:differentiator:
+     *
+     * How the velocity and acceleration of the extended samples are
+     * computed, when #GEyeEyetracker:sample-fields selects them. They are
+     * computed from the smoothed gaze and the timestamps of the eyetracker,
+     * and converted to degrees with the resolution that the eyetracker
+     * reports for the display set by
+     * geye_eyelink_et_set_display_dimensions().
+     */
+    obj_properties[PROP_DIFFERENTIATOR] = g_param_spec_enum(
+            "differentiator",
+            "Differentiator",
+            "How the velocity and acceleration of the gaze are computed.",
+            GEYE_TYPE_DIFFERENTIATOR,
+            GEYE_DIFFERENTIATOR_FIVE_POINT,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+            );
+
+    obj_properties[PROP_DIFFERENTIATOR_WINDOW] = g_param_spec_uint(
+            "differentiator-window",
+            "Differentiator window",
+            "The number of samples of the Savitzky-Golay differentiator.",
+            3, EYELINK_MAX_DIFFERENTIATOR_WINDOW,
+            EYELINK_DEFAULT_DIFFERENTIATOR_WINDOW,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+            );
+
+    /*
+     * The performance counters may be read from any thread. A change is
+     * notified in the main context of the eyetracker, at most four times
+     * per second.
+     */
+    obj_properties[PROP_SAMPLES_DRAINED] = g_param_spec_uint(
+            "samples-drained",
+            "Samples drained",
+            "The number of samples the Eyelink-thread read from the link.",
+            0, G_MAXUINT,
+            0,
+            G_PARAM_READABLE
+            );
+
+    obj_properties[PROP_SAMPLES_DISPATCHED] = g_param_spec_uint(
+            "samples-dispatched",
+            "Samples dispatched",
+            "The number of samples the main context took up for the signals.",
+            0, G_MAXUINT,
+            0,
+            G_PARAM_READABLE
+            );
+
+    obj_properties[PROP_EVENTS_PARSED] = g_param_spec_uint(
+            "events-parsed",
+            "Events parsed",
+            "The number of events other than samples read from the link.",
+            0, G_MAXUINT,
+            0,
+            G_PARAM_READABLE
+            );
+
+    obj_properties[PROP_COMMAND_QUEUE_DEPTH] = g_param_spec_uint(
+            "command-queue-depth",
+            "Command queue depth",
+            "The number of commands waiting for the Eyelink-thread.",
+            0, G_MAXUINT,
+            0,
+            G_PARAM_READABLE
+            );
+
+    obj_properties[PROP_FRAMES_CONVERTED] = g_param_spec_uint(
+            "frames-converted",
+            "Frames converted",
+            "The number of camera images converted for the image callback.",
+            0, G_MAXUINT,
+            0,
+            G_PARAM_READABLE
+            );
+
+    obj_properties[PROP_MAX_DRAIN_TIME] = g_param_spec_uint(
+            "max-drain-time",
+            "Maximum drain time",
+            "The longest time in µs the Eyelink-thread spent draining the "
+            "link at once, since the latency statistics were reset.",
+            0, G_MAXUINT,
+            0,
+            G_PARAM_READABLE
+            );
+
     g_object_class_install_properties(
             object_class, N_PROPERTIES, obj_properties
             );
@@ -387,6 +1339,28 @@ geye_eyelink_et_class_init(GEyeEyelinkEtClass* klass)
             object_class, PROP_NUM_CALPOINTS, "num-calpoints"
             );
     g_object_class_override_property(object_class, PROP_TRACKER_INFO, "tracker-info");
+    g_object_class_override_property(
+            object_class, PROP_SAMPLE_DELIVERY, "sample-delivery"
+            );
+    g_object_class_override_property(
+            object_class, PROP_SAMPLE_FIELDS, "sample-fields"
+            );
+    g_object_class_override_property(
+            object_class, PROP_DROP_POLICY, "drop-policy"
+            );
+    g_object_class_override_property(
+            object_class, PROP_SAMPLES_DROPPED, "samples-dropped"
+            );
+
+    for (i = 0; i < G_N_ELEMENTS(counter_properties); i++) {
+        if (counter_properties[i] == PROP_SAMPLES_DROPPED)
+            counter_pspecs[i] = g_object_class_find_property(
+                    object_class, "samples-dropped"
+                    );
+        else
+            counter_pspecs[i] = obj_properties[counter_properties[i]];
+    }
+    notify_signal_id = g_signal_lookup("notify", G_TYPE_OBJECT);
 }
 
 /* ***************************** public functions *************************** */
@@ -438,7 +1412,7 @@ geye_eyelink_et_set_simulated(
 
     g_rec_mutex_lock(&self->lock);
 
-    if (self->connected) {
+    if (eyelink_state_get(self) & EYELINK_STATE_CONNECTED) {
         g_set_error(
                 error,
                 geye_eyetracker_error_quark(),
@@ -537,7 +1511,7 @@ geye_eyelink_et_set_ip_address(GEyeEyelinkEt* self, const char* ip_address)
 
     g_rec_mutex_lock(&self->lock);
 
-    if (!self->connected) {
+    if (!(eyelink_state_get(self) & EYELINK_STATE_CONNECTED)) {
         if (g_strcmp0(ip_address, self->ip_address) != 0) {
 
             if (self->ip_address) {
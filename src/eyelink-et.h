@@ -26,6 +26,52 @@
 
 G_BEGIN_DECLS
 
+/**
+ * GEyeLatencyMode:
+ * @GEYE_LATENCY_MODE_SLEEP: when there is nothing to read from the eyetracker
+ *                           the Eyelink-thread sleeps up to a millisecond.
+ *                           This is cheap, but a sample might be seen a
+ *                           millisecond after it arrived.
+ * @GEYE_LATENCY_MODE_HYBRID: the Eyelink-thread keeps polling for
+ *                            #GEyeEyelinkEt:spin-time µs after the last
+ *                            received data, only then it sleeps.
+ * @GEYE_LATENCY_MODE_BUSY_POLL: the Eyelink-thread never sleeps while
+ *                               tracking, this keeps a CPU core busy.
+ *
+ * Determines how the Eyelink-thread waits for new data from the eyetracker.
+ */
+typedef enum _GEyeLatencyMode {
+    GEYE_LATENCY_MODE_SLEEP,
+    GEYE_LATENCY_MODE_HYBRID,
+    GEYE_LATENCY_MODE_BUSY_POLL,
+} GEyeLatencyMode;
+
+#define GEYE_TYPE_LATENCY_MODE geye_latency_mode_get_type()
+G_MODULE_EXPORT GType
+geye_latency_mode_get_type(void);
+
+/**
+ * GEyeSchedPolicy:
+ * @GEYE_SCHED_POLICY_OTHER: the default time sharing policy of the system.
+ * @GEYE_SCHED_POLICY_FIFO: the real-time first-in first-out policy, the
+ *                          Eyelink-thread runs until it blocks or is
+ *                          preempted by a thread of higher priority.
+ * @GEYE_SCHED_POLICY_RR: the real-time round robin policy, like
+ *                        %GEYE_SCHED_POLICY_FIFO, but threads of the same
+ *                        priority take turns.
+ *
+ * The scheduling policy of the Eyelink-thread.
+ */
+typedef enum _GEyeSchedPolicy {
+    GEYE_SCHED_POLICY_OTHER,
+    GEYE_SCHED_POLICY_FIFO,
+    GEYE_SCHED_POLICY_RR,
+} GEyeSchedPolicy;
+
+#define GEYE_TYPE_SCHED_POLICY geye_sched_policy_get_type()
+G_MODULE_EXPORT GType
+geye_sched_policy_get_type(void);
+
 #define GEYE_TYPE_EYELINK_ET geye_eyelink_et_get_type()
 G_MODULE_EXPORT
 G_DECLARE_FINAL_TYPE(GEyeEyelinkEt, geye_eyelink_et, GEYE, EYELINK_ET, GObject)
@@ -40,12 +86,61 @@ struct _GEyeEyelinkEt {
 
     gboolean        simulated;
     GThread*        eyelink_thread;
-    gboolean        connected;
-    gboolean        tracking;
-    gboolean        recording;
+    gint            state;          // Atomic, see EyelinkState
     guint           num_calpoints;
     gdouble         disp_width;
     gdouble         disp_height;
+
+    gint            latency_mode;       // Atomic, a GEyeLatencyMode
+    gint            spin_time;          // Atomic, µs for the hybrid mode
+    gint            dispatch_latency;   // Atomic, µs
+
+    /*
+     * Performance counters, the Eyelink-thread adds to them, any thread may
+     * read them. While connected, changes are notified at most every
+     * EYELINK_COUNTER_INTERVAL ms by counter_source in the main context.
+     */
+    guint           samples_drained;    // Atomic
+    guint           events_parsed;      // Atomic
+    guint           frames_converted;   // Atomic
+    guint           max_drain_time;     // Atomic, µs
+    guint           counters_notified[7]; // Main context, see notify_counters
+    GSource        *counter_source;
+
+    gint            fixation_detection; // Atomic, a GEyeFixationDetection
+    gdouble         fixation_velocity;  // pixels per second
+    gdouble         fixation_dispersion;// pixels
+    guint           fixation_duration;  // ms
+    /* Thread only, for the left and right eye. */
+    struct _GEyeFixationDetector *fixation_detectors[2];
+
+    gint            smoothing;          // Atomic, a GEyeSmoothing
+    guint           smoothing_window;   // samples
+    gdouble         smoothing_min_cutoff;// Hz
+    gdouble         smoothing_beta;
+    /* Thread only, for the left and right eye. */
+    struct _GEyeGazeFilter *gaze_filters[2];
+
+    GEyeDifferentiator differentiator;
+    guint           differentiator_window; // samples
+    /* Thread only, for the left and right eye. */
+    struct _GEyeGazeVelocity *gaze_velocities[2];
+
+    /* Areas of interest, see eyelink_thread_set_aoi_set() */
+    GEyeAoiSet     *aoi_set;        // Main context, the attached set
+    gpointer        aoi_pending;    // Atomic, handed over to the thread
+    GEyeAoiSet     *aoi_current;    // Thread only
+    GEyeAoiSet     *aoi_retired;    // Thread only, waits to be released
+
+    /* The host recording, see eyelink_thread_start_host_recording() */
+    struct _GEyeRecorder *host_recorder;   // Main context
+    struct _GEyeRecorder *recorder;        // Thread only
+
+    /* Construct only, applied by the Eyelink-thread to itself. */
+    GEyeSchedPolicy sched_policy;
+    gint            sched_priority;
+    guint64         cpu_affinity;
+    gboolean        lock_memory;
     /* Talk from instance to thread */
     GAsyncQueue*    instance_to_thread;
     /* Replies are send back via this queue */
@@ -56,10 +151,19 @@ struct _GEyeEyelinkEt {
 
     gboolean        quit_hooks;     // Thread only.
     gboolean        stop_thread;    // Thread only.
-    gint            used_eye;       // Thread only. is LEFT, RIGHT or BINOCULAR
+
+    guint           sample_delivery;// GEyeSampleDelivery flags
+    guint           sample_fields;  // Atomic, GEyeSampleFields flags
+    gchar*          link_sample_data; // Thread only, the setting to restore
+    struct _GEyeSampleDispatch *dispatch; // Samples for the signals
+    struct _GEyeSampleRing *sample_ring; // Samples for geye_eyetracker_read_samples
 
     GMainContext   *main_context; // The context in which signal will be emitted.
-    GTimer         *timer;
+    gint64          start_time; // GEyeEvent.time is relative to this.
+    struct _GEyeClockMap *clock_map; // Maps tracker time to host time.
+    struct _GEyeSampleSlot *latest_sample; // The newest sample.
+    struct _GEyeSampleBroadcast *broadcast; // Samples for the subscribers.
+    struct _GEyeLatencyHistogram *latency[GEYE_LATENCY_N_STAGES];
 
     /*
      * Callbacks for end users, although using signals is
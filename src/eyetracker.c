@@ -23,11 +23,75 @@
 
 G_DEFINE_INTERFACE(GEyeEyetracker, geye_eyetracker, G_TYPE_OBJECT)
 
+GType
+geye_sample_delivery_get_type(void)
+{
+    static gsize delivery_type = 0;
+
+    if (g_once_init_enter(&delivery_type)) {
+        static const GFlagsValue values[] = {
+            {GEYE_DELIVER_NONE, "GEYE_DELIVER_NONE", "none"},
+            {GEYE_DELIVER_SAMPLE, "GEYE_DELIVER_SAMPLE", "sample"},
+            {GEYE_DELIVER_SAMPLES, "GEYE_DELIVER_SAMPLES", "samples"},
+            {GEYE_DELIVER_PULL, "GEYE_DELIVER_PULL", "pull"},
+            {GEYE_DELIVER_BINOCULAR, "GEYE_DELIVER_BINOCULAR", "binocular"},
+            {GEYE_DELIVER_EXTENDED, "GEYE_DELIVER_EXTENDED", "extended"},
+            {0, NULL, NULL}
+        };
+        GType type = g_flags_register_static("GEyeSampleDelivery", values);
+        g_once_init_leave(&delivery_type, type);
+    }
+    return delivery_type;
+}
+
+GType
+geye_drop_policy_get_type(void)
+{
+    static gsize policy_type = 0;
+
+    if (g_once_init_enter(&policy_type)) {
+        static const GEnumValue values[] = {
+            {GEYE_DROP_NEWEST, "GEYE_DROP_NEWEST", "drop-newest"},
+            {GEYE_DROP_OLDEST, "GEYE_DROP_OLDEST", "drop-oldest"},
+            {GEYE_DROP_COALESCE, "GEYE_DROP_COALESCE", "coalesce"},
+            {0, NULL, NULL}
+        };
+        GType type = g_enum_register_static("GEyeDropPolicy", values);
+        g_once_init_leave(&policy_type, type);
+    }
+    return policy_type;
+}
+
+GType
+geye_latency_stage_get_type(void)
+{
+    static gsize stage_type = 0;
+
+    if (g_once_init_enter(&stage_type)) {
+        static const GEnumValue values[] = {
+            {GEYE_LATENCY_LINK, "GEYE_LATENCY_LINK", "link"},
+            {GEYE_LATENCY_PROCESS, "GEYE_LATENCY_PROCESS", "process"},
+            {GEYE_LATENCY_QUEUE, "GEYE_LATENCY_QUEUE", "queue"},
+            {GEYE_LATENCY_TOTAL, "GEYE_LATENCY_TOTAL", "total"},
+            {0, NULL, NULL}
+        };
+        GType type = g_enum_register_static("GEyeLatencyStage", values);
+        g_once_init_leave(&stage_type, type);
+    }
+    return stage_type;
+}
+
 enum signals {
     CONNECTED,
     CAL_POINT_START,
     CAL_POINT_STOP,
     SAMPLE,
+    SAMPLES,
+    BINOCULAR_SAMPLE,
+    EXTENDED_SAMPLE,
+    FIXATION,
+    SACCADE,
+    SAMPLES_DROPPED,
     ERROR,
     N_SIGNALS,
 };
@@ -85,6 +149,48 @@ geye_eyetracker_default_init(GEyeEyetrackerInterface *iface)
             );
     g_object_interface_install_property(iface, spec);
 
+    spec = g_param_spec_flags(
+            "sample-delivery",
+            "Sample delivery",
+            "By means of which signals samples are delivered.",
+            GEYE_TYPE_SAMPLE_DELIVERY,
+            GEYE_DELIVER_SAMPLES,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+            );
+    g_object_interface_install_property(iface, spec);
+
+    spec = g_param_spec_flags(
+            "sample-fields",
+            "Sample fields",
+            "The fields of the extended samples in addition to the gaze.",
+            GEYE_TYPE_SAMPLE_FIELDS,
+            GEYE_SAMPLE_FIELD_NONE,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+            );
+    g_object_interface_install_property(iface, spec);
+
+    spec = g_param_spec_enum(
+            "drop-policy",
+            "Drop policy",
+            "Which samples are dropped when the main context doesn't keep up.",
+            GEYE_TYPE_DROP_POLICY,
+            GEYE_DROP_NEWEST,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+            );
+    g_object_interface_install_property(iface, spec);
+
+    spec = g_param_spec_uint(
+            "samples-dropped",
+            "Samples dropped",
+            "The number of samples and events that were dropped because the "
+            "main context didn't keep up.",
+            0,
+            G_MAXUINT,
+            0,
+            G_PARAM_READABLE
+            );
+    g_object_interface_install_property(iface, spec);
+
     /**
      * GEyeEyetracker::connected:
      * @eyetracker: the object that received this signal.
@@ -157,6 +263,10 @@ geye_eyetracker_default_init(GEyeEyetrackerInterface *iface)
      * is received, it depends on the eyetracker for which `GEyeEyeTypes` can be
      * received. E.g. some eyetrackers do not support an average coordinate of
      * both eyes together.
+     * This signal is only emitted when #GEyeEyetracker:sample-delivery
+     * contains %GEYE_DELIVER_SAMPLE.
+     * The sample is only valid during the emission, use geye_sample_copy()
+     * to keep it.
      */
     signals[SAMPLE] = g_signal_new(
             "sample",
@@ -166,7 +276,142 @@ geye_eyetracker_default_init(GEyeEyetrackerInterface *iface)
             NULL, NULL,
             NULL,
             G_TYPE_NONE,
-            1, GEYE_TYPE_SAMPLE
+            1, GEYE_TYPE_SAMPLE | G_SIGNAL_TYPE_STATIC_SCOPE
+            );
+
+    /**
+     * GEyeEyetracker::samples:
+     * @eyetracker: the object that received this signal
+     * @samples:(transfer none)(element-type GEyeSample): All samples that
+     *          were received from the eyetracker in one go.
+     *
+     * This signal is emitted while tracking when #GEyeEyetracker:sample-delivery
+     * contains %GEYE_DELIVER_SAMPLES. Instead of emitting a signal for every
+     * eye of every sample, the samples are collected and emitted together.
+     * The samples are in the order in which they were received, for binocular
+     * tracking the left eye precedes the right eye.
+     * The array is reused for the next batch, copy the samples to keep them.
+     */
+    signals[SAMPLES] = g_signal_new(
+            "samples",
+            GEYE_TYPE_EYETRACKER,
+            G_SIGNAL_RUN_FIRST | G_SIGNAL_NO_RECURSE,
+            0,
+            NULL, NULL,
+            NULL,
+            G_TYPE_NONE,
+            1, G_TYPE_ARRAY | G_SIGNAL_TYPE_STATIC_SCOPE
+            );
+
+    /**
+     * GEyeEyetracker::binocular-sample:
+     * @eyetracker: the object that received this signal
+     * @sample:(transfer none): the left and right eye at one time point.
+     *
+     * This signal is emitted while tracking when #GEyeEyetracker:sample-delivery
+     * contains %GEYE_DELIVER_BINOCULAR. Once for every sample of the
+     * eyetracker, so the left and right eye don't have to be paired by
+     * the receiver. For monocular tracking only the tracked eye is valid.
+     * The sample is only valid during the emission, use
+     * geye_binocular_sample_copy() to keep it.
+     */
+    signals[BINOCULAR_SAMPLE] = g_signal_new(
+            "binocular-sample",
+            GEYE_TYPE_EYETRACKER,
+            G_SIGNAL_RUN_FIRST | G_SIGNAL_NO_RECURSE,
+            0,
+            NULL, NULL,
+            NULL,
+            G_TYPE_NONE,
+            1, GEYE_TYPE_BINOCULAR_SAMPLE | G_SIGNAL_TYPE_STATIC_SCOPE
+            );
+
+    /**
+     * GEyeEyetracker::extended-sample:
+     * @eyetracker: the object that received this signal
+     * @sample:(transfer none): the tracked eyes with the fields of
+     *         #GEyeEyetracker:sample-fields
+     *
+     * This signal is emitted while tracking when #GEyeEyetracker:sample-delivery
+     * contains %GEYE_DELIVER_EXTENDED, once for every sample of the
+     * eyetracker. Only the selected fields are converted, so a field that
+     * isn't used doesn't cost anything. The sample is only valid during the
+     * emission, use geye_extended_sample_copy() to keep it.
+     */
+    signals[EXTENDED_SAMPLE] = g_signal_new(
+            "extended-sample",
+            GEYE_TYPE_EYETRACKER,
+            G_SIGNAL_RUN_FIRST | G_SIGNAL_NO_RECURSE,
+            0,
+            NULL, NULL,
+            NULL,
+            G_TYPE_NONE,
+            1, GEYE_TYPE_EXTENDED_SAMPLE | G_SIGNAL_TYPE_STATIC_SCOPE
+            );
+
+    /**
+     * GEyeEyetracker::fixation:
+     * @eyetracker: the object that received this signal
+     * @fixation:(transfer none): the start or end of a fixation
+     *
+     * This signal is emitted while tracking when the eyetracker detected
+     * the start or the end of a fixation. The signal is emitted in the order
+     * in which the eyetracker delivered the events. The fixation is only
+     * valid during the emission, use geye_fixation_copy() to keep it.
+     */
+    signals[FIXATION] = g_signal_new(
+            "fixation",
+            GEYE_TYPE_EYETRACKER,
+            G_SIGNAL_RUN_FIRST | G_SIGNAL_NO_RECURSE,
+            0,
+            NULL, NULL,
+            NULL,
+            G_TYPE_NONE,
+            1, GEYE_TYPE_FIXATION | G_SIGNAL_TYPE_STATIC_SCOPE
+            );
+
+    /**
+     * GEyeEyetracker::saccade:
+     * @eyetracker: the object that received this signal
+     * @saccade:(transfer none): the start or end of a saccade
+     *
+     * This signal is emitted while tracking when the eyetracker detected
+     * the start or the end of a saccade. The saccade is only valid during
+     * the emission, use geye_saccade_copy() to keep it.
+     */
+    signals[SACCADE] = g_signal_new(
+            "saccade",
+            GEYE_TYPE_EYETRACKER,
+            G_SIGNAL_RUN_FIRST | G_SIGNAL_NO_RECURSE,
+            0,
+            NULL, NULL,
+            NULL,
+            G_TYPE_NONE,
+            1, GEYE_TYPE_SACCADE | G_SIGNAL_TYPE_STATIC_SCOPE
+            );
+
+    /**
+     * GEyeEyetracker::samples-dropped:
+     * @eyetracker: the object that received this signal
+     * @n_dropped: the number of samples and events that were dropped since
+     *             the previous emission
+     *
+     * The samples for the signals wait in a queue of fixed size until the
+     * main context emits them. When the main context stalls, e.g. while a
+     * modal dialog runs, the queue fills up and samples are dropped
+     * according to #GEyeEyetracker:drop-policy. This signal is emitted once
+     * the main context runs again, #GEyeEyetracker:samples-dropped holds
+     * the total.
+     */
+    signals[SAMPLES_DROPPED] = g_signal_new(
+            "samples-dropped",
+            GEYE_TYPE_EYETRACKER,
+            G_SIGNAL_RUN_FIRST | G_SIGNAL_NO_RECURSE,
+            0,
+            NULL, NULL,
+            NULL,
+            G_TYPE_NONE,
+            1, G_TYPE_UINT
             );
 
     /**
@@ -294,6 +539,29 @@ geye_eyetracker_stop_recording(GEyeEyetracker* et)
     iface->stop_recording(et);
 }
 
+/**
+ * geye_eyetracker_log_message:
+ * @et: a GEyeEyetracker
+ * @msg: the message
+ * @error: returns why the message couldn't be logged
+ *
+ * Logs a message in the recording of the eyetracker, and in the host
+ * recording if one was started with geye_eyetracker_start_host_recording().
+ */
+void
+geye_eyetracker_log_message(GEyeEyetracker* et, const char* msg, GError** error)
+{
+    GEyeEyetrackerInterface* iface;
+
+    g_return_if_fail(GEYE_IS_EYETRACKER(et));
+    g_return_if_fail(msg != NULL);
+    g_return_if_fail(error == NULL || *error == NULL);
+
+    iface = GEYE_EYETRACKER_GET_IFACE(et);
+    g_return_if_fail(iface->log_message != NULL);
+    iface->log_message(et, msg, error);
+}
+
 void
 geye_eyetracker_start_setup(GEyeEyetracker* et)
 {
@@ -461,3 +729,330 @@ geye_eyetracker_send_key_press(GEyeEyetracker*  et,
 
     return iface->send_key_press(et, key, modifiers);
 }
+
+/**
+ * geye_eyetracker_read_samples:
+ * @et: a GEyeEyetracker
+ * @samples:(out caller-allocates)(array length=max_samples): a buffer that
+ *          receives the samples.
+ * @max_samples: the number of samples that fit in @samples
+ *
+ * When #GEyeEyetracker:sample-delivery contains %GEYE_DELIVER_PULL the
+ * eyetracker stores its samples in a ring buffer. This function copies the
+ * oldest samples out of that buffer without waiting for new ones. It may be
+ * called from any thread, as long as only one thread at a time reads the
+ * samples.
+ *
+ * Returns: the number of samples written to @samples
+ */
+guint
+geye_eyetracker_read_samples(GEyeEyetracker    *et,
+                             GEyeSample        *samples,
+                             guint              max_samples)
+{
+    return geye_eyetracker_read_samples_timeout(et, samples, max_samples, 0);
+}
+
+/**
+ * geye_eyetracker_read_samples_timeout:
+ * @et: a GEyeEyetracker
+ * @samples:(out caller-allocates)(array length=max_samples): a buffer that
+ *          receives the samples.
+ * @max_samples: the number of samples that fit in @samples
+ * @timeout_us: how many microseconds to wait for samples when none are
+ *              available, 0 doesn't wait and a negative value waits until
+ *              samples arrive.
+ *
+ * As geye_eyetracker_read_samples(), but blocks the calling thread until
+ * samples are available or @timeout_us has elapsed.
+ *
+ * Returns: the number of samples written to @samples, 0 on timeout.
+ */
+guint
+geye_eyetracker_read_samples_timeout(GEyeEyetracker    *et,
+                                     GEyeSample        *samples,
+                                     guint              max_samples,
+                                     gint64             timeout_us)
+{
+    GEyeEyetrackerInterface *iface;
+
+    g_return_val_if_fail(GEYE_IS_EYETRACKER(et), 0);
+    g_return_val_if_fail(samples != NULL || max_samples == 0, 0);
+
+    iface = GEYE_EYETRACKER_GET_IFACE(et);
+    g_return_val_if_fail(iface->read_samples != NULL, 0);
+
+    return iface->read_samples(et, samples, max_samples, timeout_us);
+}
+
+/**
+ * geye_eyetracker_get_sample_overruns:
+ * @et: a GEyeEyetracker
+ *
+ * Returns: the number of samples that were dropped because the ring buffer
+ *          read by geye_eyetracker_read_samples() was full.
+ */
+guint
+geye_eyetracker_get_sample_overruns(GEyeEyetracker *et)
+{
+    GEyeEyetrackerInterface *iface;
+
+    g_return_val_if_fail(GEYE_IS_EYETRACKER(et), 0);
+
+    iface = GEYE_EYETRACKER_GET_IFACE(et);
+    g_return_val_if_fail(iface->get_sample_overruns != NULL, 0);
+
+    return iface->get_sample_overruns(et);
+}
+
+/**
+ * geye_eyetracker_tracker_to_host_time:
+ * @et: a GEyeEyetracker
+ * @tracker_time: the #GEyeEvent.tracker_time of an event
+ *
+ * The eyetracker keeps estimating how its own clock relates to the
+ * monotonic clock of this computer. This function uses that estimate to
+ * tell when an event happened, which is more accurate than the time at
+ * which the event was received.
+ *
+ * Returns: the time in the clock of g_get_monotonic_time() in µs,
+ *          or 0 when the eyetracker hasn't been able to relate the clocks yet.
+ */
+gint64
+geye_eyetracker_tracker_to_host_time(GEyeEyetracker *et,
+                                     gdouble         tracker_time)
+{
+    GEyeEyetrackerInterface *iface;
+
+    g_return_val_if_fail(GEYE_IS_EYETRACKER(et), 0);
+
+    iface = GEYE_EYETRACKER_GET_IFACE(et);
+    g_return_val_if_fail(iface->tracker_to_host_time != NULL, 0);
+
+    return iface->tracker_to_host_time(et, tracker_time);
+}
+
+/**
+ * geye_eyetracker_get_latest_sample:
+ * @et: a GEyeEyetracker
+ * @sample:(out caller-allocates): returns the newest sample
+ *
+ * Gets the newest sample of the eyetracker, e.g. to draw a gaze-contingent
+ * display at frame time. This doesn't involve a main loop and may be called
+ * from any thread. It doesn't take a lock, so it never waits for the thread
+ * that receives the samples. The sample is stored regardless of
+ * #GEyeEyetracker:sample-delivery.
+ *
+ * Returns: TRUE if @sample was filled in, FALSE if no sample has been
+ *          received yet.
+ */
+gboolean
+geye_eyetracker_get_latest_sample(GEyeEyetracker       *et,
+                                  GEyeBinocularSample  *sample)
+{
+    GEyeEyetrackerInterface *iface;
+
+    g_return_val_if_fail(GEYE_IS_EYETRACKER(et), FALSE);
+    g_return_val_if_fail(sample != NULL, FALSE);
+
+    iface = GEYE_EYETRACKER_GET_IFACE(et);
+    g_return_val_if_fail(iface->get_latest_sample != NULL, FALSE);
+
+    return iface->get_latest_sample(et, sample);
+}
+
+/**
+ * geye_eyetracker_subscribe:
+ * @et: a GEyeEyetracker
+ * @decimation: deliver every n-th sample, 1 delivers all samples
+ * @interval: the minimal time between delivered samples in seconds, 0 for
+ *            no minimum
+ * @error: returns why there is no subscription
+ *
+ * Subscribes to the binocular samples of @et. Every subscriber has its own
+ * cursor and decimation, so e.g. a gaze-contingent display that wants 60
+ * samples per second and an analysis thread that wants all samples don't
+ * interfere. A subscriber that doesn't keep up only loses its own samples,
+ * see geye_subscriber_get_lost(). Read the samples from any thread with
+ * geye_subscriber_read() or attach the subscriber to a main context with
+ * geye_subscriber_attach(). At most %GEYE_MAX_SUBSCRIBERS subscribers can
+ * exist at the same time, unreferencing a subscriber unsubscribes it.
+ *
+ * Returns:(transfer full): a new subscriber or NULL when @error is set.
+ */
+GEyeSubscriber*
+geye_eyetracker_subscribe(GEyeEyetracker   *et,
+                          guint             decimation,
+                          gdouble           interval,
+                          GError          **error)
+{
+    GEyeEyetrackerInterface *iface;
+
+    g_return_val_if_fail(GEYE_IS_EYETRACKER(et), NULL);
+    g_return_val_if_fail(decimation > 0, NULL);
+    g_return_val_if_fail(interval >= 0, NULL);
+    g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+    iface = GEYE_EYETRACKER_GET_IFACE(et);
+    g_return_val_if_fail(iface->subscribe != NULL, NULL);
+
+    return iface->subscribe(et, decimation, interval, error);
+}
+
+/**
+ * geye_eyetracker_get_latency_stats:
+ * @et: a GEyeEyetracker
+ * @stage: the stage of the path of the samples
+ * @stats:(out caller-allocates): returns the latencies of @stage
+ *
+ * Gets the latencies that were measured since the eyetracker was created,
+ * or since the last call to geye_eyetracker_reset_latency_stats(). The
+ * latencies are measured for every sample, the monotonic clock is only read
+ * once per batch of samples, so this is cheap enough to leave on. The
+ * latencies of the queue and the total are only measured for samples that
+ * are delivered by means of signals.
+ * This may be called from any thread.
+ *
+ * Returns: TRUE if @stats was filled in, FALSE if @et doesn't measure
+ *          latencies.
+ */
+gboolean
+geye_eyetracker_get_latency_stats(GEyeEyetracker   *et,
+                                  GEyeLatencyStage  stage,
+                                  GEyeLatencyStats *stats)
+{
+    GEyeEyetrackerInterface *iface;
+
+    g_return_val_if_fail(GEYE_IS_EYETRACKER(et), FALSE);
+    g_return_val_if_fail(stage < GEYE_LATENCY_N_STAGES, FALSE);
+    g_return_val_if_fail(stats != NULL, FALSE);
+
+    iface = GEYE_EYETRACKER_GET_IFACE(et);
+    if (!iface->get_latency_stats)
+        return FALSE;
+
+    return iface->get_latency_stats(et, stage, stats);
+}
+
+/**
+ * geye_eyetracker_reset_latency_stats:
+ * @et: a GEyeEyetracker
+ *
+ * Forgets the latencies that were measured so far, e.g. at the start of a
+ * block of trials. This may be called from any thread.
+ */
+void
+geye_eyetracker_reset_latency_stats(GEyeEyetracker *et)
+{
+    GEyeEyetrackerInterface *iface;
+
+    g_return_if_fail(GEYE_IS_EYETRACKER(et));
+
+    iface = GEYE_EYETRACKER_GET_IFACE(et);
+    if (iface->reset_latency_stats)
+        iface->reset_latency_stats(et);
+}
+
+/**
+ * geye_eyetracker_set_aoi_set:
+ * @et: a GEyeEyetracker
+ * @set:(nullable): the areas of interest to test the gaze against, or
+ *      NULL to stop testing.
+ *
+ * Attaches a set of areas of interest. The eyetracker tests the gaze
+ * against it on the thread that receives the samples and @set emits
+ * #GEyeAoiSet::aoi-enter and #GEyeAoiSet::aoi-leave in the main context of
+ * the eyetracker. The gaze is the average of the valid eyes.
+ *
+ * After this the areas of @set can't be changed anymore. The set replaces
+ * the previous set as a whole, also while tracking, e.g. between trials.
+ * The gaze leaves all areas of the previous set then.
+ *
+ * A set is attached to one eyetracker at a time, it keeps track of the
+ * areas that contain the gaze. Attaching a set that another eyetracker
+ * still uses is a programming error, the set isn't attached then. It may be
+ * attached to another eyetracker once it has been replaced here.
+ */
+void
+geye_eyetracker_set_aoi_set(GEyeEyetracker *et, GEyeAoiSet *set)
+{
+    GEyeEyetrackerInterface *iface;
+
+    g_return_if_fail(GEYE_IS_EYETRACKER(et));
+    g_return_if_fail(set == NULL || GEYE_IS_AOI_SET(set));
+
+    iface = GEYE_EYETRACKER_GET_IFACE(et);
+    g_return_if_fail(iface->set_aoi_set != NULL);
+
+    iface->set_aoi_set(et, set);
+}
+
+/**
+ * geye_eyetracker_get_aoi_set:
+ * @et: a GEyeEyetracker
+ *
+ * Returns:(transfer none)(nullable): the attached set of areas of interest
+ */
+GEyeAoiSet*
+geye_eyetracker_get_aoi_set(GEyeEyetracker *et)
+{
+    GEyeEyetrackerInterface *iface;
+
+    g_return_val_if_fail(GEYE_IS_EYETRACKER(et), NULL);
+
+    iface = GEYE_EYETRACKER_GET_IFACE(et);
+    g_return_val_if_fail(iface->get_aoi_set != NULL, NULL);
+
+    return iface->get_aoi_set(et);
+}
+
+/**
+ * geye_eyetracker_start_host_recording:
+ * @et: a GEyeEyetracker
+ * @filename: the file to create, an existing file is overwritten.
+ * @error: returns why the recording couldn't be started
+ *
+ * Records the samples, fixations, saccades and messages that the host
+ * receives in a binary file, next to the recording of the eyetracker
+ * itself. The file is written by a thread of its own, so a slow disk
+ * doesn't delay the samples. The header holds the tracker info and the
+ * display dimensions, the footer the number of samples and the gaps
+ * between them.
+ */
+void
+geye_eyetracker_start_host_recording(GEyeEyetracker    *et,
+                                     const gchar       *filename,
+                                     GError           **error)
+{
+    GEyeEyetrackerInterface *iface;
+
+    g_return_if_fail(GEYE_IS_EYETRACKER(et));
+    g_return_if_fail(filename != NULL);
+    g_return_if_fail(error == NULL || *error == NULL);
+
+    iface = GEYE_EYETRACKER_GET_IFACE(et);
+    g_return_if_fail(iface->start_host_recording != NULL);
+
+    iface->start_host_recording(et, filename, error);
+}
+
+/**
+ * geye_eyetracker_stop_host_recording:
+ * @et: a GEyeEyetracker
+ * @error: returns why the recording wasn't written completely
+ *
+ * Stops the host recording and waits until it has been written.
+ */
+void
+geye_eyetracker_stop_host_recording(GEyeEyetracker *et, GError **error)
+{
+    GEyeEyetrackerInterface *iface;
+
+    g_return_if_fail(GEYE_IS_EYETRACKER(et));
+    g_return_if_fail(error == NULL || *error == NULL);
+
+    iface = GEYE_EYETRACKER_GET_IFACE(et);
+    g_return_if_fail(iface->stop_host_recording != NULL);
+
+    iface->stop_host_recording(et, error);
+}
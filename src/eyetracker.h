@@ -24,9 +24,116 @@
 
 #include <glib-object.h>
 #include <gio/gio.h>
+#include "aoi-set.h"
+#include "eye-event.h"
+#include "subscriber.h"
 
 G_BEGIN_DECLS 
 
+/**
+ * GEyeSampleDelivery:
+ * @GEYE_DELIVER_NONE: samples are not delivered by means of signals.
+ * @GEYE_DELIVER_SAMPLE: emit #GEyeEyetracker::sample once for every eye of
+ *                       every sample.
+ * @GEYE_DELIVER_SAMPLES: emit #GEyeEyetracker::samples once for all samples
+ *                        that were received from the eyetracker in one go.
+ * @GEYE_DELIVER_PULL: store the samples in a ring buffer from which they
+ *                     can be read with geye_eyetracker_read_samples() from
+ *                     any thread, no main context is involved.
+ * @GEYE_DELIVER_BINOCULAR: emit #GEyeEyetracker::binocular-sample once for
+ *                          every sample, with both eyes in one record.
+ * @GEYE_DELIVER_EXTENDED: emit #GEyeEyetracker::extended-sample once for
+ *                         every sample, with the fields selected by
+ *                         #GEyeEyetracker:sample-fields.
+ *
+ * Determines by means of which signals the samples are delivered in the
+ * context in which the eyetracker was created.
+ */
+typedef enum _GEyeSampleDelivery {
+    GEYE_DELIVER_NONE       = 0,
+    GEYE_DELIVER_SAMPLE     = 1 << 0,
+    GEYE_DELIVER_SAMPLES    = 1 << 1,
+    GEYE_DELIVER_PULL       = 1 << 2,
+    GEYE_DELIVER_BINOCULAR  = 1 << 3,
+    GEYE_DELIVER_EXTENDED   = 1 << 4,
+} GEyeSampleDelivery;
+
+#define GEYE_TYPE_SAMPLE_DELIVERY geye_sample_delivery_get_type()
+G_MODULE_EXPORT GType
+geye_sample_delivery_get_type(void);
+
+/**
+ * GEyeDropPolicy:
+ * @GEYE_DROP_NEWEST: when the queue is full, new samples and events are
+ *                    dropped until the main context catches up.
+ * @GEYE_DROP_OLDEST: when the queue is full, the oldest samples and events
+ *                    make room for the new ones.
+ * @GEYE_DROP_COALESCE: as @GEYE_DROP_OLDEST, and in addition consecutive
+ *                      samples that are waiting for the main context are
+ *                      coalesced into the newest one.
+ *
+ * What happens to the samples for the signals when the main context in
+ * which they are emitted doesn't keep up with the eyetracker, see
+ * #GEyeEyetracker:drop-policy.
+ */
+typedef enum _GEyeDropPolicy {
+    GEYE_DROP_NEWEST,
+    GEYE_DROP_OLDEST,
+    GEYE_DROP_COALESCE
+} GEyeDropPolicy;
+
+#define GEYE_TYPE_DROP_POLICY geye_drop_policy_get_type()
+G_MODULE_EXPORT GType
+geye_drop_policy_get_type(void);
+
+/**
+ * GEyeLatencyStage:
+ * @GEYE_LATENCY_LINK: from the time the eyetracker took a sample until
+ *                     the host received it.
+ * @GEYE_LATENCY_PROCESS: from the time the host received a batch of
+ *                        samples until all of them were queued for the
+ *                        main context, this includes smoothing, areas of
+ *                        interest and fixation detection. It is measured
+ *                        once per batch.
+ * @GEYE_LATENCY_QUEUE: from the time the host received the batch of a
+ *                      sample until the main context emitted it, so it
+ *                      includes the processing of the batch.
+ * @GEYE_LATENCY_TOTAL: from the time the eyetracker took a sample until the
+ *                      main context emitted it.
+ * @GEYE_LATENCY_N_STAGES: the number of stages
+ *
+ * The stages of the path of a sample, of which the latency is measured.
+ */
+typedef enum _GEyeLatencyStage {
+    GEYE_LATENCY_LINK,
+    GEYE_LATENCY_PROCESS,
+    GEYE_LATENCY_QUEUE,
+    GEYE_LATENCY_TOTAL,
+    GEYE_LATENCY_N_STAGES
+} GEyeLatencyStage;
+
+#define GEYE_TYPE_LATENCY_STAGE geye_latency_stage_get_type()
+G_MODULE_EXPORT GType
+geye_latency_stage_get_type(void);
+
+/**
+ * GEyeLatencyStats:
+ * @count: the number of samples that were measured
+ * @p50: the median latency in µs
+ * @p99: the 99th percentile of the latency in µs
+ * @max: the largest latency in µs
+ *
+ * A summary of the latencies of one #GEyeLatencyStage. The percentiles are
+ * the upper bounds of histogram buckets, which are at most 1/16 wider than
+ * their lower bound.
+ */
+typedef struct _GEyeLatencyStats {
+    guint64     count;
+    gint64      p50;
+    gint64      p99;
+    gint64      max;
+} GEyeLatencyStats;
+
 #define GEYE_TYPE_EYETRACKER geye_eyetracker_get_type()
 G_MODULE_EXPORT
 G_DECLARE_INTERFACE(GEyeEyetracker, geye_eyetracker, GEYE, EYETRACKER, GObject)
@@ -112,6 +219,42 @@ struct _GEyeEyetrackerInterface {
     gboolean (*send_key_press)      (GEyeEyetracker            *et,
                                      guint16                    key_code,
                                      guint                      modifiers);
+
+    guint (*read_samples)           (GEyeEyetracker            *et,
+                                     GEyeSample                *samples,
+                                     guint                      max_samples,
+                                     gint64                     timeout_us);
+
+    guint (*get_sample_overruns)    (GEyeEyetracker            *et);
+
+    gint64 (*tracker_to_host_time)  (GEyeEyetracker            *et,
+                                     gdouble                    tracker_time);
+
+    gboolean (*get_latest_sample)   (GEyeEyetracker            *et,
+                                     GEyeBinocularSample       *sample);
+
+    GEyeSubscriber* (*subscribe)    (GEyeEyetracker            *et,
+                                     guint                      decimation,
+                                     gdouble                    interval,
+                                     GError                   **error);
+
+    gboolean (*get_latency_stats)   (GEyeEyetracker            *et,
+                                     GEyeLatencyStage           stage,
+                                     GEyeLatencyStats          *stats);
+
+    void (*reset_latency_stats)     (GEyeEyetracker            *et);
+
+    void (*set_aoi_set)             (GEyeEyetracker            *et,
+                                     GEyeAoiSet                *set);
+
+    GEyeAoiSet* (*get_aoi_set)      (GEyeEyetracker            *et);
+
+    void (*start_host_recording)    (GEyeEyetracker            *et,
+                                     const gchar               *filename,
+                                     GError                   **error);
+
+    void (*stop_host_recording)     (GEyeEyetracker            *et,
+                                     GError                   **error);
 };
 
 G_MODULE_EXPORT void
@@ -192,6 +335,56 @@ geye_eyetracker_send_key_press(GEyeEyetracker  *et,
                                guint16          key_code,
                                guint            modifiers);
 
+G_MODULE_EXPORT guint
+geye_eyetracker_read_samples(GEyeEyetracker    *et,
+                             GEyeSample        *samples,
+                             guint              max_samples);
+
+G_MODULE_EXPORT guint
+geye_eyetracker_read_samples_timeout(GEyeEyetracker    *et,
+                                     GEyeSample        *samples,
+                                     guint              max_samples,
+                                     gint64             timeout_us);
+
+G_MODULE_EXPORT guint
+geye_eyetracker_get_sample_overruns(GEyeEyetracker *et);
+
+G_MODULE_EXPORT gint64
+geye_eyetracker_tracker_to_host_time(GEyeEyetracker *et,
+                                     gdouble         tracker_time);
+
+G_MODULE_EXPORT gboolean
+geye_eyetracker_get_latest_sample(GEyeEyetracker       *et,
+                                  GEyeBinocularSample  *sample);
+
+G_MODULE_EXPORT GEyeSubscriber*
+geye_eyetracker_subscribe(GEyeEyetracker   *et,
+                          guint             decimation,
+                          gdouble           interval,
+                          GError          **error);
+
+G_MODULE_EXPORT gboolean
+geye_eyetracker_get_latency_stats(GEyeEyetracker   *et,
+                                  GEyeLatencyStage  stage,
+                                  GEyeLatencyStats *stats);
+
+G_MODULE_EXPORT void
+geye_eyetracker_reset_latency_stats(GEyeEyetracker *et);
+
+G_MODULE_EXPORT void
+geye_eyetracker_set_aoi_set(GEyeEyetracker *et, GEyeAoiSet *set);
+
+G_MODULE_EXPORT GEyeAoiSet*
+geye_eyetracker_get_aoi_set(GEyeEyetracker *et);
+
+G_MODULE_EXPORT void
+geye_eyetracker_start_host_recording(GEyeEyetracker    *et,
+                                     const gchar       *filename,
+                                     GError           **error);
+
+G_MODULE_EXPORT void
+geye_eyetracker_stop_host_recording(GEyeEyetracker *et, GError **error);
+
 
 G_END_DECLS 
 
@@ -0,0 +1,426 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <math.h>
+
+#include "fixation-detector.h"
+
+typedef struct {
+    gdouble time;
+    gdouble tracker_time;
+    gdouble pos[2];
+} WindowPoint;
+
+/*
+ * A monotonic queue of the points in the window, the keys increase from
+ * front to back, so the front holds the minimum of the window. With a sign
+ * of -1 it holds the maximum.
+ */
+typedef struct {
+    guint64    *seq;
+    guint64     head, tail;
+    guint       axis;
+    gdouble     sign;
+} ExtremeQueue;
+
+enum {MIN_X, MIN_Y, MAX_X, MAX_Y, N_EXTREMES};
+
+struct _GEyeFixationDetector {
+    GEyeFixationDetection   method;
+    gdouble                 velocity;       // pixels per second
+    gdouble                 dispersion;     // pixels
+    gdouble                 min_duration;   // seconds
+
+    /* The sliding window of the dispersion algorithm. */
+    guint                   capacity;
+    WindowPoint            *window;
+    guint64                 head, tail;
+    gdouble                 window_sum[2];
+    ExtremeQueue            extremes[N_EXTREMES];
+
+    /* The previous sample of the velocity algorithm. */
+    gboolean                have_prev;
+    GEyeSample              prev;
+
+    /* The current (candidate) fixation. */
+    gboolean                in_fixation;
+    gboolean                started;        // The start has been reported.
+    GEyeEyeType             eye;
+    gdouble                 start_time;
+    gdouble                 start_tracker_time;
+    gdouble                 end_time;
+    gdouble                 sum[2];
+    guint                   n;
+    gdouble                 min[2], max[2];
+};
+
+static inline WindowPoint*
+window_point(GEyeFixationDetector *detector, guint64 seq)
+{
+    return &detector->window[seq % detector->capacity];
+}
+
+static inline gdouble
+extreme_key(GEyeFixationDetector *detector, ExtremeQueue *queue, guint64 seq)
+{
+    return queue->sign * window_point(detector, seq)->pos[queue->axis];
+}
+
+static void
+window_clear(GEyeFixationDetector *detector)
+{
+    guint i;
+
+    detector->head = detector->tail = 0;
+    detector->window_sum[0] = detector->window_sum[1] = 0;
+    for (i = 0; i < N_EXTREMES; i++)
+        detector->extremes[i].head = detector->extremes[i].tail = 0;
+}
+
+static void
+window_pop(GEyeFixationDetector *detector)
+{
+    WindowPoint *point = window_point(detector, detector->head);
+    guint i;
+
+    for (i = 0; i < N_EXTREMES; i++) {
+        ExtremeQueue *queue = &detector->extremes[i];
+        if (queue->head < queue->tail &&
+                queue->seq[queue->head % detector->capacity] == detector->head)
+            queue->head++;
+    }
+    detector->window_sum[0] -= point->pos[0];
+    detector->window_sum[1] -= point->pos[1];
+    detector->head++;
+}
+
+static void
+window_push(GEyeFixationDetector *detector, const GEyeSample *sample)
+{
+    WindowPoint *point;
+    guint64 seq;
+    guint i;
+
+    if (detector->tail - detector->head == detector->capacity)
+        window_pop(detector);
+
+    seq = detector->tail++;
+    point = window_point(detector, seq);
+    point->time = sample->parent.time;
+    point->tracker_time = sample->parent.tracker_time;
+    point->pos[0] = sample->x;
+    point->pos[1] = sample->y;
+    detector->window_sum[0] += sample->x;
+    detector->window_sum[1] += sample->y;
+
+    // Points that are superseded by the new one can never be an extreme.
+    for (i = 0; i < N_EXTREMES; i++) {
+        ExtremeQueue *queue = &detector->extremes[i];
+        gdouble key = extreme_key(detector, queue, seq);
+        while (queue->tail > queue->head &&
+               extreme_key(detector, queue,
+                           queue->seq[(queue->tail - 1) % detector->capacity]
+                           ) >= key)
+            queue->tail--;
+        queue->seq[queue->tail++ % detector->capacity] = seq;
+    }
+}
+
+static gdouble
+window_extreme(GEyeFixationDetector *detector, guint which)
+{
+    ExtremeQueue *queue = &detector->extremes[which];
+    guint64 seq = queue->seq[queue->head % detector->capacity];
+    return window_point(detector, seq)->pos[queue->axis];
+}
+
+static void
+fixation_begin(GEyeFixationDetector *detector, const GEyeSample *sample)
+{
+    detector->in_fixation = TRUE;
+    detector->started = FALSE;
+    detector->eye = sample->parent.eye;
+    detector->start_time = detector->end_time = sample->parent.time;
+    detector->start_tracker_time = sample->parent.tracker_time;
+    detector->sum[0] = detector->min[0] = detector->max[0] = sample->x;
+    detector->sum[1] = detector->min[1] = detector->max[1] = sample->y;
+    detector->n = 1;
+}
+
+static void
+fixation_add(GEyeFixationDetector *detector, const GEyeSample *sample)
+{
+    detector->end_time = sample->parent.time;
+    detector->sum[0] += sample->x;
+    detector->sum[1] += sample->y;
+    detector->min[0] = MIN(detector->min[0], sample->x);
+    detector->min[1] = MIN(detector->min[1], sample->y);
+    detector->max[0] = MAX(detector->max[0], sample->x);
+    detector->max[1] = MAX(detector->max[1], sample->y);
+    detector->n++;
+}
+
+static void
+fixation_report(GEyeFixationDetector   *detector,
+                GEyeEventType           type,
+                GEyeFixation           *event)
+{
+    event->parent.type = type;
+    event->parent.eye = detector->eye;
+    event->parent.time = detector->start_time;
+    event->parent.tracker_time = detector->start_tracker_time;
+    event->end_time = type == GEYE_EVENT_FIX_START ?
+        detector->start_time : detector->end_time;
+    event->x = detector->sum[0] / detector->n;
+    event->y = detector->sum[1] / detector->n;
+}
+
+/* Returns the number of events, 1 if the start had been reported. */
+static guint
+fixation_finish(GEyeFixationDetector *detector, GEyeFixation *event)
+{
+    guint n = 0;
+
+    if (detector->in_fixation && detector->started) {
+        if (event)
+            fixation_report(detector, GEYE_EVENT_FIX_END, event);
+        n = 1;
+    }
+    detector->in_fixation = detector->started = FALSE;
+    return n;
+}
+
+static guint
+push_velocity(GEyeFixationDetector *detector,
+              const GEyeSample     *sample,
+              GEyeFixation         *events)
+{
+    const GEyeSample *prev = &detector->prev;
+    gdouble dt, velocity;
+    guint n = 0;
+
+    if (!detector->have_prev) {
+        detector->prev = *sample;
+        detector->have_prev = TRUE;
+        return 0;
+    }
+
+    dt = sample->parent.time - prev->parent.time;
+    if (dt <= 0)
+        return 0;
+    velocity = hypot(sample->x - prev->x, sample->y - prev->y) / dt;
+
+    if (velocity < detector->velocity) {
+        if (!detector->in_fixation)
+            fixation_begin(detector, prev);
+        fixation_add(detector, sample);
+        if (!detector->started &&
+                detector->end_time - detector->start_time >=
+                detector->min_duration) {
+            detector->started = TRUE;
+            fixation_report(detector, GEYE_EVENT_FIX_START, &events[n++]);
+        }
+    }
+    else if (detector->in_fixation) {
+        n += fixation_finish(detector, &events[n]);
+    }
+
+    detector->prev = *sample;
+    return n;
+}
+
+static guint
+push_dispersion(GEyeFixationDetector   *detector,
+                const GEyeSample       *sample,
+                GEyeFixation           *events)
+{
+    gdouble time = sample->parent.time;
+    gdouble dispersion;
+    guint n = 0;
+
+    if (detector->in_fixation) {
+        dispersion = MAX(detector->max[0], sample->x) -
+                     MIN(detector->min[0], sample->x) +
+                     MAX(detector->max[1], sample->y) -
+                     MIN(detector->min[1], sample->y);
+        if (dispersion <= detector->dispersion) {
+            fixation_add(detector, sample);
+            return 0;
+        }
+        n += fixation_finish(detector, &events[n]);
+        window_clear(detector);
+    }
+
+    window_push(detector, sample);
+
+    // Keep the shortest window that spans the minimum duration, the longer
+    // ones have been tested before.
+    while (detector->tail - detector->head > 1 &&
+           time - window_point(detector, detector->head + 1)->time >=
+           detector->min_duration)
+        window_pop(detector);
+
+    if (time - window_point(detector, detector->head)->time <
+            detector->min_duration)
+        return n;
+
+    dispersion = window_extreme(detector, MAX_X) -
+                 window_extreme(detector, MIN_X) +
+                 window_extreme(detector, MAX_Y) -
+                 window_extreme(detector, MIN_Y);
+    if (dispersion > detector->dispersion)
+        return n;
+
+    // The window becomes a fixation, from here on it only grows.
+    detector->in_fixation = detector->started = TRUE;
+    detector->eye = sample->parent.eye;
+    detector->start_time = window_point(detector, detector->head)->time;
+    detector->start_tracker_time =
+        window_point(detector, detector->head)->tracker_time;
+    detector->end_time = time;
+    detector->sum[0] = detector->window_sum[0];
+    detector->sum[1] = detector->window_sum[1];
+    detector->n = detector->tail - detector->head;
+    detector->min[0] = window_extreme(detector, MIN_X);
+    detector->min[1] = window_extreme(detector, MIN_Y);
+    detector->max[0] = window_extreme(detector, MAX_X);
+    detector->max[1] = window_extreme(detector, MAX_Y);
+    window_clear(detector);
+
+    fixation_report(detector, GEYE_EVENT_FIX_START, &events[n++]);
+    return n;
+}
+
+/**
+ * geye_fixation_detector_new:
+ * @capacity: the number of samples the window of the dispersion algorithm
+ *            may hold, it should hold the minimum duration at the sample
+ *            rate of the eyetracker.
+ *
+ * Returns: a new detector that detects nothing until it is configured.
+ */
+GEyeFixationDetector*
+geye_fixation_detector_new(guint capacity)
+{
+    GEyeFixationDetector *detector;
+    guint i;
+
+    g_return_val_if_fail(capacity > 0, NULL);
+
+    detector = g_new0(GEyeFixationDetector, 1);
+    detector->capacity = capacity;
+    detector->window = g_new(WindowPoint, capacity);
+    for (i = 0; i < N_EXTREMES; i++) {
+        detector->extremes[i].seq = g_new(guint64, capacity);
+        detector->extremes[i].axis = i % 2;
+        detector->extremes[i].sign = i < MAX_X ? 1 : -1;
+    }
+    return detector;
+}
+
+void
+geye_fixation_detector_free(GEyeFixationDetector *detector)
+{
+    guint i;
+
+    if (!detector)
+        return;
+
+    for (i = 0; i < N_EXTREMES; i++)
+        g_free(detector->extremes[i].seq);
+    g_free(detector->window);
+    g_free(detector);
+}
+
+/**
+ * geye_fixation_detector_configure:
+ * @detector: a GEyeFixationDetector
+ * @method: the algorithm to use
+ * @velocity: the velocity threshold in pixels per second
+ * @dispersion: the dispersion threshold in pixels, the dispersion is the
+ *              sum of the horizontal and vertical extent of the samples.
+ * @min_duration: the minimum duration of a fixation in seconds
+ *
+ * Changes the configuration, a fixation that is going on is dropped without
+ * reporting its end.
+ */
+void
+geye_fixation_detector_configure(GEyeFixationDetector   *detector,
+                                 GEyeFixationDetection   method,
+                                 gdouble                 velocity,
+                                 gdouble                 dispersion,
+                                 gdouble                 min_duration)
+{
+    geye_fixation_detector_end(detector, NULL);
+
+    detector->method = method;
+    detector->velocity = velocity;
+    detector->dispersion = dispersion;
+    detector->min_duration = min_duration;
+}
+
+/**
+ * geye_fixation_detector_push:
+ * @detector: a GEyeFixationDetector
+ * @sample: the next valid sample of the eye
+ * @events:(out caller-allocates): room for
+ *         GEYE_FIXATION_DETECTOR_MAX_EVENTS events
+ *
+ * Feeds the next sample to the detector. Samples must arrive in time
+ * order, without missing data, call geye_fixation_detector_end() at a gap.
+ *
+ * Returns: the number of events stored in @events.
+ */
+guint
+geye_fixation_detector_push(GEyeFixationDetector   *detector,
+                            const GEyeSample       *sample,
+                            GEyeFixation           *events)
+{
+    switch (detector->method) {
+        case GEYE_FIXATION_DETECTION_VELOCITY:
+            return push_velocity(detector, sample, events);
+        case GEYE_FIXATION_DETECTION_DISPERSION:
+            return push_dispersion(detector, sample, events);
+        case GEYE_FIXATION_DETECTION_NONE:
+        default:
+            return 0;
+    }
+}
+
+/**
+ * geye_fixation_detector_end:
+ * @detector: a GEyeFixationDetector
+ * @event:(out caller-allocates)(nullable): returns the end of the fixation
+ *
+ * Ends the fixation that is going on, e.g. at missing data or when
+ * tracking stops, and forgets the previous samples.
+ *
+ * Returns: TRUE if the start of the fixation had been reported and @event
+ *          holds its end.
+ */
+gboolean
+geye_fixation_detector_end(GEyeFixationDetector *detector, GEyeFixation *event)
+{
+    gboolean ended = fixation_finish(detector, event) > 0;
+
+    detector->have_prev = FALSE;
+    window_clear(detector);
+    return ended;
+}
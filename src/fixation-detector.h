@@ -0,0 +1,67 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GEYE_FIXATION_DETECTOR_H
+#define GEYE_FIXATION_DETECTOR_H
+
+#include "eye-event.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Detects fixations in a stream of samples of one eye, while the samples
+ * arrive. Every sample costs O(1) (amortized for the dispersion algorithm)
+ * and the memory is allocated once, when the detector is created.
+ *
+ * The start of a fixation is reported once it has lasted the minimum
+ * duration, its end at the first sample that doesn't belong to it. So
+ * events lag the samples by at most one window of the minimum duration.
+ */
+typedef struct _GEyeFixationDetector GEyeFixationDetector;
+
+/* Both a start and an end might result from one sample. */
+#define GEYE_FIXATION_DETECTOR_MAX_EVENTS 2
+
+GEyeFixationDetector*   geye_fixation_detector_new(guint capacity);
+void                    geye_fixation_detector_free(
+                                GEyeFixationDetector *detector
+                                );
+
+void                    geye_fixation_detector_configure(
+                                GEyeFixationDetector   *detector,
+                                GEyeFixationDetection   method,
+                                gdouble                 velocity,
+                                gdouble                 dispersion,
+                                gdouble                 min_duration
+                                );
+
+guint                   geye_fixation_detector_push(
+                                GEyeFixationDetector   *detector,
+                                const GEyeSample       *sample,
+                                GEyeFixation           *events
+                                );
+gboolean                geye_fixation_detector_end(
+                                GEyeFixationDetector   *detector,
+                                GEyeFixation           *event
+                                );
+
+G_END_DECLS
+
+#endif
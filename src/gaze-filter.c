@@ -0,0 +1,341 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "gaze-filter.h"
+
+/* The samples a batch is convolved with at a time. */
+#define GAZE_FILTER_CHUNK 256
+
+/* The cutoff frequency with which the 1€ filter smooths the velocity. */
+#define ONE_EURO_D_CUTOFF 1.0
+
+enum {AXIS_X, AXIS_Y, N_AXES};
+
+struct _GEyeGazeFilter {
+    GEyeSmoothing   method;
+    guint           window;         // samples
+    gdouble         min_cutoff;     // Hz
+    gdouble         beta;           // seconds per pixel
+
+    /* The convolution, the coefficients run from the oldest sample. */
+    guint           max_window;
+    gdouble        *coefficients;
+    gdouble        *history[N_AXES];
+    gdouble        *scratch;
+    guint64         n;              // samples since the reset
+
+    /* The state of the 1€ filter. */
+    gdouble         prev_time;
+    gdouble         value[N_AXES];
+    gdouble         velocity[N_AXES];
+};
+
+GEyeGazeFilter*
+geye_gaze_filter_new(guint max_window)
+{
+    GEyeGazeFilter *filter = g_new0(GEyeGazeFilter, 1);
+
+    // The Savitzky-Golay filter fits a quadratic to at least three samples.
+    filter->max_window = MAX(max_window, 3);
+    filter->coefficients = g_new0(gdouble, filter->max_window);
+    filter->history[AXIS_X] = g_new0(gdouble, filter->max_window);
+    filter->history[AXIS_Y] = g_new0(gdouble, filter->max_window);
+    filter->scratch = g_new0(gdouble, filter->max_window + GAZE_FILTER_CHUNK);
+
+    filter->method = GEYE_SMOOTHING_NONE;
+    filter->window = 1;
+    filter->min_cutoff = 1.0;
+    filter->beta = 0.0;
+
+    return filter;
+}
+
+void
+geye_gaze_filter_free(GEyeGazeFilter *filter)
+{
+    g_free(filter->coefficients);
+    g_free(filter->history[AXIS_X]);
+    g_free(filter->history[AXIS_Y]);
+    g_free(filter->scratch);
+    g_free(filter);
+}
+
+static void
+moving_average_coefficients(gdouble *coefficients, guint window)
+{
+    guint k;
+
+    for (k = 0; k < window; k++)
+        coefficients[k] = 1.0 / window;
+}
+
+/* The cofactor of M[a][b] of the 3x3 matrix M[i][j] = s[i + j]. */
+static inline gdouble
+cofactor(const gdouble *s, guint a, guint b)
+{
+#define M(i, j) s[(i) % 3 + (j) % 3]
+    return M(a + 1, b + 1) * M(a + 2, b + 2) - M(a + 1, b + 2) * M(a + 2, b + 1);
+#undef M
+}
+
+/*
+ * The least squares fit of a quadratic p(t) = a0 + a1 t + a2 t² to the
+ * samples at t = -(window - 1) .. 0 is (AᵀA)⁻¹Aᵀ applied to the samples,
+ * where the rows of A are (1, t, t²). Row d of it, times d!, gives the
+ * coefficients of the d-th derivative of the fit at t = 0, for samples that
+ * are one unit apart. AᵀA is symmetric, so are its cofactors.
+ */
+void
+geye_savitzky_golay_coefficients(gdouble   *coefficients,
+                                 guint      window,
+                                 guint      derivative)
+{
+    gdouble s[5] = {0};
+    gdouble row[3], det = 0;
+    guint k, j;
+
+    g_return_if_fail(window >= 3);
+    g_return_if_fail(derivative <= 2);
+
+    for (k = 0; k < window; k++) {
+        gdouble t = (gdouble) k - (window - 1);
+        gdouble p = 1.0;
+        for (j = 0; j < 5; j++) {
+            s[j] += p;
+            p *= t;
+        }
+    }
+
+    for (j = 0; j < 3; j++) {
+        det += s[j] * cofactor(s, 0, j);
+        row[j] = cofactor(s, derivative, j) * (derivative == 2 ? 2 : 1);
+    }
+
+    for (k = 0; k < window; k++) {
+        gdouble t = (gdouble) k - (window - 1);
+        coefficients[k] = (row[0] + row[1] * t + row[2] * t * t) / det;
+    }
+}
+
+void
+geye_gaze_filter_configure(GEyeGazeFilter  *filter,
+                           GEyeSmoothing    method,
+                           guint            window,
+                           gdouble          min_cutoff,
+                           gdouble          beta
+                           )
+{
+    window = CLAMP(window, 1, filter->max_window);
+    if (method == GEYE_SMOOTHING_SAVITZKY_GOLAY)
+        window = MAX(window, 3);
+
+    filter->min_cutoff = min_cutoff;
+    filter->beta = beta;
+
+    // The tuning of the 1€ filter may change while it runs.
+    if (method == filter->method && window == filter->window)
+        return;
+
+    filter->method = method;
+    filter->window = window;
+    if (method == GEYE_SMOOTHING_MOVING_AVERAGE)
+        moving_average_coefficients(filter->coefficients, window);
+    else if (method == GEYE_SMOOTHING_SAVITZKY_GOLAY)
+        geye_savitzky_golay_coefficients(filter->coefficients, window, 0);
+
+    geye_gaze_filter_reset(filter);
+}
+
+void
+geye_gaze_filter_reset(GEyeGazeFilter *filter)
+{
+    filter->n = 0;
+}
+
+static inline gdouble*
+history_point(GEyeGazeFilter *filter, guint axis, guint64 seq)
+{
+    return &filter->history[axis][seq % filter->max_window];
+}
+
+/* Filters the newest sample, which is already in the history. */
+static gdouble
+convolve_point(GEyeGazeFilter *filter, guint axis)
+{
+    guint64 first;
+    gdouble sum = 0;
+    guint k;
+
+    if (filter->n < filter->window) {
+        if (filter->method == GEYE_SMOOTHING_SAVITZKY_GOLAY)
+            return *history_point(filter, axis, filter->n - 1);
+        for (k = 0; k < filter->n; k++)
+            sum += *history_point(filter, axis, k);
+        return sum / filter->n;
+    }
+
+    first = filter->n - filter->window;
+    for (k = 0; k < filter->window; k++)
+        sum += filter->coefficients[k] * *history_point(filter, axis, first + k);
+    return sum;
+}
+
+static void
+convolve_step(GEyeGazeFilter *filter, gdouble *x, gdouble *y)
+{
+    *history_point(filter, AXIS_X, filter->n) = *x;
+    *history_point(filter, AXIS_Y, filter->n) = *y;
+    filter->n++;
+
+    *x = convolve_point(filter, AXIS_X);
+    *y = convolve_point(filter, AXIS_Y);
+}
+
+/*
+ * Convolves n <= GAZE_FILTER_CHUNK samples following a filled window. The
+ * history and the input are copied to one contiguous buffer, so the inner
+ * loop runs over adjacent samples and is vectorized by the compiler.
+ */
+static void
+convolve_chunk(GEyeGazeFilter *filter, guint axis, gdouble *data, guint n)
+{
+    const gdouble *coefficients = filter->coefficients;
+    gdouble *buffer = filter->scratch;
+    guint past = filter->window - 1;
+    guint k, i;
+
+    for (k = 0; k < past; k++)
+        buffer[k] = *history_point(filter, axis, filter->n - past + k);
+    memcpy(buffer + past, data, n * sizeof(gdouble));
+
+    for (i = 0; i < n; i++)
+        data[i] = 0;
+    for (k = 0; k < filter->window; k++) {
+        const gdouble c = coefficients[k];
+        const gdouble *in = buffer + k;
+        for (i = 0; i < n; i++)
+            data[i] += c * in[i];
+    }
+
+    for (i = n - MIN(n, filter->max_window); i < n; i++)
+        *history_point(filter, axis, filter->n + i) = buffer[past + i];
+}
+
+static inline gdouble
+smoothing_factor(gdouble cutoff, gdouble dt)
+{
+    gdouble r = 2 * G_PI * cutoff * dt;
+    return r / (r + 1);
+}
+
+static void
+one_euro_axis(GEyeGazeFilter *filter, guint axis, gdouble dt, gdouble *value)
+{
+    gdouble velocity = (*value - filter->value[axis]) / dt;
+    gdouble cutoff;
+
+    filter->velocity[axis] += smoothing_factor(ONE_EURO_D_CUTOFF, dt) *
+                              (velocity - filter->velocity[axis]);
+    cutoff = filter->min_cutoff + filter->beta * fabs(filter->velocity[axis]);
+    filter->value[axis] += smoothing_factor(cutoff, dt) *
+                           (*value - filter->value[axis]);
+    *value = filter->value[axis];
+}
+
+static void
+one_euro_step(GEyeGazeFilter *filter, gdouble time, gdouble *x, gdouble *y)
+{
+    gdouble dt;
+
+    if (filter->n == 0) {
+        filter->n = 1;
+        filter->prev_time = time;
+        filter->value[AXIS_X] = *x;
+        filter->value[AXIS_Y] = *y;
+        filter->velocity[AXIS_X] = filter->velocity[AXIS_Y] = 0;
+        return;
+    }
+
+    dt = time - filter->prev_time;
+    if (dt > 0) {
+        filter->n++;
+        filter->prev_time = time;
+        one_euro_axis(filter, AXIS_X, dt, x);
+        one_euro_axis(filter, AXIS_Y, dt, y);
+    }
+    else {
+        *x = filter->value[AXIS_X];
+        *y = filter->value[AXIS_Y];
+    }
+}
+
+void
+geye_gaze_filter_step(GEyeGazeFilter   *filter,
+                      gdouble           time,
+                      gdouble          *x,
+                      gdouble          *y
+                      )
+{
+    switch (filter->method) {
+        case GEYE_SMOOTHING_MOVING_AVERAGE:
+        case GEYE_SMOOTHING_SAVITZKY_GOLAY:
+            convolve_step(filter, x, y);
+            break;
+        case GEYE_SMOOTHING_ONE_EURO:
+            one_euro_step(filter, time, x, y);
+            break;
+        case GEYE_SMOOTHING_NONE:
+        default:
+            break;
+    }
+}
+
+void
+geye_gaze_filter_run(GEyeGazeFilter    *filter,
+                     const gdouble     *time,
+                     gdouble           *x,
+                     gdouble           *y,
+                     guint              n
+                     )
+{
+    guint i = 0;
+
+    if (filter->method == GEYE_SMOOTHING_MOVING_AVERAGE ||
+        filter->method == GEYE_SMOOTHING_SAVITZKY_GOLAY) {
+        // Fill the window one sample at a time.
+        for (; i < n && filter->n + 1 < filter->window; i++)
+            convolve_step(filter, &x[i], &y[i]);
+
+        while (i < n) {
+            guint chunk = MIN(n - i, GAZE_FILTER_CHUNK);
+            convolve_chunk(filter, AXIS_X, x + i, chunk);
+            convolve_chunk(filter, AXIS_Y, y + i, chunk);
+            filter->n += chunk;
+            i += chunk;
+        }
+        return;
+    }
+
+    for (; i < n; i++)
+        geye_gaze_filter_step(filter, time[i], &x[i], &y[i]);
+}
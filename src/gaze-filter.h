@@ -0,0 +1,76 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GEYE_GAZE_FILTER_H
+#define GEYE_GAZE_FILTER_H
+
+#include "eye-event.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Smooths the gaze of one eye, while the samples arrive. The filters are
+ * causal and keep their state between calls, so the samples may be fed one
+ * at a time or in batches with the same result. The memory is allocated
+ * once, when the filter is created.
+ *
+ * The moving average and Savitzky-Golay filters are convolutions over the
+ * last window samples. Until the window is filled after a reset, the moving
+ * average averages the samples it has seen and the Savitzky-Golay filter
+ * passes the samples unchanged.
+ */
+typedef struct _GEyeGazeFilter GEyeGazeFilter;
+
+GEyeGazeFilter* geye_gaze_filter_new(guint max_window);
+void            geye_gaze_filter_free(GEyeGazeFilter *filter);
+
+void            geye_gaze_filter_configure(GEyeGazeFilter  *filter,
+                                           GEyeSmoothing    method,
+                                           guint            window,
+                                           gdouble          min_cutoff,
+                                           gdouble          beta
+                                           );
+void            geye_gaze_filter_reset(GEyeGazeFilter *filter);
+
+void            geye_gaze_filter_step(GEyeGazeFilter   *filter,
+                                      gdouble           time,
+                                      gdouble          *x,
+                                      gdouble          *y
+                                      );
+void            geye_gaze_filter_run(GEyeGazeFilter    *filter,
+                                     const gdouble     *time,
+                                     gdouble           *x,
+                                     gdouble           *y,
+                                     guint              n
+                                     );
+
+/*
+ * The coefficients of a Savitzky-Golay filter of the order 2 that gives the
+ * derivative (0 to 2) at the newest of window (at least 3) samples, that are
+ * one unit of time apart. The coefficients run from the oldest sample.
+ */
+void            geye_savitzky_golay_coefficients(gdouble   *coefficients,
+                                                 guint      window,
+                                                 guint      derivative
+                                                 );
+
+G_END_DECLS
+
+#endif
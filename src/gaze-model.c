@@ -0,0 +1,464 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "gaze-model.h"
+
+#define GAZE_MODEL_DEFAULT_WIDTH 1920
+#define GAZE_MODEL_DEFAULT_HEIGHT 1080
+#define GAZE_MODEL_DEFAULT_RESOLUTION 35.0
+// The speed of the drift in degrees per second.
+#define GAZE_MODEL_DRIFT 0.25
+// The tremor in degrees and Hz.
+#define GAZE_MODEL_TREMOR_AMPLITUDE 0.01
+#define GAZE_MODEL_TREMOR_FREQUENCY 90.0
+// The main sequence, Vmax in degrees per second and C in degrees.
+#define GAZE_MODEL_VMAX 600.0
+#define GAZE_MODEL_MAIN_SEQUENCE_C 10.0
+// Smaller saccades are microsaccades, which belong to a fixation.
+#define GAZE_MODEL_MIN_AMPLITUDE 1.0
+#define GAZE_MODEL_MAX_TRIES 16
+// The part of the display along the edges that saccades don't go to.
+#define GAZE_MODEL_MARGIN 0.1
+// The shortest and the mean blink in ms.
+#define GAZE_MODEL_MIN_BLINK 100.0
+#define GAZE_MODEL_BLINK_DURATION 150.0
+// How far the right eye looks to the right of the left one, in degrees.
+#define GAZE_MODEL_VERGENCE 0.1
+
+typedef enum {
+    GAZE_FIXATION,
+    GAZE_SACCADE,
+    GAZE_BLINK
+} GazePhase;
+
+struct _GEyeGazeModel {
+    GEyeGazeModelParams params;
+    GRand      *rand;
+    gdouble     spare;              // the second value of Box-Muller
+    gboolean    has_spare;
+
+    guint64     n;                  // the index of the next sample
+    gboolean    started;
+    GazePhase   phase;
+    guint64     phase_start;        // the first sample of the phase
+    guint64     phase_end;          // the first sample after the phase
+    gdouble     x, y;               // the true gaze of the left eye
+
+    /* the current fixation */
+    gdouble     fix_x, fix_y;       // where it started
+    gdouble     drift_x, drift_y;   // pixels per second
+    gdouble     tremor_x, tremor_y; // the phase of the tremor
+    gdouble     sum_x, sum_y;       // of the true gaze, for the average
+    guint64     n_sum;
+
+    /* the current saccade */
+    gdouble     from_x, from_y;
+    gdouble     to_x, to_y;
+    gdouble     amplitude;          // degrees
+    gdouble     peak_velocity;      // degrees per second
+};
+
+void
+geye_gaze_model_params_init(GEyeGazeModelParams *params)
+{
+    params->rate                = GEYE_GAZE_MODEL_DEFAULT_RATE;
+    params->binocular           = TRUE;
+    params->seed                = 0;
+    params->disp_width          = GAZE_MODEL_DEFAULT_WIDTH;
+    params->disp_height         = GAZE_MODEL_DEFAULT_HEIGHT;
+    params->resolution          = GAZE_MODEL_DEFAULT_RESOLUTION;
+    params->fixation_duration   = GEYE_GAZE_MODEL_DEFAULT_FIXATION;
+    params->blink_rate          = GEYE_GAZE_MODEL_DEFAULT_BLINK_RATE;
+    params->noise               = GEYE_GAZE_MODEL_DEFAULT_NOISE;
+}
+
+GEyeGazeModel*
+geye_gaze_model_new(const GEyeGazeModelParams *params)
+{
+    GEyeGazeModel *model;
+
+    g_return_val_if_fail(params && params->rate > 0, NULL);
+    g_return_val_if_fail(params->resolution > 0, NULL);
+
+    model = g_new0(GEyeGazeModel, 1);
+    model->params = *params;
+    model->rand = g_rand_new_with_seed(params->seed);
+    return model;
+}
+
+void
+geye_gaze_model_free(GEyeGazeModel *model)
+{
+    g_rand_free(model->rand);
+    g_free(model);
+}
+
+/* ************************** random variables ************************** */
+
+static gdouble
+gaussian(GEyeGazeModel *model)
+{
+    gdouble u, v, r;
+
+    if (model->has_spare) {
+        model->has_spare = FALSE;
+        return model->spare;
+    }
+
+    // 1 - u, so the log never sees 0.
+    u = 1.0 - g_rand_double(model->rand);
+    v = g_rand_double(model->rand);
+    r = sqrt(-2.0 * log(u));
+    model->spare = r * sin(2 * G_PI * v);
+    model->has_spare = TRUE;
+    return r * cos(2 * G_PI * v);
+}
+
+static gdouble
+exponential(GEyeGazeModel *model, gdouble mean)
+{
+    if (mean <= 0)
+        return 0;
+    return -mean * log(1.0 - g_rand_double(model->rand));
+}
+
+/* The number of samples of a duration in ms, at least one. */
+static guint64
+n_samples(GEyeGazeModel *model, gdouble duration)
+{
+    gdouble n = round(duration * model->params.rate / 1000);
+    return n < 1 ? 1 : (guint64) n;
+}
+
+static gdouble
+sample_time(GEyeGazeModel *model, guint64 n)
+{
+    return n / (gdouble) model->params.rate;
+}
+
+/* ******************************* phases ******************************* */
+
+static void
+start_fixation(GEyeGazeModel *model, gdouble x, gdouble y)
+{
+    gdouble direction = g_rand_double_range(model->rand, 0, 2 * G_PI);
+    gdouble drift = GAZE_MODEL_DRIFT * model->params.resolution;
+    gdouble duration = GEYE_GAZE_MODEL_MIN_FIXATION + exponential(
+            model,
+            model->params.fixation_duration - GEYE_GAZE_MODEL_MIN_FIXATION
+            );
+
+    model->phase = GAZE_FIXATION;
+    model->phase_start = model->n;
+    model->phase_end = model->n + n_samples(model, duration);
+    model->fix_x = x;
+    model->fix_y = y;
+    model->drift_x = drift * cos(direction);
+    model->drift_y = drift * sin(direction);
+    model->tremor_x = g_rand_double_range(model->rand, 0, 2 * G_PI);
+    model->tremor_y = g_rand_double_range(model->rand, 0, 2 * G_PI);
+    model->sum_x = model->sum_y = 0;
+    model->n_sum = 0;
+}
+
+/*
+ * Picks a point on the display that is at least a minimal saccade away,
+ * the duration follows from the peak velocity of the main sequence and the
+ * raised cosine, whose peak is pi / 2 times its mean velocity.
+ */
+static void
+start_saccade(GEyeGazeModel *model)
+{
+    const GEyeGazeModelParams *params = &model->params;
+    gdouble w = params->disp_width, h = params->disp_height;
+    gdouble amplitude = 0, duration, peak;
+    guint i;
+
+    model->from_x = model->x;
+    model->from_y = model->y;
+    for (i = 0; i < GAZE_MODEL_MAX_TRIES &&
+                amplitude < GAZE_MODEL_MIN_AMPLITUDE; i++) {
+        model->to_x = g_rand_double_range(
+                model->rand, w * GAZE_MODEL_MARGIN, w * (1 - GAZE_MODEL_MARGIN)
+                );
+        model->to_y = g_rand_double_range(
+                model->rand, h * GAZE_MODEL_MARGIN, h * (1 - GAZE_MODEL_MARGIN)
+                );
+        amplitude = hypot(
+                model->to_x - model->from_x, model->to_y - model->from_y
+                ) / params->resolution;
+    }
+
+    peak = GAZE_MODEL_VMAX *
+        (1 - exp(-amplitude / GAZE_MODEL_MAIN_SEQUENCE_C));
+    duration = peak > 0 ? G_PI / 2 * amplitude / peak * 1000 : 0;
+
+    model->phase = GAZE_SACCADE;
+    model->phase_start = model->n;
+    model->phase_end = model->n + n_samples(model, duration);
+    model->amplitude = amplitude;
+    // The duration is whole samples, so is the profile that is played.
+    model->peak_velocity = G_PI / 2 * amplitude / (
+            sample_time(model, model->phase_end - model->phase_start)
+            );
+}
+
+static void
+start_blink(GEyeGazeModel *model)
+{
+    gdouble duration = GAZE_MODEL_MIN_BLINK + exponential(
+            model, GAZE_MODEL_BLINK_DURATION - GAZE_MODEL_MIN_BLINK
+            );
+
+    model->phase = GAZE_BLINK;
+    model->phase_start = model->n;
+    model->phase_end = model->n + n_samples(model, duration);
+}
+
+/* A fixation ends in a blink with the blink rate over its duration. */
+static gboolean
+ends_in_blink(GEyeGazeModel *model)
+{
+    gdouble duration = sample_time(
+            model, model->phase_end - model->phase_start
+            );
+    gdouble p = 1 - exp(-model->params.blink_rate * duration);
+
+    return g_rand_double(model->rand) < p;
+}
+
+/* ******************************* records ****************************** */
+
+static GEyeEyeType
+tracked_eyes(GEyeGazeModel *model)
+{
+    return model->params.binocular ? GEYE_BINOCULAR : GEYE_LEFT;
+}
+
+static gdouble
+eye_offset(GEyeGazeModel *model, GEyeEyeType eye)
+{
+    return eye == GEYE_RIGHT ?
+        GAZE_MODEL_VERGENCE * model->params.resolution : 0;
+}
+
+static void
+init_event(GEyeGazeModel   *model,
+           GEyeRecord      *record,
+           GEyeRecordType   type,
+           GEyeEventType    event,
+           GEyeEyeType      eye)
+{
+    memset(record, 0, sizeof(*record));
+    record->type = type;
+    record->event = event;
+    record->eye = eye;
+    record->time = sample_time(model, model->phase_start);
+    record->tracker_time = record->time * 1000;
+}
+
+/* The start or end of the current fixation for every tracked eye. */
+static guint
+add_fixation(GEyeGazeModel *model, GEyeRecord *records, gboolean start)
+{
+    GEyeEyeType eyes = tracked_eyes(model), eye;
+    guint n = 0;
+
+    for (eye = GEYE_LEFT; eye <= GEYE_RIGHT; eye <<= 1) {
+        GEyeRecord *record = &records[n];
+        gdouble offset = eye_offset(model, eye);
+
+        if (!(eyes & eye))
+            continue;
+        n++;
+
+        init_event(
+                model, record, GEYE_RECORD_FIXATION,
+                start ? GEYE_EVENT_FIX_START : GEYE_EVENT_FIX_END, eye
+                );
+        if (start) {
+            record->data.fixation.end_time = record->time;
+            record->data.fixation.x = model->fix_x + offset;
+            record->data.fixation.y = model->fix_y;
+        }
+        else {
+            record->data.fixation.end_time = sample_time(
+                    model, model->phase_end - 1
+                    );
+            record->data.fixation.x = model->sum_x / model->n_sum + offset;
+            record->data.fixation.y = model->sum_y / model->n_sum;
+        }
+    }
+    return n;
+}
+
+/* The start or end of the current saccade for every tracked eye. */
+static guint
+add_saccade(GEyeGazeModel *model, GEyeRecord *records, gboolean start)
+{
+    GEyeEyeType eyes = tracked_eyes(model), eye;
+    guint n = 0;
+
+    for (eye = GEYE_LEFT; eye <= GEYE_RIGHT; eye <<= 1) {
+        GEyeRecord *record = &records[n];
+        gdouble offset = eye_offset(model, eye);
+
+        if (!(eyes & eye))
+            continue;
+        n++;
+
+        init_event(
+                model, record, GEYE_RECORD_SACCADE,
+                start ? GEYE_EVENT_SAC_START : GEYE_EVENT_SAC_END, eye
+                );
+        record->data.saccade.start_x = model->from_x + offset;
+        record->data.saccade.start_y = model->from_y;
+        if (start) {
+            record->data.saccade.end_time = record->time;
+            record->data.saccade.end_x = record->data.saccade.start_x;
+            record->data.saccade.end_y = record->data.saccade.start_y;
+        }
+        else {
+            record->data.saccade.end_time = sample_time(
+                    model, model->phase_end - 1
+                    );
+            record->data.saccade.end_x = model->to_x + offset;
+            record->data.saccade.end_y = model->to_y;
+            record->data.saccade.amplitude = model->amplitude;
+            record->data.saccade.peak_velocity = model->peak_velocity;
+        }
+    }
+    return n;
+}
+
+/* Moves the true gaze to the next sample. */
+static void
+move_gaze(GEyeGazeModel *model)
+{
+    gdouble t = sample_time(model, model->n);
+    gdouble dt = sample_time(model, model->n - model->phase_start);
+    gdouble tremor = GAZE_MODEL_TREMOR_AMPLITUDE * model->params.resolution;
+    gdouble u;
+
+    switch (model->phase) {
+        case GAZE_FIXATION:
+            u = 2 * G_PI * GAZE_MODEL_TREMOR_FREQUENCY * t;
+            model->x = model->fix_x + model->drift_x * dt +
+                tremor * sin(u + model->tremor_x);
+            model->y = model->fix_y + model->drift_y * dt +
+                tremor * sin(u + model->tremor_y);
+            model->sum_x += model->x;
+            model->sum_y += model->y;
+            model->n_sum++;
+            break;
+        case GAZE_SACCADE:
+            u = (model->n - model->phase_start) /
+                (gdouble) (model->phase_end - model->phase_start);
+            u = 0.5 - 0.5 * cos(G_PI * u);
+            model->x = model->from_x + (model->to_x - model->from_x) * u;
+            model->y = model->from_y + (model->to_y - model->from_y) * u;
+            break;
+        case GAZE_BLINK:
+            // The eye stays where it was.
+            break;
+    }
+}
+
+static void
+make_sample(GEyeGazeModel *model, GEyeRecord *record)
+{
+    GEyeEyeType eyes = tracked_eyes(model);
+    gdouble noise = model->params.noise * model->params.resolution;
+
+    move_gaze(model);
+
+    memset(record, 0, sizeof(*record));
+    record->type = GEYE_RECORD_SAMPLE;
+    record->event = GEYE_EVENT_SAMPLE;
+    record->eye = eyes;
+    record->valid = model->phase == GAZE_BLINK ? GEYE_NONE : eyes;
+    record->time = sample_time(model, model->n);
+    record->tracker_time = record->time * 1000;
+    record->data.sample.left_x = record->data.sample.left_y = NAN;
+    record->data.sample.right_x = record->data.sample.right_y = NAN;
+
+    if (record->valid & GEYE_LEFT) {
+        record->data.sample.left_x = model->x + noise * gaussian(model);
+        record->data.sample.left_y = model->y + noise * gaussian(model);
+    }
+    if (record->valid & GEYE_RIGHT) {
+        record->data.sample.right_x = model->x +
+            eye_offset(model, GEYE_RIGHT) + noise * gaussian(model);
+        record->data.sample.right_y = model->y + noise * gaussian(model);
+    }
+}
+
+/* ******************************* stepping ***************************** */
+
+guint
+geye_gaze_model_step(GEyeGazeModel *model, GEyeRecord *records)
+{
+    guint n = 0;
+
+    if (!model->started) {
+        model->started = TRUE;
+        start_fixation(
+                model,
+                model->params.disp_width / 2,
+                model->params.disp_height / 2
+                );
+        n += add_fixation(model, records, TRUE);
+    }
+    else if (model->n == model->phase_end) {
+        switch (model->phase) {
+            case GAZE_FIXATION:
+                n += add_fixation(model, records, FALSE);
+                if (ends_in_blink(model))
+                    start_blink(model);
+                else {
+                    start_saccade(model);
+                    n += add_saccade(model, &records[n], TRUE);
+                }
+                break;
+            case GAZE_SACCADE:
+                n += add_saccade(model, records, FALSE);
+                start_fixation(model, model->to_x, model->to_y);
+                n += add_fixation(model, &records[n], TRUE);
+                break;
+            case GAZE_BLINK:
+                start_fixation(model, model->x, model->y);
+                n += add_fixation(model, records, TRUE);
+                break;
+        }
+    }
+
+    make_sample(model, &records[n++]);
+    model->n++;
+    return n;
+}
+
+gdouble
+geye_gaze_model_get_time(GEyeGazeModel *model)
+{
+    return sample_time(model, model->n);
+}
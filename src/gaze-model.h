@@ -0,0 +1,95 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GEYE_GAZE_MODEL_H
+#define GEYE_GAZE_MODEL_H
+
+#include "eye-event.h"
+#include "recording.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Generates gaze from a parametric model of someone looking around a
+ * display. The gaze alternates between fixations and saccades, some
+ * fixations end in a blink:
+ *
+ *   - A fixation lasts a minimum plus an exponentially distributed time.
+ *     The eye drifts slowly in a random direction and a tremor is added on
+ *     top of that.
+ *   - A saccade moves to a random point of the display, its peak velocity
+ *     follows the main sequence, Vp = Vmax * (1 - exp(-A / C)), and its
+ *     velocity profile is a raised cosine, as the fake libeyelink_core uses.
+ *   - During a blink the gaze of both eyes is missing, the next fixation
+ *     starts where the eye was.
+ *
+ * The measured gaze has gaussian noise, independent for each eye. The right
+ * eye looks slightly to the right of the left one.
+ *
+ * The model hands out GEyeRecords, so it can be played as a recording. The
+ * fixations and saccades are the ground truth: they are exact, aren't
+ * detected from the noisy samples and are reported without delay. A start
+ * comes before the first sample of a fixation or saccade, its end before the
+ * first sample after it. The time is in seconds since the first sample and
+ * the tracker time in ms.
+ *
+ * The same parameters and seed give the same gaze.
+ */
+typedef struct {
+    guint       rate;               // Hz
+    gboolean    binocular;          // otherwise the left eye only
+    guint32     seed;
+    gdouble     disp_width;         // pixels
+    gdouble     disp_height;        // pixels
+    gdouble     resolution;         // pixels per degree
+    gdouble     fixation_duration;  // mean in ms
+    gdouble     blink_rate;         // per second of fixation
+    gdouble     noise;              // standard deviation in degrees
+} GEyeGazeModelParams;
+
+#define GEYE_GAZE_MODEL_DEFAULT_RATE 1000
+#define GEYE_GAZE_MODEL_DEFAULT_FIXATION 250.0
+#define GEYE_GAZE_MODEL_DEFAULT_BLINK_RATE 0.3
+#define GEYE_GAZE_MODEL_DEFAULT_NOISE 0.02
+// The shortest fixation in ms, the rest of its duration is exponential.
+#define GEYE_GAZE_MODEL_MIN_FIXATION 80.0
+
+/* The end of two events and the start of two others, and a sample. */
+#define GEYE_GAZE_MODEL_MAX_RECORDS 5
+
+typedef struct _GEyeGazeModel GEyeGazeModel;
+
+void            geye_gaze_model_params_init(GEyeGazeModelParams *params);
+
+GEyeGazeModel*  geye_gaze_model_new(const GEyeGazeModelParams *params);
+void            geye_gaze_model_free(GEyeGazeModel *model);
+
+/*
+ * Generates the next sample and the events that precede it. Returns the
+ * number of records, the sample is the last one.
+ */
+guint           geye_gaze_model_step(GEyeGazeModel *model, GEyeRecord *records);
+
+/* The time of the next sample in s. */
+gdouble         geye_gaze_model_get_time(GEyeGazeModel *model);
+
+G_END_DECLS
+
+#endif
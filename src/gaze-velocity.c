@@ -0,0 +1,173 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <math.h>
+
+#include "gaze-filter.h"
+#include "gaze-velocity.h"
+
+// The five-point central differences need five samples.
+#define GAZE_VELOCITY_MIN_WINDOW 5
+
+typedef struct {
+    gdouble time;
+    gdouble pos[2];
+} VelocityPoint;
+
+struct _GEyeGazeVelocity {
+    GEyeDifferentiator  method;
+    guint               window;
+
+    /* The coefficients run from the oldest sample. */
+    guint               max_window;
+    gdouble            *first;
+    gdouble            *second;
+    VelocityPoint      *history;
+    guint64             n;          // samples since the reset
+};
+
+GEyeGazeVelocity*
+geye_gaze_velocity_new(guint max_window)
+{
+    GEyeGazeVelocity *velocity = g_new0(GEyeGazeVelocity, 1);
+
+    velocity->max_window = MAX(max_window, GAZE_VELOCITY_MIN_WINDOW);
+    velocity->first = g_new0(gdouble, velocity->max_window);
+    velocity->second = g_new0(gdouble, velocity->max_window);
+    velocity->history = g_new0(VelocityPoint, velocity->max_window);
+
+    velocity->method = GEYE_DIFFERENTIATOR_TWO_POINT;
+    velocity->window = 0;
+    geye_gaze_velocity_configure(velocity, GEYE_DIFFERENTIATOR_TWO_POINT, 3);
+
+    return velocity;
+}
+
+void
+geye_gaze_velocity_free(GEyeGazeVelocity *velocity)
+{
+    g_free(velocity->first);
+    g_free(velocity->second);
+    g_free(velocity->history);
+    g_free(velocity);
+}
+
+void
+geye_gaze_velocity_configure(GEyeGazeVelocity  *velocity,
+                             GEyeDifferentiator method,
+                             guint              window)
+{
+    static const gdouble two_point[2][3] = {
+        {0, -1, 1},
+        {1, -2, 1}
+    };
+    static const gdouble five_point[2][5] = {
+        {1 / 12.0, -8 / 12.0, 0, 8 / 12.0, -1 / 12.0},
+        {-1 / 12.0, 16 / 12.0, -30 / 12.0, 16 / 12.0, -1 / 12.0}
+    };
+    guint k;
+
+    switch (method) {
+        case GEYE_DIFFERENTIATOR_TWO_POINT:
+            window = G_N_ELEMENTS(two_point[0]);
+            break;
+        case GEYE_DIFFERENTIATOR_FIVE_POINT:
+            window = G_N_ELEMENTS(five_point[0]);
+            break;
+        case GEYE_DIFFERENTIATOR_SAVITZKY_GOLAY:
+        default:
+            window = CLAMP(window, 3, velocity->max_window);
+            break;
+    }
+    if (method == velocity->method && window == velocity->window)
+        return;
+
+    velocity->method = method;
+    velocity->window = window;
+    for (k = 0; k < window; k++) {
+        if (method == GEYE_DIFFERENTIATOR_TWO_POINT) {
+            velocity->first[k] = two_point[0][k];
+            velocity->second[k] = two_point[1][k];
+        }
+        else if (method == GEYE_DIFFERENTIATOR_FIVE_POINT) {
+            velocity->first[k] = five_point[0][k];
+            velocity->second[k] = five_point[1][k];
+        }
+    }
+    if (method == GEYE_DIFFERENTIATOR_SAVITZKY_GOLAY) {
+        geye_savitzky_golay_coefficients(velocity->first, window, 1);
+        geye_savitzky_golay_coefficients(velocity->second, window, 2);
+    }
+
+    geye_gaze_velocity_reset(velocity);
+}
+
+void
+geye_gaze_velocity_reset(GEyeGazeVelocity *velocity)
+{
+    velocity->n = 0;
+}
+
+static inline VelocityPoint*
+velocity_point(GEyeGazeVelocity *velocity, guint64 seq)
+{
+    return &velocity->history[seq % velocity->max_window];
+}
+
+gboolean
+geye_gaze_velocity_push(GEyeGazeVelocity   *velocity,
+                        gdouble             time,
+                        gdouble             x,
+                        gdouble             y,
+                        gdouble            *v,
+                        gdouble            *a)
+{
+    VelocityPoint *point = velocity_point(velocity, velocity->n);
+    guint64 first;
+    gdouble interval;
+    guint k, axis;
+
+    point->time = time;
+    point->pos[0] = x;
+    point->pos[1] = y;
+    velocity->n++;
+
+    v[0] = v[1] = a[0] = a[1] = NAN;
+    if (velocity->n < velocity->window)
+        return FALSE;
+
+    first = velocity->n - velocity->window;
+    interval = (time - velocity_point(velocity, first)->time) /
+               (velocity->window - 1);
+    if (interval <= 0)
+        return FALSE;
+
+    for (axis = 0; axis < 2; axis++) {
+        gdouble d1 = 0, d2 = 0;
+        for (k = 0; k < velocity->window; k++) {
+            gdouble pos = velocity_point(velocity, first + k)->pos[axis];
+            d1 += velocity->first[k] * pos;
+            d2 += velocity->second[k] * pos;
+        }
+        v[axis] = d1 / interval;
+        a[axis] = d2 / (interval * interval);
+    }
+    return TRUE;
+}
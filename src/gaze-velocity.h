@@ -0,0 +1,62 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GEYE_GAZE_VELOCITY_H
+#define GEYE_GAZE_VELOCITY_H
+
+#include "eye-event.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Differentiates the gaze of one eye, while the samples arrive. Every method
+ * is a pair of convolutions over the last samples, one for the velocity and
+ * one for the acceleration, scaled by the mean interval of the samples in
+ * the window. The memory is allocated once, when it is created.
+ */
+typedef struct _GEyeGazeVelocity GEyeGazeVelocity;
+
+GEyeGazeVelocity*   geye_gaze_velocity_new(guint max_window);
+void                geye_gaze_velocity_free(GEyeGazeVelocity *velocity);
+
+void                geye_gaze_velocity_configure(
+                            GEyeGazeVelocity   *velocity,
+                            GEyeDifferentiator  method,
+                            guint               window
+                            );
+void                geye_gaze_velocity_reset(GEyeGazeVelocity *velocity);
+
+/*
+ * Adds a sample, in pixels and seconds, and computes the velocity and
+ * acceleration in pixels per second (²). Returns FALSE and NAN until the
+ * window is filled.
+ */
+gboolean            geye_gaze_velocity_push(
+                            GEyeGazeVelocity   *velocity,
+                            gdouble             time,
+                            gdouble             x,
+                            gdouble             y,
+                            gdouble            *v,
+                            gdouble            *a
+                            );
+
+G_END_DECLS
+
+#endif
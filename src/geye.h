@@ -21,9 +21,14 @@
 #ifndef GEYE_H
 #define GEYE_H
 
+#include "aoi-set.h"
 #include "eye-event.h"
 #include "eyelink-et.h"
 #include "eyetracker-error.h"
 #include "eyetracker.h"
+#include "recording.h"
+#include "replay-et.h"
+#include "subscriber.h"
+#include "synthetic-et.h"
 
 #endif
@@ -0,0 +1,187 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+
+#include "latency-histogram.h"
+
+/*
+ * A latency below HISTOGRAM_LINEAR has a bucket of its own. Above, the
+ * latency is shifted right until HISTOGRAM_SUB_BITS + 1 bits remain, the
+ * highest of which is always set, the other bits select one of the
+ * HISTOGRAM_SUB_BUCKETS buckets of its power of two.
+ */
+#define HISTOGRAM_SUB_BITS      4
+#define HISTOGRAM_SUB_BUCKETS   (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_LINEAR        (2 * HISTOGRAM_SUB_BUCKETS)
+#define HISTOGRAM_MAX_BITS      32
+#define HISTOGRAM_N_BUCKETS     (HISTOGRAM_LINEAR + \
+        (HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS - 1) * HISTOGRAM_SUB_BUCKETS)
+
+struct _GEyeLatencyHistogram {
+    guint       counts[HISTOGRAM_N_BUCKETS];    // Atomic
+    guint       max;                            // Atomic
+    gint        resets;         // Atomic, the number of requested resets
+    gint        done;           // Atomic, the number of carried out resets
+};
+
+static guint
+histogram_bucket(guint32 latency)
+{
+    guint bits, shift;
+
+    if (latency < HISTOGRAM_LINEAR)
+        return latency;
+
+    bits = g_bit_storage(latency);
+    shift = bits - HISTOGRAM_SUB_BITS - 1;
+    return HISTOGRAM_LINEAR +
+           (shift - 1) * HISTOGRAM_SUB_BUCKETS +
+           ((latency >> shift) - HISTOGRAM_SUB_BUCKETS);
+}
+
+/* The largest latency that falls in bucket. */
+static gint64
+histogram_upper_bound(guint bucket)
+{
+    guint shift, sub;
+
+    if (bucket < HISTOGRAM_LINEAR)
+        return bucket;
+
+    shift = (bucket - HISTOGRAM_LINEAR) / HISTOGRAM_SUB_BUCKETS + 1;
+    sub = (bucket - HISTOGRAM_LINEAR) % HISTOGRAM_SUB_BUCKETS;
+    return ((gint64) (HISTOGRAM_SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+/**
+ * geye_latency_histogram_new:
+ *
+ * Returns: an empty histogram, free it with geye_latency_histogram_free().
+ */
+GEyeLatencyHistogram*
+geye_latency_histogram_new(void)
+{
+    return g_new0(GEyeLatencyHistogram, 1);
+}
+
+void
+geye_latency_histogram_free(GEyeLatencyHistogram *histogram)
+{
+    g_free(histogram);
+}
+
+static void
+histogram_clear(GEyeLatencyHistogram *histogram)
+{
+    guint i;
+
+    for (i = 0; i < HISTOGRAM_N_BUCKETS; i++)
+        g_atomic_int_set(&histogram->counts[i], 0);
+    g_atomic_int_set(&histogram->max, 0);
+}
+
+/**
+ * geye_latency_histogram_record:
+ * @histogram: a GEyeLatencyHistogram
+ * @latency: a latency in µs, a negative latency, due to the jitter of the
+ *           clocks, counts as 0.
+ *
+ * Must only be called from the recording thread.
+ */
+void
+geye_latency_histogram_record(GEyeLatencyHistogram *histogram,
+                              gint64                latency)
+{
+    gint resets = g_atomic_int_get(&histogram->resets);
+
+    if (resets != histogram->done) {
+        histogram_clear(histogram);
+        g_atomic_int_set(&histogram->done, resets);
+    }
+
+    latency = CLAMP(latency, 0, G_MAXUINT32);
+    g_atomic_int_inc(&histogram->counts[histogram_bucket(latency)]);
+    if (latency > histogram->max)
+        g_atomic_int_set(&histogram->max, latency);
+}
+
+/**
+ * geye_latency_histogram_reset:
+ * @histogram: a GEyeLatencyHistogram
+ *
+ * Empties the histogram, it may be called from any thread.
+ */
+void
+geye_latency_histogram_reset(GEyeLatencyHistogram *histogram)
+{
+    g_return_if_fail(histogram != NULL);
+    g_atomic_int_inc(&histogram->resets);
+}
+
+/**
+ * geye_latency_histogram_get_stats:
+ * @histogram: a GEyeLatencyHistogram
+ * @stats:(out caller-allocates): returns the statistics
+ *
+ * Summarizes the histogram, it may be called from any thread. A latency
+ * that is recorded meanwhile may or may not be included.
+ */
+void
+geye_latency_histogram_get_stats(GEyeLatencyHistogram *histogram,
+                                 GEyeLatencyStats     *stats)
+{
+    guint counts[HISTOGRAM_N_BUCKETS];
+    guint64 count = 0, median, p99, seen = 0;
+    gboolean have_median = FALSE;
+    guint i;
+
+    g_return_if_fail(histogram != NULL);
+    g_return_if_fail(stats != NULL);
+
+    *stats = (GEyeLatencyStats) {0};
+    if (g_atomic_int_get(&histogram->resets) !=
+            g_atomic_int_get(&histogram->done))
+        return;
+
+    for (i = 0; i < HISTOGRAM_N_BUCKETS; i++) {
+        counts[i] = g_atomic_int_get(&histogram->counts[i]);
+        count += counts[i];
+    }
+    if (count == 0)
+        return;
+
+    stats->count = count;
+    stats->max = g_atomic_int_get(&histogram->max);
+
+    // The rank of the percentiles, rounded up.
+    median = (count + 1) / 2;
+    p99 = (count * 99 + 99) / 100;
+    for (i = 0; i < HISTOGRAM_N_BUCKETS; i++) {
+        seen += counts[i];
+        if (!have_median && seen >= median) {
+            stats->p50 = MIN(histogram_upper_bound(i), stats->max);
+            have_median = TRUE;
+        }
+        if (seen >= p99) {
+            stats->p99 = MIN(histogram_upper_bound(i), stats->max);
+            break;
+        }
+    }
+}
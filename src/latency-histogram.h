@@ -0,0 +1,63 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+
+#ifndef GEYE_LATENCY_HISTOGRAM_H
+#define GEYE_LATENCY_HISTOGRAM_H
+
+#include "eyetracker.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Counts latencies in µs in buckets of fixed size, without allocating or
+ * locking. Latencies below 32 µs have a bucket each, above that every power
+ * of two is split into 16 buckets, so a bucket is at most 1/16 wider than its
+ * lower bound. Latencies up to about 71 minutes are distinguished.
+ *
+ * One thread records the latencies, any thread may read the statistics or
+ * reset the histogram. A reset is carried out by the recording thread with
+ * the next latency, until then the histogram reads as empty.
+ */
+typedef struct _GEyeLatencyHistogram GEyeLatencyHistogram;
+
+GEyeLatencyHistogram*   geye_latency_histogram_new(void);
+void                    geye_latency_histogram_free(
+                                GEyeLatencyHistogram *histogram
+                                );
+
+/* recording side */
+void                    geye_latency_histogram_record(
+                                GEyeLatencyHistogram *histogram,
+                                gint64                latency
+                                );
+
+/* any thread */
+void                    geye_latency_histogram_reset(
+                                GEyeLatencyHistogram *histogram
+                                );
+void                    geye_latency_histogram_get_stats(
+                                GEyeLatencyHistogram *histogram,
+                                GEyeLatencyStats     *stats
+                                );
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,215 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#define _GNU_SOURCE
+#include "realtime.h"
+#include <gio/gio.h>
+#include <errno.h>
+#include <string.h>
+
+#if defined(G_OS_UNIX)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#if defined(HAVE_MLOCKALL)
+#include <sys/mman.h>
+#endif
+
+#define REALTIME_STACK_SIZE (128 * 1024)
+#define REALTIME_PAGE_SIZE  4096
+
+static void
+realtime_set_error(GError **error, int err, const gchar *what)
+{
+    g_set_error(error,
+                G_IO_ERROR,
+                g_io_error_from_errno(err),
+                "%s: %s",
+                what,
+                g_strerror(err)
+                );
+}
+
+G_GNUC_UNUSED static void
+realtime_set_unsupported(GError **error, const gchar *what)
+{
+    g_set_error(error,
+                G_IO_ERROR,
+                G_IO_ERROR_NOT_SUPPORTED,
+                "%s is not supported on this platform",
+                what
+                );
+}
+
+/**
+ * geye_realtime_set_scheduling:
+ * @policy: the desired policy
+ * @priority: the priority for @policy, it is clamped to the range the
+ *            operating system supports for @policy.
+ * @error: returns the reason when the policy could not be applied
+ *
+ * Sets the scheduling policy of the calling thread. Typically the process
+ * needs CAP_SYS_NICE or an rtprio limit for the real-time policies.
+ *
+ * Returns: TRUE if the policy was applied.
+ */
+gboolean
+geye_realtime_set_scheduling(GEyeSchedPolicy    policy,
+                             gint               priority,
+                             GError           **error)
+{
+    g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+    if (policy == GEYE_SCHED_POLICY_OTHER)
+        return TRUE;
+
+#if defined(G_OS_UNIX)
+    struct sched_param param;
+    int os_policy = policy == GEYE_SCHED_POLICY_FIFO ? SCHED_FIFO : SCHED_RR;
+    int ret;
+
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = CLAMP(
+            priority,
+            sched_get_priority_min(os_policy),
+            sched_get_priority_max(os_policy)
+            );
+
+    ret = pthread_setschedparam(pthread_self(), os_policy, &param);
+    if (ret != 0) {
+        realtime_set_error(error, ret, "Unable to set the scheduling policy");
+        return FALSE;
+    }
+    return TRUE;
+#else
+    (void) priority;
+    realtime_set_unsupported(error, "A real-time scheduling policy");
+    return FALSE;
+#endif
+}
+
+/**
+ * geye_realtime_set_affinity:
+ * @cpu_mask: bit n allows the thread to run on CPU n, 0 leaves the affinity
+ *            as it is.
+ * @error: returns the reason when the affinity could not be applied
+ *
+ * Pins the calling thread to a set of CPUs.
+ *
+ * Returns: TRUE if the affinity was applied.
+ */
+gboolean
+geye_realtime_set_affinity(guint64 cpu_mask, GError **error)
+{
+    g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+    if (cpu_mask == 0)
+        return TRUE;
+
+#if defined(HAVE_PTHREAD_SETAFFINITY_NP)
+    cpu_set_t cpus;
+    guint cpu;
+    int ret;
+
+    CPU_ZERO(&cpus);
+    for (cpu = 0; cpu < 64; cpu++)
+        if (cpu_mask & (G_GUINT64_CONSTANT(1) << cpu))
+            CPU_SET(cpu, &cpus);
+
+    ret = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (ret != 0) {
+        realtime_set_error(error, ret, "Unable to set the CPU affinity");
+        return FALSE;
+    }
+    return TRUE;
+#else
+    realtime_set_unsupported(error, "Setting the CPU affinity");
+    return FALSE;
+#endif
+}
+
+/**
+ * geye_realtime_lock_memory:
+ * @error: returns the reason when the memory could not be locked
+ *
+ * Locks all current and future pages of the process into RAM, so the
+ * real-time thread doesn't stall on page faults.
+ *
+ * Returns: TRUE if the memory is locked.
+ */
+gboolean
+geye_realtime_lock_memory(GError **error)
+{
+    g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+#if defined(HAVE_MLOCKALL)
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        realtime_set_error(error, errno, "Unable to lock the memory");
+        return FALSE;
+    }
+    return TRUE;
+#else
+    realtime_set_unsupported(error, "Locking the memory");
+    return FALSE;
+#endif
+}
+
+/**
+ * geye_realtime_prefault:
+ * @mem: the start of a buffer
+ * @size: the size of the buffer
+ *
+ * Touches every page of the buffer, so that the first real use of it
+ * doesn't have to wait for the operating system. The contents of the buffer
+ * are kept.
+ */
+void
+geye_realtime_prefault(gpointer mem, gsize size)
+{
+    volatile guint8 *bytes = mem;
+    gsize page_size = REALTIME_PAGE_SIZE;
+    gsize i;
+
+#if defined(G_OS_UNIX)
+    long sc_page_size = sysconf(_SC_PAGESIZE);
+    if (sc_page_size > 0)
+        page_size = sc_page_size;
+#endif
+
+    for (i = 0; i < size; i += page_size)
+        bytes[i] = bytes[i];
+    if (size > 0)
+        bytes[size - 1] = bytes[size - 1];
+}
+
+/**
+ * geye_realtime_prefault_stack:
+ *
+ * Touches the next part of the stack of the calling thread.
+ */
+void
+geye_realtime_prefault_stack(void)
+{
+    guint8 stack[REALTIME_STACK_SIZE];
+    memset(stack, 0, sizeof(stack));
+    geye_realtime_prefault(stack, sizeof(stack));
+}
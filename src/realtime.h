@@ -0,0 +1,47 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GEYE_REALTIME_H
+#define GEYE_REALTIME_H
+
+#include "eyelink-et.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Helpers that make the calling thread suffer less from the rest of the
+ * system: a real-time scheduling policy, a CPU affinity and memory that is
+ * locked into RAM. They fail with a GError in the G_IO_ERROR domain when the
+ * operating system refuses, the thread then simply keeps running as before.
+ */
+
+gboolean    geye_realtime_set_scheduling(GEyeSchedPolicy    policy,
+                                         gint               priority,
+                                         GError           **error);
+gboolean    geye_realtime_set_affinity(guint64      cpu_mask,
+                                       GError     **error);
+gboolean    geye_realtime_lock_memory(GError **error);
+
+void        geye_realtime_prefault(gpointer mem, gsize size);
+void        geye_realtime_prefault_stack(void);
+
+G_END_DECLS
+
+#endif
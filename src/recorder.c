@@ -0,0 +1,409 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+#include "recorder.h"
+#include "realtime.h"
+#include "sample-ring.h"
+
+static const char* RECORDER_THREAD_NAME = "GEye-recorder";
+
+// Records per buffer, about 4 seconds of binocular samples at 2000 Hz.
+#define RECORDER_BUFFER_SIZE 8192
+#define RECORDER_N_BUFFERS 8
+// A buffer that isn't full yet is handed to the writer after this many µs.
+#define RECORDER_COMMIT_INTERVAL G_USEC_PER_SEC
+// The writer looks this often whether the recorder is being closed.
+#define RECORDER_WAIT_US (100 * 1000)
+
+typedef struct {
+    guint       n;
+    GEyeRecord  records[RECORDER_BUFFER_SIZE];
+} RecorderBuffer;
+
+struct _GEyeRecorder {
+    FILE               *file;
+    GThread            *writer;
+    GEyeSampleRing     *filled;     // RecorderBuffer*, producer to writer
+    GEyeSampleRing     *empty;      // RecorderBuffer*, writer to producer
+    RecorderBuffer     *buffers[RECORDER_N_BUFFERS];
+    gint                closing;    // Atomic
+
+    /* Producer only. */
+    RecorderBuffer     *current;
+    gint64              current_since;
+    GEyeRecordingFooter footer;
+    gdouble             min_interval;
+
+    /* Writer only, until it is joined. */
+    GError             *error;
+};
+
+static void
+recorder_set_error(GError **error, int err, const gchar *what)
+{
+    g_set_error(error,
+                G_IO_ERROR,
+                g_io_error_from_errno(err),
+                "%s: %s",
+                what,
+                g_strerror(err)
+                );
+}
+
+static gpointer
+recorder_writer(gpointer data)
+{
+    GEyeRecorder *recorder = data;
+    RecorderBuffer *buffer;
+    gboolean closing;
+
+    do {
+        // Once closing is seen, everything the producer handed over before
+        // can be popped, so the writer only stops when it is drained.
+        closing = g_atomic_int_get(&recorder->closing);
+        while (closing ?
+                geye_sample_ring_pop(recorder->filled, &buffer, 1) :
+                geye_sample_ring_pop_timeout(
+                    recorder->filled, &buffer, 1, RECORDER_WAIT_US)
+                ) {
+            if (!recorder->error &&
+                    (fwrite(buffer->records,
+                            sizeof(GEyeRecord),
+                            buffer->n,
+                            recorder->file) != buffer->n ||
+                     fflush(recorder->file) != 0))
+                recorder_set_error(
+                        &recorder->error, errno, "Unable to write recording"
+                        );
+            buffer->n = 0;
+            geye_sample_ring_push(recorder->empty, &buffer);
+        }
+    } while (!closing);
+
+    return NULL;
+}
+
+static void
+recorder_hand_over(GEyeRecorder *recorder)
+{
+    // There is room for all buffers in the ring, so this doesn't fail.
+    geye_sample_ring_push(recorder->filled, &recorder->current);
+    geye_sample_ring_wake(recorder->filled);
+    recorder->current = NULL;
+}
+
+/*
+ * Returns a cleared record in the current buffer, or NULL when the writer
+ * didn't return a buffer in time.
+ */
+static GEyeRecord*
+recorder_next(GEyeRecorder *recorder, GEyeRecordType type)
+{
+    GEyeRecord *record;
+
+    if (recorder->current && recorder->current->n == RECORDER_BUFFER_SIZE)
+        recorder_hand_over(recorder);
+
+    if (!recorder->current) {
+        if (!geye_sample_ring_pop(recorder->empty, &recorder->current, 1)) {
+            recorder->footer.n_dropped++;
+            return NULL;
+        }
+        recorder->current_since = g_get_monotonic_time();
+    }
+
+    record = &recorder->current->records[recorder->current->n++];
+    memset(record, 0, sizeof(GEyeRecord));
+    record->type = type;
+    recorder->footer.n_records++;
+    return record;
+}
+
+static void
+recorder_count_sample(GEyeRecorder *recorder, gdouble time)
+{
+    GEyeRecordingFooter *footer = &recorder->footer;
+    gdouble interval;
+
+    if (footer->n_samples++ == 0) {
+        footer->first_time = footer->last_time = time;
+        return;
+    }
+
+    interval = time - footer->last_time;
+    if (interval > 0 &&
+            (recorder->min_interval == 0 || interval < recorder->min_interval))
+        recorder->min_interval = interval;
+    if (recorder->min_interval > 0 && interval > 2 * recorder->min_interval) {
+        footer->n_gaps++;
+        footer->gap_time += interval - recorder->min_interval;
+    }
+    footer->last_time = time;
+}
+
+/**
+ * geye_recorder_new:
+ * @filename: the file to create, an existing file is overwritten.
+ * @tracker_info:(nullable): a description of the eyetracker
+ * @disp_width: the width of the display
+ * @disp_height: the height of the display
+ * @start_time: µs since the epoch at which GEyeEvent.time is 0
+ * @error: returns why the file couldn't be created
+ *
+ * Creates the file, writes the header and starts the writer thread. The
+ * buffers are allocated and touched here, so the producer doesn't take
+ * page faults.
+ *
+ * Returns: a new recorder, or NULL when the file can't be written.
+ */
+GEyeRecorder*
+geye_recorder_new(const gchar  *filename,
+                  const gchar  *tracker_info,
+                  gdouble       disp_width,
+                  gdouble       disp_height,
+                  gint64        start_time,
+                  GError      **error)
+{
+    GEyeRecordingHeader header = {
+        .version = GEYE_RECORDING_VERSION,
+        .header_size = sizeof(GEyeRecordingHeader),
+        .record_size = sizeof(GEyeRecord),
+        .start_time = start_time,
+        .disp_width = disp_width,
+        .disp_height = disp_height
+    };
+    GEyeRecorder *recorder;
+    FILE *file;
+    guint i;
+
+    g_return_val_if_fail(filename != NULL, NULL);
+    g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+    memcpy(header.magic, GEYE_RECORDING_MAGIC, sizeof(header.magic));
+    if (tracker_info)
+        g_strlcpy(
+                header.tracker_info, tracker_info, sizeof(header.tracker_info)
+                );
+
+    file = g_fopen(filename, "wb");
+    if (!file) {
+        recorder_set_error(error, errno, filename);
+        return NULL;
+    }
+    if (fwrite(&header, sizeof(header), 1, file) != 1) {
+        recorder_set_error(error, errno, filename);
+        fclose(file);
+        return NULL;
+    }
+
+    recorder = g_new0(GEyeRecorder, 1);
+    recorder->file = file;
+    recorder->filled = geye_sample_ring_new(
+            RECORDER_N_BUFFERS, sizeof(RecorderBuffer*)
+            );
+    recorder->empty = geye_sample_ring_new(
+            RECORDER_N_BUFFERS, sizeof(RecorderBuffer*)
+            );
+    for (i = 0; i < RECORDER_N_BUFFERS; i++) {
+        recorder->buffers[i] = g_malloc(sizeof(RecorderBuffer));
+        geye_realtime_prefault(recorder->buffers[i], sizeof(RecorderBuffer));
+        recorder->buffers[i]->n = 0;
+        geye_sample_ring_push(recorder->empty, &recorder->buffers[i]);
+    }
+    memcpy(recorder->footer.magic,
+           GEYE_RECORDING_FOOTER_MAGIC,
+           sizeof(recorder->footer.magic)
+           );
+
+    recorder->writer = g_thread_new(
+            RECORDER_THREAD_NAME, recorder_writer, recorder
+            );
+    return recorder;
+}
+
+/**
+ * geye_recorder_close:
+ * @recorder: a GEyeRecorder, the producer must be done with it.
+ * @error: returns the first error of writing the recording
+ *
+ * Waits until the writer wrote all buffers that were handed over, writes
+ * the footer and frees the recorder. Call geye_recorder_flush() on the
+ * producer side first, otherwise the last records are lost.
+ *
+ * Returns: TRUE if the whole recording was written.
+ */
+gboolean
+geye_recorder_close(GEyeRecorder *recorder, GError **error)
+{
+    GError *close_error = NULL;
+    guint i;
+
+    g_return_val_if_fail(recorder != NULL, FALSE);
+
+    g_atomic_int_set(&recorder->closing, TRUE);
+    geye_sample_ring_wake(recorder->filled);
+    g_thread_join(recorder->writer);
+
+    close_error = recorder->error;
+    if (!close_error &&
+            fwrite(&recorder->footer,
+                   sizeof(GEyeRecordingFooter), 1, recorder->file) != 1)
+        recorder_set_error(&close_error, errno, "Unable to write recording");
+    if (fclose(recorder->file) != 0 && !close_error)
+        recorder_set_error(&close_error, errno, "Unable to close recording");
+
+    for (i = 0; i < RECORDER_N_BUFFERS; i++)
+        g_free(recorder->buffers[i]);
+    geye_sample_ring_free(recorder->filled);
+    geye_sample_ring_free(recorder->empty);
+    g_free(recorder);
+
+    if (close_error) {
+        g_propagate_error(error, close_error);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void
+geye_recorder_sample(GEyeRecorder              *recorder,
+                     const GEyeBinocularSample *sample)
+{
+    GEyeRecord *record;
+
+    recorder_count_sample(recorder, sample->parent.time);
+
+    record = recorder_next(recorder, GEYE_RECORD_SAMPLE);
+    if (!record)
+        return;
+
+    record->event = sample->parent.type;
+    record->eye = sample->parent.eye;
+    record->valid = sample->valid;
+    record->time = sample->parent.time;
+    record->tracker_time = sample->parent.tracker_time;
+    record->data.sample.left_x = sample->left_x;
+    record->data.sample.left_y = sample->left_y;
+    record->data.sample.right_x = sample->right_x;
+    record->data.sample.right_y = sample->right_y;
+}
+
+void
+geye_recorder_fixation(GEyeRecorder *recorder, const GEyeFixation *fixation)
+{
+    GEyeRecord *record = recorder_next(recorder, GEYE_RECORD_FIXATION);
+
+    if (!record)
+        return;
+
+    record->event = fixation->parent.type;
+    record->eye = fixation->parent.eye;
+    record->time = fixation->parent.time;
+    record->tracker_time = fixation->parent.tracker_time;
+    record->data.fixation.end_time = fixation->end_time;
+    record->data.fixation.x = fixation->x;
+    record->data.fixation.y = fixation->y;
+}
+
+void
+geye_recorder_saccade(GEyeRecorder *recorder, const GEyeSaccade *saccade)
+{
+    GEyeRecord *record = recorder_next(recorder, GEYE_RECORD_SACCADE);
+
+    if (!record)
+        return;
+
+    record->event = saccade->parent.type;
+    record->eye = saccade->parent.eye;
+    record->time = saccade->parent.time;
+    record->tracker_time = saccade->parent.tracker_time;
+    record->data.saccade.end_time = saccade->end_time;
+    record->data.saccade.start_x = saccade->start_x;
+    record->data.saccade.start_y = saccade->start_y;
+    record->data.saccade.end_x = saccade->end_x;
+    record->data.saccade.end_y = saccade->end_y;
+    record->data.saccade.amplitude = saccade->amplitude;
+    record->data.saccade.peak_velocity = saccade->peak_velocity;
+}
+
+/**
+ * geye_recorder_message:
+ * @recorder: a GEyeRecorder
+ * @time: the time of the message
+ * @text: the message
+ *
+ * Adds a message, a long message is spread over consecutive records. The
+ * text in a record isn't terminated when it fills the record.
+ */
+void
+geye_recorder_message(GEyeRecorder *recorder, gdouble time, const gchar *text)
+{
+    gsize len = strlen(text), offset = 0;
+
+    do {
+        gsize n = MIN(len - offset, GEYE_RECORD_MESSAGE_SIZE);
+        GEyeRecord *record = recorder_next(recorder, GEYE_RECORD_MESSAGE);
+
+        if (!record)
+            return;
+
+        record->time = time;
+        memcpy(record->data.message, text + offset, n);
+        offset += n;
+        if (offset < len)
+            record->flags |= GEYE_RECORD_FLAG_MORE;
+    } while (offset < len);
+}
+
+/**
+ * geye_recorder_commit:
+ * @recorder: a GEyeRecorder
+ *
+ * Hands the current buffer to the writer when it has been filling for
+ * a while, so that a slow stream of records still reaches the disk. Call
+ * it after a batch of records.
+ */
+void
+geye_recorder_commit(GEyeRecorder *recorder)
+{
+    if (recorder->current && recorder->current->n > 0 &&
+            g_get_monotonic_time() - recorder->current_since >=
+            RECORDER_COMMIT_INTERVAL)
+        recorder_hand_over(recorder);
+}
+
+/**
+ * geye_recorder_flush:
+ * @recorder: a GEyeRecorder
+ *
+ * Hands the current buffer to the writer, the last thing the producer
+ * does with the recorder.
+ */
+void
+geye_recorder_flush(GEyeRecorder *recorder)
+{
+    if (recorder->current && recorder->current->n > 0)
+        recorder_hand_over(recorder);
+}
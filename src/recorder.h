@@ -0,0 +1,62 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GEYE_RECORDER_H
+#define GEYE_RECORDER_H
+
+#include <gio/gio.h>
+#include "eye-event.h"
+#include "recording.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Writes a host recording. One producer thread, the one that receives the
+ * samples, adds records to large buffers without taking a lock or
+ * allocating memory. Full buffers are handed to a writer thread, so a disk
+ * that stalls doesn't delay the producer. When no empty buffer is left,
+ * records are dropped and counted in the footer.
+ */
+typedef struct _GEyeRecorder GEyeRecorder;
+
+GEyeRecorder*   geye_recorder_new(const gchar  *filename,
+                                  const gchar  *tracker_info,
+                                  gdouble       disp_width,
+                                  gdouble       disp_height,
+                                  gint64        start_time,
+                                  GError      **error);
+gboolean        geye_recorder_close(GEyeRecorder *recorder, GError **error);
+
+/* producer side */
+void            geye_recorder_sample(GEyeRecorder              *recorder,
+                                     const GEyeBinocularSample *sample);
+void            geye_recorder_fixation(GEyeRecorder        *recorder,
+                                       const GEyeFixation  *fixation);
+void            geye_recorder_saccade(GEyeRecorder         *recorder,
+                                      const GEyeSaccade    *saccade);
+void            geye_recorder_message(GEyeRecorder *recorder,
+                                      gdouble       time,
+                                      const gchar  *text);
+void            geye_recorder_commit(GEyeRecorder *recorder);
+void            geye_recorder_flush(GEyeRecorder *recorder);
+
+G_END_DECLS
+
+#endif
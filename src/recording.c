@@ -0,0 +1,454 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+
+#include <string.h>
+#include <gio/gio.h>
+
+#include "recording.h"
+
+// The time index has an entry for every this many samples.
+#define RECORDING_INDEX_STRIDE 256
+#define RECORDING_INDEX_MAGIC "GEYEIDX1"
+#define RECORDING_INDEX_SUFFIX ".idx"
+
+/*
+ * The time of an entry is the highest sample time up to its record, so the
+ * entries are sorted, even when the clock of the host stepped back.
+ */
+typedef struct {
+    gdouble     time;
+    guint64     record;
+} IndexEntry;
+
+/* The index file, followed by the entries. */
+typedef struct {
+    gchar       magic[8];
+    guint32     stride;
+    guint32     record_size;
+    guint64     n_records;
+    guint64     n_entries;
+} IndexHeader;
+
+struct _GEyeRecording {
+    GObject                     parent;
+
+    gchar                      *filename;
+    GMappedFile                *file;
+    GBytes                     *bytes;      // the whole mapping
+
+    const GEyeRecordingHeader  *header;
+    const GEyeRecordingFooter  *footer;     // NULL if it wasn't closed
+    const GEyeRecord           *records;
+    gsize                       n_records;
+
+    IndexEntry                 *index;
+    gsize                       n_entries;
+};
+
+G_DEFINE_TYPE(GEyeRecording, geye_recording, G_TYPE_OBJECT)
+
+static void
+geye_recording_init(GEyeRecording *self)
+{
+    (void) self;
+}
+
+static void
+recording_finalize(GObject *gobject)
+{
+    GEyeRecording *self = GEYE_RECORDING(gobject);
+
+    g_free(self->filename);
+    g_free(self->index);
+    if (self->bytes)
+        g_bytes_unref(self->bytes);
+    if (self->file)
+        g_mapped_file_unref(self->file);
+
+    G_OBJECT_CLASS(geye_recording_parent_class)->finalize(gobject);
+}
+
+static void
+geye_recording_class_init(GEyeRecordingClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    object_class->finalize = recording_finalize;
+}
+
+/*
+ * Checks the header and finds the records and the footer.
+ */
+static gboolean
+recording_map(GEyeRecording *self, GError **error)
+{
+    const gchar *contents;
+    gsize length, data_size;
+
+    self->file = g_mapped_file_new(self->filename, FALSE, error);
+    if (!self->file)
+        return FALSE;
+
+    contents = g_mapped_file_get_contents(self->file);
+    length = g_mapped_file_get_length(self->file);
+    self->bytes = g_mapped_file_get_bytes(self->file);
+    self->header = (const GEyeRecordingHeader*) contents;
+
+    if (length < sizeof(GEyeRecordingHeader) ||
+            memcmp(self->header->magic, GEYE_RECORDING_MAGIC, 8) != 0) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                    "%s is not a host recording", self->filename);
+        return FALSE;
+    }
+    if (self->header->version != GEYE_RECORDING_VERSION ||
+            self->header->header_size != sizeof(GEyeRecordingHeader) ||
+            self->header->record_size != sizeof(GEyeRecord)) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                    "%s is a host recording of version %u, expected %u",
+                    self->filename,
+                    self->header->version,
+                    GEYE_RECORDING_VERSION);
+        return FALSE;
+    }
+
+    data_size = length - sizeof(GEyeRecordingHeader);
+    self->records = (const GEyeRecord*) (contents + sizeof(GEyeRecordingHeader));
+
+    if (data_size >= sizeof(GEyeRecordingFooter)) {
+        const GEyeRecordingFooter *footer = (const GEyeRecordingFooter*)
+            (contents + length - sizeof(GEyeRecordingFooter));
+        gsize records_size = data_size - sizeof(GEyeRecordingFooter);
+
+        if (memcmp(footer->magic, GEYE_RECORDING_FOOTER_MAGIC, 8) == 0 &&
+                records_size % sizeof(GEyeRecord) == 0) {
+            self->footer = footer;
+            data_size = records_size;
+        }
+    }
+    // Without a footer, the last record might be incomplete.
+    self->n_records = data_size / sizeof(GEyeRecord);
+
+    return TRUE;
+}
+
+static gchar*
+recording_index_filename(GEyeRecording *self)
+{
+    return g_strconcat(self->filename, RECORDING_INDEX_SUFFIX, NULL);
+}
+
+/*
+ * Loads the index that was saved with geye_recording_save_index(), as long
+ * as it belongs to the records as they are now.
+ */
+static gboolean
+recording_load_index(GEyeRecording *self)
+{
+    gchar *filename = recording_index_filename(self);
+    gchar *contents = NULL;
+    gsize length = 0;
+    const IndexHeader *header;
+    const IndexEntry *entries;
+    gboolean valid = FALSE;
+    gsize i;
+
+    if (!g_file_get_contents(filename, &contents, &length, NULL))
+        goto out;
+
+    header = (const IndexHeader*) contents;
+    if (length < sizeof(IndexHeader) ||
+            memcmp(header->magic, RECORDING_INDEX_MAGIC, 8) != 0 ||
+            header->stride != RECORDING_INDEX_STRIDE ||
+            header->record_size != sizeof(GEyeRecord) ||
+            header->n_records != self->n_records ||
+            header->n_entries > (length - sizeof(IndexHeader)) / sizeof(IndexEntry) ||
+            length != sizeof(IndexHeader) + header->n_entries * sizeof(IndexEntry))
+        goto out;
+
+    entries = (const IndexEntry*) (contents + sizeof(IndexHeader));
+    for (i = 0; i < header->n_entries; i++)
+        if (entries[i].record >= self->n_records)
+            goto out;
+
+    self->n_entries = header->n_entries;
+    self->index = g_new(IndexEntry, self->n_entries);
+    memcpy(self->index, entries, self->n_entries * sizeof(IndexEntry));
+    valid = TRUE;
+
+out:
+    g_free(contents);
+    g_free(filename);
+    return valid;
+}
+
+static void
+recording_build_index(GEyeRecording *self)
+{
+    GArray *index = g_array_new(FALSE, FALSE, sizeof(IndexEntry));
+    gdouble max_time = -G_MAXDOUBLE;
+    guint64 n_samples = 0;
+    gsize i;
+
+    for (i = 0; i < self->n_records; i++) {
+        const GEyeRecord *record = &self->records[i];
+
+        if (record->type != GEYE_RECORD_SAMPLE)
+            continue;
+        max_time = MAX(max_time, record->time);
+        if (n_samples++ % RECORDING_INDEX_STRIDE == 0) {
+            IndexEntry entry = {.time = max_time, .record = i};
+            g_array_append_val(index, entry);
+        }
+    }
+
+    self->n_entries = index->len;
+    self->index = (IndexEntry*) g_array_free(index, FALSE);
+}
+
+/* ************************** public functions **************************** */
+
+/**
+ * geye_recording_open:(constructor)
+ * @filename: a file written by geye_eyetracker_start_host_recording()
+ * @error: returns why the file couldn't be opened
+ *
+ * Maps a host recording into memory, the records are read from the file as
+ * they are used. A recording that wasn't closed properly, or that is still
+ * being written, can be opened too, it just has no footer.
+ *
+ * A sparse time index is loaded from @filename with ".idx" appended, when
+ * it matches the recording, otherwise it is built, which takes a single
+ * pass over the samples. Save it with geye_recording_save_index().
+ *
+ * Returns:(transfer full)(nullable): a new GEyeRecording
+ */
+GEyeRecording*
+geye_recording_open(const gchar *filename, GError **error)
+{
+    GEyeRecording *self;
+
+    g_return_val_if_fail(filename != NULL, NULL);
+    g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+    self = g_object_new(GEYE_TYPE_RECORDING, NULL);
+    self->filename = g_strdup(filename);
+
+    if (!recording_map(self, error)) {
+        g_object_unref(self);
+        return NULL;
+    }
+    if (!recording_load_index(self))
+        recording_build_index(self);
+
+    return self;
+}
+
+/**
+ * geye_recording_get_header:
+ * @recording: a GEyeRecording
+ *
+ * Returns:(transfer none): the header, with the tracker info, the display
+ *                          dimensions and the wall clock time at which
+ *                          GEyeEvent.time was 0.
+ */
+const GEyeRecordingHeader*
+geye_recording_get_header(GEyeRecording *recording)
+{
+    g_return_val_if_fail(GEYE_IS_RECORDING(recording), NULL);
+    return recording->header;
+}
+
+/**
+ * geye_recording_get_footer:
+ * @recording: a GEyeRecording
+ *
+ * Returns:(transfer none)(nullable): the footer with the number of samples
+ *                                    and the gaps between them, or NULL
+ *                                    when the recording wasn't closed.
+ */
+const GEyeRecordingFooter*
+geye_recording_get_footer(GEyeRecording *recording)
+{
+    g_return_val_if_fail(GEYE_IS_RECORDING(recording), NULL);
+    return recording->footer;
+}
+
+/**
+ * geye_recording_get_records:
+ * @recording: a GEyeRecording
+ * @n_records:(out): the number of records
+ *
+ * The records point into the mapping of the file, they remain valid as
+ * long as @recording is alive. They are in the order in which the
+ * Eyelink-thread received them, an ended fixation, whose time is that of
+ * its start, follows the samples of the fixation.
+ *
+ * Returns:(transfer none)(array length=n_records): the records
+ */
+const GEyeRecord*
+geye_recording_get_records(GEyeRecording *recording, gsize *n_records)
+{
+    g_return_val_if_fail(GEYE_IS_RECORDING(recording), NULL);
+    g_return_val_if_fail(n_records != NULL, NULL);
+
+    *n_records = recording->n_records;
+    return recording->records;
+}
+
+/**
+ * geye_recording_get_bytes:
+ * @recording: a GEyeRecording
+ * @first: the first record
+ * @n: the number of records
+ *
+ * Returns records without copying them, the bytes keep the mapping alive,
+ * also after @recording is gone. In Python, numpy.frombuffer() with a
+ * structured dtype that matches GEyeRecord turns them into an array. Or
+ * use numpy.memmap() on the file itself, the records of @first start at
+ * GEyeRecordingHeader.header_size + @first * GEyeRecordingHeader.record_size.
+ *
+ * Returns:(transfer full): the records @first up to @first + @n
+ */
+GBytes*
+geye_recording_get_bytes(GEyeRecording *recording, gsize first, gsize n)
+{
+    g_return_val_if_fail(GEYE_IS_RECORDING(recording), NULL);
+    g_return_val_if_fail(first <= recording->n_records, NULL);
+    g_return_val_if_fail(n <= recording->n_records - first, NULL);
+
+    return g_bytes_new_from_bytes(
+            recording->bytes,
+            sizeof(GEyeRecordingHeader) + first * sizeof(GEyeRecord),
+            n * sizeof(GEyeRecord)
+            );
+}
+
+/**
+ * geye_recording_find_time:
+ * @recording: a GEyeRecording
+ * @time: a time in the unit of GEyeEvent.time
+ *
+ * Looks up the first sample at or after @time with a binary search in the
+ * time index, followed by a scan of at most a few hundred samples.
+ *
+ * Returns: the index of the record of that sample, or the number of records
+ *          when all samples are before @time.
+ */
+gsize
+geye_recording_find_time(GEyeRecording *recording, gdouble time)
+{
+    gsize lo = 0, hi, i = 0;
+
+    g_return_val_if_fail(GEYE_IS_RECORDING(recording), 0);
+
+    // The last entry before time, the samples before it are too early.
+    hi = recording->n_entries;
+    while (lo < hi) {
+        gsize mid = lo + (hi - lo) / 2;
+        if (recording->index[mid].time < time)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo > 0)
+        i = recording->index[lo - 1].record;
+
+    for (; i < recording->n_records; i++) {
+        const GEyeRecord *record = &recording->records[i];
+        if (record->type == GEYE_RECORD_SAMPLE && record->time >= time)
+            break;
+    }
+    return i;
+}
+
+/**
+ * geye_recording_find_range:
+ * @recording: a GEyeRecording
+ * @start: the start of the range
+ * @end: the end of the range, it isn't included
+ * @first:(out): the index of the first record in the range
+ *
+ * Looks up the records from the first sample at or after @start up to the
+ * first sample at or after @end. The events in between are included. Use
+ * geye_recording_get_records() or geye_recording_get_bytes() to get to
+ * them.
+ *
+ * Returns: the number of records in the range
+ */
+gsize
+geye_recording_find_range(GEyeRecording    *recording,
+                          gdouble           start,
+                          gdouble           end,
+                          gsize            *first)
+{
+    gsize last;
+
+    g_return_val_if_fail(GEYE_IS_RECORDING(recording), 0);
+    g_return_val_if_fail(first != NULL, 0);
+
+    *first = geye_recording_find_time(recording, start);
+    if (end <= start)
+        return 0;
+    last = geye_recording_find_time(recording, end);
+    return last > *first ? last - *first : 0;
+}
+
+/**
+ * geye_recording_save_index:
+ * @recording: a GEyeRecording
+ * @error: returns why the index couldn't be saved
+ *
+ * Saves the time index next to the recording, so that opening it again
+ * doesn't need a pass over the samples.
+ *
+ * Returns: TRUE when the index was saved
+ */
+gboolean
+geye_recording_save_index(GEyeRecording *recording, GError **error)
+{
+    IndexHeader header = {
+        .stride = RECORDING_INDEX_STRIDE,
+        .record_size = sizeof(GEyeRecord),
+    };
+    gsize entries_size, length;
+    gchar *contents, *filename;
+    gboolean saved;
+
+    g_return_val_if_fail(GEYE_IS_RECORDING(recording), FALSE);
+    g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+    memcpy(header.magic, RECORDING_INDEX_MAGIC, sizeof(header.magic));
+    header.n_records = recording->n_records;
+    header.n_entries = recording->n_entries;
+    entries_size = recording->n_entries * sizeof(IndexEntry);
+    length = sizeof(header) + entries_size;
+
+    contents = g_malloc(length);
+    memcpy(contents, &header, sizeof(header));
+    if (entries_size)
+        memcpy(contents + sizeof(header), recording->index, entries_size);
+
+    filename = recording_index_filename(recording);
+    saved = g_file_set_contents(filename, contents, length, error);
+
+    g_free(filename);
+    g_free(contents);
+    return saved;
+}
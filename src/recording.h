@@ -0,0 +1,147 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+
+#ifndef GEYE_RECORDING_H
+#define GEYE_RECORDING_H
+
+#include <glib-object.h>
+#include <gmodule.h>
+
+G_BEGIN_DECLS
+
+/*
+ * The binary file of a host recording. It consists of a header, fixed size
+ * records and a footer. All values are in the byte order of the host that
+ * wrote it, times are in the unit of GEyeEvent.time.
+ *
+ *   GEyeRecordingHeader
+ *   GEyeRecord * n_records
+ *   GEyeRecordingFooter
+ *
+ * A file without a footer was not closed properly, the complete records
+ * before the end are still valid.
+ */
+
+#define GEYE_RECORDING_MAGIC            "GEYEREC1"
+#define GEYE_RECORDING_FOOTER_MAGIC     "GEYEEND1"
+#define GEYE_RECORDING_VERSION          1
+
+typedef enum {
+    GEYE_RECORD_SAMPLE = 1,
+    GEYE_RECORD_FIXATION,
+    GEYE_RECORD_SACCADE,
+    GEYE_RECORD_MESSAGE
+} GEyeRecordType;
+
+/* The text of the message continues in the next record. */
+#define GEYE_RECORD_FLAG_MORE   (1 << 0)
+
+#define GEYE_RECORD_MESSAGE_SIZE 56
+
+typedef struct {
+    gchar       magic[8];
+    guint32     version;
+    guint32     header_size;
+    guint32     record_size;
+    guint32     reserved;
+    gint64      start_time;     // µs since the epoch at GEyeEvent.time 0
+    gdouble     disp_width;
+    gdouble     disp_height;
+    gchar       tracker_info[208];
+} GEyeRecordingHeader;
+
+typedef struct {
+    guint16     type;           // GEyeRecordType
+    guint16     event;          // GEyeEventType
+    guint8      eye;            // GEyeEyeType
+    guint8      valid;          // GEyeEyeType, samples only
+    guint16     flags;
+    gdouble     time;
+    gdouble     tracker_time;
+    union {
+        struct {
+            gdouble left_x, left_y;
+            gdouble right_x, right_y;
+        } sample;
+        struct {
+            gdouble end_time;
+            gdouble x, y;
+        } fixation;
+        struct {
+            gdouble end_time;
+            gdouble start_x, start_y;
+            gdouble end_x, end_y;
+            gdouble amplitude;
+            gdouble peak_velocity;
+        } saccade;
+        gchar message[GEYE_RECORD_MESSAGE_SIZE];
+    } data;
+} GEyeRecord;
+
+typedef struct {
+    gchar       magic[8];
+    guint64     n_records;
+    guint64     n_samples;
+    guint64     n_gaps;         // intervals of more than twice the shortest
+    gdouble     gap_time;       // time missing in those gaps
+    guint64     n_dropped;      // records the writer couldn't keep up with
+    gdouble     first_time;     // of the first sample
+    gdouble     last_time;      // of the last sample
+} GEyeRecordingFooter;
+
+G_STATIC_ASSERT(sizeof(GEyeRecordingHeader) == 256);
+G_STATIC_ASSERT(sizeof(GEyeRecord) == 80);
+G_STATIC_ASSERT(sizeof(GEyeRecordingFooter) == 64);
+
+#define GEYE_TYPE_RECORDING geye_recording_get_type()
+G_MODULE_EXPORT
+G_DECLARE_FINAL_TYPE(GEyeRecording, geye_recording, GEYE, RECORDING, GObject)
+
+G_MODULE_EXPORT GEyeRecording*
+geye_recording_open(const gchar *filename, GError **error);
+
+G_MODULE_EXPORT const GEyeRecordingHeader*
+geye_recording_get_header(GEyeRecording *recording);
+
+G_MODULE_EXPORT const GEyeRecordingFooter*
+geye_recording_get_footer(GEyeRecording *recording);
+
+G_MODULE_EXPORT const GEyeRecord*
+geye_recording_get_records(GEyeRecording *recording, gsize *n_records);
+
+G_MODULE_EXPORT GBytes*
+geye_recording_get_bytes(GEyeRecording *recording, gsize first, gsize n);
+
+G_MODULE_EXPORT gsize
+geye_recording_find_time(GEyeRecording *recording, gdouble time);
+
+G_MODULE_EXPORT gsize
+geye_recording_find_range(GEyeRecording    *recording,
+                          gdouble           start,
+                          gdouble           end,
+                          gsize            *first);
+
+G_MODULE_EXPORT gboolean
+geye_recording_save_index(GEyeRecording *recording, GError **error);
+
+G_END_DECLS
+
+#endif
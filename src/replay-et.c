@@ -0,0 +1,724 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "eyetracker-error.h"
+#include "replay-et.h"
+#include "replay-reader.h"
+#include "sample-output.h"
+
+static const char* REPLAY_THREAD_NAME = "GEye-replay";
+
+// The player looks this often whether it should stop, while the reader
+// is behind.
+#define REPLAY_WAIT_US (100 * 1000)
+
+#define REPLAY_DEFAULT_SPEED 1.0
+
+struct _GEyeReplayEt {
+    GObject         parent;
+
+    GMutex          lock;
+    GCond           cond;           // Signals a change of speed or stop
+
+    gchar          *filename;
+    gdouble         speed;          // Lock, 0 is as fast as possible
+    gboolean        stop;           // Lock, the player should return
+
+    GEyeReplayReader *reader;       // The player uses it while tracking
+    GThread        *player;         // Main context
+
+    /*
+     * Relates the tracker time of the recording to the host time at which
+     * it is played, set by the player. Lock.
+     */
+    gint64          anchor_host;    // 0 while not playing at a speed
+    gdouble         anchor_tracker; // ms
+    gdouble         anchor_speed;
+
+    /* Player only, kept while it is stopped. */
+    const GEyeRecord *records;
+    guint           n_records;
+    guint           next_record;
+
+    GEyeSampleOutput *output;       // Sends the records of the player
+};
+
+typedef enum {
+    FINISHED,
+    N_SIGNALS
+} GEyeReplayEtSignal;
+
+static guint replay_signals[N_SIGNALS];
+
+static void
+geye_eyetracker_interface_init(GEyeEyetrackerInterface* iface);
+
+G_DEFINE_TYPE_WITH_CODE(GEyeReplayEt,
+                        geye_replay_et,
+                        G_TYPE_OBJECT,
+                        G_IMPLEMENT_INTERFACE(GEYE_TYPE_EYETRACKER,
+                                              geye_eyetracker_interface_init)
+                        )
+
+typedef enum {
+    PROP_NULL,
+    PROP_FILENAME,
+    PROP_SPEED,
+    PROP_SAMPLES_PLAYED,
+    N_PROPERTIES
+} GEyeReplayEtProperty;
+
+static GParamSpec* obj_properties[N_PROPERTIES] = {NULL, };
+
+static void
+geye_replay_et_init(GEyeReplayEt* self)
+{
+    g_mutex_init(&self->lock);
+    g_cond_init(&self->cond);
+
+    self->speed     = REPLAY_DEFAULT_SPEED;
+    self->output    = geye_sample_output_new(
+            GEYE_EYETRACKER(self), "replay", obj_properties[PROP_SAMPLES_PLAYED]
+            );
+}
+
+static gboolean
+replay_connected(GEyeReplayEt *self)
+{
+    return (geye_sample_output_get_state(self->output) &
+            GEYE_SAMPLE_OUTPUT_CONNECTED) != 0;
+}
+
+/* ****************************** the player ******************************** */
+
+/*
+ * The time at which a record would have arrived from the eyetracker, the
+ * end of a fixation or saccade is known once it ended.
+ */
+static gdouble
+record_arrival(const GEyeRecord *record)
+{
+    if (record->type == GEYE_RECORD_FIXATION &&
+            record->event != GEYE_EVENT_FIX_START)
+        return record->data.fixation.end_time;
+    if (record->type == GEYE_RECORD_SACCADE &&
+            record->event != GEYE_EVENT_SAC_START)
+        return record->data.saccade.end_time;
+    return record->time;
+}
+
+/* When the player plays the records, taken at a change of speed. */
+typedef struct {
+    gint64              anchor_host;    // µs
+    gdouble             anchor_time;    // s, record_arrival() at anchor_host
+    gdouble             speed;
+} PlayOptions;
+
+/* The host time at which a record is due, 0 when it is due right away. */
+static gint64
+record_due(const PlayOptions *options, const GEyeRecord *record)
+{
+    if (options->speed <= 0)
+        return 0;
+    return options->anchor_host + (gint64) (
+            (record_arrival(record) - options->anchor_time) *
+            G_USEC_PER_SEC / options->speed
+            );
+}
+
+static gint
+emit_finished(gpointer data)
+{
+    GEyeReplayEt *self = data;
+    g_assert(g_main_context_is_owner(
+                geye_sample_output_get_context(self->output)
+                ));
+
+    // The player returned by itself, unless it was stopped in the meantime.
+    if (self->player) {
+        g_thread_join(self->player);
+        self->player = NULL;
+        geye_sample_output_update_state(
+                self->output, GEYE_SAMPLE_OUTPUT_TRACKING, 0
+                );
+        g_signal_emit(self, replay_signals[FINISHED], 0);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * Plays the records that are due at once, then waits for the next one. The
+ * position in the recording is kept when the player is stopped, so it
+ * continues there when tracking starts again.
+ */
+static gpointer
+replay_player(gpointer data)
+{
+    GEyeReplayEt *self = data;
+    PlayOptions options = {.speed = -1};
+    gboolean anchored = FALSE, finished = FALSE;
+
+    for (;;) {
+        gint64 woke, due = 0;
+
+        g_mutex_lock(&self->lock);
+        if (self->stop) {
+            g_mutex_unlock(&self->lock);
+            break;
+        }
+        if (self->speed != options.speed) {
+            options.speed = self->speed;
+            anchored = FALSE;
+        }
+        g_mutex_unlock(&self->lock);
+
+        if (!self->records) {
+            self->records = geye_replay_reader_next(
+                    self->reader, &self->n_records, REPLAY_WAIT_US
+                    );
+            self->next_record = 0;
+            if (!self->records) {
+                if (geye_replay_reader_at_end(self->reader)) {
+                    finished = TRUE;
+                    break;
+                }
+                continue;
+            }
+        }
+
+        woke = g_get_monotonic_time();
+        if (!anchored) {
+            const GEyeRecord *record = &self->records[self->next_record];
+            options.anchor_host = woke;
+            options.anchor_time = record_arrival(record);
+            g_mutex_lock(&self->lock);
+            self->anchor_host = options.speed > 0 ? woke : 0;
+            self->anchor_tracker = record->tracker_time -
+                (record->time - options.anchor_time) * 1000;
+            self->anchor_speed = options.speed;
+            g_mutex_unlock(&self->lock);
+            anchored = TRUE;
+        }
+        geye_sample_output_begin(self->output);
+
+        while (self->next_record < self->n_records) {
+            const GEyeRecord *record = &self->records[self->next_record];
+            due = record_due(&options, record);
+            if (due > woke)
+                break;
+            geye_sample_output_record(self->output, record, due, woke);
+            self->next_record++;
+        }
+        geye_sample_output_end(self->output);
+
+        if (self->next_record == self->n_records) {
+            geye_replay_reader_release(self->reader);
+            self->records = NULL;
+            continue;
+        }
+
+        // Wait for the next record, a change of speed or stop.
+        g_mutex_lock(&self->lock);
+        if (!self->stop && self->speed == options.speed)
+            g_cond_wait_until(&self->cond, &self->lock, due);
+        g_mutex_unlock(&self->lock);
+    }
+
+    // Not invoked, that might run it here, where the player can't be joined.
+    if (finished) {
+        GSource *source = g_idle_source_new();
+        g_source_set_callback(
+                source, emit_finished, g_object_ref(self), g_object_unref
+                );
+        g_source_attach(
+                source, geye_sample_output_get_context(self->output)
+                );
+        g_source_unref(source);
+    }
+    return NULL;
+}
+
+/* Stops the player and waits for it, from the main context. */
+static void
+replay_et_stop_player(GEyeReplayEt *self)
+{
+    if (!self->player)
+        return;
+
+    g_mutex_lock(&self->lock);
+    self->stop = TRUE;
+    g_cond_signal(&self->cond);
+    g_mutex_unlock(&self->lock);
+
+    g_thread_join(self->player);
+    self->player = NULL;
+}
+
+/* Drops the position of the player and the reader. */
+static void
+replay_et_close_reader(GEyeReplayEt *self)
+{
+    GError *error = NULL;
+
+    if (!self->reader)
+        return;
+
+    if (self->records)
+        geye_replay_reader_release(self->reader);
+    self->records = NULL;
+    if (!geye_replay_reader_close(self->reader, &error)) {
+        g_signal_emit_by_name(self, "error", error->message);
+        g_error_free(error);
+    }
+    self->reader = NULL;
+}
+
+/* **************************** interface methods *************************** */
+
+static void
+replay_et_connect(GEyeEyetracker* et, GError** error)
+{
+    GEyeReplayEt *self = GEYE_REPLAY_ET(et);
+    GEyeReplayReader *reader;
+    GError *open_error = NULL;
+    gchar *filename;
+
+    if (replay_connected(self))
+        return;
+
+    filename = geye_replay_et_get_filename(self);
+    if (!filename) {
+        g_set_error(
+                error,
+                geye_eyetracker_error_quark(),
+                GEYE_EYETRACKER_ERROR_UNABLE_TO_CONNECT,
+                "There is no recording to replay."
+                );
+        return;
+    }
+
+    reader = geye_replay_reader_new(filename, &open_error);
+    g_free(filename);
+    if (!reader) {
+        g_set_error(
+                error,
+                geye_eyetracker_error_quark(),
+                GEYE_EYETRACKER_ERROR_UNABLE_TO_CONNECT,
+                "%s",
+                open_error->message
+                );
+        g_error_free(open_error);
+        return;
+    }
+
+    self->reader = reader;
+    geye_sample_output_set_info(
+            self->output, geye_replay_reader_get_header(reader)->tracker_info
+            );
+    geye_sample_output_update_state(
+            self->output, 0, GEYE_SAMPLE_OUTPUT_CONNECTED
+            );
+}
+
+static void
+replay_et_disconnect(GEyeEyetracker* et)
+{
+    GEyeReplayEt *self = GEYE_REPLAY_ET(et);
+
+    if (!replay_connected(self))
+        return;
+
+    geye_eyetracker_stop_tracking(et);
+    replay_et_close_reader(self);
+    geye_sample_output_update_state(self->output, ~0, 0);
+}
+
+/*
+ * Starts playing where the previous playback stopped, or from the start
+ * once the end was reached.
+ */
+static void
+replay_et_start_tracking(GEyeEyetracker* et, GError** error)
+{
+    GEyeReplayEt *self = GEYE_REPLAY_ET(et);
+    GError *open_error = NULL;
+
+    if (!geye_sample_output_check_connected(
+                self->output, "start tracking", error))
+        return;
+    if (self->player)
+        return;
+
+    if (!self->records && geye_replay_reader_at_end(self->reader)) {
+        gchar *filename = geye_replay_et_get_filename(self);
+        replay_et_close_reader(self);
+        self->reader = geye_replay_reader_new(filename, &open_error);
+        g_free(filename);
+        if (!self->reader) {
+            g_set_error(
+                    error,
+                    geye_eyetracker_error_quark(),
+                    GEYE_EYETRACKER_ERROR_UNABLE_TO_CONNECT,
+                    "%s",
+                    open_error->message
+                    );
+            g_error_free(open_error);
+            // Without a reader the replay is no longer connected.
+            geye_sample_output_update_state(self->output, ~0, 0);
+            return;
+        }
+    }
+
+    geye_sample_output_prefault(self->output);
+
+    self->stop = FALSE;
+    self->player = g_thread_new(REPLAY_THREAD_NAME, replay_player, self);
+    geye_sample_output_update_state(
+            self->output, 0, GEYE_SAMPLE_OUTPUT_TRACKING
+            );
+}
+
+static void
+replay_et_stop_tracking(GEyeEyetracker* et)
+{
+    GEyeReplayEt *self = GEYE_REPLAY_ET(et);
+
+    if (!self->player)
+        return;
+
+    replay_et_stop_player(self);
+    g_mutex_lock(&self->lock);
+    self->anchor_host = 0;
+    g_mutex_unlock(&self->lock);
+    geye_sample_output_update_state(
+            self->output, GEYE_SAMPLE_OUTPUT_TRACKING, 0
+            );
+}
+
+/*
+ * The host time at which a tracker time is played, 0 while it isn't played
+ * at a speed.
+ */
+static gint64
+replay_et_tracker_to_host_time(GEyeEyetracker* et, gdouble tracker_time)
+{
+    GEyeReplayEt *self = GEYE_REPLAY_ET(et);
+    gint64 host = 0;
+
+    g_mutex_lock(&self->lock);
+    if (self->anchor_host)
+        host = self->anchor_host + (gint64) (
+                (tracker_time - self->anchor_tracker) * 1000 /
+                self->anchor_speed
+                );
+    g_mutex_unlock(&self->lock);
+    return host;
+}
+
+
+
+static void
+geye_eyetracker_interface_init(GEyeEyetrackerInterface* iface)
+{
+    geye_sample_output_interface_init(iface);
+
+    iface->connect          = replay_et_connect;
+    iface->disconnect       = replay_et_disconnect;
+
+    iface->start_tracking   = replay_et_start_tracking;
+    iface->stop_tracking    = replay_et_stop_tracking;
+
+    iface->tracker_to_host_time = replay_et_tracker_to_host_time;
+}
+
+/* ******************************* GObject ********************************** */
+
+static void
+replay_et_dispose(GObject* gobject)
+{
+    GEyeReplayEt* self = GEYE_REPLAY_ET(gobject);
+
+    replay_et_stop_player(self);
+    replay_et_close_reader(self);
+
+    // The player is gone, drop its references.
+    geye_sample_output_dispose(self->output);
+
+    G_OBJECT_CLASS(geye_replay_et_parent_class)->dispose(gobject);
+}
+
+static void
+replay_et_finalize(GObject* gobject)
+{
+    GEyeReplayEt* self = GEYE_REPLAY_ET(gobject);
+
+    g_free(self->filename);
+    geye_sample_output_free(self->output);
+    g_cond_clear(&self->cond);
+    g_mutex_clear(&self->lock);
+
+    G_OBJECT_CLASS(geye_replay_et_parent_class)->finalize(gobject);
+}
+
+static void
+geye_replay_et_set_property(GObject        *obj,
+                            guint           property_id,
+                            const GValue   *value,
+                            GParamSpec     *pspec
+                            )
+{
+    GEyeReplayEt* self = GEYE_REPLAY_ET(obj);
+    GError *error = NULL;
+
+    switch((GEyeReplayEtProperty) property_id) {
+        case PROP_FILENAME:
+            geye_replay_et_set_filename(
+                    self, g_value_get_string(value), &error
+                    );
+            if (error) {
+                g_warning("%s", error->message);
+                g_error_free(error);
+            }
+            break;
+        case PROP_SPEED:
+            geye_replay_et_set_speed(self, g_value_get_double(value));
+            break;
+        case PROP_SAMPLES_PLAYED:
+        case PROP_NULL:
+        case N_PROPERTIES:
+        default:
+            if (!geye_sample_output_set_property(
+                        self->output, property_id - N_PROPERTIES, value))
+                G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, property_id, pspec);
+    }
+}
+
+static void
+geye_replay_et_get_property(GObject        *obj,
+                            guint           property_id,
+                            GValue         *value,
+                            GParamSpec     *pspec
+                            )
+{
+    GEyeReplayEt* self = GEYE_REPLAY_ET(obj);
+
+    switch((GEyeReplayEtProperty) property_id) {
+        case PROP_FILENAME:
+            g_value_take_string(value, geye_replay_et_get_filename(self));
+            break;
+        case PROP_SPEED:
+            g_value_set_double(value, geye_replay_et_get_speed(self));
+            break;
+        case PROP_SAMPLES_PLAYED:
+            g_value_set_uint(
+                    value, geye_sample_output_get_produced(self->output)
+                    );
+            break;
+        case PROP_NULL:
+        case N_PROPERTIES:
+        default:
+            if (!geye_sample_output_get_property(
+                        self->output, property_id - N_PROPERTIES, value))
+                G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, property_id, pspec);
+    }
+}
+
+static void
+geye_replay_et_class_init(GEyeReplayEtClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = replay_et_dispose;
+    object_class->finalize = replay_et_finalize;
+    object_class->get_property = geye_replay_et_get_property;
+    object_class->set_property = geye_replay_et_set_property;
+
+    obj_properties[PROP_FILENAME] = g_param_spec_string(
+            "filename",
+            "Filename",
+            "The host recording or ASC file to replay.",
+            NULL,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+            );
+
+    /**
+     * GEyeReplayEt:speed:
+     *
+     * How many times faster than real time the recording is played, 0 plays
+     * it as fast as possible. Then the samples are dispatched faster than
+     * the main context can emit them, so the dispatch drops them according
+     * to #GEyeEyetracker:drop-policy. The speed may be changed while
+     * playing.
+     */
+    obj_properties[PROP_SPEED] = g_param_spec_double(
+            "speed",
+            "Speed",
+            "How many times faster than real time the recording is played, "
+            "0 is as fast as possible.",
+            0, G_MAXDOUBLE,
+            REPLAY_DEFAULT_SPEED,
+            G_PARAM_READWRITE | G_PARAM_CONSTRUCT
+            );
+
+    obj_properties[PROP_SAMPLES_PLAYED] = g_param_spec_uint(
+            "samples-played",
+            "Samples played",
+            "The number of samples the player took from the recording, "
+            "changes are notified at most four times per second.",
+            0, G_MAXUINT,
+            0,
+            G_PARAM_READABLE
+            );
+
+    g_object_class_install_properties(
+            object_class, N_PROPERTIES, obj_properties
+            );
+
+    geye_sample_output_override_properties(object_class, N_PROPERTIES);
+
+    /**
+     * GEyeReplayEt::finished:
+     * @replay: the object that received this signal
+     *
+     * Emitted when the whole recording has been played, tracking has
+     * stopped then. Starting to track again plays the recording from the
+     * start.
+     */
+    replay_signals[FINISHED] = g_signal_new(
+            "finished",
+            G_TYPE_FROM_CLASS(klass),
+            G_SIGNAL_RUN_LAST,
+            0,
+            NULL, NULL,
+            NULL,
+            G_TYPE_NONE,
+            0
+            );
+}
+
+/* ***************************** public functions *************************** */
+
+/**
+ * geye_replay_et_new:(constructor)
+ * @filename:(nullable): the host recording or ASC file to replay
+ *
+ * Returns:(transfer full): a new GEyeReplayEt*
+ */
+GEyeReplayEt*
+geye_replay_et_new(const gchar *filename)
+{
+    return g_object_new(GEYE_TYPE_REPLAY_ET, "filename", filename, NULL);
+}
+
+/**
+ * geye_replay_et_destroy:(destructor)
+ * @self: the #GEyeReplayEt instance to destroy.
+ *
+ * Drops a reference on self.
+ */
+void
+geye_replay_et_destroy(GEyeReplayEt *self)
+{
+    g_object_unref(self);
+}
+
+/**
+ * geye_replay_et_set_filename:
+ * @self: a GEyeReplayEt
+ * @filename:(nullable): the host recording or ASC file to replay
+ * @error: returns an error when the replay is connected
+ *
+ * The file is opened when the replay connects, so it is set before.
+ */
+void
+geye_replay_et_set_filename(GEyeReplayEt   *self,
+                            const gchar    *filename,
+                            GError        **error)
+{
+    g_return_if_fail(GEYE_IS_REPLAY_ET(self));
+    g_return_if_fail(error == NULL || *error == NULL);
+
+    if (replay_connected(self)) {
+        g_set_error(
+                error,
+                geye_eyetracker_error_quark(),
+                GEYE_EYETRACKER_ERROR_INCORRECT_MODE,
+                "Set the filename prior to connecting to the replay"
+                );
+        return;
+    }
+
+    g_mutex_lock(&self->lock);
+    g_free(self->filename);
+    self->filename = g_strdup(filename);
+    g_mutex_unlock(&self->lock);
+}
+
+/**
+ * geye_replay_et_get_filename:
+ * @self: a GEyeReplayEt
+ *
+ * Returns:(transfer full)(nullable): the file that is replayed
+ */
+gchar*
+geye_replay_et_get_filename(GEyeReplayEt *self)
+{
+    gchar *filename;
+
+    g_return_val_if_fail(GEYE_IS_REPLAY_ET(self), NULL);
+
+    g_mutex_lock(&self->lock);
+    filename = g_strdup(self->filename);
+    g_mutex_unlock(&self->lock);
+    return filename;
+}
+
+/**
+ * geye_replay_et_set_speed:
+ * @self: a GEyeReplayEt
+ * @speed: how many times faster than real time to play, 0 is as fast as
+ *         possible
+ *
+ * Sets #GEyeReplayEt:speed, a playback in progress continues at the new
+ * speed from the next record.
+ */
+void
+geye_replay_et_set_speed(GEyeReplayEt *self, gdouble speed)
+{
+    g_return_if_fail(GEYE_IS_REPLAY_ET(self));
+    g_return_if_fail(speed >= 0);
+
+    g_mutex_lock(&self->lock);
+    self->speed = speed;
+    g_cond_signal(&self->cond);
+    g_mutex_unlock(&self->lock);
+}
+
+gdouble
+geye_replay_et_get_speed(GEyeReplayEt *self)
+{
+    gdouble speed;
+
+    g_return_val_if_fail(GEYE_IS_REPLAY_ET(self), 0);
+
+    g_mutex_lock(&self->lock);
+    speed = self->speed;
+    g_mutex_unlock(&self->lock);
+    return speed;
+}
@@ -0,0 +1,69 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+
+#ifndef GEYE_REPLAY_ET_H
+#define GEYE_REPLAY_ET_H
+
+#include "eyetracker.h"
+
+G_BEGIN_DECLS
+
+/**
+ * GEyeReplayEt:
+ *
+ * An eyetracker that plays back a recorded session: a host recording, see
+ * geye_eyetracker_start_host_recording(), or the ASCII export of an EDF
+ * file written by edf2asc. Connecting opens the file, tracking plays it
+ * with the same signals, geye_eyetracker_read_samples(), subscribers and
+ * areas of interest as a live eyetracker. The times of the samples and
+ * events are those of the recording.
+ *
+ * The playback runs at #GEyeReplayEt:speed times real time, or as fast as
+ * possible. The file is read ahead on a thread of its own, so the disk
+ * doesn't disturb the timing of the playback.
+ */
+#define GEYE_TYPE_REPLAY_ET geye_replay_et_get_type()
+G_MODULE_EXPORT
+G_DECLARE_FINAL_TYPE(GEyeReplayEt, geye_replay_et, GEYE, REPLAY_ET, GObject)
+
+G_MODULE_EXPORT GEyeReplayEt*
+geye_replay_et_new(const gchar *filename);
+
+G_MODULE_EXPORT void
+geye_replay_et_destroy(GEyeReplayEt *self);
+
+G_MODULE_EXPORT void
+geye_replay_et_set_filename(GEyeReplayEt   *self,
+                            const gchar    *filename,
+                            GError        **error);
+
+G_MODULE_EXPORT gchar*
+geye_replay_et_get_filename(GEyeReplayEt *self);
+
+G_MODULE_EXPORT void
+geye_replay_et_set_speed(GEyeReplayEt *self, gdouble speed);
+
+G_MODULE_EXPORT gdouble
+geye_replay_et_get_speed(GEyeReplayEt *self);
+
+G_END_DECLS
+
+#endif
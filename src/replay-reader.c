@@ -0,0 +1,653 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+
+#include "replay-reader.h"
+#include "realtime.h"
+#include "sample-ring.h"
+
+static const char* REPLAY_READER_THREAD_NAME = "GEye-replay-reader";
+
+// Records per buffer, about 2 seconds of binocular samples at 2000 Hz.
+#define REPLAY_BUFFER_SIZE 4096
+#define REPLAY_N_BUFFERS 8
+// The reader looks this often whether it is being closed.
+#define REPLAY_WAIT_US (100 * 1000)
+// Longer lines of an ASC file are cut off, only messages get that long.
+#define REPLAY_LINE_SIZE 1024
+// The most fields of an ASC line that are looked at, a binocular sample
+// with velocity and resolution has 13 columns and the flags.
+#define REPLAY_MAX_FIELDS 16
+// The gaze and the pupil size of every eye in a sample line of an ASC file.
+#define ASC_EYE_COLUMNS 3
+
+typedef struct {
+    guint       n;
+    GEyeRecord  records[REPLAY_BUFFER_SIZE];
+} ReplayBuffer;
+
+struct _GEyeReplayReader {
+    gchar              *filename;
+    FILE               *file;
+    GEyeReplayFormat    format;
+    GEyeRecordingHeader header;
+    GThread            *thread;
+    GEyeSampleRing     *filled;     // ReplayBuffer*, reader to player
+    GEyeSampleRing     *empty;      // ReplayBuffer*, player to reader
+    ReplayBuffer       *buffers[REPLAY_N_BUFFERS];
+    gint                closing;    // Atomic
+    gint                done;       // Atomic, everything has been handed over
+
+    /* Player only. */
+    ReplayBuffer       *current;
+
+    /* Reader only, until it is joined. */
+    GError             *error;
+    GEyeEyeType         asc_eyes;   // the eyes of the samples
+    guint               asc_columns;// that a sample line has at least
+    guint               asc_line;   // the number of the line being parsed
+    gdouble             asc_start;  // tracker time in ms at time 0
+    gboolean            asc_started;
+};
+
+static void
+reader_set_error(GError **error, int err, const gchar *filename)
+{
+    g_set_error(error,
+                G_IO_ERROR,
+                g_io_error_from_errno(err),
+                "Unable to read %s: %s",
+                filename,
+                g_strerror(err)
+                );
+}
+
+/* ******************************* ASC files ******************************** */
+
+/*
+ * Reads a line without its line ending, the rest of a line that doesn't fit
+ * is skipped.
+ */
+static gboolean
+asc_read_line(FILE *file, gchar *line, gsize size)
+{
+    gsize len;
+
+    if (!fgets(line, size, file))
+        return FALSE;
+
+    len = strlen(line);
+    if (len > 0 && line[len - 1] != '\n') {
+        int c;
+        do {
+            c = fgetc(file);
+        } while (c != '\n' && c != EOF);
+    }
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+        line[--len] = '\0';
+    return TRUE;
+}
+
+/* Splits a line in place at white space. */
+static guint
+asc_split(gchar *line, gchar **fields, guint max_fields)
+{
+    guint n = 0;
+
+    while (n < max_fields) {
+        while (*line == ' ' || *line == '\t')
+            line++;
+        if (*line == '\0')
+            break;
+        fields[n++] = line;
+        while (*line != '\0' && *line != ' ' && *line != '\t')
+            line++;
+        if (*line != '\0')
+            *line++ = '\0';
+    }
+    return n;
+}
+
+/* A missing value is written as a dot. */
+static gdouble
+asc_value(const gchar *field)
+{
+    if (field[0] == '.')
+        return NAN;
+    return g_ascii_strtod(field, NULL);
+}
+
+static GEyeEyeType
+asc_eye(const gchar *field)
+{
+    switch (field[0]) {
+        case 'L': return GEYE_LEFT;
+        case 'R': return GEYE_RIGHT;
+        default:  return GEYE_NONE;
+    }
+}
+
+/* The eyes named by a START, SAMPLES or EVENTS line. */
+static GEyeEyeType
+asc_line_eyes(gchar **fields, guint n_fields)
+{
+    GEyeEyeType eyes = GEYE_NONE;
+    guint i;
+
+    for (i = 1; i < n_fields; i++) {
+        if (strcmp(fields[i], "LEFT") == 0)
+            eyes |= GEYE_LEFT;
+        else if (strcmp(fields[i], "RIGHT") == 0)
+            eyes |= GEYE_RIGHT;
+    }
+    return eyes;
+}
+
+/*
+ * The columns of a sample line that a SAMPLES line announces. The gaze and
+ * the pupil size of every eye come first, then the velocity of every eye
+ * (VEL) and the resolution (RES). The flags that may follow aren't read.
+ */
+static guint
+asc_sample_columns(gchar **fields, guint n_fields, GEyeEyeType eyes)
+{
+    guint n_eyes = (eyes & GEYE_LEFT ? 1 : 0) + (eyes & GEYE_RIGHT ? 1 : 0);
+    guint columns = 1 + n_eyes * ASC_EYE_COLUMNS;
+    guint i;
+
+    for (i = 1; i < n_fields; i++) {
+        if (strcmp(fields[i], "VEL") == 0)
+            columns += n_eyes * 2;
+        else if (strcmp(fields[i], "RES") == 0)
+            columns += 2;
+    }
+    return columns;
+}
+
+static gdouble
+asc_time(GEyeReplayReader *reader, gdouble tracker_ms)
+{
+    return (tracker_ms - reader->asc_start) / 1000.0;
+}
+
+static gboolean
+asc_sample(GEyeReplayReader *reader,
+           gchar           **fields,
+           guint             n_fields,
+           GEyeRecord       *record)
+{
+    GEyeEyeType eyes = reader->asc_eyes ? reader->asc_eyes : GEYE_LEFT;
+    guint columns = reader->asc_columns ? reader->asc_columns :
+                                          1 + ASC_EYE_COLUMNS;
+    gdouble tracker_time = g_ascii_strtod(fields[0], NULL);
+    gdouble *gaze[2] = {
+        &record->data.sample.left_x, &record->data.sample.right_x
+    };
+    guint field = 1, eye;
+
+    // Otherwise the columns of one eye would be taken for those of another.
+    if (n_fields < columns) {
+        g_set_error(&reader->error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                    "%s:%u: a sample has %u columns, the SAMPLES line "
+                    "announced %u",
+                    reader->filename, reader->asc_line, n_fields, columns);
+        return FALSE;
+    }
+
+    record->type = GEYE_RECORD_SAMPLE;
+    record->event = GEYE_EVENT_SAMPLE;
+    record->eye = eyes;
+    record->time = asc_time(reader, tracker_time);
+    record->tracker_time = tracker_time;
+    record->data.sample.left_x = record->data.sample.left_y = NAN;
+    record->data.sample.right_x = record->data.sample.right_y = NAN;
+
+    // Every eye has x, y and the pupil size, in the order left, right.
+    for (eye = 0; eye < 2; eye++) {
+        GEyeEyeType flag = eye == 0 ? GEYE_LEFT : GEYE_RIGHT;
+        if (!(eyes & flag))
+            continue;
+        gaze[eye][0] = asc_value(fields[field]);
+        gaze[eye][1] = asc_value(fields[field + 1]);
+        if (!isnan(gaze[eye][0]) && !isnan(gaze[eye][1]))
+            record->valid |= flag;
+        field += ASC_EYE_COLUMNS;
+    }
+    return TRUE;
+}
+
+/*
+ * Converts a line of an ASC file to a record. Returns FALSE for the lines
+ * that don't become a record and for a line that is malformed, then
+ * reader->error is set.
+ */
+static gboolean
+asc_parse_line(GEyeReplayReader *reader, gchar *line, GEyeRecord *record)
+{
+    gchar *fields[REPLAY_MAX_FIELDS];
+    guint n = asc_split(line, fields, REPLAY_MAX_FIELDS);
+
+    memset(record, 0, sizeof(GEyeRecord));
+    if (n == 0)
+        return FALSE;
+
+    if (g_ascii_isdigit(fields[0][0])) {
+        if (!reader->asc_started) {
+            reader->asc_start = g_ascii_strtod(fields[0], NULL);
+            reader->asc_started = TRUE;
+        }
+        return asc_sample(reader, fields, n, record);
+    }
+
+    if (strcmp(fields[0], "START") == 0 || strcmp(fields[0], "SAMPLES") == 0) {
+        gboolean start = strcmp(fields[0], "START") == 0;
+        GEyeEyeType eyes = asc_line_eyes(fields, n);
+        if (eyes)
+            reader->asc_eyes = eyes;
+        if (!start)
+            reader->asc_columns = asc_sample_columns(
+                    fields, n, reader->asc_eyes ? reader->asc_eyes : GEYE_LEFT
+                    );
+        if (start && !reader->asc_started && n > 1) {
+            reader->asc_start = g_ascii_strtod(fields[1], NULL);
+            reader->asc_started = TRUE;
+        }
+        return FALSE;
+    }
+
+    if (!reader->asc_started)
+        return FALSE;
+
+    // SFIX L start and SSACC L start
+    if ((strcmp(fields[0], "SFIX") == 0 || strcmp(fields[0], "SSACC") == 0) &&
+            n >= 3) {
+        gboolean fix = fields[0][1] == 'F';
+        record->type = fix ? GEYE_RECORD_FIXATION : GEYE_RECORD_SACCADE;
+        record->event = fix ? GEYE_EVENT_FIX_START : GEYE_EVENT_SAC_START;
+        record->eye = asc_eye(fields[1]);
+        record->tracker_time = g_ascii_strtod(fields[2], NULL);
+        record->time = asc_time(reader, record->tracker_time);
+        return record->eye != GEYE_NONE;
+    }
+
+    // EFIX L start end duration x y pupil
+    if (strcmp(fields[0], "EFIX") == 0 && n >= 7) {
+        record->type = GEYE_RECORD_FIXATION;
+        record->event = GEYE_EVENT_FIX_END;
+        record->eye = asc_eye(fields[1]);
+        record->tracker_time = g_ascii_strtod(fields[2], NULL);
+        record->time = asc_time(reader, record->tracker_time);
+        record->data.fixation.end_time =
+            asc_time(reader, g_ascii_strtod(fields[3], NULL));
+        record->data.fixation.x = asc_value(fields[5]);
+        record->data.fixation.y = asc_value(fields[6]);
+        return record->eye != GEYE_NONE;
+    }
+
+    // ESACC L start end duration start_x start_y end_x end_y amplitude peak
+    if (strcmp(fields[0], "ESACC") == 0 && n >= 11) {
+        record->type = GEYE_RECORD_SACCADE;
+        record->event = GEYE_EVENT_SAC_END;
+        record->eye = asc_eye(fields[1]);
+        record->tracker_time = g_ascii_strtod(fields[2], NULL);
+        record->time = asc_time(reader, record->tracker_time);
+        record->data.saccade.end_time =
+            asc_time(reader, g_ascii_strtod(fields[3], NULL));
+        record->data.saccade.start_x = asc_value(fields[5]);
+        record->data.saccade.start_y = asc_value(fields[6]);
+        record->data.saccade.end_x = asc_value(fields[7]);
+        record->data.saccade.end_y = asc_value(fields[8]);
+        record->data.saccade.amplitude = asc_value(fields[9]);
+        record->data.saccade.peak_velocity = asc_value(fields[10]);
+        return record->eye != GEYE_NONE;
+    }
+
+    return FALSE;
+}
+
+/*
+ * Reads the lines before the first sample for the header, it isn't
+ * consumed, the reader thread starts at the beginning again. Returns FALSE
+ * when the file doesn't look like an ASC file.
+ */
+static gboolean
+asc_read_preamble(GEyeReplayReader *reader)
+{
+    GEyeRecordingHeader *header = &reader->header;
+    gchar line[REPLAY_LINE_SIZE];
+    gboolean is_asc = FALSE;
+    const gchar *version = "** VERSION:";
+
+    while (asc_read_line(reader->file, line, sizeof(line))) {
+        gchar *fields[REPLAY_MAX_FIELDS];
+        guint n;
+
+        if (g_str_has_prefix(line, version)) {
+            g_strlcpy(header->tracker_info,
+                      g_strstrip(line + strlen(version)),
+                      sizeof(header->tracker_info)
+                      );
+            is_asc = TRUE;
+            continue;
+        }
+        if (g_str_has_prefix(line, "**")) {
+            is_asc = TRUE;
+            continue;
+        }
+
+        n = asc_split(line, fields, REPLAY_MAX_FIELDS);
+        if (n == 0)
+            continue;
+        if (g_ascii_isdigit(fields[0][0]))
+            break;
+        // MSG time DISPLAY_COORDS left top right bottom
+        if (strcmp(fields[0], "MSG") == 0 && n >= 7 &&
+                strcmp(fields[2], "DISPLAY_COORDS") == 0) {
+            header->disp_width =
+                asc_value(fields[5]) - asc_value(fields[3]) + 1;
+            header->disp_height =
+                asc_value(fields[6]) - asc_value(fields[4]) + 1;
+        }
+        if (strcmp(fields[0], "START") == 0 ||
+                strcmp(fields[0], "SAMPLES") == 0)
+            is_asc = TRUE;
+    }
+
+    if (header->tracker_info[0] == '\0')
+        g_strlcpy(header->tracker_info,
+                  "EyeLink ASC export",
+                  sizeof(header->tracker_info)
+                  );
+    rewind(reader->file);
+    return is_asc;
+}
+
+/* ***************************** reader thread ****************************** */
+
+/* Fills a buffer, returns FALSE at the end of the file. */
+static gboolean
+reader_fill(GEyeReplayReader *reader, ReplayBuffer *buffer)
+{
+    if (reader->format == GEYE_REPLAY_FORMAT_RECORDING) {
+        // A footer, or a record that was cut off, isn't a whole record.
+        buffer->n = fread(buffer->records,
+                          sizeof(GEyeRecord),
+                          REPLAY_BUFFER_SIZE,
+                          reader->file
+                          );
+        return buffer->n == REPLAY_BUFFER_SIZE;
+    }
+    else {
+        gchar line[REPLAY_LINE_SIZE];
+
+        buffer->n = 0;
+        while (buffer->n < REPLAY_BUFFER_SIZE) {
+            if (!asc_read_line(reader->file, line, sizeof(line)))
+                return FALSE;
+            reader->asc_line++;
+            if (asc_parse_line(reader, line, &buffer->records[buffer->n]))
+                buffer->n++;
+            else if (reader->error)
+                return FALSE;
+        }
+        return TRUE;
+    }
+}
+
+static gpointer
+replay_reader_thread(gpointer data)
+{
+    GEyeReplayReader *reader = data;
+    ReplayBuffer *buffer;
+    gboolean more = TRUE;
+
+    while (more && !g_atomic_int_get(&reader->closing)) {
+        if (!geye_sample_ring_pop_timeout(
+                    reader->empty, &buffer, 1, REPLAY_WAIT_US))
+            continue;
+
+        more = reader_fill(reader, buffer);
+        if (!more && !reader->error && ferror(reader->file))
+            reader_set_error(&reader->error, errno, reader->filename);
+        // There is room for all buffers in the ring, so this doesn't fail.
+        if (buffer->n > 0) {
+            geye_sample_ring_push(reader->filled, &buffer);
+            geye_sample_ring_wake(reader->filled);
+        }
+    }
+
+    g_atomic_int_set(&reader->done, TRUE);
+    geye_sample_ring_wake(reader->filled);
+    return NULL;
+}
+
+/* ***************************** public functions *************************** */
+
+/**
+ * geye_replay_reader_new:
+ * @filename: a host recording or an ASC file
+ * @error: returns why the file can't be replayed
+ *
+ * Opens the file, reads its header and starts the reader thread. The
+ * buffers are allocated and touched here, so the player doesn't take page
+ * faults.
+ *
+ * Returns: a new reader, or NULL when the file can't be read.
+ */
+GEyeReplayReader*
+geye_replay_reader_new(const gchar *filename, GError **error)
+{
+    GEyeReplayReader *reader;
+    FILE *file;
+    guint i;
+
+    g_return_val_if_fail(filename != NULL, NULL);
+    g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+    file = g_fopen(filename, "rb");
+    if (!file) {
+        reader_set_error(error, errno, filename);
+        return NULL;
+    }
+
+    reader = g_new0(GEyeReplayReader, 1);
+    reader->filename = g_strdup(filename);
+    reader->file = file;
+
+    if (fread(&reader->header, sizeof(reader->header), 1, file) == 1 &&
+            memcmp(reader->header.magic, GEYE_RECORDING_MAGIC, 8) == 0) {
+        reader->format = GEYE_REPLAY_FORMAT_RECORDING;
+        if (reader->header.version != GEYE_RECORDING_VERSION ||
+                reader->header.header_size != sizeof(GEyeRecordingHeader) ||
+                reader->header.record_size != sizeof(GEyeRecord)) {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                        "%s is a host recording of version %u, expected %u",
+                        filename,
+                        reader->header.version,
+                        GEYE_RECORDING_VERSION);
+            geye_replay_reader_close(reader, NULL);
+            return NULL;
+        }
+    }
+    else {
+        memset(&reader->header, 0, sizeof(reader->header));
+        rewind(file);
+        if (!asc_read_preamble(reader)) {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                        "%s is neither a host recording nor an ASC file",
+                        filename);
+            geye_replay_reader_close(reader, NULL);
+            return NULL;
+        }
+        reader->format = GEYE_REPLAY_FORMAT_ASC;
+        memcpy(reader->header.magic, GEYE_RECORDING_MAGIC, 8);
+        reader->header.version = GEYE_RECORDING_VERSION;
+        reader->header.header_size = sizeof(GEyeRecordingHeader);
+        reader->header.record_size = sizeof(GEyeRecord);
+    }
+
+    reader->filled = geye_sample_ring_new(
+            REPLAY_N_BUFFERS, sizeof(ReplayBuffer*)
+            );
+    reader->empty = geye_sample_ring_new(
+            REPLAY_N_BUFFERS, sizeof(ReplayBuffer*)
+            );
+    for (i = 0; i < REPLAY_N_BUFFERS; i++) {
+        reader->buffers[i] = g_malloc(sizeof(ReplayBuffer));
+        geye_realtime_prefault(reader->buffers[i], sizeof(ReplayBuffer));
+        reader->buffers[i]->n = 0;
+        geye_sample_ring_push(reader->empty, &reader->buffers[i]);
+    }
+
+    reader->thread = g_thread_new(
+            REPLAY_READER_THREAD_NAME, replay_reader_thread, reader
+            );
+    return reader;
+}
+
+/**
+ * geye_replay_reader_close:
+ * @reader: a GEyeReplayReader, the player must be done with it.
+ * @error: returns why the file couldn't be read to the end
+ *
+ * Stops the reader thread, wherever it is in the file, and frees the
+ * reader.
+ *
+ * Returns: TRUE if no error occurred while reading.
+ */
+gboolean
+geye_replay_reader_close(GEyeReplayReader *reader, GError **error)
+{
+    GError *read_error;
+    guint i;
+
+    g_return_val_if_fail(reader != NULL, FALSE);
+
+    if (reader->thread) {
+        g_atomic_int_set(&reader->closing, TRUE);
+        g_thread_join(reader->thread);
+    }
+    read_error = reader->error;
+
+    fclose(reader->file);
+    for (i = 0; i < REPLAY_N_BUFFERS; i++)
+        g_free(reader->buffers[i]);
+    if (reader->filled)
+        geye_sample_ring_free(reader->filled);
+    if (reader->empty)
+        geye_sample_ring_free(reader->empty);
+    g_free(reader->filename);
+    g_free(reader);
+
+    if (read_error) {
+        g_propagate_error(error, read_error);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+GEyeReplayFormat
+geye_replay_reader_get_format(GEyeReplayReader *reader)
+{
+    return reader->format;
+}
+
+/**
+ * geye_replay_reader_get_header:
+ * @reader: a GEyeReplayReader
+ *
+ * The header of an ASC file has the tracker info of its VERSION line and
+ * the display of its DISPLAY_COORDS message, its start time is unknown.
+ *
+ * Returns:(transfer none): the header of the recording
+ */
+const GEyeRecordingHeader*
+geye_replay_reader_get_header(GEyeReplayReader *reader)
+{
+    return &reader->header;
+}
+
+/**
+ * geye_replay_reader_next:
+ * @reader: a GEyeReplayReader
+ * @n_records:(out): the number of records returned
+ * @timeout_us: how long to wait for the reader, as in
+ *              geye_sample_ring_pop_timeout()
+ *
+ * Takes the next buffer of records, it has to be released with
+ * geye_replay_reader_release() before the next one is taken.
+ *
+ * Returns: the records, or NULL on timeout or at the end.
+ */
+const GEyeRecord*
+geye_replay_reader_next(GEyeReplayReader   *reader,
+                        guint              *n_records,
+                        gint64              timeout_us)
+{
+    g_return_val_if_fail(reader->current == NULL, NULL);
+
+    if (!geye_sample_ring_pop_timeout(
+                reader->filled, &reader->current, 1, timeout_us)) {
+        *n_records = 0;
+        return NULL;
+    }
+    *n_records = reader->current->n;
+    return reader->current->records;
+}
+
+/**
+ * geye_replay_reader_release:
+ * @reader: a GEyeReplayReader
+ *
+ * Hands the buffer of geye_replay_reader_next() back to the reader.
+ */
+void
+geye_replay_reader_release(GEyeReplayReader *reader)
+{
+    g_return_if_fail(reader->current != NULL);
+
+    reader->current->n = 0;
+    geye_sample_ring_push(reader->empty, &reader->current);
+    geye_sample_ring_wake(reader->empty);
+    reader->current = NULL;
+}
+
+/**
+ * geye_replay_reader_at_end:
+ * @reader: a GEyeReplayReader
+ *
+ * Returns: TRUE when the player took all records of the file.
+ */
+gboolean
+geye_replay_reader_at_end(GEyeReplayReader *reader)
+{
+    // The reader hands over its last buffer before it is done.
+    gboolean done = g_atomic_int_get(&reader->done);
+    guint n;
+
+    geye_sample_ring_peek(reader->filled, &n);
+    return done && n == 0;
+}
@@ -0,0 +1,65 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GEYE_REPLAY_READER_H
+#define GEYE_REPLAY_READER_H
+
+#include "recording.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Reads a recorded session ahead of its playback. A reader thread parses
+ * the file into large buffers of GEyeRecords and hands the full ones to the
+ * player, which never touches the disk itself, so a slow disk doesn't
+ * disturb the timing of the playback. The reader runs ahead as far as its
+ * buffers allow, then it waits for the player to hand an empty one back.
+ *
+ * Two formats are read: host recordings, see recording.h, and the ASCII
+ * export of an EDF file, as written by edf2asc. The latter is converted to
+ * records with the time in seconds since its first START line and the
+ * tracker time in ms, as the host recording of a GEyeEyelinkEt has them.
+ */
+typedef enum {
+    GEYE_REPLAY_FORMAT_RECORDING,
+    GEYE_REPLAY_FORMAT_ASC
+} GEyeReplayFormat;
+
+typedef struct _GEyeReplayReader GEyeReplayReader;
+
+GEyeReplayReader*   geye_replay_reader_new(const gchar *filename,
+                                           GError     **error);
+gboolean            geye_replay_reader_close(GEyeReplayReader  *reader,
+                                             GError           **error);
+
+GEyeReplayFormat    geye_replay_reader_get_format(GEyeReplayReader *reader);
+const GEyeRecordingHeader*
+                    geye_replay_reader_get_header(GEyeReplayReader *reader);
+
+/* player side */
+const GEyeRecord*   geye_replay_reader_next(GEyeReplayReader  *reader,
+                                            guint             *n_records,
+                                            gint64             timeout_us);
+void                geye_replay_reader_release(GEyeReplayReader *reader);
+gboolean            geye_replay_reader_at_end(GEyeReplayReader *reader);
+
+G_END_DECLS
+
+#endif
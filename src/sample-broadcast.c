@@ -0,0 +1,664 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <gio/gio.h>
+#include <string.h>
+
+#include "sample-broadcast.h"
+
+/*
+ * Every slot is a seqlock. The producer invalidates the sequence number of
+ * a slot, writes the sample and then stores its sequence number, a
+ * subscriber accepts its copy of a sample only if the sequence number was
+ * the same before and after copying. The fences keep the copy between
+ * the sequence numbers.
+ */
+#if defined(__GNUC__)
+#define BROADCAST_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+static gint broadcast_fence;
+#define BROADCAST_FENCE() g_atomic_int_inc(&broadcast_fence)
+#endif
+
+typedef struct {
+    guint               seq;        // Atomic
+    guint               wanted;     // the subscriptions that receive it
+    GEyeBinocularSample sample;
+} BroadcastSlot;
+
+typedef struct {
+    GEyeSubscriber *subscriber;     // Under lock, not referenced
+    guint           decimation;
+    gdouble         interval;       // seconds
+    guint           missed;         // broadcast->missed when subscribed
+
+    /* Producer only, the decimation. */
+    guint           countdown;
+    gdouble         next_time;
+
+    guint           lost;           // Atomic, counted by the producer
+    guint           cursor;         // Atomic, written by the subscriber
+
+    /* Waking the subscriber. */
+    gint            waiters;        // Atomic
+    GMutex          mutex;
+    GCond           cond;
+    GSource        *source;         // Under lock
+    gint            pending;        // Atomic, TRUE while source is scheduled
+} Subscription;
+
+struct _GEyeSampleBroadcast {
+    gint            ref_count;
+    BroadcastSlot  *slots;
+    guint           capacity;
+    guint           mask;
+    guint           head;           // Atomic, written by the producer
+
+    /*
+     * Held by the producer from the first sample of a drain until it is
+     * published, and while subscriptions are added and removed.
+     */
+    GMutex          lock;
+    guint           active;         // Under lock, a bit per subscription
+    guint           missed;         // Atomic, samples pushed without lock
+
+    /* Producer only. */
+    gboolean        locked;
+    guint           wake;           // the subscriptions to wake
+
+    Subscription    subscriptions[GEYE_MAX_SUBSCRIBERS];
+};
+
+struct _GEyeSubscriber {
+    GObject                 parent;
+    GEyeSampleBroadcast    *broadcast;
+    guint                   index;
+};
+
+typedef struct {
+    GSource         source;
+    GEyeSubscriber *subscriber;
+} SubscriberSource;
+
+G_DEFINE_TYPE(GEyeSubscriber, geye_subscriber, G_TYPE_OBJECT)
+
+typedef enum {
+    READY,
+    N_SIGNALS
+} GEyeSubscriberSignal;
+
+static guint subscriber_signals[N_SIGNALS];
+
+/**
+ * geye_sample_broadcast_new:
+ * @capacity: the minimal number of samples in the ring, it is rounded up to
+ *            the next power of two.
+ *
+ * Returns: a new broadcast, release it with geye_sample_broadcast_unref().
+ *          Every subscriber holds a reference too.
+ */
+GEyeSampleBroadcast*
+geye_sample_broadcast_new(guint capacity)
+{
+    GEyeSampleBroadcast *broadcast;
+    guint size = 2, i;
+
+    g_return_val_if_fail(capacity > 0 && capacity <= G_MAXUINT / 4, NULL);
+
+    while (size < capacity)
+        size <<= 1;
+
+    broadcast = g_new0(GEyeSampleBroadcast, 1);
+    broadcast->ref_count = 1;
+    broadcast->slots = g_new0(BroadcastSlot, size);
+    broadcast->capacity = size;
+    broadcast->mask = size - 1;
+    g_mutex_init(&broadcast->lock);
+    for (i = 0; i < GEYE_MAX_SUBSCRIBERS; i++) {
+        g_mutex_init(&broadcast->subscriptions[i].mutex);
+        g_cond_init(&broadcast->subscriptions[i].cond);
+    }
+
+    return broadcast;
+}
+
+GEyeSampleBroadcast*
+geye_sample_broadcast_ref(GEyeSampleBroadcast *broadcast)
+{
+    g_return_val_if_fail(broadcast != NULL, NULL);
+    g_atomic_int_inc(&broadcast->ref_count);
+    return broadcast;
+}
+
+void
+geye_sample_broadcast_unref(GEyeSampleBroadcast *broadcast)
+{
+    guint i;
+
+    if (!broadcast || !g_atomic_int_dec_and_test(&broadcast->ref_count))
+        return;
+
+    for (i = 0; i < GEYE_MAX_SUBSCRIBERS; i++) {
+        g_mutex_clear(&broadcast->subscriptions[i].mutex);
+        g_cond_clear(&broadcast->subscriptions[i].cond);
+    }
+    g_mutex_clear(&broadcast->lock);
+    g_free(broadcast->slots);
+    g_free(broadcast);
+}
+
+/**
+ * geye_sample_broadcast_prefault:
+ * @broadcast: a GEyeSampleBroadcast
+ *
+ * Maps the pages of the ring, call it before the first sample is pushed.
+ */
+void
+geye_sample_broadcast_prefault(GEyeSampleBroadcast *broadcast)
+{
+    g_return_if_fail(broadcast != NULL);
+
+    g_mutex_lock(&broadcast->lock);
+    if (g_atomic_int_get(&broadcast->head) == 0)
+        memset(broadcast->slots,
+               0,
+               broadcast->capacity * sizeof(BroadcastSlot));
+    g_mutex_unlock(&broadcast->lock);
+}
+
+/**
+ * geye_sample_broadcast_subscribe:
+ * @broadcast: a GEyeSampleBroadcast
+ * @decimation: receive every @decimation-th sample, 1 receives all samples.
+ * @interval: the minimal time in seconds between the samples received,
+ *            e.g. 1/60.0 for a display of 60 Hz, 0 doesn't limit the rate.
+ * @error: returns why the subscription failed
+ *
+ * Subscribes to the samples that are pushed from now on. The subscription
+ * ends when the subscriber is finalized.
+ *
+ * Returns:(transfer full): a new subscriber, or NULL when there are
+ *         GEYE_MAX_SUBSCRIBERS already.
+ */
+GEyeSubscriber*
+geye_sample_broadcast_subscribe(GEyeSampleBroadcast    *broadcast,
+                                guint                   decimation,
+                                gdouble                 interval,
+                                GError                **error)
+{
+    GEyeSubscriber *subscriber;
+    Subscription *subscription;
+    guint i;
+
+    g_return_val_if_fail(broadcast != NULL, NULL);
+    g_return_val_if_fail(decimation > 0, NULL);
+    g_return_val_if_fail(interval >= 0, NULL);
+    g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+    // Don't allocate while the producer is locked out.
+    subscriber = g_object_new(GEYE_TYPE_SUBSCRIBER, NULL);
+
+    g_mutex_lock(&broadcast->lock);
+
+    for (i = 0; i < GEYE_MAX_SUBSCRIBERS; i++)
+        if (!(broadcast->active & (1u << i)))
+            break;
+    if (i == GEYE_MAX_SUBSCRIBERS) {
+        g_mutex_unlock(&broadcast->lock);
+        g_object_unref(subscriber);
+        g_set_error(error,
+                    G_IO_ERROR,
+                    G_IO_ERROR_NO_SPACE,
+                    "An eyetracker serves at most %d subscribers",
+                    GEYE_MAX_SUBSCRIBERS);
+        return NULL;
+    }
+
+    subscriber->broadcast = geye_sample_broadcast_ref(broadcast);
+    subscriber->index = i;
+
+    // The producer doesn't push while we hold the lock.
+    subscription = &broadcast->subscriptions[i];
+    subscription->subscriber = subscriber;
+    subscription->decimation = decimation;
+    subscription->interval = interval;
+    subscription->missed = g_atomic_int_get(&broadcast->missed);
+    subscription->countdown = 0;
+    subscription->next_time = -G_MAXDOUBLE;
+    g_atomic_int_set(&subscription->lost, 0);
+    g_atomic_int_set(&subscription->cursor, broadcast->head);
+    g_atomic_int_set(&broadcast->active, broadcast->active | (1u << i));
+
+    g_mutex_unlock(&broadcast->lock);
+
+    return subscriber;
+}
+
+/* Applies the decimation of a subscription, producer only. */
+static gboolean
+subscription_wants(Subscription *subscription, const GEyeBinocularSample *sample)
+{
+    gdouble time = sample->parent.time;
+
+    if (subscription->countdown > 0) {
+        subscription->countdown--;
+        return FALSE;
+    }
+    if (subscription->interval > 0) {
+        if (time < subscription->next_time)
+            return FALSE;
+        // Keep to the grid of the interval, unless we are behind.
+        subscription->next_time += subscription->interval;
+        if (subscription->next_time <= time)
+            subscription->next_time = time + subscription->interval;
+    }
+    subscription->countdown = subscription->decimation - 1;
+    return TRUE;
+}
+
+/* Counts the subscribers that didn't read the sample that is overwritten. */
+static void
+count_lost(GEyeSampleBroadcast *broadcast, const BroadcastSlot *slot)
+{
+    guint wanted = slot->wanted & broadcast->active;
+    guint i;
+
+    for (i = 0; wanted; i++, wanted >>= 1) {
+        Subscription *subscription = &broadcast->subscriptions[i];
+        if (!(wanted & 1))
+            continue;
+        if ((gint) (slot->seq - g_atomic_int_get(&subscription->cursor)) >= 0)
+            g_atomic_int_inc(&subscription->lost);
+    }
+}
+
+/**
+ * geye_sample_broadcast_push:
+ * @broadcast: a GEyeSampleBroadcast
+ * @sample: the sample to broadcast
+ *
+ * Must only be called from the producer thread, it doesn't allocate and
+ * doesn't wait for a lock. The subscribers are not woken, call
+ * geye_sample_broadcast_publish() once a batch of samples has been pushed.
+ * While a subscription is added or removed, the samples are not broadcast,
+ * they count as lost for every subscriber.
+ */
+void
+geye_sample_broadcast_push(GEyeSampleBroadcast         *broadcast,
+                           const GEyeBinocularSample   *sample)
+{
+    BroadcastSlot *slot;
+    guint active, wanted = 0, head, i;
+
+    if (!g_atomic_int_get(&broadcast->active))
+        return;
+    if (!broadcast->locked) {
+        broadcast->locked = g_mutex_trylock(&broadcast->lock);
+        if (!broadcast->locked) {
+            g_atomic_int_inc(&broadcast->missed);
+            return;
+        }
+    }
+
+    active = broadcast->active;
+    for (i = 0; active; i++, active >>= 1)
+        if (active & 1 &&
+                subscription_wants(&broadcast->subscriptions[i], sample))
+            wanted |= 1u << i;
+    if (!wanted)
+        return;
+
+    head = broadcast->head;
+    slot = &broadcast->slots[head & broadcast->mask];
+    if (slot->wanted)
+        count_lost(broadcast, slot);
+
+    g_atomic_int_set(&slot->seq, head - 1);
+    BROADCAST_FENCE();
+    slot->wanted = wanted;
+    slot->sample = *sample;
+    BROADCAST_FENCE();
+    g_atomic_int_set(&slot->seq, head);
+    g_atomic_int_set(&broadcast->head, head + 1);
+
+    broadcast->wake |= wanted;
+}
+
+static void
+subscription_wake(Subscription *subscription)
+{
+    if (g_atomic_int_get(&subscription->waiters) > 0) {
+        g_mutex_lock(&subscription->mutex);
+        g_cond_broadcast(&subscription->cond);
+        g_mutex_unlock(&subscription->mutex);
+    }
+    // g_source_set_ready_time() takes the lock of the main context, only
+    // do so when the source isn't scheduled already.
+    if (subscription->source && g_atomic_int_compare_and_exchange(
+                &subscription->pending, FALSE, TRUE))
+        g_source_set_ready_time(subscription->source, 0);
+}
+
+/**
+ * geye_sample_broadcast_publish:
+ * @broadcast: a GEyeSampleBroadcast
+ *
+ * Wakes the subscribers that received samples since the last call.
+ */
+void
+geye_sample_broadcast_publish(GEyeSampleBroadcast *broadcast)
+{
+    guint wake = broadcast->wake;
+    guint i;
+
+    if (!broadcast->locked)
+        return;
+
+    for (i = 0; wake; i++, wake >>= 1)
+        if (wake & 1)
+            subscription_wake(&broadcast->subscriptions[i]);
+
+    broadcast->wake = 0;
+    broadcast->locked = FALSE;
+    g_mutex_unlock(&broadcast->lock);
+}
+
+static inline Subscription*
+subscriber_subscription(GEyeSubscriber *self)
+{
+    return &self->broadcast->subscriptions[self->index];
+}
+
+/* Copies the samples for this subscriber, without waiting. */
+static guint
+subscriber_collect(GEyeSubscriber      *self,
+                   GEyeBinocularSample *samples,
+                   guint                max_samples)
+{
+    GEyeSampleBroadcast *broadcast = self->broadcast;
+    Subscription *subscription = subscriber_subscription(self);
+    guint bit = 1u << self->index;
+    guint cursor = subscription->cursor;
+    guint head = g_atomic_int_get(&broadcast->head);
+    guint n = 0;
+
+    while (n < max_samples && cursor != head) {
+        const BroadcastSlot *slot;
+        GEyeBinocularSample sample;
+        guint wanted;
+
+        // Skip what was overwritten, the producer counted it as lost.
+        if (head - cursor > broadcast->capacity)
+            cursor = head - broadcast->capacity;
+
+        slot = &broadcast->slots[cursor & broadcast->mask];
+        if ((guint) g_atomic_int_get(&slot->seq) != cursor) {
+            cursor++;
+            continue;
+        }
+        BROADCAST_FENCE();
+        wanted = slot->wanted;
+        sample = slot->sample;
+        BROADCAST_FENCE();
+        if ((guint) g_atomic_int_get(&slot->seq) != cursor) {
+            cursor++;
+            continue;
+        }
+
+        cursor++;
+        if (wanted & bit)
+            samples[n++] = sample;
+    }
+
+    g_atomic_int_set(&subscription->cursor, cursor);
+    return n;
+}
+
+static void
+geye_subscriber_init(GEyeSubscriber *self)
+{
+    (void) self;
+}
+
+static void
+subscriber_finalize(GObject *gobject)
+{
+    GEyeSubscriber *self = GEYE_SUBSCRIBER(gobject);
+    GEyeSampleBroadcast *broadcast = self->broadcast;
+    Subscription *subscription;
+    GSource *source;
+
+    // It didn't get a subscription.
+    if (!broadcast) {
+        G_OBJECT_CLASS(geye_subscriber_parent_class)->finalize(gobject);
+        return;
+    }
+
+    subscription = subscriber_subscription(self);
+    g_mutex_lock(&broadcast->lock);
+    g_atomic_int_set(
+            &broadcast->active, broadcast->active & ~(1u << self->index)
+            );
+    subscription->subscriber = NULL;
+    source = subscription->source;
+    subscription->source = NULL;
+    g_mutex_unlock(&broadcast->lock);
+
+    if (source) {
+        g_source_destroy(source);
+        g_source_unref(source);
+    }
+    geye_sample_broadcast_unref(broadcast);
+
+    G_OBJECT_CLASS(geye_subscriber_parent_class)->finalize(gobject);
+}
+
+static void
+geye_subscriber_class_init(GEyeSubscriberClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    object_class->finalize = subscriber_finalize;
+
+    /**
+     * GEyeSubscriber::ready:
+     * @subscriber: the subscriber that received samples
+     *
+     * Samples arrived, read them with geye_subscriber_read(). It is emitted
+     * in the main context that was given to geye_subscriber_attach(), at
+     * most once for every batch of samples from the eyetracker.
+     */
+    subscriber_signals[READY] = g_signal_new(
+            "ready",
+            GEYE_TYPE_SUBSCRIBER,
+            G_SIGNAL_RUN_FIRST,
+            0,
+            NULL, NULL,
+            NULL,
+            G_TYPE_NONE,
+            0
+            );
+}
+
+/**
+ * geye_subscriber_read:
+ * @subscriber: a GEyeSubscriber
+ * @samples:(out caller-allocates)(array length=max_samples): receives the
+ *          samples
+ * @max_samples: the number of samples that fit in @samples
+ * @timeout_us: the maximum number of microseconds to wait for samples, 0
+ *              doesn't wait and a negative value waits until samples
+ *              arrive.
+ *
+ * Reads the samples that arrived since the previous read, oldest first.
+ * Only one thread at a time should read from a subscriber, other
+ * subscribers are not affected by it.
+ *
+ * Returns: the number of samples written to @samples, 0 on timeout.
+ */
+guint
+geye_subscriber_read(GEyeSubscriber        *subscriber,
+                     GEyeBinocularSample   *samples,
+                     guint                  max_samples,
+                     gint64                 timeout_us)
+{
+    Subscription *subscription;
+    gint64 end_time;
+    guint n;
+
+    g_return_val_if_fail(GEYE_IS_SUBSCRIBER(subscriber), 0);
+    g_return_val_if_fail(samples != NULL || max_samples == 0, 0);
+
+    n = subscriber_collect(subscriber, samples, max_samples);
+    if (n > 0 || timeout_us == 0 || max_samples == 0)
+        return n;
+
+    subscription = subscriber_subscription(subscriber);
+    end_time = g_get_monotonic_time() + timeout_us;
+
+    g_mutex_lock(&subscription->mutex);
+    g_atomic_int_inc(&subscription->waiters);
+    // The producer publishes the head before it looks at the waiters, so
+    // either we see the samples here, or the producer sees us waiting.
+    while ((n = subscriber_collect(subscriber, samples, max_samples)) == 0) {
+        if (timeout_us < 0)
+            g_cond_wait(&subscription->cond, &subscription->mutex);
+        else if (!g_cond_wait_until(
+                    &subscription->cond, &subscription->mutex, end_time))
+            break;
+    }
+    g_atomic_int_add(&subscription->waiters, -1);
+    g_mutex_unlock(&subscription->mutex);
+
+    return n;
+}
+
+/**
+ * geye_subscriber_get_lost:
+ * @subscriber: a GEyeSubscriber
+ *
+ * Returns: the number of samples for this subscriber that were overwritten
+ *          before it read them. It may be read from any thread.
+ */
+guint
+geye_subscriber_get_lost(GEyeSubscriber *subscriber)
+{
+    Subscription *subscription;
+
+    g_return_val_if_fail(GEYE_IS_SUBSCRIBER(subscriber), 0);
+
+    subscription = subscriber_subscription(subscriber);
+    return g_atomic_int_get(&subscription->lost) +
+           (g_atomic_int_get(&subscriber->broadcast->missed) -
+            subscription->missed);
+}
+
+/**
+ * geye_subscriber_get_decimation:
+ * @subscriber: a GEyeSubscriber
+ *
+ * Returns: every how many samples the subscriber receives one.
+ */
+guint
+geye_subscriber_get_decimation(GEyeSubscriber *subscriber)
+{
+    g_return_val_if_fail(GEYE_IS_SUBSCRIBER(subscriber), 0);
+    return subscriber_subscription(subscriber)->decimation;
+}
+
+/**
+ * geye_subscriber_get_interval:
+ * @subscriber: a GEyeSubscriber
+ *
+ * Returns: the minimal time in seconds between the samples it receives.
+ */
+gdouble
+geye_subscriber_get_interval(GEyeSubscriber *subscriber)
+{
+    g_return_val_if_fail(GEYE_IS_SUBSCRIBER(subscriber), 0);
+    return subscriber_subscription(subscriber)->interval;
+}
+
+static gboolean
+subscriber_source_dispatch(GSource       *source,
+                           GSourceFunc    callback,
+                           gpointer       data)
+{
+    (void) callback;
+    (void) data;
+    GEyeSubscriber *subscriber = ((SubscriberSource*) source)->subscriber;
+    Subscription *subscription = subscriber_subscription(subscriber);
+
+    // Unschedule first, samples that are published from now on schedule
+    // the source again.
+    g_source_set_ready_time(source, -1);
+    g_atomic_int_set(&subscription->pending, FALSE);
+
+    g_object_ref(subscriber);
+    g_signal_emit(subscriber, subscriber_signals[READY], 0);
+    g_object_unref(subscriber);
+
+    return G_SOURCE_CONTINUE;
+}
+
+static GSourceFuncs subscriber_source_funcs = {
+    .dispatch = subscriber_source_dispatch,
+};
+
+/**
+ * geye_subscriber_attach:
+ * @subscriber: a GEyeSubscriber
+ * @context:(nullable): the main context in which #GEyeSubscriber::ready is
+ *          emitted, NULL for the default one.
+ *
+ * Lets the subscriber emit #GEyeSubscriber::ready when it receives
+ * samples, instead of blocking in geye_subscriber_read(). Only the
+ * subscribers that received samples are woken, so a subscriber with a
+ * decimation wakes its main context at its own rate. Drop the last
+ * reference in @context.
+ */
+void
+geye_subscriber_attach(GEyeSubscriber *subscriber, GMainContext *context)
+{
+    GEyeSampleBroadcast *broadcast;
+    Subscription *subscription;
+    GSource *source, *old;
+
+    g_return_if_fail(GEYE_IS_SUBSCRIBER(subscriber));
+
+    broadcast = subscriber->broadcast;
+    subscription = subscriber_subscription(subscriber);
+
+    source = g_source_new(&subscriber_source_funcs, sizeof(SubscriberSource));
+    ((SubscriberSource*) source)->subscriber = subscriber;
+    g_source_set_name(source, "GEyeSubscriber");
+    g_source_set_priority(source, G_PRIORITY_DEFAULT);
+    g_source_attach(source, context);
+
+    g_mutex_lock(&broadcast->lock);
+    old = subscription->source;
+    subscription->source = source;
+    g_atomic_int_set(&subscription->pending, FALSE);
+    g_mutex_unlock(&broadcast->lock);
+
+    if (old) {
+        g_source_destroy(old);
+        g_source_unref(old);
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GEYE_SAMPLE_BROADCAST_H
+#define GEYE_SAMPLE_BROADCAST_H
+
+#include "subscriber.h"
+
+G_BEGIN_DECLS
+
+/*
+ * A single-producer/multi-consumer ring of binocular samples. Every
+ * subscriber reads it with a cursor of its own, at its own pace, so a slow
+ * subscriber only loses its own samples. The producer never waits for the
+ * subscribers and doesn't allocate.
+ *
+ * The producer applies the decimation, it marks every sample with the
+ * subscribers that receive it, and counts the samples of a subscriber that
+ * it overwrites before they were read. Samples that no subscriber receives
+ * don't take a slot.
+ */
+typedef struct _GEyeSampleBroadcast GEyeSampleBroadcast;
+
+GEyeSampleBroadcast*    geye_sample_broadcast_new(guint capacity);
+GEyeSampleBroadcast*    geye_sample_broadcast_ref(
+                                GEyeSampleBroadcast *broadcast
+                                );
+void                    geye_sample_broadcast_unref(
+                                GEyeSampleBroadcast *broadcast
+                                );
+void                    geye_sample_broadcast_prefault(
+                                GEyeSampleBroadcast *broadcast
+                                );
+
+GEyeSubscriber*         geye_sample_broadcast_subscribe(
+                                GEyeSampleBroadcast    *broadcast,
+                                guint                   decimation,
+                                gdouble                 interval,
+                                GError                **error
+                                );
+
+/* producer side */
+void                    geye_sample_broadcast_push(
+                                GEyeSampleBroadcast        *broadcast,
+                                const GEyeBinocularSample  *sample
+                                );
+void                    geye_sample_broadcast_publish(
+                                GEyeSampleBroadcast *broadcast
+                                );
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,759 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "sample-dispatch.h"
+#include "aoi-set-private.h"
+#include "sample-ring.h"
+#include <string.h>
+
+static guint DISPATCH_BATCH_SIZE = 64; // reserved samples for "samples"
+// The records the main context takes out of the ring at once.
+#define DISPATCH_CHUNK_SIZE 64
+
+typedef enum {
+    DISPATCH_SAMPLE,        // emit "sample"
+    DISPATCH_BATCH_SAMPLE,  // add to the batch for "samples"
+    DISPATCH_BATCH_END,     // emit "samples" with the batch
+    DISPATCH_BINOCULAR,     // emit "binocular-sample"
+    DISPATCH_EXTENDED,      // emit "extended-sample"
+    DISPATCH_FIXATION,      // emit "fixation"
+    DISPATCH_SACCADE,       // emit "saccade"
+    DISPATCH_AOI_ENTER,     // emit "aoi-enter" on the set
+    DISPATCH_AOI_LEAVE,     // emit "aoi-leave" on the set
+    DISPATCH_UNREF          // drop a reference of the producer
+} DispatchType;
+
+typedef struct {
+    GEyeAoiSet *set;    // Kept alive by the producer until DISPATCH_UNREF.
+    guint       aoi;
+    gdouble     time;
+    gdouble     dwell;
+} DispatchAoi;
+
+typedef struct {
+    DispatchType type;
+    gint64       sampled;   // host time at which the sample was taken
+    gint64       queued;    // host time at which it was queued, 0 if unknown
+    union DispatchContent {
+        GEyeSample          sample;
+        GEyeBinocularSample binocular;
+        GEyeFixation        fixation;
+        GEyeSaccade         saccade;
+        DispatchAoi         aoi;
+        gpointer            object;
+        guint               slot;       // into extended
+    } content;
+} DispatchRecord;
+
+typedef struct {
+    GSource             source;
+    GEyeSampleDispatch *dispatch;
+} DispatchSource;
+
+struct _GEyeSampleDispatch {
+    GEyeEyetracker *et;         // Not referenced, the eyetracker owns us.
+    GMainContext   *context;
+    GSource        *source;
+    GEyeSampleRing *ring;
+
+    gint            pending;    // TRUE while the source is scheduled.
+    gint            policy;     // Atomic, GEyeDropPolicy
+    guint           dropped;    // Atomic, records dropped or coalesced
+    guint           dispatched; // Atomic, stamped samples emitted
+
+    /*
+     * The main context copies records out of the ring under this lock, so
+     * the producer may discard the oldest record when the ring is full.
+     * The producer only tries the lock, it never waits for the main context.
+     */
+    GMutex          lock;
+
+    guint           unflushed;  // Producer only.
+    gboolean        in_batch;   // Producer only.
+
+    /* The times for the next sample record, producer only */
+    gint64          stamp_sampled;
+    gint64          stamp_queued;
+
+    /*
+     * The extended samples don't fit in a record without making every
+     * record larger, so they have slots of their own, allocated when the
+     * first one is pushed. There is one slot more than the ring holds
+     * records, hence the slot of the next sample is never in use.
+     */
+    GEyeExtendedSample *extended;
+    guint               n_extended;
+    guint               next_extended;  // Producer only.
+
+    GArray         *batch;      // Main context only.
+
+    /* Main context only */
+    DispatchRecord     *chunk;          // copied out of the ring
+    GEyeExtendedSample *chunk_extended; // the slots of the extended records
+    guint               reported;       // dropped at the last emission
+    guint               emitted;        // stamped records, not yet counted
+    GEyeLatencyHistogram *queue_latency;
+    GEyeLatencyHistogram *total_latency;
+
+    /* Samples that are coalesced into the newest one, main context only */
+    guint               waiting;        // flags of the waiting samples
+    guint               waiting_stamped;// of those, the stamped ones
+    GEyeSample          waiting_sample[4];  // by GEyeEye
+    GEyeBinocularSample waiting_binocular;
+    GEyeExtendedSample  waiting_extended;
+};
+
+enum {
+    WAITING_BINOCULAR   = 1 << 4,
+    WAITING_EXTENDED    = 1 << 5
+};
+
+static void
+emit_record(GEyeSampleDispatch         *dispatch,
+            const DispatchRecord       *record,
+            GEyeExtendedSample         *extended)
+{
+    switch (record->type) {
+        case DISPATCH_SAMPLE:
+            g_signal_emit_by_name(
+                    dispatch->et, "sample", &record->content.sample
+                    );
+            break;
+        case DISPATCH_BATCH_SAMPLE:
+            g_array_append_val(dispatch->batch, record->content.sample);
+            break;
+        case DISPATCH_BATCH_END:
+            if (dispatch->batch->len > 0)
+                g_signal_emit_by_name(dispatch->et, "samples", dispatch->batch);
+            g_array_set_size(dispatch->batch, 0);
+            break;
+        case DISPATCH_BINOCULAR:
+            g_signal_emit_by_name(
+                    dispatch->et,
+                    "binocular-sample",
+                    &record->content.binocular
+                    );
+            break;
+        case DISPATCH_EXTENDED:
+            g_signal_emit_by_name(dispatch->et, "extended-sample", extended);
+            break;
+        case DISPATCH_FIXATION:
+            g_signal_emit_by_name(
+                    dispatch->et, "fixation", &record->content.fixation
+                    );
+            break;
+        case DISPATCH_SACCADE:
+            g_signal_emit_by_name(
+                    dispatch->et, "saccade", &record->content.saccade
+                    );
+            break;
+        case DISPATCH_AOI_ENTER:
+            geye_aoi_set_emit_enter(
+                    record->content.aoi.set,
+                    record->content.aoi.aoi,
+                    record->content.aoi.time
+                    );
+            break;
+        case DISPATCH_AOI_LEAVE:
+            geye_aoi_set_emit_leave(
+                    record->content.aoi.set,
+                    record->content.aoi.aoi,
+                    record->content.aoi.time,
+                    record->content.aoi.dwell
+                    );
+            break;
+        case DISPATCH_UNREF:
+            g_object_unref(record->content.object);
+            break;
+        default:
+            g_assert_not_reached();
+    }
+}
+
+static void
+emit_waiting(GEyeSampleDispatch *dispatch)
+{
+    guint waiting = dispatch->waiting;
+    guint stamped = waiting & dispatch->waiting_stamped;
+    guint eye;
+
+    dispatch->waiting = dispatch->waiting_stamped = 0;
+    for (; stamped; stamped &= stamped - 1)
+        dispatch->emitted++;
+    for (eye = 0; eye < G_N_ELEMENTS(dispatch->waiting_sample); eye++)
+        if (waiting & (1u << eye))
+            g_signal_emit_by_name(
+                    dispatch->et, "sample", &dispatch->waiting_sample[eye]
+                    );
+    if (waiting & WAITING_BINOCULAR)
+        g_signal_emit_by_name(
+                dispatch->et, "binocular-sample", &dispatch->waiting_binocular
+                );
+    if (waiting & WAITING_EXTENDED)
+        g_signal_emit_by_name(
+                dispatch->et, "extended-sample", &dispatch->waiting_extended
+                );
+}
+
+/*
+ * Keeps the newest of consecutive samples, any other record emits the
+ * samples that are waiting first, so the order of samples and events
+ * is kept.
+ *
+ * Returns: TRUE if the record is waiting, FALSE if it should be emitted.
+ */
+static gboolean
+coalesce_record(GEyeSampleDispatch         *dispatch,
+                const DispatchRecord       *record,
+                const GEyeExtendedSample   *extended)
+{
+    guint flag;
+
+    switch (record->type) {
+        case DISPATCH_SAMPLE:
+            flag = 1u << (record->content.sample.parent.eye & 3);
+            dispatch->waiting_sample[record->content.sample.parent.eye & 3] =
+                record->content.sample;
+            break;
+        case DISPATCH_BINOCULAR:
+            flag = WAITING_BINOCULAR;
+            dispatch->waiting_binocular = record->content.binocular;
+            break;
+        case DISPATCH_EXTENDED:
+            flag = WAITING_EXTENDED;
+            dispatch->waiting_extended = *extended;
+            break;
+        case DISPATCH_BATCH_SAMPLE:
+            // The batch is emitted as a whole anyway.
+            return FALSE;
+        default:
+            if (dispatch->waiting)
+                emit_waiting(dispatch);
+            return FALSE;
+    }
+
+    if (dispatch->waiting & flag)
+        g_atomic_int_inc(&dispatch->dropped);
+    dispatch->waiting |= flag;
+    if (record->queued)
+        dispatch->waiting_stamped |= flag;
+    else
+        dispatch->waiting_stamped &= ~flag;
+    return TRUE;
+}
+
+/*
+ * Copies the oldest records out of the ring, the extended samples they
+ * refer to included, since the producer may reuse a slot as soon as its
+ * record has left the ring.
+ */
+static guint
+take_records(GEyeSampleDispatch *dispatch)
+{
+    DispatchRecord *records;
+    guint n, i;
+
+    g_mutex_lock(&dispatch->lock);
+    records = geye_sample_ring_peek(dispatch->ring, &n);
+    n = MIN(n, DISPATCH_CHUNK_SIZE);
+    memcpy(dispatch->chunk, records, n * sizeof(DispatchRecord));
+    for (i = 0; i < n; i++)
+        if (records[i].type == DISPATCH_EXTENDED)
+            dispatch->chunk_extended[i] =
+                dispatch->extended[records[i].content.slot];
+    geye_sample_ring_release(dispatch->ring, n);
+    g_mutex_unlock(&dispatch->lock);
+
+    return n;
+}
+
+static void
+measure_latency(GEyeSampleDispatch *dispatch, const DispatchRecord *record)
+{
+    gint64 now = g_get_monotonic_time();
+
+    geye_latency_histogram_record(
+            dispatch->queue_latency, now - record->queued
+            );
+    if (record->sampled)
+        geye_latency_histogram_record(
+                dispatch->total_latency, now - record->sampled
+                );
+}
+
+static void
+dispatch_records(GEyeSampleDispatch *dispatch)
+{
+    gboolean coalesce;
+    guint n, i;
+
+    coalesce = g_atomic_int_get(&dispatch->policy) == GEYE_DROP_COALESCE;
+
+    while ((n = take_records(dispatch)) > 0) {
+        for (i = 0; i < n; i++) {
+            DispatchRecord *record = &dispatch->chunk[i];
+            GEyeExtendedSample *extended = &dispatch->chunk_extended[i];
+
+            if (record->queued && dispatch->queue_latency)
+                measure_latency(dispatch, record);
+            if (coalesce && coalesce_record(dispatch, record, extended))
+                continue;
+            if (record->queued)
+                dispatch->emitted++;
+            emit_record(dispatch, record, extended);
+        }
+    }
+    if (dispatch->waiting)
+        emit_waiting(dispatch);
+    // A coalesced sample that is superseded is dropped, not dispatched.
+    if (dispatch->emitted) {
+        g_atomic_int_add(&dispatch->dispatched, dispatch->emitted);
+        dispatch->emitted = 0;
+    }
+}
+
+static void
+report_dropped(GEyeSampleDispatch *dispatch)
+{
+    guint dropped = g_atomic_int_get(&dispatch->dropped);
+    guint n_dropped = dropped - dispatch->reported;
+
+    if (n_dropped == 0)
+        return;
+    dispatch->reported = dropped;
+    g_signal_emit_by_name(dispatch->et, "samples-dropped", n_dropped);
+}
+
+static gboolean
+dispatch_source_dispatch(GSource *source, GSourceFunc callback, gpointer data)
+{
+    (void) callback;
+    (void) data;
+    GEyeSampleDispatch *dispatch = ((DispatchSource*) source)->dispatch;
+    GEyeEyetracker *et = dispatch->et;
+
+    g_assert(g_main_context_is_owner(dispatch->context));
+
+    // Unschedule before looking at the ring, samples that are pushed from
+    // now on schedule the source again.
+    g_source_set_ready_time(source, -1);
+    g_atomic_int_set(&dispatch->pending, FALSE);
+
+    // A handler might drop the last reference on the eyetracker, which
+    // frees the dispatch, so keep it alive until we are done.
+    g_object_ref(et);
+    dispatch_records(dispatch);
+    report_dropped(dispatch);
+    g_object_unref(et);
+
+    return G_SOURCE_CONTINUE;
+}
+
+static GSourceFuncs dispatch_source_funcs = {
+    .dispatch = dispatch_source_dispatch,
+};
+
+/**
+ * geye_sample_dispatch_new:
+ * @et: the eyetracker on which the signals are emitted
+ * @context: the main context in which the signals are emitted
+ * @capacity: how many records may be waiting for the main context
+ *
+ * Returns: a new GEyeSampleDispatch, free it with geye_sample_dispatch_free()
+ */
+GEyeSampleDispatch*
+geye_sample_dispatch_new(GEyeEyetracker    *et,
+                         GMainContext      *context,
+                         guint              capacity)
+{
+    GEyeSampleDispatch *dispatch;
+
+    g_return_val_if_fail(GEYE_IS_EYETRACKER(et), NULL);
+    g_return_val_if_fail(context != NULL, NULL);
+
+    dispatch = g_new0(GEyeSampleDispatch, 1);
+    dispatch->et = et;
+    dispatch->context = g_main_context_ref(context);
+    dispatch->ring = geye_sample_ring_new(capacity, sizeof(DispatchRecord));
+    dispatch->batch = g_array_sized_new(
+            FALSE, FALSE, sizeof(GEyeSample), DISPATCH_BATCH_SIZE
+            );
+    dispatch->chunk = g_new(DispatchRecord, DISPATCH_CHUNK_SIZE);
+    dispatch->chunk_extended = g_new(GEyeExtendedSample, DISPATCH_CHUNK_SIZE);
+    dispatch->policy = GEYE_DROP_NEWEST;
+    g_mutex_init(&dispatch->lock);
+
+    dispatch->source = g_source_new(
+            &dispatch_source_funcs, sizeof(DispatchSource)
+            );
+    ((DispatchSource*) dispatch->source)->dispatch = dispatch;
+    g_source_set_name(dispatch->source, "GEyeSampleDispatch");
+    g_source_set_priority(dispatch->source, G_PRIORITY_DEFAULT);
+    g_source_attach(dispatch->source, context);
+
+    return dispatch;
+}
+
+/**
+ * geye_sample_dispatch_free:
+ * @dispatch: a GEyeSampleDispatch
+ *
+ * Frees the dispatch, the producer must not use it anymore. Samples that
+ * were not yet emitted are discarded, references that were passed to
+ * geye_sample_dispatch_unref() are dropped.
+ */
+void
+geye_sample_dispatch_free(GEyeSampleDispatch *dispatch)
+{
+    DispatchRecord *records;
+    guint n, i;
+
+    if (!dispatch)
+        return;
+
+    // The references that were handed to us must still be dropped.
+    while ((records = geye_sample_ring_peek(dispatch->ring, &n)), n > 0) {
+        for (i = 0; i < n; i++)
+            if (records[i].type == DISPATCH_UNREF)
+                g_object_unref(records[i].content.object);
+        geye_sample_ring_release(dispatch->ring, n);
+    }
+
+    g_source_destroy(dispatch->source);
+    g_source_unref(dispatch->source);
+    geye_sample_ring_free(dispatch->ring);
+    g_free(dispatch->extended);
+    g_free(dispatch->chunk);
+    g_free(dispatch->chunk_extended);
+    g_mutex_clear(&dispatch->lock);
+    g_array_unref(dispatch->batch);
+    g_main_context_unref(dispatch->context);
+    g_free(dispatch);
+}
+
+/**
+ * geye_sample_dispatch_prefault:
+ * @dispatch: a GEyeSampleDispatch
+ *
+ * Maps the pages of the buffer of the dispatch, call it before the first
+ * sample is pushed.
+ */
+void
+geye_sample_dispatch_prefault(GEyeSampleDispatch *dispatch)
+{
+    g_return_if_fail(dispatch != NULL);
+    geye_sample_ring_prefault(dispatch->ring);
+}
+
+/**
+ * geye_sample_dispatch_set_policy:
+ * @dispatch: a GEyeSampleDispatch
+ * @policy: what to drop when the main context doesn't keep up
+ *
+ * May be called from any thread, the producer and the main context pick up
+ * the new policy with the next record.
+ */
+void
+geye_sample_dispatch_set_policy(GEyeSampleDispatch *dispatch,
+                                GEyeDropPolicy      policy)
+{
+    g_return_if_fail(dispatch != NULL);
+    g_atomic_int_set(&dispatch->policy, policy);
+}
+
+GEyeDropPolicy
+geye_sample_dispatch_get_policy(GEyeSampleDispatch *dispatch)
+{
+    g_return_val_if_fail(dispatch != NULL, GEYE_DROP_NEWEST);
+    return g_atomic_int_get(&dispatch->policy);
+}
+
+/**
+ * geye_sample_dispatch_get_dropped:
+ * @dispatch: a GEyeSampleDispatch
+ *
+ * Returns: The number of records that were dropped or coalesced, because the
+ *          main context didn't keep up with the eyetracker. It may be read
+ *          from any thread.
+ */
+guint
+geye_sample_dispatch_get_dropped(GEyeSampleDispatch *dispatch)
+{
+    g_return_val_if_fail(dispatch != NULL, 0);
+    return g_atomic_int_get(&dispatch->dropped);
+}
+
+/**
+ * geye_sample_dispatch_get_dispatched:
+ * @dispatch: a GEyeSampleDispatch
+ *
+ * Returns: The number of samples stamped with geye_sample_dispatch_stamp()
+ *          that the main context emitted. It may be read from any thread.
+ */
+guint
+geye_sample_dispatch_get_dispatched(GEyeSampleDispatch *dispatch)
+{
+    g_return_val_if_fail(dispatch != NULL, 0);
+    return g_atomic_int_get(&dispatch->dispatched);
+}
+
+/*
+ * Discards the oldest record to make room for a new one. When the main
+ * context is taking records out right now, it will make room soon enough,
+ * so the producer doesn't wait for it.
+ */
+static gboolean
+drop_oldest(GEyeSampleDispatch *dispatch)
+{
+    DispatchRecord *oldest;
+    gboolean dropped = FALSE;
+    guint n;
+
+    if (!g_mutex_trylock(&dispatch->lock))
+        return FALSE;
+    oldest = geye_sample_ring_peek(dispatch->ring, &n);
+    // A reference must be dropped in the main context, never discard it.
+    if (n > 0 && oldest->type != DISPATCH_UNREF) {
+        geye_sample_ring_release(dispatch->ring, 1);
+        dropped = TRUE;
+    }
+    g_mutex_unlock(&dispatch->lock);
+
+    return dropped;
+}
+
+/**
+ * geye_sample_dispatch_set_latency:
+ * @dispatch: a GEyeSampleDispatch
+ * @queue: the histogram of the time the samples wait for the main context
+ * @total: the histogram of the time from taking a sample until it is emitted
+ *
+ * Measures the latencies of the samples that were stamped with
+ * geye_sample_dispatch_stamp(). The histograms are recorded in the main
+ * context and must outlive the dispatch. Set them before the first sample
+ * is pushed.
+ */
+void
+geye_sample_dispatch_set_latency(GEyeSampleDispatch     *dispatch,
+                                 GEyeLatencyHistogram   *queue,
+                                 GEyeLatencyHistogram   *total)
+{
+    g_return_if_fail(dispatch != NULL);
+    g_return_if_fail(queue != NULL && total != NULL);
+
+    dispatch->queue_latency = queue;
+    dispatch->total_latency = total;
+}
+
+/**
+ * geye_sample_dispatch_stamp:
+ * @dispatch: a GEyeSampleDispatch
+ * @sampled: the host time at which the eyetracker took the sample, 0 if
+ *           it isn't known
+ * @queued: the host time from which the sample waits for the main context,
+ *          the time at which its batch was received will do
+ *
+ * Stamps the first sample record that is pushed after this call, so its
+ * latency is measured once, however many signals it is emitted with.
+ */
+void
+geye_sample_dispatch_stamp(GEyeSampleDispatch *dispatch,
+                           gint64              sampled,
+                           gint64              queued)
+{
+    dispatch->stamp_sampled = sampled;
+    dispatch->stamp_queued = queued;
+}
+
+static gboolean
+dispatch_push(GEyeSampleDispatch *dispatch, DispatchRecord *record)
+{
+    switch (record->type) {
+        case DISPATCH_SAMPLE:
+        case DISPATCH_BATCH_SAMPLE:
+        case DISPATCH_BINOCULAR:
+        case DISPATCH_EXTENDED:
+            record->sampled = dispatch->stamp_sampled;
+            record->queued = dispatch->stamp_queued;
+            dispatch->stamp_queued = 0;
+            break;
+        default:
+            ;
+    }
+
+    if (!geye_sample_ring_push(dispatch->ring, record)) {
+        if (g_atomic_int_get(&dispatch->policy) == GEYE_DROP_NEWEST ||
+                !drop_oldest(dispatch)) {
+            // The producer keeps a reference and tries again later.
+            if (record->type != DISPATCH_UNREF)
+                g_atomic_int_inc(&dispatch->dropped);
+            return FALSE;
+        }
+        g_atomic_int_inc(&dispatch->dropped);
+        geye_sample_ring_push(dispatch->ring, record);
+    }
+    dispatch->unflushed++;
+    return TRUE;
+}
+
+void
+geye_sample_dispatch_sample(GEyeSampleDispatch *dispatch,
+                            const GEyeSample   *sample)
+{
+    DispatchRecord record = {.type = DISPATCH_SAMPLE};
+    record.content.sample = *sample;
+    dispatch_push(dispatch, &record);
+}
+
+void
+geye_sample_dispatch_batch_sample(GEyeSampleDispatch *dispatch,
+                                  const GEyeSample   *sample)
+{
+    DispatchRecord record = {.type = DISPATCH_BATCH_SAMPLE};
+    record.content.sample = *sample;
+    dispatch_push(dispatch, &record);
+    dispatch->in_batch = TRUE;
+}
+
+void
+geye_sample_dispatch_binocular(GEyeSampleDispatch         *dispatch,
+                               const GEyeBinocularSample  *sample)
+{
+    DispatchRecord record = {.type = DISPATCH_BINOCULAR};
+    record.content.binocular = *sample;
+    dispatch_push(dispatch, &record);
+}
+
+/*
+ * The slots are allocated by the producer, the consumer only sees them
+ * after the record that refers to them.
+ */
+void
+geye_sample_dispatch_extended(GEyeSampleDispatch         *dispatch,
+                              const GEyeExtendedSample   *sample)
+{
+    DispatchRecord record = {.type = DISPATCH_EXTENDED};
+
+    if (!dispatch->extended) {
+        dispatch->n_extended = geye_sample_ring_get_capacity(dispatch->ring) + 1;
+        dispatch->extended = g_new(GEyeExtendedSample, dispatch->n_extended);
+    }
+
+    record.content.slot = dispatch->next_extended;
+    dispatch->extended[record.content.slot] = *sample;
+    if (dispatch_push(dispatch, &record))
+        dispatch->next_extended =
+            (dispatch->next_extended + 1) % dispatch->n_extended;
+}
+
+void
+geye_sample_dispatch_fixation(GEyeSampleDispatch *dispatch,
+                              const GEyeFixation *fixation)
+{
+    DispatchRecord record = {.type = DISPATCH_FIXATION};
+    record.content.fixation = *fixation;
+    dispatch_push(dispatch, &record);
+}
+
+void
+geye_sample_dispatch_saccade(GEyeSampleDispatch *dispatch,
+                             const GEyeSaccade  *saccade)
+{
+    DispatchRecord record = {.type = DISPATCH_SACCADE};
+    record.content.saccade = *saccade;
+    dispatch_push(dispatch, &record);
+}
+
+/**
+ * geye_sample_dispatch_aoi:
+ * @dispatch: a GEyeSampleDispatch
+ * @set: the set of the area, the producer must keep a reference until it
+ *       passed it to geye_sample_dispatch_unref()
+ * @aoi: the index of the area
+ * @enter: whether the gaze entered or left the area
+ * @time: the time of the transition
+ * @dwell: for a leave, how long the gaze was inside
+ *
+ * Emits "aoi-enter" or "aoi-leave" on @set in the main context.
+ */
+void
+geye_sample_dispatch_aoi(GEyeSampleDispatch *dispatch,
+                         GEyeAoiSet         *set,
+                         guint               aoi,
+                         gboolean            enter,
+                         gdouble             time,
+                         gdouble             dwell)
+{
+    DispatchRecord record = {
+        .type = enter ? DISPATCH_AOI_ENTER : DISPATCH_AOI_LEAVE
+    };
+    record.content.aoi.set = set;
+    record.content.aoi.aoi = aoi;
+    record.content.aoi.time = time;
+    record.content.aoi.dwell = dwell;
+    dispatch_push(dispatch, &record);
+}
+
+/**
+ * geye_sample_dispatch_unref:
+ * @dispatch: a GEyeSampleDispatch
+ * @object: a GObject
+ *
+ * Drops a reference on @object in the main context, after the records that
+ * were pushed before have been emitted. So the producer never drops the
+ * last reference itself.
+ *
+ * Returns: FALSE if the dispatch is full, the producer keeps its reference
+ *          and should try again later.
+ */
+gboolean
+geye_sample_dispatch_unref(GEyeSampleDispatch *dispatch, gpointer object)
+{
+    DispatchRecord record = {.type = DISPATCH_UNREF};
+    record.content.object = object;
+    return dispatch_push(dispatch, &record);
+}
+
+/**
+ * geye_sample_dispatch_flush:
+ * @dispatch: a GEyeSampleDispatch
+ *
+ * Closes the current batch and schedules the main context to emit what
+ * has been pushed since the previous flush. Call this once after draining
+ * the eyetracker, rather than for every sample.
+ */
+void
+geye_sample_dispatch_flush(GEyeSampleDispatch *dispatch)
+{
+    if (dispatch->in_batch) {
+        DispatchRecord record = {.type = DISPATCH_BATCH_END};
+        dispatch_push(dispatch, &record);
+        dispatch->in_batch = FALSE;
+    }
+
+    if (dispatch->unflushed == 0)
+        return;
+    dispatch->unflushed = 0;
+
+    // g_source_set_ready_time() is thread safe, but takes the lock of the
+    // main context, so only do so when the source isn't scheduled already.
+    if (g_atomic_int_compare_and_exchange(&dispatch->pending, FALSE, TRUE))
+        g_source_set_ready_time(dispatch->source, 0);
+}
@@ -0,0 +1,123 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GEYE_SAMPLE_DISPATCH_H
+#define GEYE_SAMPLE_DISPATCH_H
+
+#include "aoi-set.h"
+#include "eye-event.h"
+#include "eyetracker.h"
+#include "latency-histogram.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Carries samples from the thread that talks to the eyetracker to the main
+ * context in which the eyetracker was created, where they are emitted as
+ * the "sample", "samples", "binocular-sample", "extended-sample",
+ * "fixation" and "saccade" signals, and the "aoi-enter" and "aoi-leave"
+ * signals of a GEyeAoiSet.
+ *
+ * The samples are copied into a preallocated ring buffer and one GSource,
+ * attached once to the main context, emits them. Once it is set up,
+ * dispatching samples doesn't allocate memory, apart from the slots of the
+ * extended samples, which are allocated with the first one.
+ *
+ * When the main context stalls, the ring fills up and records are dropped
+ * according to a GEyeDropPolicy, so the memory and the time the main
+ * context needs to catch up stay bounded. The number of dropped records is
+ * emitted as "samples-dropped" once the main context runs again.
+ */
+typedef struct _GEyeSampleDispatch GEyeSampleDispatch;
+
+GEyeSampleDispatch* geye_sample_dispatch_new(GEyeEyetracker    *et,
+                                             GMainContext      *context,
+                                             guint              capacity);
+void                geye_sample_dispatch_free(GEyeSampleDispatch *dispatch);
+
+void                geye_sample_dispatch_prefault(
+                            GEyeSampleDispatch *dispatch
+                            );
+guint               geye_sample_dispatch_get_dropped(
+                            GEyeSampleDispatch *dispatch
+                            );
+guint               geye_sample_dispatch_get_dispatched(
+                            GEyeSampleDispatch *dispatch
+                            );
+void                geye_sample_dispatch_set_policy(
+                            GEyeSampleDispatch *dispatch,
+                            GEyeDropPolicy      policy
+                            );
+GEyeDropPolicy      geye_sample_dispatch_get_policy(
+                            GEyeSampleDispatch *dispatch
+                            );
+void                geye_sample_dispatch_set_latency(
+                            GEyeSampleDispatch     *dispatch,
+                            GEyeLatencyHistogram   *queue,
+                            GEyeLatencyHistogram   *total
+                            );
+
+/* producer side */
+void                geye_sample_dispatch_stamp(
+                            GEyeSampleDispatch *dispatch,
+                            gint64              sampled,
+                            gint64              queued
+                            );
+void                geye_sample_dispatch_sample(
+                            GEyeSampleDispatch *dispatch,
+                            const GEyeSample   *sample
+                            );
+void                geye_sample_dispatch_batch_sample(
+                            GEyeSampleDispatch *dispatch,
+                            const GEyeSample   *sample
+                            );
+void                geye_sample_dispatch_binocular(
+                            GEyeSampleDispatch         *dispatch,
+                            const GEyeBinocularSample  *sample
+                            );
+void                geye_sample_dispatch_extended(
+                            GEyeSampleDispatch         *dispatch,
+                            const GEyeExtendedSample   *sample
+                            );
+void                geye_sample_dispatch_fixation(
+                            GEyeSampleDispatch *dispatch,
+                            const GEyeFixation *fixation
+                            );
+void                geye_sample_dispatch_saccade(
+                            GEyeSampleDispatch *dispatch,
+                            const GEyeSaccade  *saccade
+                            );
+void                geye_sample_dispatch_aoi(
+                            GEyeSampleDispatch *dispatch,
+                            GEyeAoiSet         *set,
+                            guint               aoi,
+                            gboolean            enter,
+                            gdouble             time,
+                            gdouble             dwell
+                            );
+gboolean            geye_sample_dispatch_unref(
+                            GEyeSampleDispatch *dispatch,
+                            gpointer            object
+                            );
+void                geye_sample_dispatch_flush(GEyeSampleDispatch *dispatch);
+
+G_END_DECLS
+
+#endif
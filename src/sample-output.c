@@ -0,0 +1,1116 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "aoi-set-private.h"
+#include "eyetracker-error.h"
+#include "latency-histogram.h"
+#include "sample-broadcast.h"
+#include "sample-dispatch.h"
+#include "sample-output.h"
+#include "sample-ring.h"
+#include "sample-slot.h"
+
+// The sizes of a GEyeEyelinkEt, so the load is handled the same way.
+#define OUTPUT_SAMPLE_RING_SIZE 16384
+#define OUTPUT_DISPATCH_SIZE 8192
+#define OUTPUT_BROADCAST_SIZE 4096
+// Changed counters are notified at most this often, in ms.
+#define OUTPUT_COUNTER_INTERVAL 250
+
+// The value of aoi_pending that detaches the current set.
+static gchar        output_aoi_none;
+#define OUTPUT_AOI_NONE ((gpointer) &output_aoi_none)
+
+// Finds the output of an eyetracker, set by the interface init.
+static GQuark       output_quark;
+
+typedef enum {
+    PROP_CONNECTED,
+    PROP_TRACKING,
+    PROP_RECORDING,
+    PROP_NUM_CALPOINTS,
+    PROP_TRACKER_INFO,
+    PROP_SAMPLE_DELIVERY,
+    PROP_SAMPLE_FIELDS,
+    PROP_DROP_POLICY,
+    PROP_SAMPLES_DROPPED,
+    N_PROPERTIES
+} GEyeSampleOutputProperty;
+
+static const gchar* output_property_names[N_PROPERTIES] = {
+    "connected",
+    "tracking",
+    "recording",
+    "num-calpoints",
+    "tracker-info",
+    "sample-delivery",
+    "sample-fields",
+    "drop-policy",
+    "samples-dropped"
+};
+
+struct _GEyeSampleOutput {
+    GEyeEyetracker *et;             // Owns the output
+    const gchar    *name;           // What the eyetracker is called in errors
+    GParamSpec     *produced;       // The counter of the samples produced
+
+    GMutex          lock;
+    gchar          *info;           // Lock
+    gint            state;          // Atomic, see GEyeSampleOutputState
+    guint           num_calpoints;
+
+    guint           samples;        // Atomic, the samples produced
+    guint           counters_notified[2]; // Main context
+    GSource        *counter_source; // Main context, while connected
+
+    /* Producer only, taken once for every block in _begin(). */
+    guint           delivery;
+    GEyeSampleFields fields;
+    gboolean        sent;
+    gint64          woke;           // When the producer woke for the block
+    gdouble         last_time;
+
+    /* Areas of interest, see output_set_aoi_set() */
+    GEyeAoiSet     *aoi_set;        // Main context, the attached set
+    gpointer        aoi_pending;    // Atomic, handed over to the producer
+    GEyeAoiSet     *aoi_current;    // Producer only
+    GEyeAoiSet     *aoi_retired;    // Producer only, waits to be released
+
+    guint           sample_delivery;// Atomic, GEyeSampleDelivery flags
+    guint           sample_fields;  // Atomic, GEyeSampleFields flags
+    GEyeSampleDispatch *dispatch;   // Samples for the signals
+    GEyeSampleRing *sample_ring;    // Samples for read_samples
+    GEyeSampleSlot *latest_sample;
+    GEyeSampleBroadcast *broadcast;
+    GEyeLatencyHistogram *latency[GEYE_LATENCY_N_STAGES];
+
+    GMainContext   *main_context;   // The context in which signals are emitted.
+
+    geye_start_cal_func      cb_start_calibration;
+    gpointer                 cb_start_calibration_data;
+    geye_stop_cal_func       cb_stop_calibration;
+    gpointer                 cb_stop_calibration_data;
+    geye_calpoint_start_func cb_calpoint_start;
+    gpointer                 cb_calpoint_start_data;
+    geye_calpoint_stop_func  cb_calpoint_stop;
+    gpointer                 cb_calpoint_stop_data;
+    geye_image_data_func     cb_image_data;
+    gpointer                 cb_image_data_data;
+};
+
+/*
+ * @et: the eyetracker that owns the output, it is created in the main
+ *      context of the eyetracker
+ * @name: what the eyetracker is called in errors, "replay" for instance
+ * @produced: the property that counts the samples, notified along with
+ *            "samples-dropped"
+ */
+GEyeSampleOutput*
+geye_sample_output_new(GEyeEyetracker *et,
+                       const gchar    *name,
+                       GParamSpec     *produced)
+{
+    GEyeSampleOutput *output = g_new0(GEyeSampleOutput, 1);
+
+    g_mutex_init(&output->lock);
+    output->et              = et;
+    output->name            = name;
+    output->produced        = produced;
+    output->num_calpoints   = 9;
+    output->main_context    = g_main_context_ref_thread_default();
+    output->latest_sample   = geye_sample_slot_new();
+    output->sample_ring     = geye_sample_ring_new(
+            OUTPUT_SAMPLE_RING_SIZE, sizeof(GEyeSample)
+            );
+    output->dispatch        = geye_sample_dispatch_new(
+            et, output->main_context, OUTPUT_DISPATCH_SIZE
+            );
+    output->broadcast       = geye_sample_broadcast_new(OUTPUT_BROADCAST_SIZE);
+    for (guint i = 0; i < GEYE_LATENCY_N_STAGES; i++)
+        output->latency[i] = geye_latency_histogram_new();
+    geye_sample_dispatch_set_latency(
+            output->dispatch,
+            output->latency[GEYE_LATENCY_QUEUE],
+            output->latency[GEYE_LATENCY_TOTAL]
+            );
+
+    g_object_set_qdata(G_OBJECT(et), output_quark, output);
+    return output;
+}
+
+static void
+output_stop_counters(GEyeSampleOutput *output);
+
+/*
+ * Drops the areas of interest, the counters and the dispatch, from the
+ * dispose of the eyetracker once its producer is gone.
+ */
+void
+geye_sample_output_dispose(GEyeSampleOutput *output)
+{
+    gpointer pending;
+
+    pending = g_atomic_pointer_get(&output->aoi_pending);
+    if (pending && pending != OUTPUT_AOI_NONE) {
+        geye_aoi_set_detach(pending);
+        g_object_unref(pending);
+    }
+    output->aoi_pending = NULL;
+    if (output->aoi_current)
+        geye_aoi_set_detach(output->aoi_current);
+    g_clear_object(&output->aoi_current);
+    g_clear_object(&output->aoi_retired);
+    g_clear_object(&output->aoi_set);
+
+    output_stop_counters(output);
+
+    if (output->dispatch) {
+        geye_sample_dispatch_free(output->dispatch);
+        output->dispatch = NULL;
+    }
+
+    if (output->main_context) {
+        g_main_context_unref(output->main_context);
+        output->main_context = NULL;
+    }
+}
+
+void
+geye_sample_output_free(GEyeSampleOutput *output)
+{
+    g_free(output->info);
+    geye_sample_ring_free(output->sample_ring);
+    geye_sample_slot_free(output->latest_sample);
+    geye_sample_broadcast_unref(output->broadcast);
+    for (guint i = 0; i < GEYE_LATENCY_N_STAGES; i++)
+        geye_latency_histogram_free(output->latency[i]);
+    g_mutex_clear(&output->lock);
+    g_free(output);
+}
+
+GEyeSampleOutput*
+geye_sample_output_get(GEyeEyetracker *et)
+{
+    return g_object_get_qdata(G_OBJECT(et), output_quark);
+}
+
+/* ******************************* counters ********************************* */
+
+static guint
+output_get_dropped(GEyeSampleOutput *output)
+{
+    return output->dispatch ?
+        geye_sample_dispatch_get_dropped(output->dispatch) : 0;
+}
+
+/*
+ * GObject allocates to queue a notification even when nobody listens, so
+ * only the counters with a handler are notified.
+ */
+static gboolean
+output_counter_watched(GObject *obj, GParamSpec *pspec)
+{
+    return g_signal_has_handler_pending(
+            obj,
+            g_signal_lookup("notify", G_TYPE_OBJECT),
+            g_param_spec_get_name_quark(pspec),
+            TRUE
+            );
+}
+
+/*
+ * Notifies the counters that changed since the previous time, so watching
+ * them doesn't cost a notification for every sample.
+ */
+static gboolean
+output_notify_counters(gpointer data)
+{
+    GEyeSampleOutput *output = data;
+    GObject *obj = G_OBJECT(output->et);
+    GParamSpec *dropped_pspec = g_object_class_find_property(
+            G_OBJECT_GET_CLASS(obj), "samples-dropped"
+            );
+    guint produced = g_atomic_int_get(&output->samples);
+    guint dropped = output_get_dropped(output);
+    GParamSpec *changed[2];
+    guint n_changed = 0, i;
+
+    if (produced != output->counters_notified[0]) {
+        output->counters_notified[0] = produced;
+        if (output_counter_watched(obj, output->produced))
+            changed[n_changed++] = output->produced;
+    }
+    if (dropped != output->counters_notified[1]) {
+        output->counters_notified[1] = dropped;
+        if (output_counter_watched(obj, dropped_pspec))
+            changed[n_changed++] = dropped_pspec;
+    }
+    if (!n_changed)
+        return G_SOURCE_CONTINUE;
+
+    g_object_freeze_notify(obj);
+    for (i = 0; i < n_changed; i++)
+        g_object_notify_by_pspec(obj, changed[i]);
+    g_object_thaw_notify(obj);
+
+    return G_SOURCE_CONTINUE;
+}
+
+/*
+ * The counters only change while connected, so they are only watched
+ * while connected.
+ */
+static void
+output_start_counters(GEyeSampleOutput *output)
+{
+    if (output->counter_source)
+        return;
+
+    output->counter_source = g_timeout_source_new(OUTPUT_COUNTER_INTERVAL);
+    g_source_set_callback(
+            output->counter_source, output_notify_counters, output, NULL
+            );
+    g_source_set_name(output->counter_source, "GEyeSampleOutput counters");
+    g_source_attach(output->counter_source, output->main_context);
+}
+
+static void
+output_stop_counters(GEyeSampleOutput *output)
+{
+    if (!output->counter_source)
+        return;
+
+    g_source_destroy(output->counter_source);
+    g_source_unref(output->counter_source);
+    output->counter_source = NULL;
+}
+
+guint
+geye_sample_output_get_produced(GEyeSampleOutput *output)
+{
+    return g_atomic_int_get(&output->samples);
+}
+
+/* ******************************** state *********************************** */
+
+GMainContext*
+geye_sample_output_get_context(GEyeSampleOutput *output)
+{
+    return output->main_context;
+}
+
+gint
+geye_sample_output_get_state(GEyeSampleOutput *output)
+{
+    return g_atomic_int_get(&output->state);
+}
+
+static gint
+emit_connected(gpointer data)
+{
+    GEyeEyetracker *et = data;
+    GEyeSampleOutput *output = geye_sample_output_get(et);
+    gboolean connected =
+        (geye_sample_output_get_state(output) & GEYE_SAMPLE_OUTPUT_CONNECTED)
+        != 0;
+
+    g_object_notify(G_OBJECT(et), "connected");
+    g_signal_emit_by_name(et, "connected", connected);
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * Changes the state in the main context and notifies the properties that
+ * changed. The connection is signalled from an idle callback, so the
+ * caller of connect or disconnect returns first.
+ */
+void
+geye_sample_output_update_state(GEyeSampleOutput *output, gint clear, gint set)
+{
+    gint old_state, new_state, changed;
+
+    do {
+        old_state = g_atomic_int_get(&output->state);
+        new_state = (old_state & ~clear) | set;
+    } while (!g_atomic_int_compare_and_exchange(
+                &output->state, old_state, new_state)
+            );
+
+    changed = old_state ^ new_state;
+    if (changed & GEYE_SAMPLE_OUTPUT_TRACKING)
+        g_object_notify(G_OBJECT(output->et), "tracking");
+    if (changed & GEYE_SAMPLE_OUTPUT_RECORDING)
+        g_object_notify(G_OBJECT(output->et), "recording");
+    if (changed & GEYE_SAMPLE_OUTPUT_CONNECTED) {
+        if (new_state & GEYE_SAMPLE_OUTPUT_CONNECTED) {
+            output_start_counters(output);
+        }
+        else if (output->counter_source) {
+            // Don't miss the changes since the last interval.
+            output_notify_counters(output);
+            output_stop_counters(output);
+        }
+        g_main_context_invoke_full(
+                output->main_context,
+                G_PRIORITY_DEFAULT,
+                emit_connected,
+                g_object_ref(output->et),
+                g_object_unref
+                );
+    }
+}
+
+/* Returns whether the eyetracker is connected, sets error when it isn't. */
+gboolean
+geye_sample_output_check_connected(GEyeSampleOutput   *output,
+                                   const gchar        *what,
+                                   GError            **error)
+{
+    if (geye_sample_output_get_state(output) & GEYE_SAMPLE_OUTPUT_CONNECTED)
+        return TRUE;
+
+    g_set_error(
+            error,
+            geye_eyetracker_error_quark(),
+            GEYE_EYETRACKER_ERROR_INCORRECT_MODE,
+            "Unable to %s, the %s isn't connected.",
+            what,
+            output->name
+            );
+    return FALSE;
+}
+
+void
+geye_sample_output_set_info(GEyeSampleOutput *output, const gchar *info)
+{
+    g_mutex_lock(&output->lock);
+    g_free(output->info);
+    output->info = g_strdup(info);
+    g_mutex_unlock(&output->lock);
+}
+
+/* Prepares the output for a producer that doesn't page fault. */
+void
+geye_sample_output_prefault(GEyeSampleOutput *output)
+{
+    geye_sample_dispatch_prefault(output->dispatch);
+    geye_sample_broadcast_prefault(output->broadcast);
+}
+
+/* ****************************** the producer ****************************** */
+
+static void
+aoi_dispatch(GEyeAoiSet    *set,
+             guint          aoi,
+             gboolean       enter,
+             gdouble        time,
+             gdouble        dwell,
+             gpointer       data)
+{
+    GEyeSampleOutput *output = data;
+    geye_sample_dispatch_aoi(output->dispatch, set, aoi, enter, time, dwell);
+}
+
+/*
+ * Picks up the set of areas of interest that was attached in the meantime,
+ * as the Eyelink-thread does, see eyelink-et-private.c.
+ */
+static void
+aoi_swap(GEyeSampleOutput *output)
+{
+    gpointer next;
+
+    if (output->aoi_retired &&
+            geye_sample_dispatch_unref(output->dispatch, output->aoi_retired))
+        output->aoi_retired = NULL;
+
+    if (output->aoi_retired || !g_atomic_pointer_get(&output->aoi_pending))
+        return;
+
+    do {
+        next = g_atomic_pointer_get(&output->aoi_pending);
+    } while (!g_atomic_pointer_compare_and_exchange(
+                &output->aoi_pending, next, NULL)
+            );
+
+    if (output->aoi_current) {
+        geye_aoi_set_leave_all(
+                output->aoi_current, output->last_time, aoi_dispatch, output
+                );
+        geye_aoi_set_detach(output->aoi_current);
+        if (!geye_sample_dispatch_unref(output->dispatch, output->aoi_current))
+            output->aoi_retired = output->aoi_current;
+    }
+    output->aoi_current = next == OUTPUT_AOI_NONE ? NULL : next;
+    geye_sample_dispatch_flush(output->dispatch);
+}
+
+/* The areas of interest that contain the average of the valid eyes. */
+static void
+detect_aois(GEyeSampleOutput *output, const GEyeBinocularSample *sample)
+{
+    gdouble x = 0, y = 0;
+    guint n = 0;
+
+    if (sample->valid & GEYE_LEFT) {
+        x += sample->left_x;
+        y += sample->left_y;
+        n++;
+    }
+    if (sample->valid & GEYE_RIGHT) {
+        x += sample->right_x;
+        y += sample->right_y;
+        n++;
+    }
+    if (n == 0)
+        return;
+
+    geye_aoi_set_update(
+            output->aoi_current, x / n, y / n, sample->parent.time,
+            aoi_dispatch, output
+            );
+}
+
+/*
+ * Measures how late the producer woke up for the sample as LINK, unless the
+ * sample was due right away. The dispatch measures the stages in the main
+ * context from the time the producer woke, PROCESS is measured once per
+ * block by geye_sample_output_end(), so the clock isn't read per sample.
+ */
+static void
+measure_latency(GEyeSampleOutput *output, gint64 due, gint64 woke)
+{
+    if (due)
+        geye_latency_histogram_record(
+                output->latency[GEYE_LATENCY_LINK], MAX(woke - due, 0)
+                );
+    geye_sample_dispatch_stamp(output->dispatch, due, woke);
+}
+
+/*
+ * The records only have the gaze, so the extended samples carry the gaze
+ * and the unfiltered gaze, which is the same.
+ */
+static void
+send_extended_sample(GEyeSampleOutput          *output,
+                     const GEyeBinocularSample *binocular)
+{
+    GEyeExtendedSample extended = {
+        .parent = binocular->parent,
+        .valid  = binocular->valid,
+        .fields = output->fields & GEYE_SAMPLE_FIELD_UNFILTERED
+    };
+    gdouble *value = extended.values;
+
+    if (binocular->parent.eye & GEYE_LEFT) {
+        *value++ = binocular->left_x;
+        *value++ = binocular->left_y;
+        if (extended.fields) {
+            *value++ = binocular->left_x;
+            *value++ = binocular->left_y;
+        }
+    }
+    if (binocular->parent.eye & GEYE_RIGHT) {
+        *value++ = binocular->right_x;
+        *value++ = binocular->right_y;
+        if (extended.fields) {
+            *value++ = binocular->right_x;
+            *value++ = binocular->right_y;
+        }
+    }
+    geye_sample_dispatch_extended(output->dispatch, &extended);
+}
+
+static void
+send_sample(GEyeSampleOutput   *output,
+            const GEyeRecord   *record,
+            gint64              due,
+            gint64              woke)
+{
+    GEyeSample samples[2];
+    GEyeBinocularSample binocular = {
+        .parent = {
+            .type = GEYE_EVENT_SAMPLE,
+            .eye  = record->eye,
+            .time = record->time,
+            .tracker_time = record->tracker_time
+        },
+        .valid   = record->valid,
+        .left_x  = record->data.sample.left_x,
+        .left_y  = record->data.sample.left_y,
+        .right_x = record->data.sample.right_x,
+        .right_y = record->data.sample.right_y
+    };
+    guint delivery = output->delivery;
+    guint n = 0, i;
+
+    geye_sample_slot_store(output->latest_sample, &binocular);
+    geye_sample_broadcast_push(output->broadcast, &binocular);
+    if (output->aoi_current)
+        detect_aois(output, &binocular);
+    measure_latency(output, due, woke);
+
+    if (record->eye & GEYE_LEFT) {
+        samples[n].parent = binocular.parent;
+        samples[n].parent.eye = GEYE_LEFT;
+        samples[n].x = binocular.left_x;
+        samples[n].y = binocular.left_y;
+        n++;
+    }
+    if (record->eye & GEYE_RIGHT) {
+        samples[n].parent = binocular.parent;
+        samples[n].parent.eye = GEYE_RIGHT;
+        samples[n].x = binocular.right_x;
+        samples[n].y = binocular.right_y;
+        n++;
+    }
+
+    if (delivery & GEYE_DELIVER_BINOCULAR)
+        geye_sample_dispatch_binocular(output->dispatch, &binocular);
+    if (delivery & GEYE_DELIVER_EXTENDED)
+        send_extended_sample(output, &binocular);
+
+    for (i = 0; i < n; i++) {
+        if (delivery & GEYE_DELIVER_PULL)
+            geye_sample_ring_push(output->sample_ring, &samples[i]);
+        if (delivery & GEYE_DELIVER_SAMPLES)
+            geye_sample_dispatch_batch_sample(output->dispatch, &samples[i]);
+        if (delivery & GEYE_DELIVER_SAMPLE)
+            geye_sample_dispatch_sample(output->dispatch, &samples[i]);
+    }
+
+    g_atomic_int_inc(&output->samples);
+    output->last_time = record->time;
+}
+
+/*
+ * Takes what to do with the samples of a block, and the areas of interest
+ * that were attached in the meantime.
+ */
+void
+geye_sample_output_begin(GEyeSampleOutput *output)
+{
+    output->delivery = g_atomic_int_get(&output->sample_delivery);
+    output->fields = g_atomic_int_get(&output->sample_fields);
+    output->sent = FALSE;
+    aoi_swap(output);
+}
+
+/*
+ * Sends a record of the block.
+ *
+ * @due: the host time at which the record was due, 0 when it was due right
+ *       away
+ * @woke: the host time at which the producer woke up for the block
+ */
+void
+geye_sample_output_record(GEyeSampleOutput *output,
+                          const GEyeRecord *record,
+                          gint64            due,
+                          gint64            woke)
+{
+    GEyeEvent event = {
+        .type = record->event,
+        .eye  = record->eye,
+        .time = record->time,
+        .tracker_time = record->tracker_time
+    };
+
+    switch (record->type) {
+        case GEYE_RECORD_SAMPLE:
+            send_sample(output, record, due, woke);
+            break;
+        case GEYE_RECORD_FIXATION:
+            {
+                GEyeFixation fixation = {
+                    .parent = event,
+                    .end_time = record->data.fixation.end_time,
+                    .x = record->data.fixation.x,
+                    .y = record->data.fixation.y
+                };
+                geye_sample_dispatch_fixation(output->dispatch, &fixation);
+            }
+            break;
+        case GEYE_RECORD_SACCADE:
+            {
+                GEyeSaccade saccade = {
+                    .parent = event,
+                    .end_time = record->data.saccade.end_time,
+                    .start_x = record->data.saccade.start_x,
+                    .start_y = record->data.saccade.start_y,
+                    .end_x = record->data.saccade.end_x,
+                    .end_y = record->data.saccade.end_y,
+                    .amplitude = record->data.saccade.amplitude,
+                    .peak_velocity = record->data.saccade.peak_velocity
+                };
+                geye_sample_dispatch_saccade(output->dispatch, &saccade);
+            }
+            break;
+        default:
+            // Messages have no signal.
+            return;
+    }
+    output->sent = TRUE;
+    output->woke = woke;
+}
+
+/*
+ * Hands the records of the block to the main context and the subscribers,
+ * the time that took since the producer woke up is the PROCESS latency of
+ * the block.
+ */
+void
+geye_sample_output_end(GEyeSampleOutput *output)
+{
+    if (!output->sent)
+        return;
+
+    geye_sample_dispatch_flush(output->dispatch);
+    geye_sample_broadcast_publish(output->broadcast);
+    geye_latency_histogram_record(
+            output->latency[GEYE_LATENCY_PROCESS],
+            g_get_monotonic_time() - output->woke
+            );
+}
+
+/* **************************** interface methods *************************** */
+
+static void
+output_set_unsupported(GEyeSampleOutput *output,
+                       GError          **error,
+                       const gchar      *what)
+{
+    g_set_error(
+            error,
+            geye_eyetracker_error_quark(),
+            GEYE_EYETRACKER_ERROR_INCORRECT_MODE,
+            "A %s can't %s.",
+            output->name,
+            what
+            );
+}
+
+static gchar*
+output_get_tracker_info(GEyeEyetracker* et)
+{
+    GEyeSampleOutput *output = geye_sample_output_get(et);
+    gchar *ret;
+
+    g_mutex_lock(&output->lock);
+    ret = g_strdup(output->info);
+    g_mutex_unlock(&output->lock);
+    return ret;
+}
+
+/* There is no eyetracker to record on, only the state is kept. */
+static void
+output_start_recording(GEyeEyetracker* et, GError** error)
+{
+    GEyeSampleOutput *output = geye_sample_output_get(et);
+
+    if (!geye_sample_output_check_connected(output, "start recording", error))
+        return;
+    geye_sample_output_update_state(output, 0, GEYE_SAMPLE_OUTPUT_RECORDING);
+}
+
+static void
+output_stop_recording(GEyeEyetracker* et)
+{
+    geye_sample_output_update_state(
+            geye_sample_output_get(et), GEYE_SAMPLE_OUTPUT_RECORDING, 0
+            );
+}
+
+static void
+output_log_message(GEyeEyetracker* et, const gchar* msg, GError** error)
+{
+    output_set_unsupported(geye_sample_output_get(et), error, "log a message");
+}
+
+static void
+output_start_setup(GEyeEyetracker* et)
+{
+}
+
+static void
+output_stop_setup(GEyeEyetracker* et)
+{
+}
+
+static void
+output_calibrate(GEyeEyetracker* et, GError** error)
+{
+    output_set_unsupported(geye_sample_output_get(et), error, "be calibrated");
+}
+
+static void
+output_validate(GEyeEyetracker* et, GError** error)
+{
+    output_set_unsupported(geye_sample_output_get(et), error, "be validated");
+}
+
+static void
+output_trigger_calpoint(GEyeEyetracker* et, GError** error)
+{
+    output_set_unsupported(
+            geye_sample_output_get(et), error, "trigger a calibration point"
+            );
+}
+
+static guint
+output_get_num_calpoints(GEyeEyetracker* et)
+{
+    return geye_sample_output_get(et)->num_calpoints;
+}
+
+static void
+output_set_num_calpoints(GEyeEyetracker* et, guint n)
+{
+    geye_sample_output_get(et)->num_calpoints = n;
+}
+
+static void
+output_set_calibration_start_cb(GEyeEyetracker     *et,
+                                geye_start_cal_func cb,
+                                gpointer            data)
+{
+    GEyeSampleOutput *output = geye_sample_output_get(et);
+    output->cb_start_calibration = cb;
+    output->cb_start_calibration_data = data;
+}
+
+static void
+output_set_calibration_stop_cb(GEyeEyetracker    *et,
+                               geye_stop_cal_func cb,
+                               gpointer           data)
+{
+    GEyeSampleOutput *output = geye_sample_output_get(et);
+    output->cb_stop_calibration = cb;
+    output->cb_stop_calibration_data = data;
+}
+
+static void
+output_set_calpoint_start_cb(GEyeEyetracker          *et,
+                             geye_calpoint_start_func cb,
+                             gpointer                 data)
+{
+    GEyeSampleOutput *output = geye_sample_output_get(et);
+    output->cb_calpoint_start = cb;
+    output->cb_calpoint_start_data = data;
+}
+
+static void
+output_set_calpoint_stop_cb(GEyeEyetracker          *et,
+                            geye_calpoint_stop_func  cb,
+                            gpointer                 data)
+{
+    GEyeSampleOutput *output = geye_sample_output_get(et);
+    output->cb_calpoint_stop = cb;
+    output->cb_calpoint_stop_data = data;
+}
+
+static void
+output_set_image_data_cb(GEyeEyetracker      *et,
+                         geye_image_data_func cb,
+                         gpointer             data)
+{
+    GEyeSampleOutput *output = geye_sample_output_get(et);
+    output->cb_image_data = cb;
+    output->cb_image_data_data = data;
+}
+
+static gboolean
+output_send_key_press(GEyeEyetracker* et, guint16 key, guint modifiers)
+{
+    return FALSE;
+}
+
+static guint
+output_read_samples(GEyeEyetracker *et,
+                    GEyeSample     *samples,
+                    guint           max_samples,
+                    gint64          timeout_us)
+{
+    GEyeSampleOutput *output = geye_sample_output_get(et);
+    return geye_sample_ring_pop_timeout(
+            output->sample_ring, samples, max_samples, timeout_us
+            );
+}
+
+static guint
+output_get_sample_overruns(GEyeEyetracker *et)
+{
+    GEyeSampleOutput *output = geye_sample_output_get(et);
+    return geye_sample_ring_get_overruns(output->sample_ring);
+}
+
+static gboolean
+output_get_latest_sample(GEyeEyetracker* et, GEyeBinocularSample* sample)
+{
+    GEyeSampleOutput *output = geye_sample_output_get(et);
+    return geye_sample_slot_load(output->latest_sample, sample);
+}
+
+static GEyeSubscriber*
+output_subscribe(GEyeEyetracker    *et,
+                 guint              decimation,
+                 gdouble            interval,
+                 GError           **error)
+{
+    GEyeSampleOutput *output = geye_sample_output_get(et);
+    return geye_sample_broadcast_subscribe(
+            output->broadcast, decimation, interval, error
+            );
+}
+
+static gboolean
+output_get_latency_stats(GEyeEyetracker   *et,
+                         GEyeLatencyStage  stage,
+                         GEyeLatencyStats *stats)
+{
+    GEyeSampleOutput *output = geye_sample_output_get(et);
+    geye_latency_histogram_get_stats(output->latency[stage], stats);
+    return TRUE;
+}
+
+static void
+output_reset_latency_stats(GEyeEyetracker *et)
+{
+    GEyeSampleOutput *output = geye_sample_output_get(et);
+    for (guint i = 0; i < GEYE_LATENCY_N_STAGES; i++)
+        geye_latency_histogram_reset(output->latency[i]);
+}
+
+/*
+ * The set is handed over to the producer, which leaves the areas of the
+ * previous set and detects the areas of the new one from its next block.
+ */
+static void
+output_set_aoi_set(GEyeEyetracker* et, GEyeAoiSet* set)
+{
+    GEyeSampleOutput *output = geye_sample_output_get(et);
+    gpointer next, old;
+
+    if (set == output->aoi_set)
+        return;
+
+    if (set && !geye_aoi_set_attach(set, et))
+        return;
+    g_set_object(&output->aoi_set, set);
+
+    next = set ? g_object_ref(set) : OUTPUT_AOI_NONE;
+    do {
+        old = g_atomic_pointer_get(&output->aoi_pending);
+    } while (!g_atomic_pointer_compare_and_exchange(
+                &output->aoi_pending, old, next)
+            );
+    // The producer didn't pick up the previous set.
+    if (old && old != OUTPUT_AOI_NONE) {
+        geye_aoi_set_detach(old);
+        g_object_unref(old);
+    }
+}
+
+static GEyeAoiSet*
+output_get_aoi_set(GEyeEyetracker* et)
+{
+    return geye_sample_output_get(et)->aoi_set;
+}
+
+static void
+output_start_host_recording(GEyeEyetracker  *et,
+                            const gchar     *filename,
+                            GError         **error)
+{
+    output_set_unsupported(
+            geye_sample_output_get(et), error, "make a host recording"
+            );
+}
+
+static void
+output_stop_host_recording(GEyeEyetracker* et, GError** error)
+{
+    output_set_unsupported(
+            geye_sample_output_get(et), error, "make a host recording"
+            );
+}
+
+/*
+ * Fills in the methods of GEyeEyetracker other than connect, disconnect,
+ * start_tracking, stop_tracking and tracker_to_host_time, which the
+ * eyetracker implements.
+ */
+void
+geye_sample_output_interface_init(GEyeEyetrackerInterface *iface)
+{
+    // The classes are initialized before their first instance.
+    if (!output_quark)
+        output_quark = g_quark_from_static_string("geye-sample-output");
+
+    iface->tracker_info     = output_get_tracker_info;
+
+    iface->start_recording  = output_start_recording;
+    iface->stop_recording   = output_stop_recording;
+
+    iface->log_message      = output_log_message;
+
+    iface->start_setup      = output_start_setup;
+    iface->stop_setup       = output_stop_setup;
+
+    iface->calibrate        = output_calibrate;
+    iface->validate         = output_validate;
+    iface->trigger_calpoint = output_trigger_calpoint;
+
+    iface->get_num_calpoints= output_get_num_calpoints;
+    iface->set_num_calpoints= output_set_num_calpoints;
+
+    iface->set_calibration_start_cb = output_set_calibration_start_cb;
+    iface->set_calibration_stop_cb  = output_set_calibration_stop_cb;
+    iface->set_calpoint_start_cb    = output_set_calpoint_start_cb;
+    iface->set_calpoint_stop_cb     = output_set_calpoint_stop_cb;
+
+    iface->set_image_data_cb = output_set_image_data_cb;
+
+    iface->send_key_press   = output_send_key_press;
+
+    iface->read_samples         = output_read_samples;
+    iface->get_sample_overruns  = output_get_sample_overruns;
+    iface->get_latest_sample    = output_get_latest_sample;
+    iface->subscribe            = output_subscribe;
+    iface->get_latency_stats    = output_get_latency_stats;
+    iface->reset_latency_stats  = output_reset_latency_stats;
+    iface->set_aoi_set          = output_set_aoi_set;
+    iface->get_aoi_set          = output_get_aoi_set;
+
+    iface->start_host_recording = output_start_host_recording;
+    iface->stop_host_recording  = output_stop_host_recording;
+}
+
+/* ****************************** properties ******************************** */
+
+/*
+ * Overrides the properties of GEyeEyetracker with the ids from first_id,
+ * the first id after those of the eyetracker itself.
+ */
+void
+geye_sample_output_override_properties(GObjectClass *klass, guint first_id)
+{
+    for (guint i = 0; i < N_PROPERTIES; i++)
+        g_object_class_override_property(
+                klass, first_id + i, output_property_names[i]
+                );
+}
+
+/*
+ * Gets a property of GEyeEyetracker, property_id counts from the first_id
+ * of geye_sample_output_override_properties(). Returns FALSE for another
+ * property.
+ */
+gboolean
+geye_sample_output_get_property(GEyeSampleOutput   *output,
+                                guint               property_id,
+                                GValue             *value)
+{
+    gint state = geye_sample_output_get_state(output);
+
+    switch ((GEyeSampleOutputProperty) property_id) {
+        case PROP_CONNECTED:
+            g_value_set_boolean(
+                    value, (state & GEYE_SAMPLE_OUTPUT_CONNECTED) != 0
+                    );
+            break;
+        case PROP_TRACKING:
+            g_value_set_boolean(
+                    value, (state & GEYE_SAMPLE_OUTPUT_TRACKING) != 0
+                    );
+            break;
+        case PROP_RECORDING:
+            g_value_set_boolean(
+                    value, (state & GEYE_SAMPLE_OUTPUT_RECORDING) != 0
+                    );
+            break;
+        case PROP_NUM_CALPOINTS:
+            g_value_set_uint(value, output->num_calpoints);
+            break;
+        case PROP_TRACKER_INFO:
+            g_value_take_string(
+                    value, output_get_tracker_info(output->et)
+                    );
+            break;
+        case PROP_SAMPLE_DELIVERY:
+            g_value_set_flags(
+                    value, g_atomic_int_get(&output->sample_delivery)
+                    );
+            break;
+        case PROP_SAMPLE_FIELDS:
+            g_value_set_flags(value, g_atomic_int_get(&output->sample_fields));
+            break;
+        case PROP_DROP_POLICY:
+            g_value_set_enum(
+                    value,
+                    output->dispatch ?
+                        geye_sample_dispatch_get_policy(output->dispatch) :
+                        GEYE_DROP_NEWEST
+                    );
+            break;
+        case PROP_SAMPLES_DROPPED:
+            g_value_set_uint(value, output_get_dropped(output));
+            break;
+        case N_PROPERTIES:
+        default:
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/* Sets a property of GEyeEyetracker, see geye_sample_output_get_property(). */
+gboolean
+geye_sample_output_set_property(GEyeSampleOutput   *output,
+                                guint               property_id,
+                                const GValue       *value)
+{
+    switch ((GEyeSampleOutputProperty) property_id) {
+        case PROP_NUM_CALPOINTS:
+            output->num_calpoints = g_value_get_uint(value);
+            break;
+        case PROP_SAMPLE_DELIVERY:
+            g_atomic_int_set(
+                    &output->sample_delivery, g_value_get_flags(value)
+                    );
+            break;
+        case PROP_SAMPLE_FIELDS:
+            g_atomic_int_set(&output->sample_fields, g_value_get_flags(value));
+            break;
+        case PROP_DROP_POLICY:
+            geye_sample_dispatch_set_policy(
+                    output->dispatch, g_value_get_enum(value)
+                    );
+            break;
+        case PROP_CONNECTED:
+        case PROP_TRACKING:
+        case PROP_RECORDING:
+        case PROP_TRACKER_INFO:
+        case PROP_SAMPLES_DROPPED:
+        case N_PROPERTIES:
+        default:
+            return FALSE;
+    }
+    return TRUE;
+}
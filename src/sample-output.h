@@ -0,0 +1,108 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GEYE_SAMPLE_OUTPUT_H
+#define GEYE_SAMPLE_OUTPUT_H
+
+#include "eyetracker.h"
+#include "recording.h"
+
+G_BEGIN_DECLS
+
+/*
+ * The part of an eyetracker that produces its samples on a thread of its
+ * own, without a link to a real eyetracker, such as GEyeReplayEt and
+ * GEyeSyntheticEt. It hands the records of that thread to the signals,
+ * geye_eyetracker_read_samples(), the latest sample, the subscribers and
+ * the areas of interest, measures their latency and keeps the state, the
+ * counters and the properties of GEyeEyetracker.
+ *
+ * The eyetracker creates it in its init function and implements the
+ * connection and tracking itself. geye_sample_output_interface_init()
+ * fills in the other methods of GEyeEyetracker, they find the output with
+ * geye_sample_output_get().
+ */
+typedef struct _GEyeSampleOutput GEyeSampleOutput;
+
+typedef enum {
+    GEYE_SAMPLE_OUTPUT_CONNECTED  = 1 << 0,
+    GEYE_SAMPLE_OUTPUT_TRACKING   = 1 << 1,
+    GEYE_SAMPLE_OUTPUT_RECORDING  = 1 << 2
+} GEyeSampleOutputState;
+
+GEyeSampleOutput*   geye_sample_output_new(GEyeEyetracker *et,
+                                           const gchar    *name,
+                                           GParamSpec     *produced);
+void                geye_sample_output_dispose(GEyeSampleOutput *output);
+void                geye_sample_output_free(GEyeSampleOutput *output);
+
+GEyeSampleOutput*   geye_sample_output_get(GEyeEyetracker *et);
+
+void                geye_sample_output_interface_init(
+                            GEyeEyetrackerInterface *iface
+                            );
+void                geye_sample_output_override_properties(
+                            GObjectClass   *klass,
+                            guint           first_id
+                            );
+gboolean            geye_sample_output_get_property(
+                            GEyeSampleOutput   *output,
+                            guint               property_id,
+                            GValue             *value
+                            );
+gboolean            geye_sample_output_set_property(
+                            GEyeSampleOutput   *output,
+                            guint               property_id,
+                            const GValue       *value
+                            );
+
+/* main context */
+GMainContext*       geye_sample_output_get_context(GEyeSampleOutput *output);
+gint                geye_sample_output_get_state(GEyeSampleOutput *output);
+void                geye_sample_output_update_state(
+                            GEyeSampleOutput   *output,
+                            gint                clear,
+                            gint                set
+                            );
+gboolean            geye_sample_output_check_connected(
+                            GEyeSampleOutput   *output,
+                            const gchar        *what,
+                            GError            **error
+                            );
+void                geye_sample_output_set_info(GEyeSampleOutput *output,
+                                                const gchar      *info);
+void                geye_sample_output_prefault(GEyeSampleOutput *output);
+
+/* any thread */
+guint               geye_sample_output_get_produced(
+                            GEyeSampleOutput *output
+                            );
+
+/* producer side */
+void                geye_sample_output_begin(GEyeSampleOutput *output);
+void                geye_sample_output_record(GEyeSampleOutput *output,
+                                              const GEyeRecord *record,
+                                              gint64            due,
+                                              gint64            woke);
+void                geye_sample_output_end(GEyeSampleOutput *output);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,301 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "sample-ring.h"
+
+/*
+ * The indices run freely and wrap around at G_MAXUINT, since the capacity
+ * is a power of two, head - tail is always the number of stored records.
+ * head is only written by the producer and tail only by the consumer, they
+ * live on separate cache lines so the threads don't bounce them around.
+ */
+#define RING_CACHE_LINE 64
+
+struct _GEyeSampleRing {
+    guint8     *buffer;
+    gsize       record_size;
+    guint       capacity;
+    guint       mask;
+
+    /* written by the producer */
+    guint       head;
+    guint       cached_tail;    // the producer's last view on tail
+    guint       overruns;
+    guint8      pad_producer[RING_CACHE_LINE];
+
+    /* written by the consumer */
+    guint       tail;
+    guint8      pad_consumer[RING_CACHE_LINE];
+
+    /* only used when the consumer has to wait for new records */
+    gint        waiters;
+    GMutex      mutex;
+    GCond       cond;
+};
+
+static inline gpointer
+ring_record(GEyeSampleRing *ring, guint index)
+{
+    return ring->buffer + (gsize) (index & ring->mask) * ring->record_size;
+}
+
+/**
+ * geye_sample_ring_new:
+ * @capacity: the minimal number of records the ring should hold, it is
+ *            rounded up to the next power of two.
+ * @record_size: the size of one record e.g. sizeof(GEyeSample)
+ *
+ * Allocates a ring buffer, this is the only allocation the ring makes.
+ *
+ * Returns: a new ring buffer, free it with geye_sample_ring_free().
+ */
+GEyeSampleRing*
+geye_sample_ring_new(guint capacity, gsize record_size)
+{
+    GEyeSampleRing *ring;
+    guint size = 1;
+
+    g_return_val_if_fail(capacity > 0 && capacity <= G_MAXUINT / 2, NULL);
+    g_return_val_if_fail(record_size > 0, NULL);
+
+    while (size < capacity)
+        size <<= 1;
+
+    ring = g_new0(GEyeSampleRing, 1);
+    ring->buffer = g_malloc0_n(size, record_size);
+    ring->record_size = record_size;
+    ring->capacity = size;
+    ring->mask = size - 1;
+
+    g_mutex_init(&ring->mutex);
+    g_cond_init(&ring->cond);
+
+    return ring;
+}
+
+void
+geye_sample_ring_free(GEyeSampleRing *ring)
+{
+    if (!ring)
+        return;
+
+    g_mutex_clear(&ring->mutex);
+    g_cond_clear(&ring->cond);
+    g_free(ring->buffer);
+    g_free(ring);
+}
+
+/**
+ * geye_sample_ring_prefault:
+ * @ring: a GEyeSampleRing
+ *
+ * Writes the whole buffer, so the operating system maps all its pages
+ * before the first record is pushed. Call this before the ring is used.
+ */
+void
+geye_sample_ring_prefault(GEyeSampleRing *ring)
+{
+    g_return_if_fail(ring != NULL);
+    memset(ring->buffer, 0, (gsize) ring->capacity * ring->record_size);
+}
+
+guint
+geye_sample_ring_get_capacity(GEyeSampleRing *ring)
+{
+    g_return_val_if_fail(ring != NULL, 0);
+    return ring->capacity;
+}
+
+/**
+ * geye_sample_ring_get_overruns:
+ * @ring: a GEyeSampleRing
+ *
+ * Returns: the number of records that were dropped because the consumer
+ *          didn't keep up with the producer. It may be read from any thread.
+ */
+guint
+geye_sample_ring_get_overruns(GEyeSampleRing *ring)
+{
+    g_return_val_if_fail(ring != NULL, 0);
+    return g_atomic_int_get(&ring->overruns);
+}
+
+/**
+ * geye_sample_ring_push:
+ * @ring: a GEyeSampleRing
+ * @record: the record to copy into the ring
+ *
+ * Must only be called from the producer thread. This function doesn't lock
+ * and doesn't allocate. The consumer is not woken, call
+ * geye_sample_ring_wake() once a batch of records has been pushed.
+ *
+ * Returns: TRUE if the record was stored, FALSE if the ring was full.
+ */
+gboolean
+geye_sample_ring_push(GEyeSampleRing *ring, gconstpointer record)
+{
+    guint head = ring->head;
+
+    if (head - ring->cached_tail == ring->capacity) {
+        ring->cached_tail = g_atomic_int_get(&ring->tail);
+        if (head - ring->cached_tail == ring->capacity) {
+            g_atomic_int_inc(&ring->overruns);
+            return FALSE;
+        }
+    }
+
+    memcpy(ring_record(ring, head), record, ring->record_size);
+    g_atomic_int_set(&ring->head, head + 1);
+
+    return TRUE;
+}
+
+/**
+ * geye_sample_ring_wake:
+ * @ring: a GEyeSampleRing
+ *
+ * Wakes a consumer that is blocked in geye_sample_ring_pop_timeout(). When
+ * no consumer is waiting, this doesn't take a lock.
+ */
+void
+geye_sample_ring_wake(GEyeSampleRing *ring)
+{
+    if (g_atomic_int_get(&ring->waiters) > 0) {
+        g_mutex_lock(&ring->mutex);
+        g_cond_broadcast(&ring->cond);
+        g_mutex_unlock(&ring->mutex);
+    }
+}
+
+/**
+ * geye_sample_ring_peek:
+ * @ring: a GEyeSampleRing
+ * @n_records:(out): the number of records available at the returned address
+ *
+ * Gives the consumer access to the oldest records without copying them.
+ * The records stay valid until they are released with
+ * geye_sample_ring_release(). When the stored records wrap around the end
+ * of the buffer, only the records up to the end are returned.
+ *
+ * Returns: the oldest record in the ring.
+ */
+gpointer
+geye_sample_ring_peek(GEyeSampleRing *ring, guint *n_records)
+{
+    guint tail = ring->tail;
+    guint head = g_atomic_int_get(&ring->head);
+
+    *n_records = MIN(head - tail, ring->capacity - (tail & ring->mask));
+    return ring_record(ring, tail);
+}
+
+/**
+ * geye_sample_ring_release:
+ * @ring: a GEyeSampleRing
+ * @n_records: the number of records the consumer is done with
+ *
+ * Returns the oldest @n_records to the producer.
+ */
+void
+geye_sample_ring_release(GEyeSampleRing *ring, guint n_records)
+{
+    g_atomic_int_set(&ring->tail, ring->tail + n_records);
+}
+
+/**
+ * geye_sample_ring_pop:
+ * @ring: a GEyeSampleRing
+ * @records:(out caller-allocates): the buffer that receives the records.
+ * @max_records: the number of records that fit in @records
+ *
+ * Copies the oldest records out of the ring. Only one thread at a time
+ * should consume records.
+ *
+ * Returns: the number of records written to @records
+ */
+guint
+geye_sample_ring_pop(GEyeSampleRing *ring,
+                     gpointer        records,
+                     guint           max_records)
+{
+    guint8 *dest = records;
+    guint n = 0;
+
+    // Copy in at most two runs, the second one after wrapping around.
+    while (n < max_records) {
+        guint available;
+        gpointer src = geye_sample_ring_peek(ring, &available);
+
+        available = MIN(available, max_records - n);
+        if (available == 0)
+            break;
+
+        memcpy(dest, src, available * ring->record_size);
+        geye_sample_ring_release(ring, available);
+        dest += available * ring->record_size;
+        n += available;
+    }
+
+    return n;
+}
+
+/**
+ * geye_sample_ring_pop_timeout:
+ * @ring: a GEyeSampleRing
+ * @records:(out caller-allocates): the buffer that receives the records.
+ * @max_records: the number of records that fit in @records
+ * @timeout_us: the maximum number of microseconds to wait for records,
+ *              0 doesn't wait and a negative value waits until records
+ *              arrive.
+ *
+ * As geye_sample_ring_pop(), but waits for records when the ring is empty.
+ *
+ * Returns: the number of records written to @records, 0 on timeout.
+ */
+guint
+geye_sample_ring_pop_timeout(GEyeSampleRing *ring,
+                             gpointer        records,
+                             guint           max_records,
+                             gint64          timeout_us)
+{
+    gint64 end_time;
+    guint n;
+
+    n = geye_sample_ring_pop(ring, records, max_records);
+    if (n > 0 || timeout_us == 0 || max_records == 0)
+        return n;
+
+    end_time = g_get_monotonic_time() + timeout_us;
+
+    g_mutex_lock(&ring->mutex);
+    g_atomic_int_inc(&ring->waiters);
+    // The producer publishes head before it looks at waiters, so either
+    // we see the record here, or the producer sees us waiting.
+    while (g_atomic_int_get(&ring->head) == ring->tail) {
+        if (timeout_us < 0)
+            g_cond_wait(&ring->cond, &ring->mutex);
+        else if (!g_cond_wait_until(&ring->cond, &ring->mutex, end_time))
+            break;
+    }
+    g_atomic_int_add(&ring->waiters, -1);
+    g_mutex_unlock(&ring->mutex);
+
+    return geye_sample_ring_pop(ring, records, max_records);
+}
@@ -0,0 +1,66 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GEYE_SAMPLE_RING_H
+#define GEYE_SAMPLE_RING_H
+
+#include "eye-event.h"
+
+G_BEGIN_DECLS
+
+/*
+ * A single-producer/single-consumer ring buffer of fixed size records,
+ * typically GEyeSamples.
+ *
+ * The producer (the thread that talks to the eyetracker) pushes records
+ * without taking a lock or allocating memory. When the ring is full the
+ * newest record is dropped and counted as an overrun. One consumer at a
+ * time may pop records from any thread.
+ */
+typedef struct _GEyeSampleRing GEyeSampleRing;
+
+GEyeSampleRing* geye_sample_ring_new(guint capacity, gsize record_size);
+void            geye_sample_ring_free(GEyeSampleRing *ring);
+
+guint           geye_sample_ring_get_capacity(GEyeSampleRing *ring);
+guint           geye_sample_ring_get_overruns(GEyeSampleRing *ring);
+void            geye_sample_ring_prefault(GEyeSampleRing *ring);
+
+/* producer side */
+gboolean        geye_sample_ring_push(GEyeSampleRing *ring,
+                                      gconstpointer   record);
+void            geye_sample_ring_wake(GEyeSampleRing *ring);
+
+/* consumer side */
+guint           geye_sample_ring_pop(GEyeSampleRing *ring,
+                                     gpointer        records,
+                                     guint           max_records);
+guint           geye_sample_ring_pop_timeout(GEyeSampleRing *ring,
+                                             gpointer        records,
+                                             guint           max_records,
+                                             gint64          timeout_us);
+gpointer        geye_sample_ring_peek(GEyeSampleRing *ring,
+                                      guint          *n_records);
+void            geye_sample_ring_release(GEyeSampleRing *ring,
+                                         guint           n_records);
+
+G_END_DECLS
+
+#endif
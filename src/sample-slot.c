@@ -0,0 +1,99 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "sample-slot.h"
+
+/*
+ * The sample is copied with plain loads and stores, the fences keep it
+ * between the two changes of the sequence number on the writer side and
+ * before the second read of it on the reader side. Without the builtin an
+ * atomic operation is a full barrier.
+ */
+#if defined(__GNUC__)
+#define SLOT_RELEASE_FENCE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define SLOT_ACQUIRE_FENCE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#else
+static gint slot_fence;
+#define SLOT_RELEASE_FENCE() g_atomic_int_inc(&slot_fence)
+#define SLOT_ACQUIRE_FENCE() g_atomic_int_inc(&slot_fence)
+#endif
+
+struct _GEyeSampleSlot {
+    gint                seq;    // odd while a sample is stored
+    GEyeBinocularSample sample;
+};
+
+GEyeSampleSlot*
+geye_sample_slot_new(void)
+{
+    return g_new0(GEyeSampleSlot, 1);
+}
+
+void
+geye_sample_slot_free(GEyeSampleSlot *slot)
+{
+    g_free(slot);
+}
+
+/**
+ * geye_sample_slot_store:
+ * @slot: a GEyeSampleSlot
+ * @sample: the newest sample
+ *
+ * Replaces the sample in the slot. Must only be called from one thread.
+ */
+void
+geye_sample_slot_store(GEyeSampleSlot            *slot,
+                       const GEyeBinocularSample *sample)
+{
+    g_atomic_int_inc(&slot->seq);
+    SLOT_RELEASE_FENCE();
+    slot->sample = *sample;
+    SLOT_RELEASE_FENCE();
+    g_atomic_int_inc(&slot->seq);
+}
+
+/**
+ * geye_sample_slot_load:
+ * @slot: a GEyeSampleSlot
+ * @sample:(out caller-allocates): returns the newest sample
+ *
+ * Returns: FALSE if no sample has been stored yet, @sample is untouched
+ *          then.
+ */
+gboolean
+geye_sample_slot_load(GEyeSampleSlot *slot, GEyeBinocularSample *sample)
+{
+    GEyeBinocularSample copy;
+    gint seq;
+
+    do {
+        while ((seq = g_atomic_int_get(&slot->seq)) & 1)
+            ;
+        copy = slot->sample;
+        SLOT_ACQUIRE_FENCE();
+    } while (g_atomic_int_get(&slot->seq) != seq);
+
+    if (seq == 0)
+        return FALSE;
+
+    *sample = copy;
+    return TRUE;
+}
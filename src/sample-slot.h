@@ -0,0 +1,49 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GEYE_SAMPLE_SLOT_H
+#define GEYE_SAMPLE_SLOT_H
+
+#include "eye-event.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Holds the most recent binocular sample. One thread stores samples, any
+ * number of threads may load the newest one at any time. The slot is
+ * guarded by a sequence lock: storing never waits and loading never blocks,
+ * a reader only retries when it raced with a store.
+ */
+typedef struct _GEyeSampleSlot GEyeSampleSlot;
+
+GEyeSampleSlot* geye_sample_slot_new(void);
+void            geye_sample_slot_free(GEyeSampleSlot *slot);
+
+/* writer side */
+void            geye_sample_slot_store(GEyeSampleSlot            *slot,
+                                       const GEyeBinocularSample *sample);
+
+/* any thread */
+gboolean        geye_sample_slot_load(GEyeSampleSlot       *slot,
+                                      GEyeBinocularSample  *sample);
+
+G_END_DECLS
+
+#endif
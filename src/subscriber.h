@@ -0,0 +1,59 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GEYE_SUBSCRIBER_H
+#define GEYE_SUBSCRIBER_H
+
+#include <glib-object.h>
+#include <gmodule.h>
+#include "eye-event.h"
+
+G_BEGIN_DECLS
+
+/*
+ * The most subscribers that one eyetracker serves at the same time.
+ */
+#define GEYE_MAX_SUBSCRIBERS 32
+
+#define GEYE_TYPE_SUBSCRIBER geye_subscriber_get_type()
+G_MODULE_EXPORT
+G_DECLARE_FINAL_TYPE(GEyeSubscriber, geye_subscriber, GEYE, SUBSCRIBER, GObject)
+
+G_MODULE_EXPORT guint
+geye_subscriber_read(GEyeSubscriber        *subscriber,
+                     GEyeBinocularSample   *samples,
+                     guint                  max_samples,
+                     gint64                 timeout_us);
+
+G_MODULE_EXPORT guint
+geye_subscriber_get_lost(GEyeSubscriber *subscriber);
+
+G_MODULE_EXPORT guint
+geye_subscriber_get_decimation(GEyeSubscriber *subscriber);
+
+G_MODULE_EXPORT gdouble
+geye_subscriber_get_interval(GEyeSubscriber *subscriber);
+
+G_MODULE_EXPORT void
+geye_subscriber_attach(GEyeSubscriber *subscriber, GMainContext *context);
+
+G_END_DECLS
+
+#endif
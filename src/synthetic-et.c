@@ -0,0 +1,506 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include "gaze-model.h"
+#include "sample-output.h"
+#include "synthetic-et.h"
+
+static const char* SYNTHETIC_THREAD_NAME = "GEye-synthetic";
+
+// The generator wakes up at most this often, in µs, and then produces the
+// samples that are due at once, as a link delivers them in blocks.
+#define SYNTHETIC_BLOCK_US 1000
+
+#define SYNTHETIC_MAX_RATE 10000
+
+struct _GEyeSyntheticEt {
+    GObject         parent;
+
+    GMutex          lock;
+    GCond           cond;           // Signals stop
+
+    GEyeGazeModelParams params;     // Lock, used at the next connection
+    gboolean        stop;           // Lock, the generator should return
+
+    GEyeGazeModel  *model;          // The generator uses it while tracking
+    GThread        *generator;      // Main context
+
+    /*
+     * Relates the tracker time of the model to the host time at which it is
+     * generated, set by the generator. Lock.
+     */
+    gint64          anchor_host;    // 0 while not tracking
+    gdouble         anchor_tracker; // ms
+
+    GEyeSampleOutput *output;       // Sends the samples of the generator
+};
+
+static void
+geye_eyetracker_interface_init(GEyeEyetrackerInterface* iface);
+
+G_DEFINE_TYPE_WITH_CODE(GEyeSyntheticEt,
+                        geye_synthetic_et,
+                        G_TYPE_OBJECT,
+                        G_IMPLEMENT_INTERFACE(GEYE_TYPE_EYETRACKER,
+                                              geye_eyetracker_interface_init)
+                        )
+
+typedef enum {
+    PROP_NULL,
+    PROP_RATE,
+    PROP_BINOCULAR,
+    PROP_SEED,
+    PROP_FIXATION_DURATION,
+    PROP_BLINK_RATE,
+    PROP_NOISE,
+    PROP_SAMPLES_GENERATED,
+    N_PROPERTIES
+} GEyeSyntheticEtProperty;
+
+static GParamSpec* obj_properties[N_PROPERTIES] = {NULL, };
+
+static void
+geye_synthetic_et_init(GEyeSyntheticEt* self)
+{
+    g_mutex_init(&self->lock);
+    g_cond_init(&self->cond);
+
+    geye_gaze_model_params_init(&self->params);
+    self->output = geye_sample_output_new(
+            GEYE_EYETRACKER(self),
+            "synthetic eyetracker",
+            obj_properties[PROP_SAMPLES_GENERATED]
+            );
+}
+
+/* ***************************** the generator ****************************** */
+
+/*
+ * Generates the samples that are due at once, then sleeps for at least a
+ * block. The model keeps its position when the generator is stopped, so
+ * the gaze continues where it was when tracking starts again, without a
+ * gap in its time.
+ */
+static gpointer
+synthetic_generator(gpointer data)
+{
+    GEyeSyntheticEt *self = data;
+    GEyeRecord records[GEYE_GAZE_MODEL_MAX_RECORDS];
+    gint64 anchor_host = g_get_monotonic_time();
+    gdouble anchor_time = geye_gaze_model_get_time(self->model);
+
+    g_mutex_lock(&self->lock);
+    self->anchor_host = anchor_host;
+    self->anchor_tracker = anchor_time * 1000;
+    g_mutex_unlock(&self->lock);
+
+    for (;;) {
+        gint64 woke, due;
+
+        g_mutex_lock(&self->lock);
+        if (self->stop) {
+            g_mutex_unlock(&self->lock);
+            break;
+        }
+        g_mutex_unlock(&self->lock);
+
+        woke = g_get_monotonic_time();
+        geye_sample_output_begin(self->output);
+
+        for (;;) {
+            guint n, i;
+
+            due = anchor_host + (gint64) (
+                    (geye_gaze_model_get_time(self->model) - anchor_time) *
+                    G_USEC_PER_SEC
+                    );
+            if (due > woke)
+                break;
+
+            n = geye_gaze_model_step(self->model, records);
+            for (i = 0; i < n; i++)
+                geye_sample_output_record(self->output, &records[i], due, woke);
+        }
+        geye_sample_output_end(self->output);
+
+        g_mutex_lock(&self->lock);
+        if (!self->stop)
+            g_cond_wait_until(
+                    &self->cond, &self->lock,
+                    MAX(due, woke + SYNTHETIC_BLOCK_US)
+                    );
+        g_mutex_unlock(&self->lock);
+    }
+    return NULL;
+}
+
+/* Stops the generator and waits for it, from the main context. */
+static void
+synthetic_et_stop_generator(GEyeSyntheticEt *self)
+{
+    if (!self->generator)
+        return;
+
+    g_mutex_lock(&self->lock);
+    self->stop = TRUE;
+    g_cond_signal(&self->cond);
+    g_mutex_unlock(&self->lock);
+
+    g_thread_join(self->generator);
+    self->generator = NULL;
+}
+
+/* **************************** interface methods *************************** */
+
+/* Connecting starts the model with the current parameters. */
+static void
+synthetic_et_connect(GEyeEyetracker* et, GError** error)
+{
+    GEyeSyntheticEt *self = GEYE_SYNTHETIC_ET(et);
+    gchar *info;
+
+    if (geye_sample_output_get_state(self->output) &
+            GEYE_SAMPLE_OUTPUT_CONNECTED)
+        return;
+
+    g_mutex_lock(&self->lock);
+    self->model = geye_gaze_model_new(&self->params);
+    info = g_strdup_printf(
+            "GEye synthetic gaze, %u Hz %s",
+            self->params.rate,
+            self->params.binocular ? "binocular" : "monocular"
+            );
+    g_mutex_unlock(&self->lock);
+
+    geye_sample_output_set_info(self->output, info);
+    g_free(info);
+    geye_sample_output_update_state(
+            self->output, 0, GEYE_SAMPLE_OUTPUT_CONNECTED
+            );
+}
+
+static void
+synthetic_et_disconnect(GEyeEyetracker* et)
+{
+    GEyeSyntheticEt *self = GEYE_SYNTHETIC_ET(et);
+
+    if (!(geye_sample_output_get_state(self->output) &
+                GEYE_SAMPLE_OUTPUT_CONNECTED))
+        return;
+
+    geye_eyetracker_stop_tracking(et);
+    g_clear_pointer(&self->model, geye_gaze_model_free);
+    geye_sample_output_update_state(self->output, ~0, 0);
+}
+
+static void
+synthetic_et_start_tracking(GEyeEyetracker* et, GError** error)
+{
+    GEyeSyntheticEt *self = GEYE_SYNTHETIC_ET(et);
+
+    if (!geye_sample_output_check_connected(
+                self->output, "start tracking", error))
+        return;
+    if (self->generator)
+        return;
+
+    geye_sample_output_prefault(self->output);
+
+    self->stop = FALSE;
+    self->generator = g_thread_new(
+            SYNTHETIC_THREAD_NAME, synthetic_generator, self
+            );
+    geye_sample_output_update_state(
+            self->output, 0, GEYE_SAMPLE_OUTPUT_TRACKING
+            );
+}
+
+static void
+synthetic_et_stop_tracking(GEyeEyetracker* et)
+{
+    GEyeSyntheticEt *self = GEYE_SYNTHETIC_ET(et);
+
+    if (!self->generator)
+        return;
+
+    synthetic_et_stop_generator(self);
+    g_mutex_lock(&self->lock);
+    self->anchor_host = 0;
+    g_mutex_unlock(&self->lock);
+    geye_sample_output_update_state(
+            self->output, GEYE_SAMPLE_OUTPUT_TRACKING, 0
+            );
+}
+
+/* The host time at which a tracker time is generated, 0 while not tracking. */
+static gint64
+synthetic_et_tracker_to_host_time(GEyeEyetracker* et, gdouble tracker_time)
+{
+    GEyeSyntheticEt *self = GEYE_SYNTHETIC_ET(et);
+    gint64 host = 0;
+
+    g_mutex_lock(&self->lock);
+    if (self->anchor_host)
+        host = self->anchor_host + (gint64) (
+                (tracker_time - self->anchor_tracker) * 1000
+                );
+    g_mutex_unlock(&self->lock);
+    return host;
+}
+
+static void
+geye_eyetracker_interface_init(GEyeEyetrackerInterface* iface)
+{
+    geye_sample_output_interface_init(iface);
+
+    iface->connect          = synthetic_et_connect;
+    iface->disconnect       = synthetic_et_disconnect;
+
+    iface->start_tracking   = synthetic_et_start_tracking;
+    iface->stop_tracking    = synthetic_et_stop_tracking;
+
+    iface->tracker_to_host_time = synthetic_et_tracker_to_host_time;
+}
+
+/* ******************************* GObject ********************************** */
+
+static void
+synthetic_et_dispose(GObject* gobject)
+{
+    GEyeSyntheticEt* self = GEYE_SYNTHETIC_ET(gobject);
+
+    synthetic_et_stop_generator(self);
+    g_clear_pointer(&self->model, geye_gaze_model_free);
+
+    // The generator is gone, drop its references.
+    geye_sample_output_dispose(self->output);
+
+    G_OBJECT_CLASS(geye_synthetic_et_parent_class)->dispose(gobject);
+}
+
+static void
+synthetic_et_finalize(GObject* gobject)
+{
+    GEyeSyntheticEt* self = GEYE_SYNTHETIC_ET(gobject);
+
+    geye_sample_output_free(self->output);
+    g_cond_clear(&self->cond);
+    g_mutex_clear(&self->lock);
+
+    G_OBJECT_CLASS(geye_synthetic_et_parent_class)->finalize(gobject);
+}
+
+static void
+geye_synthetic_et_set_property(GObject        *obj,
+                               guint           property_id,
+                               const GValue   *value,
+                               GParamSpec     *pspec
+                               )
+{
+    GEyeSyntheticEt* self = GEYE_SYNTHETIC_ET(obj);
+    GEyeGazeModelParams *params = &self->params;
+
+    g_mutex_lock(&self->lock);
+    switch((GEyeSyntheticEtProperty) property_id) {
+        case PROP_RATE:
+            params->rate = g_value_get_uint(value);
+            break;
+        case PROP_BINOCULAR:
+            params->binocular = g_value_get_boolean(value);
+            break;
+        case PROP_SEED:
+            params->seed = g_value_get_uint(value);
+            break;
+        case PROP_FIXATION_DURATION:
+            params->fixation_duration = g_value_get_double(value);
+            break;
+        case PROP_BLINK_RATE:
+            params->blink_rate = g_value_get_double(value);
+            break;
+        case PROP_NOISE:
+            params->noise = g_value_get_double(value);
+            break;
+        case PROP_SAMPLES_GENERATED:
+        case PROP_NULL:
+        case N_PROPERTIES:
+        default:
+            if (!geye_sample_output_set_property(
+                        self->output, property_id - N_PROPERTIES, value))
+                G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, property_id, pspec);
+    }
+    g_mutex_unlock(&self->lock);
+}
+
+static void
+geye_synthetic_et_get_property(GObject        *obj,
+                               guint           property_id,
+                               GValue         *value,
+                               GParamSpec     *pspec
+                               )
+{
+    GEyeSyntheticEt* self = GEYE_SYNTHETIC_ET(obj);
+    GEyeGazeModelParams params;
+
+    g_mutex_lock(&self->lock);
+    params = self->params;
+    g_mutex_unlock(&self->lock);
+
+    switch((GEyeSyntheticEtProperty) property_id) {
+        case PROP_RATE:
+            g_value_set_uint(value, params.rate);
+            break;
+        case PROP_BINOCULAR:
+            g_value_set_boolean(value, params.binocular);
+            break;
+        case PROP_SEED:
+            g_value_set_uint(value, params.seed);
+            break;
+        case PROP_FIXATION_DURATION:
+            g_value_set_double(value, params.fixation_duration);
+            break;
+        case PROP_BLINK_RATE:
+            g_value_set_double(value, params.blink_rate);
+            break;
+        case PROP_NOISE:
+            g_value_set_double(value, params.noise);
+            break;
+        case PROP_SAMPLES_GENERATED:
+            g_value_set_uint(
+                    value, geye_sample_output_get_produced(self->output)
+                    );
+            break;
+        case PROP_NULL:
+        case N_PROPERTIES:
+        default:
+            if (!geye_sample_output_get_property(
+                        self->output, property_id - N_PROPERTIES, value))
+                G_OBJECT_WARN_INVALID_PROPERTY_ID(obj, property_id, pspec);
+    }
+}
+
+static void
+geye_synthetic_et_class_init(GEyeSyntheticEtClass* klass)
+{
+    GObjectClass* object_class = G_OBJECT_CLASS(klass);
+    object_class->dispose = synthetic_et_dispose;
+    object_class->finalize = synthetic_et_finalize;
+    object_class->get_property = geye_synthetic_et_get_property;
+    object_class->set_property = geye_synthetic_et_set_property;
+
+    obj_properties[PROP_RATE] = g_param_spec_uint(
+            "rate",
+            "Rate",
+            "The number of samples per second.",
+            1, SYNTHETIC_MAX_RATE,
+            GEYE_GAZE_MODEL_DEFAULT_RATE,
+            G_PARAM_READWRITE
+            );
+
+    obj_properties[PROP_BINOCULAR] = g_param_spec_boolean(
+            "binocular",
+            "Binocular",
+            "Whether both eyes are tracked, otherwise the left eye only.",
+            TRUE,
+            G_PARAM_READWRITE
+            );
+
+    obj_properties[PROP_SEED] = g_param_spec_uint(
+            "seed",
+            "Seed",
+            "The seed of the random numbers of the model.",
+            0, G_MAXUINT32,
+            0,
+            G_PARAM_READWRITE
+            );
+
+    /**
+     * GEyeSyntheticEt:fixation-duration:
+     *
+     * The mean duration of a fixation in ms. A fixation lasts at least
+     * 80 ms, the rest of its duration is exponentially distributed.
+     */
+    obj_properties[PROP_FIXATION_DURATION] = g_param_spec_double(
+            "fixation-duration",
+            "Fixation duration",
+            "The mean duration of a fixation in ms.",
+            GEYE_GAZE_MODEL_MIN_FIXATION, G_MAXDOUBLE,
+            GEYE_GAZE_MODEL_DEFAULT_FIXATION,
+            G_PARAM_READWRITE
+            );
+
+    obj_properties[PROP_BLINK_RATE] = g_param_spec_double(
+            "blink-rate",
+            "Blink rate",
+            "The number of blinks per second of fixation.",
+            0, G_MAXDOUBLE,
+            GEYE_GAZE_MODEL_DEFAULT_BLINK_RATE,
+            G_PARAM_READWRITE
+            );
+
+    obj_properties[PROP_NOISE] = g_param_spec_double(
+            "noise",
+            "Noise",
+            "The standard deviation of the noise on the gaze in degrees.",
+            0, G_MAXDOUBLE,
+            GEYE_GAZE_MODEL_DEFAULT_NOISE,
+            G_PARAM_READWRITE
+            );
+
+    obj_properties[PROP_SAMPLES_GENERATED] = g_param_spec_uint(
+            "samples-generated",
+            "Samples generated",
+            "The number of samples the model generated, "
+            "changes are notified at most four times per second.",
+            0, G_MAXUINT,
+            0,
+            G_PARAM_READABLE
+            );
+
+    g_object_class_install_properties(
+            object_class, N_PROPERTIES, obj_properties
+            );
+
+    geye_sample_output_override_properties(object_class, N_PROPERTIES);
+}
+
+/* ***************************** public functions *************************** */
+
+/**
+ * geye_synthetic_et_new:(constructor)
+ *
+ * Returns:(transfer full): a new GEyeSyntheticEt*
+ */
+GEyeSyntheticEt*
+geye_synthetic_et_new(void)
+{
+    return g_object_new(GEYE_TYPE_SYNTHETIC_ET, NULL);
+}
+
+/**
+ * geye_synthetic_et_destroy:(destructor)
+ * @self: the #GEyeSyntheticEt instance to destroy.
+ *
+ * Drops a reference on self.
+ */
+void
+geye_synthetic_et_destroy(GEyeSyntheticEt *self)
+{
+    g_object_unref(self);
+}
@@ -0,0 +1,58 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GEYE_SYNTHETIC_ET_H
+#define GEYE_SYNTHETIC_ET_H
+
+#include "eyetracker.h"
+
+G_BEGIN_DECLS
+
+/**
+ * GEyeSyntheticEt:
+ *
+ * An eyetracker that generates gaze from a parametric model: fixations with
+ * drift and tremor, saccades that follow the main sequence, blinks and
+ * measurement noise. It produces samples in real time at up to 10 kHz, of
+ * one or both eyes, with the same signals, geye_eyetracker_read_samples(),
+ * subscribers and areas of interest as a live eyetracker.
+ *
+ * The fixations and saccades it emits are the ground truth of the model,
+ * not detected from the noisy samples, so they are the known answer for an
+ * online detector that runs on the samples. Compare
+ * #GEyeSyntheticEt:samples-generated with #GEyeEyetracker:samples-dropped
+ * to see how much of a load the signal path keeps up with.
+ *
+ * The parameters of the model take effect at the next connection. The same
+ * #GEyeSyntheticEt:seed gives the same gaze.
+ */
+#define GEYE_TYPE_SYNTHETIC_ET geye_synthetic_et_get_type()
+G_MODULE_EXPORT
+G_DECLARE_FINAL_TYPE(GEyeSyntheticEt, geye_synthetic_et, GEYE, SYNTHETIC_ET, GObject)
+
+G_MODULE_EXPORT GEyeSyntheticEt*
+geye_synthetic_et_new(void);
+
+G_MODULE_EXPORT void
+geye_synthetic_et_destroy(GEyeSyntheticEt *self);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,95 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include "allocation-counter.h"
+
+#if defined(HAVE_ALLOCATION_COUNTER)
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t n, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+extern void  __libc_free(void* ptr);
+
+static gint count_allocations;
+static gint num_allocations;
+
+static inline void
+count_allocation(void)
+{
+    if (g_atomic_int_get(&count_allocations))
+        g_atomic_int_inc(&num_allocations);
+}
+
+void*
+malloc(size_t size)
+{
+    count_allocation();
+    return __libc_malloc(size);
+}
+
+void*
+calloc(size_t n, size_t size)
+{
+    count_allocation();
+    return __libc_calloc(n, size);
+}
+
+void*
+realloc(void* ptr, size_t size)
+{
+    count_allocation();
+    return __libc_realloc(ptr, size);
+}
+
+int
+posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    count_allocation();
+    *ptr = __libc_memalign(alignment, size);
+    return *ptr ? 0 : ENOMEM;
+}
+
+void
+free(void* ptr)
+{
+    __libc_free(ptr);
+}
+
+void
+allocation_counter_start(void)
+{
+    g_atomic_int_set(&num_allocations, 0);
+    g_atomic_int_set(&count_allocations, TRUE);
+}
+
+/*
+ * Returns the number of allocations since allocation_counter_start().
+ */
+guint
+allocation_counter_stop(void)
+{
+    g_atomic_int_set(&count_allocations, FALSE);
+    return g_atomic_int_get(&num_allocations);
+}
+
+#endif
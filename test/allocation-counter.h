@@ -0,0 +1,42 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#ifndef GEYE_ALLOCATION_COUNTER_H
+#define GEYE_ALLOCATION_COUNTER_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Counts the allocations of all threads of the test by interposing the
+ * allocator of glibc, g_mem_set_vtable() is a no-op in current GLib. Link
+ * allocation-counter.c into the test to use it.
+ */
+#if defined(__GLIBC__)
+#define HAVE_ALLOCATION_COUNTER 1
+
+void    allocation_counter_start(void);
+guint   allocation_counter_stop(void);
+#endif
+
+G_END_DECLS
+
+#endif
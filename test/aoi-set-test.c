@@ -0,0 +1,259 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <aoi-set.h>
+#include <aoi-set-private.h>
+#include <locale.h>
+
+typedef struct {
+    guint       aoi;
+    gboolean    enter;
+    gdouble     time;
+    gdouble     dwell;
+} Transition;
+
+static void
+record_transition(GEyeAoiSet   *set,
+                  guint         aoi,
+                  gboolean      enter,
+                  gdouble       time,
+                  gdouble       dwell,
+                  gpointer      data)
+{
+    (void) set;
+    Transition t = {aoi, enter, time, dwell};
+    g_array_append_val((GArray*) data, t);
+}
+
+static void
+aoi_set_shapes(void)
+{
+    GEyeAoiSet *set = geye_aoi_set_new();
+    const gdouble triangle[] = {0, 0, 100, 0, 0, 100};
+    guint rect, ellipse, polygon;
+
+    rect = geye_aoi_set_add_rectangle(set, 10, 20, 30, 40);
+    ellipse = geye_aoi_set_add_ellipse(set, 100, 100, 50, 25);
+    polygon = geye_aoi_set_add_polygon(set, triangle, 3);
+
+    g_assert_cmpuint(geye_aoi_set_get_size(set), ==, 3);
+    g_assert_cmpint(geye_aoi_set_get_shape(set, rect), ==, GEYE_AOI_RECTANGLE);
+    g_assert_cmpint(geye_aoi_set_get_shape(set, ellipse), ==, GEYE_AOI_ELLIPSE);
+    g_assert_cmpint(geye_aoi_set_get_shape(set, polygon), ==, GEYE_AOI_POLYGON);
+
+    g_assert_true(geye_aoi_set_contains(set, rect, 10, 20));
+    g_assert_true(geye_aoi_set_contains(set, rect, 39, 59));
+    g_assert_false(geye_aoi_set_contains(set, rect, 40, 20));
+
+    g_assert_true(geye_aoi_set_contains(set, ellipse, 100, 100));
+    g_assert_true(geye_aoi_set_contains(set, ellipse, 140, 100));
+    g_assert_false(geye_aoi_set_contains(set, ellipse, 140, 120));
+
+    g_assert_true(geye_aoi_set_contains(set, polygon, 10, 10));
+    g_assert_false(geye_aoi_set_contains(set, polygon, 60, 60));
+
+    g_object_unref(set);
+}
+
+static void
+aoi_set_transitions(void)
+{
+    GEyeAoiSet *set = geye_aoi_set_new();
+    GArray *transitions = g_array_new(FALSE, FALSE, sizeof(Transition));
+    Transition *t;
+    guint left, right, overlap;
+
+    left = geye_aoi_set_add_rectangle(set, 0, 0, 100, 100);
+    right = geye_aoi_set_add_rectangle(set, 200, 0, 100, 100);
+    overlap = geye_aoi_set_add_ellipse(set, 100, 50, 30, 30);
+    geye_aoi_set_seal(set);
+    g_assert_true(geye_aoi_set_is_sealed(set));
+
+    geye_aoi_set_update(set, 50, 50, 1.0, record_transition, transitions);
+    g_assert_cmpuint(transitions->len, ==, 1);
+    t = &g_array_index(transitions, Transition, 0);
+    g_assert_cmpuint(t->aoi, ==, left);
+    g_assert_true(t->enter);
+
+    // Staying inside reports nothing.
+    geye_aoi_set_update(set, 55, 50, 1.5, record_transition, transitions);
+    g_assert_cmpuint(transitions->len, ==, 1);
+
+    // Into the overlap of two areas.
+    geye_aoi_set_update(set, 90, 50, 2.0, record_transition, transitions);
+    g_assert_cmpuint(transitions->len, ==, 2);
+    t = &g_array_index(transitions, Transition, 1);
+    g_assert_cmpuint(t->aoi, ==, overlap);
+    g_assert_true(t->enter);
+
+    // Leave both for the right one, the leaves come first.
+    geye_aoi_set_update(set, 250, 50, 3.0, record_transition, transitions);
+    g_assert_cmpuint(transitions->len, ==, 5);
+    for (guint i = 2; i < 4; i++) {
+        t = &g_array_index(transitions, Transition, i);
+        g_assert_false(t->enter);
+        g_assert_cmpfloat(t->time, ==, 3.0);
+        if (t->aoi == left)
+            g_assert_cmpfloat(t->dwell, ==, 2.0);
+        else
+            g_assert_cmpfloat(t->dwell, ==, 1.0);
+    }
+    t = &g_array_index(transitions, Transition, 4);
+    g_assert_cmpuint(t->aoi, ==, right);
+    g_assert_true(t->enter);
+
+    geye_aoi_set_leave_all(set, 3.5, record_transition, transitions);
+    g_assert_cmpuint(transitions->len, ==, 6);
+    t = &g_array_index(transitions, Transition, 5);
+    g_assert_cmpuint(t->aoi, ==, right);
+    g_assert_false(t->enter);
+    g_assert_cmpfloat(t->dwell, ==, 0.5);
+
+    g_array_unref(transitions);
+    g_object_unref(set);
+}
+
+static void
+on_aoi_leave(GEyeAoiSet *set, guint aoi, gdouble time, gdouble dwell,
+             gpointer data)
+{
+    (void) set;
+    (void) aoi;
+    (void) time;
+    *(gdouble*) data += dwell;
+}
+
+static void
+aoi_set_dwell(void)
+{
+    GEyeAoiSet *set = geye_aoi_set_new();
+    gdouble signalled = 0;
+    guint aoi = geye_aoi_set_add_rectangle(set, 0, 0, 10, 10);
+
+    geye_aoi_set_seal(set);
+    g_signal_connect(set, "aoi-leave", G_CALLBACK(on_aoi_leave), &signalled);
+
+    geye_aoi_set_emit_enter(set, aoi, 1.0);
+    geye_aoi_set_emit_leave(set, aoi, 1.25, 0.25);
+    geye_aoi_set_emit_enter(set, aoi, 2.0);
+    geye_aoi_set_emit_leave(set, aoi, 2.5, 0.5);
+
+    g_assert_cmpfloat(geye_aoi_set_get_dwell_time(set, aoi), ==, 0.75);
+    g_assert_cmpfloat(signalled, ==, 0.75);
+
+    geye_aoi_set_reset_dwell_times(set);
+    g_assert_cmpfloat(geye_aoi_set_get_dwell_time(set, aoi), ==, 0);
+
+    g_object_unref(set);
+}
+
+/*
+ * The grid must find exactly the areas that a test of all areas finds.
+ */
+static void
+aoi_set_grid(void)
+{
+    GEyeAoiSet *set = geye_aoi_set_new();
+    GArray *transitions = g_array_new(FALSE, FALSE, sizeof(Transition));
+    GRand *rand = g_rand_new_with_seed(42);
+    guint n_aois = 500, i, j;
+    gboolean *inside = g_new0(gboolean, n_aois);
+
+    for (i = 0; i < n_aois; i++) {
+        gdouble x = g_rand_double_range(rand, 0, 1920);
+        gdouble y = g_rand_double_range(rand, 0, 1080);
+        gdouble w = g_rand_double_range(rand, 1, 200);
+        gdouble h = g_rand_double_range(rand, 1, 200);
+        if (i % 2)
+            geye_aoi_set_add_rectangle(set, x, y, w, h);
+        else
+            geye_aoi_set_add_ellipse(set, x, y, w, h);
+    }
+    geye_aoi_set_seal(set);
+
+    for (i = 0; i < 2000; i++) {
+        gdouble x = g_rand_double_range(rand, -100, 2020);
+        gdouble y = g_rand_double_range(rand, -100, 1180);
+
+        g_array_set_size(transitions, 0);
+        geye_aoi_set_update(set, x, y, i, record_transition, transitions);
+        for (j = 0; j < transitions->len; j++) {
+            Transition *t = &g_array_index(transitions, Transition, j);
+            g_assert_cmpint(inside[t->aoi], !=, t->enter);
+            inside[t->aoi] = t->enter;
+        }
+        for (j = 0; j < n_aois; j++)
+            g_assert_cmpint(inside[j], ==, geye_aoi_set_contains(set, j, x, y));
+    }
+
+    g_free(inside);
+    g_rand_free(rand);
+    g_array_unref(transitions);
+    g_object_unref(set);
+}
+
+/*
+ * A set is used by one eyetracker at a time, which may hand it to its
+ * thread more than once.
+ */
+static void
+aoi_set_attach(void)
+{
+    GEyeAoiSet *set = geye_aoi_set_new();
+    gint first, second;
+
+    geye_aoi_set_add_rectangle(set, 0, 0, 10, 10);
+    g_assert_true(geye_aoi_set_attach(set, &first));
+    g_assert_true(geye_aoi_set_is_sealed(set));
+    g_assert_true(geye_aoi_set_attach(set, &first));
+
+    g_test_expect_message(
+            G_LOG_DOMAIN, G_LOG_LEVEL_CRITICAL, "*another eyetracker*"
+            );
+    g_assert_false(geye_aoi_set_attach(set, &second));
+    g_test_assert_expected_messages();
+
+    geye_aoi_set_detach(set);
+    g_test_expect_message(
+            G_LOG_DOMAIN, G_LOG_LEVEL_CRITICAL, "*another eyetracker*"
+            );
+    g_assert_false(geye_aoi_set_attach(set, &second));
+    g_test_assert_expected_messages();
+
+    geye_aoi_set_detach(set);
+    g_assert_true(geye_aoi_set_attach(set, &second));
+    geye_aoi_set_detach(set);
+
+    g_object_unref(set);
+}
+
+int main(int argc, char** argv)
+{
+    setlocale(LC_ALL, "");
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/AoiSet/shapes", aoi_set_shapes);
+    g_test_add_func("/AoiSet/transitions", aoi_set_transitions);
+    g_test_add_func("/AoiSet/dwell", aoi_set_dwell);
+    g_test_add_func("/AoiSet/grid", aoi_set_grid);
+    g_test_add_func("/AoiSet/attach", aoi_set_attach);
+
+    return g_test_run();
+}
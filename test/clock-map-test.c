@@ -0,0 +1,103 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <clock-map.h>
+#include <locale.h>
+
+// The tracker clock runs 50 ppm fast and started 12.5 s after the host.
+static const gdouble    TRACKER_RATE = 1.00005;
+static const gint64     HOST_START = 12500000;
+
+static gdouble
+tracker_time(gint64 host_us)
+{
+    return (host_us - HOST_START) * TRACKER_RATE;
+}
+
+static void
+clock_map_invalid(void)
+{
+    GEyeClockMap *map = geye_clock_map_new();
+    g_assert_false(geye_clock_map_is_valid(map));
+    g_assert_cmpint(geye_clock_map_to_host(map, 1000), ==, 0);
+
+    geye_clock_map_update(map, 1000, 2000);
+    g_assert_true(geye_clock_map_is_valid(map));
+    g_assert_cmpint(geye_clock_map_to_host(map, 1500), ==, 2500);
+
+    geye_clock_map_reset(map);
+    g_assert_false(geye_clock_map_is_valid(map));
+    geye_clock_map_free(map);
+}
+
+static void
+clock_map_drift(void)
+{
+    GEyeClockMap *map = geye_clock_map_new();
+    GRand *rand = g_rand_new_with_seed(42);
+    gint64 host;
+
+    // Ten seconds of drains every millisecond, reading the clocks jitters
+    // up to 20 µs.
+    for (host = HOST_START; host < HOST_START + 10000000; host += 1000) {
+        gint64 jitter = g_rand_int_range(rand, 0, 20);
+        geye_clock_map_update(map, tracker_time(host), host + jitter);
+    }
+
+    g_assert_cmpfloat_with_epsilon(
+            geye_clock_map_get_slope(map), 1 / TRACKER_RATE, 1e-5
+            );
+    // A sample that the tracker took a little while ago.
+    host -= 2000;
+    g_assert_cmpint(
+            ABS(geye_clock_map_to_host(map, tracker_time(host)) - host), <, 50
+            );
+
+    g_rand_free(rand);
+    geye_clock_map_free(map);
+}
+
+static void
+clock_map_tracker_restart(void)
+{
+    GEyeClockMap *map = geye_clock_map_new();
+    gint64 host;
+
+    for (host = HOST_START; host < HOST_START + 1000000; host += 1000)
+        geye_clock_map_update(map, tracker_time(host), host);
+
+    // The tracker application restarts its clock at 0.
+    geye_clock_map_update(map, 0, host);
+    g_assert_cmpint(geye_clock_map_to_host(map, 1000), ==, host + 1000);
+
+    geye_clock_map_free(map);
+}
+
+int main(int argc, char** argv)
+{
+    setlocale(LC_ALL, "");
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/ClockMap/invalid", clock_map_invalid);
+    g_test_add_func("/ClockMap/drift", clock_map_drift);
+    g_test_add_func("/ClockMap/tracker_restart", clock_map_tracker_restart);
+
+    return g_test_run();
+}
@@ -19,7 +19,12 @@
  */
 
 #include <geye.h>
+#include <glib/gstdio.h>
 #include <locale.h>
+#ifdef GEYE_FAKE_EYELINK
+#include <fake-eyelink.h>
+#endif
+#include "allocation-counter.h"
 
 typedef struct {
     GEyeEyelinkEt  *et;
@@ -70,6 +75,508 @@ eyelink_create(void)
     g_object_unref(et);
 }
 
+static void
+eyelink_sample_delivery(void)
+{
+    GEyeEyelinkEt  *et;
+    guint           delivery, fields, dropped;
+    GEyeDropPolicy  policy;
+
+    et = geye_eyelink_et_new();
+
+    g_object_get(et, "sample-delivery", &delivery, NULL);
+    g_assert_cmpuint(delivery, ==, GEYE_DELIVER_SAMPLES);
+
+    g_object_set(et,
+                 "sample-delivery", GEYE_DELIVER_SAMPLE | GEYE_DELIVER_SAMPLES,
+                 NULL);
+    g_object_get(et, "sample-delivery", &delivery, NULL);
+    g_assert_cmpuint(delivery, ==, GEYE_DELIVER_SAMPLE | GEYE_DELIVER_SAMPLES);
+
+    g_object_get(et, "sample-fields", &fields, NULL);
+    g_assert_cmpuint(fields, ==, GEYE_SAMPLE_FIELD_NONE);
+    g_object_set(et,
+                 "sample-fields", GEYE_SAMPLE_FIELD_PUPIL | GEYE_SAMPLE_FIELD_HREF,
+                 NULL);
+    g_object_get(et, "sample-fields", &fields, NULL);
+    g_assert_cmpuint(fields, ==, GEYE_SAMPLE_FIELD_PUPIL | GEYE_SAMPLE_FIELD_HREF);
+
+    g_object_get(et, "drop-policy", &policy, "samples-dropped", &dropped, NULL);
+    g_assert_cmpint(policy, ==, GEYE_DROP_NEWEST);
+    g_assert_cmpuint(dropped, ==, 0);
+    g_object_set(et, "drop-policy", GEYE_DROP_COALESCE, NULL);
+    g_object_get(et, "drop-policy", &policy, NULL);
+    g_assert_cmpint(policy, ==, GEYE_DROP_COALESCE);
+
+    geye_eyelink_et_destroy(et);
+}
+
+static void
+eyelink_latency_mode(void)
+{
+    GEyeEyelinkEt  *et;
+    GEyeLatencyMode mode;
+    guint           spin_time, latency;
+
+    et = geye_eyelink_et_new();
+
+    g_object_get(et,
+                 "latency-mode", &mode,
+                 "dispatch-latency", &latency,
+                 NULL);
+    g_assert_cmpint(mode, ==, GEYE_LATENCY_MODE_SLEEP);
+    g_assert_cmpuint(latency, ==, 0);
+
+    g_object_set(et,
+                 "latency-mode", GEYE_LATENCY_MODE_HYBRID,
+                 "spin-time", 250,
+                 NULL);
+    g_object_get(et,
+                 "latency-mode", &mode,
+                 "spin-time", &spin_time,
+                 NULL);
+    g_assert_cmpint(mode, ==, GEYE_LATENCY_MODE_HYBRID);
+    g_assert_cmpuint(spin_time, ==, 250);
+
+    geye_eyelink_et_destroy(et);
+}
+
+static void
+eyelink_fixation_detection(void)
+{
+    GEyeEyelinkEt          *et;
+    GEyeFixationDetection   detection;
+    gdouble                 velocity, dispersion;
+    guint                   duration;
+
+    et = geye_eyelink_et_new();
+
+    g_object_get(et, "fixation-detection", &detection, NULL);
+    g_assert_cmpint(detection, ==, GEYE_FIXATION_DETECTION_NONE);
+
+    g_object_set(et,
+                 "fixation-detection", GEYE_FIXATION_DETECTION_DISPERSION,
+                 "fixation-velocity", 1500.0,
+                 "fixation-dispersion", 40.0,
+                 "fixation-duration", 80,
+                 NULL);
+    g_object_get(et,
+                 "fixation-detection", &detection,
+                 "fixation-velocity", &velocity,
+                 "fixation-dispersion", &dispersion,
+                 "fixation-duration", &duration,
+                 NULL);
+    g_assert_cmpint(detection, ==, GEYE_FIXATION_DETECTION_DISPERSION);
+    g_assert_cmpfloat(velocity, ==, 1500.0);
+    g_assert_cmpfloat(dispersion, ==, 40.0);
+    g_assert_cmpuint(duration, ==, 80);
+
+    geye_eyelink_et_destroy(et);
+}
+
+static void
+eyelink_subscribe(void)
+{
+    GEyeEyelinkEt  *et = geye_eyelink_et_new();
+    GEyeEyetracker *tracker = GEYE_EYETRACKER(et);
+    GEyeSubscriber *display, *all;
+    GEyeBinocularSample sample;
+    GError         *error = NULL;
+
+    display = geye_eyetracker_subscribe(tracker, 1, 1 / 60.0, &error);
+    g_assert_no_error(error);
+    all = geye_eyetracker_subscribe(tracker, 1, 0, &error);
+    g_assert_no_error(error);
+    g_assert_cmpfloat(geye_subscriber_get_interval(display), ==, 1 / 60.0);
+
+    // Without a connection there are no samples.
+    g_assert_cmpuint(geye_subscriber_read(all, &sample, 1, 1000), ==, 0);
+    g_assert_cmpuint(geye_subscriber_get_lost(all), ==, 0);
+
+    // A subscriber may outlive the eyetracker.
+    geye_eyelink_et_destroy(et);
+    g_assert_cmpuint(geye_subscriber_read(display, &sample, 1, 0), ==, 0);
+    g_object_unref(display);
+    g_object_unref(all);
+}
+
+static void
+eyelink_latency_stats(void)
+{
+    GEyeEyelinkEt  *et = geye_eyelink_et_new();
+    GEyeEyetracker *tracker = GEYE_EYETRACKER(et);
+    GEyeLatencyStats stats;
+    GEyeLatencyStage stage;
+
+    // Without a connection nothing has been measured.
+    for (stage = GEYE_LATENCY_LINK; stage < GEYE_LATENCY_N_STAGES; stage++) {
+        g_assert_true(
+                geye_eyetracker_get_latency_stats(tracker, stage, &stats)
+                );
+        g_assert_cmpuint(stats.count, ==, 0);
+    }
+    geye_eyetracker_reset_latency_stats(tracker);
+    g_assert_true(
+            geye_eyetracker_get_latency_stats(
+                tracker, GEYE_LATENCY_TOTAL, &stats
+                )
+            );
+    g_assert_cmpuint(stats.count, ==, 0);
+
+    geye_eyelink_et_destroy(et);
+}
+
+static void
+eyelink_counters(void)
+{
+    GEyeEyelinkEt *et = geye_eyelink_et_new();
+    const gchar *counters[] = {
+        "samples-drained",
+        "samples-dispatched",
+        "samples-dropped",
+        "events-parsed",
+        "command-queue-depth",
+        "frames-converted",
+        "max-drain-time"
+    };
+    guint value, i;
+
+    // Without a connection nothing has been counted.
+    for (i = 0; i < G_N_ELEMENTS(counters); i++) {
+        value = G_MAXUINT;
+        g_object_get(et, counters[i], &value, NULL);
+        g_assert_cmpuint(value, ==, 0);
+    }
+
+    geye_eyelink_et_destroy(et);
+}
+
+static void
+eyelink_smoothing(void)
+{
+    GEyeEyelinkEt  *et;
+    GEyeSmoothing   smoothing;
+    guint           window;
+    gdouble         min_cutoff, beta;
+
+    et = geye_eyelink_et_new();
+
+    g_object_get(et, "smoothing", &smoothing, NULL);
+    g_assert_cmpint(smoothing, ==, GEYE_SMOOTHING_NONE);
+
+    g_object_set(et,
+                 "smoothing", GEYE_SMOOTHING_ONE_EURO,
+                 "smoothing-window", 9,
+                 "smoothing-min-cutoff", 0.5,
+                 "smoothing-beta", 0.02,
+                 NULL);
+    g_object_get(et,
+                 "smoothing", &smoothing,
+                 "smoothing-window", &window,
+                 "smoothing-min-cutoff", &min_cutoff,
+                 "smoothing-beta", &beta,
+                 NULL);
+    g_assert_cmpint(smoothing, ==, GEYE_SMOOTHING_ONE_EURO);
+    g_assert_cmpuint(window, ==, 9);
+    g_assert_cmpfloat(min_cutoff, ==, 0.5);
+    g_assert_cmpfloat(beta, ==, 0.02);
+
+    geye_eyelink_et_destroy(et);
+}
+
+static void
+eyelink_differentiator(void)
+{
+    GEyeEyelinkEt      *et;
+    GEyeDifferentiator  differentiator;
+    guint               window;
+
+    et = geye_eyelink_et_new();
+
+    g_object_get(et, "differentiator", &differentiator, NULL);
+    g_assert_cmpint(differentiator, ==, GEYE_DIFFERENTIATOR_FIVE_POINT);
+
+    g_object_set(et,
+                 "differentiator", GEYE_DIFFERENTIATOR_SAVITZKY_GOLAY,
+                 "differentiator-window", 11,
+                 "sample-fields", GEYE_SAMPLE_FIELD_VELOCITY,
+                 NULL);
+    g_object_get(et,
+                 "differentiator", &differentiator,
+                 "differentiator-window", &window,
+                 NULL);
+    g_assert_cmpint(differentiator, ==, GEYE_DIFFERENTIATOR_SAVITZKY_GOLAY);
+    g_assert_cmpuint(window, ==, 11);
+
+    geye_eyelink_et_destroy(et);
+}
+
+static void
+eyelink_aoi_set(void)
+{
+    GEyeEyelinkEt  *et = geye_eyelink_et_new();
+    GEyeEyetracker *tracker = GEYE_EYETRACKER(et);
+    GEyeAoiSet     *first = geye_aoi_set_new();
+    GEyeAoiSet     *second = geye_aoi_set_new();
+
+    geye_aoi_set_add_rectangle(first, 0, 0, 100, 100);
+    geye_aoi_set_add_ellipse(second, 50, 50, 10, 10);
+    g_object_add_weak_pointer(G_OBJECT(first), (gpointer*) &first);
+    g_object_add_weak_pointer(G_OBJECT(second), (gpointer*) &second);
+
+    g_assert_null(geye_eyetracker_get_aoi_set(tracker));
+    geye_eyetracker_set_aoi_set(tracker, first);
+    g_assert_true(geye_eyetracker_get_aoi_set(tracker) == first);
+
+    // Swapping while attached and detaching.
+    geye_eyetracker_set_aoi_set(tracker, second);
+    g_assert_true(geye_eyetracker_get_aoi_set(tracker) == second);
+    g_object_unref(first);
+    g_object_unref(second);
+    geye_eyetracker_set_aoi_set(tracker, NULL);
+    g_assert_null(geye_eyetracker_get_aoi_set(tracker));
+
+    // The eyetracker releases all of its references.
+    geye_eyelink_et_destroy(et);
+    g_assert_null(first);
+    g_assert_null(second);
+}
+
+static void
+eyelink_host_recording(void)
+{
+    GEyeEyelinkEt  *et = geye_eyelink_et_new();
+    GEyeEyetracker *tracker = GEYE_EYETRACKER(et);
+    GError         *error = NULL;
+    gchar          *dir = g_dir_make_tmp("geye-XXXXXX", NULL);
+    gchar          *filename = g_build_filename(dir, "host.geye", NULL);
+
+    g_assert_nonnull(dir);
+
+    // Without a connection or host recording a message goes nowhere.
+    geye_eyetracker_log_message(tracker, "nowhere", &error);
+    g_assert_error(error, geye_eyetracker_error_quark(),
+                   GEYE_EYETRACKER_ERROR_INCORRECT_MODE);
+    g_clear_error(&error);
+
+    geye_eyetracker_stop_host_recording(tracker, &error);
+    g_assert_error(error, geye_eyetracker_error_quark(),
+                   GEYE_EYETRACKER_ERROR_INCORRECT_MODE);
+    g_clear_error(&error);
+
+    geye_eyetracker_start_host_recording(tracker, filename, &error);
+    g_assert_no_error(error);
+    geye_eyetracker_start_host_recording(tracker, filename, &error);
+    g_assert_error(error, geye_eyetracker_error_quark(),
+                   GEYE_EYETRACKER_ERROR_INCORRECT_MODE);
+    g_clear_error(&error);
+
+    geye_eyetracker_log_message(tracker, "trial 1", &error);
+    g_assert_no_error(error);
+    geye_eyetracker_stop_host_recording(tracker, &error);
+    g_assert_no_error(error);
+    g_assert_true(g_file_test(filename, G_FILE_TEST_IS_REGULAR));
+
+    geye_eyelink_et_destroy(et);
+    g_remove(filename);
+    g_rmdir(dir);
+    g_free(filename);
+    g_free(dir);
+}
+
+static void
+eyelink_realtime(void)
+{
+    GEyeEyelinkEt  *et;
+    GEyeSchedPolicy policy;
+    gint            priority;
+    guint64         affinity;
+    gboolean        lock_memory;
+
+    // The system may refuse these, that is reported, but not fatal.
+    et = g_object_new(GEYE_TYPE_EYELINK_ET,
+                      "sched-policy", GEYE_SCHED_POLICY_FIFO,
+                      "sched-priority", 20,
+                      "cpu-affinity", G_GUINT64_CONSTANT(1),
+                      NULL);
+
+    g_object_get(et,
+                 "sched-policy", &policy,
+                 "sched-priority", &priority,
+                 "cpu-affinity", &affinity,
+                 "lock-memory", &lock_memory,
+                 NULL);
+    g_assert_cmpint(policy, ==, GEYE_SCHED_POLICY_FIFO);
+    g_assert_cmpint(priority, ==, 20);
+    g_assert_cmpuint(affinity, ==, 1);
+    g_assert_false(lock_memory);
+
+    geye_eyelink_et_destroy(et);
+}
+
+static void
+binocular_sample_eyes(void)
+{
+    GEyeBinocularSample *sample, *copy;
+    gdouble x, y;
+
+    sample = geye_binocular_sample_new(
+            GEYE_BINOCULAR, GEYE_RIGHT, 1.0, 1, 2, 3, 4
+            );
+    copy = geye_binocular_sample_copy(sample);
+    geye_binocular_sample_free(sample);
+
+    g_assert_cmpint(copy->parent.eye, ==, GEYE_BINOCULAR);
+    g_assert_false(geye_binocular_sample_get_eye(copy, GEYE_LEFT, NULL, NULL));
+    g_assert_true(geye_binocular_sample_get_eye(copy, GEYE_RIGHT, &x, &y));
+    g_assert_cmpfloat(x, ==, 3);
+    g_assert_cmpfloat(y, ==, 4);
+
+    geye_binocular_sample_free(copy);
+}
+
+static void
+extended_sample_fields(void)
+{
+    // Binocular with the pupil, the raw position and the status.
+    GEyeExtendedSample binocular = {
+        .parent = {.type = GEYE_EVENT_SAMPLE, .eye = GEYE_BINOCULAR},
+        .valid = GEYE_LEFT,
+        .fields = GEYE_SAMPLE_FIELD_PUPIL | GEYE_SAMPLE_FIELD_RAW |
+                  GEYE_SAMPLE_FIELD_STATUS,
+        .values = {1, 2, 3, 4, 5,   6, 7, 8, 9, 10,   11}
+    };
+    // The right eye with the HREF, the unfiltered gaze and the resolution.
+    GEyeExtendedSample right = {
+        .parent = {.type = GEYE_EVENT_SAMPLE, .eye = GEYE_RIGHT},
+        .valid = GEYE_RIGHT,
+        .fields = GEYE_SAMPLE_FIELD_HREF | GEYE_SAMPLE_FIELD_UNFILTERED |
+                  GEYE_SAMPLE_FIELD_RESOLUTION,
+        .values = {1, 2, 3, 4, 5, 6,   7, 8}
+    };
+    // The left eye with the velocity and acceleration.
+    GEyeExtendedSample motion = {
+        .parent = {.type = GEYE_EVENT_SAMPLE, .eye = GEYE_LEFT},
+        .valid = GEYE_LEFT,
+        .fields = GEYE_SAMPLE_FIELD_VELOCITY | GEYE_SAMPLE_FIELD_ACCELERATION |
+                  GEYE_SAMPLE_FIELD_STATUS,
+        .values = {1, 2, 3, 4, 5, 6,   7}
+    };
+    GEyeExtendedSample *copy;
+    gdouble x, y, size;
+    guint status;
+
+    g_assert_cmpuint(
+            geye_extended_sample_get_n_values(
+                binocular.fields, binocular.parent.eye), ==, 11
+            );
+    g_assert_cmpuint(
+            geye_extended_sample_get_n_values(right.fields, right.parent.eye),
+            ==, 8
+            );
+
+    copy = geye_extended_sample_copy(&binocular);
+    g_assert_true(geye_extended_sample_get_gaze(copy, GEYE_LEFT, &x, &y));
+    g_assert_cmpfloat(x, ==, 1);
+    g_assert_cmpfloat(y, ==, 2);
+    g_assert_true(geye_extended_sample_get_pupil(copy, GEYE_LEFT, &size));
+    g_assert_cmpfloat(size, ==, 3);
+    g_assert_true(geye_extended_sample_get_raw(copy, GEYE_LEFT, &x, &y));
+    g_assert_cmpfloat(x, ==, 4);
+    g_assert_cmpfloat(y, ==, 5);
+    // Tracked, but not valid in this sample.
+    g_assert_false(geye_extended_sample_get_gaze(copy, GEYE_RIGHT, &x, &y));
+    g_assert_cmpfloat(x, ==, 6);
+    g_assert_true(geye_extended_sample_get_pupil(copy, GEYE_RIGHT, &size));
+    g_assert_cmpfloat(size, ==, 8);
+    g_assert_true(geye_extended_sample_get_raw(copy, GEYE_RIGHT, &x, &y));
+    g_assert_cmpfloat(y, ==, 10);
+    g_assert_true(geye_extended_sample_get_status(copy, &status));
+    g_assert_cmpuint(status, ==, 11);
+    g_assert_false(geye_extended_sample_get_href(copy, GEYE_LEFT, &x, &y));
+    g_assert_false(geye_extended_sample_get_resolution(copy, &x, &y));
+    g_assert_false(
+            geye_extended_sample_get_unfiltered(copy, GEYE_LEFT, &x, &y)
+            );
+    geye_extended_sample_free(copy);
+
+    g_assert_false(geye_extended_sample_get_gaze(&right, GEYE_LEFT, &x, &y));
+    g_assert_true(geye_extended_sample_get_gaze(&right, GEYE_RIGHT, &x, &y));
+    g_assert_cmpfloat(x, ==, 1);
+    g_assert_true(geye_extended_sample_get_href(&right, GEYE_RIGHT, &x, &y));
+    g_assert_cmpfloat(x, ==, 3);
+    g_assert_cmpfloat(y, ==, 4);
+    g_assert_false(geye_extended_sample_get_pupil(&right, GEYE_RIGHT, &size));
+    g_assert_true(
+            geye_extended_sample_get_unfiltered(&right, GEYE_RIGHT, &x, &y)
+            );
+    g_assert_cmpfloat(x, ==, 5);
+    g_assert_cmpfloat(y, ==, 6);
+    g_assert_true(geye_extended_sample_get_resolution(&right, &x, &y));
+    g_assert_cmpfloat(x, ==, 7);
+    g_assert_cmpfloat(y, ==, 8);
+    g_assert_false(geye_extended_sample_get_status(&right, &status));
+
+    g_assert_cmpuint(
+            geye_extended_sample_get_n_values(motion.fields, motion.parent.eye),
+            ==, 7
+            );
+    g_assert_true(
+            geye_extended_sample_get_velocity(&motion, GEYE_LEFT, &x, &y)
+            );
+    g_assert_cmpfloat(x, ==, 3);
+    g_assert_cmpfloat(y, ==, 4);
+    g_assert_true(
+            geye_extended_sample_get_acceleration(&motion, GEYE_LEFT, &x, &y)
+            );
+    g_assert_cmpfloat(x, ==, 5);
+    g_assert_cmpfloat(y, ==, 6);
+    g_assert_false(
+            geye_extended_sample_get_velocity(&motion, GEYE_RIGHT, &x, &y)
+            );
+    g_assert_true(geye_extended_sample_get_status(&motion, &status));
+    g_assert_cmpuint(status, ==, 7);
+}
+
+static void
+fixation_saccade_boxed(void)
+{
+    GEyeFixation fixation = {
+        .parent = {.type = GEYE_EVENT_FIX_END, .eye = GEYE_LEFT, .time = 1.0},
+        .end_time = 1.25,
+        .x = 100,
+        .y = 200
+    };
+    GEyeSaccade saccade = {
+        .parent = {.type = GEYE_EVENT_SAC_END, .eye = GEYE_RIGHT, .time = 2.0},
+        .end_time = 2.05,
+        .start_x = 100,
+        .end_x = 400,
+        .amplitude = 8.5,
+        .peak_velocity = 350
+    };
+    GEyeFixation *fix_copy;
+    GEyeSaccade *sac_copy;
+
+    g_assert_true(G_TYPE_IS_BOXED(GEYE_TYPE_FIXATION));
+    g_assert_true(G_TYPE_IS_BOXED(GEYE_TYPE_SACCADE));
+
+    fix_copy = g_boxed_copy(GEYE_TYPE_FIXATION, &fixation);
+    g_assert_cmpint(fix_copy->parent.type, ==, GEYE_EVENT_FIX_END);
+    g_assert_cmpint(fix_copy->parent.eye, ==, GEYE_LEFT);
+    g_assert_cmpfloat(fix_copy->end_time - fix_copy->parent.time, ==, 0.25);
+    g_assert_cmpfloat(fix_copy->x, ==, 100);
+    g_assert_cmpfloat(fix_copy->y, ==, 200);
+    g_boxed_free(GEYE_TYPE_FIXATION, fix_copy);
+
+    sac_copy = g_boxed_copy(GEYE_TYPE_SACCADE, &saccade);
+    g_assert_cmpint(sac_copy->parent.type, ==, GEYE_EVENT_SAC_END);
+    g_assert_cmpfloat(sac_copy->end_x, ==, 400);
+    g_assert_cmpfloat(sac_copy->amplitude, ==, 8.5);
+    g_assert_cmpfloat(sac_copy->peak_velocity, ==, 350);
+    g_boxed_free(GEYE_TYPE_SACCADE, sac_copy);
+}
+
 typedef struct ConnectData {
     EyelinkFixture *fix;
     gboolean connected;
@@ -391,6 +898,389 @@ eyelink_calibrate(void)
     geye_eyelink_et_destroy(el);
 }
 
+#ifdef GEYE_FAKE_EYELINK
+
+typedef struct {
+    EyelinkFixture *fix;
+    guint           samples;
+    guint           expected;
+    guint           fixations;
+    guint           saccades;
+} FakeTrackingData;
+
+static void
+on_fake_connected(GEyeEyetracker *et, gboolean connected, gpointer data)
+{
+    GError *error = NULL;
+    (void) data;
+
+    g_assert_true(connected);
+    geye_eyetracker_start_tracking(et, &error);
+    g_assert_no_error(error);
+}
+
+static void
+on_fake_sample(GEyeEyetracker *et, GEyeSample *sample, gpointer data)
+{
+    FakeTrackingData *tracking = data;
+    (void) et;
+    (void) sample;
+
+    if (++tracking->samples == tracking->expected)
+        g_main_loop_quit(tracking->fix->loop);
+}
+
+static void
+on_fake_fixation(GEyeEyetracker *et, GEyeFixation *fixation, gpointer data)
+{
+    FakeTrackingData *tracking = data;
+    (void) et;
+    (void) fixation;
+    tracking->fixations++;
+}
+
+static void
+on_fake_saccade(GEyeEyetracker *et, GEyeSaccade *saccade, gpointer data)
+{
+    FakeTrackingData *tracking = data;
+    (void) et;
+
+    if (saccade->parent.type == GEYE_EVENT_SAC_END) {
+        g_assert_cmpfloat(saccade->start_x, ==, 500);
+        g_assert_cmpfloat(saccade->end_x, ==, 850);
+        g_assert_cmpfloat_with_epsilon(saccade->amplitude, 10, 1e-9);
+    }
+    tracking->saccades++;
+}
+
+// Once the fake records, its clock jumps 200 ms ahead.
+static gboolean
+advance_fake_clock(gpointer data)
+{
+    (void) data;
+
+    if (!fake_eyelink_is_recording())
+        return G_SOURCE_CONTINUE;
+    fake_eyelink_advance_clock(200 * 1000);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+eyelink_fake_tracking(EyelinkFixture* fix, gconstpointer data)
+{
+    const FakeEyelinkSegment script[] = {
+        {FAKE_EYELINK_FIXATION, 100, 500, 400},
+        {FAKE_EYELINK_SACCADE,   20, 850, 400},
+        {FAKE_EYELINK_FIXATION, 100, 850, 400}
+    };
+    // Both eyes of the samples from 0 to 200 ms.
+    FakeTrackingData tracking = {.fix = fix, .expected = 2 * 201};
+    GSource *source;
+    (void) data;
+
+    fake_eyelink_reset();
+    fake_eyelink_set_manual_clock(TRUE);
+    fake_eyelink_set_script(script, G_N_ELEMENTS(script));
+
+    g_object_set(fix->et,
+                 "sample-delivery", GEYE_DELIVER_SAMPLE,
+                 "fixation-detection", GEYE_FIXATION_DETECTION_NONE,
+                 NULL);
+    g_signal_connect(
+            fix->et, "connected", G_CALLBACK(on_fake_connected), NULL
+            );
+    g_signal_connect(
+            fix->et, "sample", G_CALLBACK(on_fake_sample), &tracking
+            );
+    g_signal_connect(
+            fix->et, "fixation", G_CALLBACK(on_fake_fixation), &tracking
+            );
+    g_signal_connect(
+            fix->et, "saccade", G_CALLBACK(on_fake_saccade), &tracking
+            );
+
+    source = g_timeout_source_new(10);
+    g_source_set_callback(source, advance_fake_clock, NULL, NULL);
+    g_source_attach(source, fix->context);
+
+    geye_eyetracker_connect(GEYE_EYETRACKER(fix->et), NULL);
+    g_main_loop_run(fix->loop);
+
+    g_source_destroy(source);
+    g_source_unref(source);
+
+    g_assert_cmpuint(tracking.samples, ==, tracking.expected);
+    // The start and end of the first fixation and the start of the second,
+    // the start and end of the saccade, for both eyes.
+    g_assert_cmpuint(tracking.fixations, ==, 2 * 3);
+    g_assert_cmpuint(tracking.saccades, ==, 2 * 2);
+
+    geye_eyetracker_stop_tracking(GEYE_EYETRACKER(fix->et));
+}
+
+typedef struct {
+    guint   notified;
+    guint   drained;
+    gint64  last;
+    gint64  min_interval;
+} FakeCounterData;
+
+static void
+on_fake_drained(GObject *et, GParamSpec *spec, gpointer data)
+{
+    FakeCounterData *counters = data;
+    gint64 now = g_get_monotonic_time();
+    guint drained;
+    (void) spec;
+
+    g_object_get(et, "samples-drained", &drained, NULL);
+    g_assert_cmpuint(drained, >, counters->drained);
+    counters->drained = drained;
+    if (counters->notified++)
+        counters->min_interval = MIN(counters->min_interval,
+                                     now - counters->last);
+    counters->last = now;
+}
+
+static void
+eyelink_fake_counters(EyelinkFixture* fix, gconstpointer data)
+{
+    GEyeEyetracker *et = GEYE_EYETRACKER(fix->et);
+    FakeCounterData counters = {.min_interval = G_MAXINT64};
+    GSource *source;
+    guint dispatched = 0, drained = 0;
+    (void) data;
+
+    fake_eyelink_reset();
+    g_object_set(fix->et, "sample-delivery", GEYE_DELIVER_SAMPLE, NULL);
+    g_signal_connect(
+            fix->et, "connected", G_CALLBACK(on_fake_connected), NULL
+            );
+    g_signal_connect(
+            fix->et, "notify::samples-drained",
+            G_CALLBACK(on_fake_drained), &counters
+            );
+
+    // About a second of samples at 1000 Hz.
+    source = g_timeout_source_new(1100);
+    g_source_set_callback(source, quit_main_loop, fix->loop, NULL);
+    g_source_attach(source, fix->context);
+
+    geye_eyetracker_connect(et, NULL);
+    g_main_loop_run(fix->loop);
+
+    g_source_destroy(source);
+    g_source_unref(source);
+
+    g_object_get(fix->et,
+                 "samples-drained", &drained,
+                 "samples-dispatched", &dispatched,
+                 NULL);
+    g_assert_cmpuint(drained, >, 0);
+    g_assert_cmpuint(dispatched, >, 0);
+    g_assert_cmpuint(dispatched, <=, drained);
+
+    // At most one notification every 250 ms.
+    g_assert_cmpuint(counters.notified, >, 0);
+    g_assert_cmpuint(counters.notified, <=, 1100 / 250);
+    if (counters.notified > 1)
+        g_assert_cmpint(counters.min_interval, >=, 250 * 1000 - 1000);
+
+    geye_eyetracker_stop_tracking(et);
+    g_signal_handlers_disconnect_by_func(fix->et, on_fake_drained, &counters);
+}
+
+static void
+on_fake_first_sample(GEyeEyetracker *et, gpointer sample, gpointer data)
+{
+    EyelinkFixture *fix = data;
+    (void) sample;
+
+    g_signal_handlers_disconnect_by_func(et, on_fake_first_sample, data);
+    g_main_loop_quit(fix->loop);
+}
+
+static void
+eyelink_fake_link_samples(EyelinkFixture* fix, gconstpointer data)
+{
+    GEyeEyetracker *et = GEYE_EYETRACKER(fix->et);
+    gchar *initial, *expected, *setting;
+    (void) data;
+
+    fake_eyelink_reset();
+    initial = fake_eyelink_dup_link_sample_data();
+
+    // Only the extended samples need more than the default.
+    g_object_set(fix->et,
+                 "sample-delivery", GEYE_DELIVER_EXTENDED,
+                 "sample-fields", GEYE_SAMPLE_FIELD_HREF,
+                 NULL);
+    g_signal_connect(
+            fix->et, "connected", G_CALLBACK(on_fake_connected), NULL
+            );
+    g_signal_connect(
+            fix->et, "extended-sample", G_CALLBACK(on_fake_first_sample), fix
+            );
+    geye_eyetracker_connect(et, NULL);
+    g_main_loop_run(fix->loop);
+
+    setting = fake_eyelink_dup_link_sample_data();
+    expected = g_strconcat(initial, ",HREF", NULL);
+    g_assert_cmpstr(setting, ==, expected);
+    g_free(expected);
+    g_free(setting);
+
+    // The setting of the application is back once they're no longer needed.
+    geye_eyetracker_stop_tracking(et);
+    g_object_set(fix->et, "sample-delivery", GEYE_DELIVER_SAMPLE, NULL);
+    g_signal_connect(
+            fix->et, "sample", G_CALLBACK(on_fake_first_sample), fix
+            );
+    geye_eyetracker_start_tracking(et, NULL);
+    g_main_loop_run(fix->loop);
+
+    setting = fake_eyelink_dup_link_sample_data();
+    g_assert_cmpstr(setting, ==, initial);
+    g_free(setting);
+    g_free(initial);
+
+    geye_eyetracker_stop_tracking(et);
+}
+
+// At 1000 Hz, half a second to warm up and three seconds to count.
+#define FAKE_WARM_UP_SAMPLES    500
+#define FAKE_COUNTED_SAMPLES    3000
+
+typedef struct {
+    EyelinkFixture *fix;
+    GEyeSubscriber *subscriber;
+    guint           samples;
+    guint           emitted;
+    guint           allocations;
+} FakeAllocationData;
+
+static void
+on_fake_emitted(GEyeEyetracker *et, gpointer event, gpointer data)
+{
+    FakeAllocationData *alloc = data;
+    (void) et;
+    (void) event;
+    alloc->emitted++;
+}
+
+static void
+on_fake_counted_sample(GEyeEyetracker       *et,
+                       GEyeBinocularSample  *sample,
+                       gpointer              data)
+{
+    FakeAllocationData *alloc = data;
+    GEyeBinocularSample subscribed[16];
+    GEyeSample pulled[16];
+    (void) sample;
+
+    // Read the subscriber and the ring as an application would.
+    while (geye_subscriber_read(
+                alloc->subscriber, subscribed, G_N_ELEMENTS(subscribed), 0))
+        ;
+    while (geye_eyetracker_read_samples(et, pulled, G_N_ELEMENTS(pulled)))
+        ;
+
+    alloc->samples++;
+    if (alloc->samples == FAKE_WARM_UP_SAMPLES) {
+        allocation_counter_start();
+    }
+    else if (alloc->samples == FAKE_WARM_UP_SAMPLES + FAKE_COUNTED_SAMPLES) {
+        alloc->allocations = allocation_counter_stop();
+        g_main_loop_quit(alloc->fix->loop);
+    }
+}
+
+/*
+ * Once tracking runs, the whole sample path must be free of allocations.
+ * The Eyelink-thread drains the fake link, filters and detects fixations,
+ * tests the AOIs, feeds the subscriber and the host recording, and the
+ * main context emits every delivery. All threads are counted.
+ */
+static void
+eyelink_fake_allocation_free(EyelinkFixture* fix, gconstpointer data)
+{
+#if defined(HAVE_ALLOCATION_COUNTER)
+    GEyeEyetracker *et = GEYE_EYETRACKER(fix->et);
+    FakeAllocationData alloc = {.fix = fix};
+    GEyeAoiSet *aois = geye_aoi_set_new();
+    GError *error = NULL;
+    gchar *dir = g_dir_make_tmp("geye-XXXXXX", NULL);
+    gchar *filename = g_build_filename(dir, "fake.geye", NULL);
+    (void) data;
+
+    fake_eyelink_reset();
+
+    g_object_set(fix->et,
+                 "sample-delivery",
+                 GEYE_DELIVER_SAMPLE | GEYE_DELIVER_SAMPLES |
+                 GEYE_DELIVER_PULL | GEYE_DELIVER_BINOCULAR |
+                 GEYE_DELIVER_EXTENDED,
+                 "fixation-detection", GEYE_FIXATION_DETECTION_VELOCITY,
+                 "smoothing", GEYE_SMOOTHING_ONE_EURO,
+                 NULL);
+    geye_aoi_set_add_rectangle(aois, 400, 300, 200, 200);
+    geye_aoi_set_add_ellipse(aois, 850, 400, 50, 50);
+    geye_eyetracker_set_aoi_set(et, aois);
+    alloc.subscriber = geye_eyetracker_subscribe(et, 1, 0, &error);
+    g_assert_no_error(error);
+    geye_eyetracker_start_host_recording(et, filename, &error);
+    g_assert_no_error(error);
+
+    g_signal_connect(
+            fix->et, "connected", G_CALLBACK(on_fake_connected), NULL
+            );
+    g_signal_connect(
+            fix->et, "binocular-sample",
+            G_CALLBACK(on_fake_counted_sample), &alloc
+            );
+    g_signal_connect(
+            fix->et, "sample", G_CALLBACK(on_fake_emitted), &alloc
+            );
+    g_signal_connect(
+            fix->et, "samples", G_CALLBACK(on_fake_emitted), &alloc
+            );
+    g_signal_connect(
+            fix->et, "extended-sample", G_CALLBACK(on_fake_emitted), &alloc
+            );
+    g_signal_connect(
+            fix->et, "fixation", G_CALLBACK(on_fake_emitted), &alloc
+            );
+    g_signal_connect(
+            fix->et, "saccade", G_CALLBACK(on_fake_emitted), &alloc
+            );
+
+    geye_eyetracker_connect(et, NULL);
+    g_main_loop_run(fix->loop);
+
+    g_assert_cmpuint(alloc.samples, ==,
+                     FAKE_WARM_UP_SAMPLES + FAKE_COUNTED_SAMPLES);
+    g_assert_cmpuint(alloc.emitted, >, 0);
+    g_assert_cmpuint(alloc.allocations, ==, 0);
+
+    geye_eyetracker_stop_tracking(et);
+    geye_eyetracker_stop_host_recording(et, &error);
+    g_assert_no_error(error);
+
+    g_object_unref(alloc.subscriber);
+    g_object_unref(aois);
+    g_remove(filename);
+    g_rmdir(dir);
+    g_free(filename);
+    g_free(dir);
+#else
+    (void) fix;
+    (void) data;
+    g_test_skip("Counting allocations is only supported with glibc");
+#endif
+}
+
+#endif
+
 int main(int argc, char** argv)
 {
     setlocale(LC_ALL, "");
@@ -401,6 +1291,22 @@ int main(int argc, char** argv)
     g_log_set_always_fatal(G_LOG_FLAG_FATAL | G_LOG_FLAG_RECURSION);
 
     g_test_add_func("/EyelinkEt/create",  eyelink_create);
+    g_test_add_func("/EyelinkEt/sample_delivery", eyelink_sample_delivery);
+    g_test_add_func("/EyelinkEt/latency_mode", eyelink_latency_mode);
+    g_test_add_func("/EyelinkEt/realtime", eyelink_realtime);
+    g_test_add_func("/EyelinkEt/aoi_set", eyelink_aoi_set);
+    g_test_add_func("/EyelinkEt/host_recording", eyelink_host_recording);
+    g_test_add_func(
+            "/EyelinkEt/fixation_detection", eyelink_fixation_detection
+            );
+    g_test_add_func("/EyelinkEt/subscribe", eyelink_subscribe);
+    g_test_add_func("/EyelinkEt/latency_stats", eyelink_latency_stats);
+    g_test_add_func("/EyelinkEt/counters", eyelink_counters);
+    g_test_add_func("/EyelinkEt/smoothing", eyelink_smoothing);
+    g_test_add_func("/EyelinkEt/differentiator", eyelink_differentiator);
+    g_test_add_func("/Event/binocular_sample", binocular_sample_eyes);
+    g_test_add_func("/Event/fixation_saccade", fixation_saccade_boxed);
+    g_test_add_func("/Event/extended_sample", extended_sample_fields);
 
     g_test_add("/EyelinkEt/connect",
                EyelinkFixture,
@@ -432,6 +1338,40 @@ int main(int argc, char** argv)
     g_test_add_func(
             "/EyelinkEt/start_tracking", eyelink_tracking
     );
+#ifdef GEYE_FAKE_EYELINK
+    g_test_add(
+            "/EyelinkEt/fake_tracking",
+            EyelinkFixture,
+            &four,
+            eyelink_fixture_setup,
+            eyelink_fake_tracking,
+            eyelink_fixture_tear_down
+            );
+    g_test_add(
+            "/EyelinkEt/fake_counters",
+            EyelinkFixture,
+            &four,
+            eyelink_fixture_setup,
+            eyelink_fake_counters,
+            eyelink_fixture_tear_down
+            );
+    g_test_add(
+            "/EyelinkEt/fake_link_samples",
+            EyelinkFixture,
+            &four,
+            eyelink_fixture_setup,
+            eyelink_fake_link_samples,
+            eyelink_fixture_tear_down
+            );
+    g_test_add(
+            "/EyelinkEt/fake_allocation_free",
+            EyelinkFixture,
+            &eight,
+            eyelink_fixture_setup,
+            eyelink_fake_allocation_free,
+            eyelink_fixture_tear_down
+            );
+#endif
 
 
     //g_test_add_func(
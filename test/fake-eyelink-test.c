@@ -0,0 +1,385 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <fake-eyelink.h>
+#include <EyeLink/core_expt.h>
+#include <locale.h>
+
+typedef struct {
+    guint   samples;
+    guint   types[256];
+    gdouble last_time;
+    DSAMPLE last_sample;
+    DEVENT  last_event;
+} Drained;
+
+static void
+drain(Drained *drained)
+{
+    ALLD_DATA data;
+    gint type;
+
+    while ((type = eyelink_get_next_data(NULL)) != 0) {
+        g_assert_cmpint(eyelink_get_double_data(&data), ==, type);
+        drained->types[type]++;
+        if (type == SAMPLE_TYPE) {
+            g_assert_cmpfloat(data.fs.time, >=, drained->last_time);
+            drained->last_time = data.fs.time;
+            drained->last_sample = data.fs;
+            drained->samples++;
+        }
+        else {
+            // An event never comes after a sample that is later.
+            g_assert_cmpfloat(data.fe.time, >=, drained->last_time);
+            drained->last_event = data.fe;
+        }
+    }
+}
+
+static void
+fake_eyelink_connect(void)
+{
+    fake_eyelink_reset();
+
+    g_assert_cmpint(start_recording(0, 0, 1, 1), !=, OK_RESULT);
+    fake_eyelink_set_open_result(CONNECT_TIMEOUT_FAILED);
+    g_assert_cmpint(eyelink_open(), ==, CONNECT_TIMEOUT_FAILED);
+    g_assert_cmpint(eyemsg_printf("no connection"), !=, OK_RESULT);
+
+    fake_eyelink_set_open_result(OK_RESULT);
+    g_assert_cmpint(eyelink_open(), ==, OK_RESULT);
+    g_assert_cmpint(eyemsg_printf("connected"), ==, OK_RESULT);
+    g_assert_cmpint(eyecmd_printf("link_sample_data = %s", "GAZE"), ==, 0);
+    gchar *command = fake_eyelink_dup_last_command();
+    g_assert_cmpstr(command, ==, "link_sample_data = GAZE");
+    g_free(command);
+
+    char reply[256];
+    g_assert_cmpint(eyelink_read_reply(reply), ==, NO_REPLY);
+    g_assert_cmpint(eyelink_read_request("link_sample_data"), ==, OK_RESULT);
+    g_assert_cmpint(eyelink_read_reply(reply), ==, OK_RESULT);
+    g_assert_cmpstr(reply, ==, "GAZE");
+
+    close_eyelink_connection();
+    g_assert_cmpint(eyemsg_printf("closed"), !=, OK_RESULT);
+}
+
+static void
+fake_eyelink_samples(void)
+{
+    Drained drained = {0};
+    gdouble start;
+
+    fake_eyelink_reset();
+    fake_eyelink_set_manual_clock(TRUE);
+    fake_eyelink_set_rate(2000);
+    fake_eyelink_set_eye(LEFT_EYE);
+    eyelink_open();
+
+    // Nothing is on the link before recording.
+    drain(&drained);
+    g_assert_cmpuint(drained.samples, ==, 0);
+
+    g_assert_cmpint(start_recording(0, 0, 1, 0), ==, OK_RESULT);
+    g_assert_true(eyelink_wait_for_block_start(100, 1, 0));
+    g_assert_false(eyelink_wait_for_block_start(100, 0, 1));
+    g_assert_cmpint(eyelink_eye_available(), ==, LEFT_EYE);
+    start = eyelink_tracker_double_usec() / 1000;
+
+    // The clock stands still, only the first sample is due.
+    drain(&drained);
+    drain(&drained);
+    g_assert_cmpuint(drained.samples, ==, 1);
+    g_assert_cmpfloat(drained.last_sample.time, ==, start);
+
+    fake_eyelink_advance_clock(100 * 1000);
+    drain(&drained);
+    g_assert_cmpuint(drained.samples, ==, 201);
+    g_assert_cmpuint(fake_eyelink_get_samples_sent(), ==, 201);
+    g_assert_cmpfloat(drained.last_sample.time, ==, start + 100);
+    g_assert_cmpfloat(drained.last_sample.gx[RIGHT], ==, MISSING_DATA);
+    g_assert_cmpfloat(drained.last_sample.gx[LEFT], !=, MISSING_DATA);
+    g_assert_cmpfloat(drained.last_sample.rx, ==, FAKE_EYELINK_RESOLUTION);
+    // Without link events there are none.
+    g_assert_cmpuint(fake_eyelink_get_events_sent(), ==, 0);
+
+    set_offline_mode();
+    fake_eyelink_advance_clock(100 * 1000);
+    drain(&drained);
+    g_assert_cmpuint(drained.samples, ==, 201);
+    g_assert_false(fake_eyelink_is_recording());
+
+    close_eyelink_connection();
+}
+
+static void
+fake_eyelink_script(void)
+{
+    const FakeEyelinkSegment script[] = {
+        {FAKE_EYELINK_FIXATION, 100, 500, 400},
+        {FAKE_EYELINK_SACCADE,   20, 850, 400},
+        {FAKE_EYELINK_BLINK,     50, 0, 0},
+        {FAKE_EYELINK_FIXATION, 100, 850, 400}
+    };
+    Drained drained = {0};
+    gdouble start;
+
+    fake_eyelink_reset();
+    fake_eyelink_set_manual_clock(TRUE);
+    fake_eyelink_set_script(script, G_N_ELEMENTS(script));
+    eyelink_open();
+    g_assert_cmpint(start_recording(0, 0, 1, 1), ==, OK_RESULT);
+    start = eyelink_tracker_double_usec() / 1000;
+
+    // Halfway the saccade the gaze is halfway.
+    fake_eyelink_advance_clock(110 * 1000);
+    drain(&drained);
+    g_assert_cmpuint(drained.samples, ==, 111);
+    g_assert_cmpfloat_with_epsilon(drained.last_sample.gx[LEFT], 675, 1e-6);
+    g_assert_cmpfloat(drained.last_sample.gx[RIGHT], ==,
+                      drained.last_sample.gx[LEFT]);
+    g_assert_cmpuint(drained.types[STARTFIX], ==, 2);
+    g_assert_cmpuint(drained.types[ENDFIX], ==, 2);
+    g_assert_cmpuint(drained.types[STARTSACC], ==, 2);
+    g_assert_cmpuint(drained.types[ENDSACC], ==, 0);
+
+    // During the blink the gaze is missing.
+    fake_eyelink_advance_clock(30 * 1000);
+    drain(&drained);
+    g_assert_cmpuint(drained.types[ENDSACC], ==, 2);
+    g_assert_cmpuint(drained.types[STARTBLINK], ==, 2);
+    g_assert_cmpfloat(drained.last_sample.gx[LEFT], ==, MISSING_DATA);
+    g_assert_cmpfloat(drained.last_sample.pa[LEFT], ==, 0);
+
+    // The script starts over after the last fixation.
+    fake_eyelink_advance_clock(200 * 1000);
+    drain(&drained);
+    g_assert_cmpuint(drained.samples, ==, 341);
+    g_assert_cmpuint(drained.types[ENDBLINK], ==, 2);
+    g_assert_cmpuint(drained.types[STARTFIX], ==, 6);
+    g_assert_cmpuint(drained.types[ENDFIX], ==, 4);
+    g_assert_cmpuint(drained.types[STARTSACC], ==, 2);
+    g_assert_cmpuint(fake_eyelink_get_events_sent(), ==, 2 * 9);
+    g_assert_cmpfloat(drained.last_sample.gx[LEFT], ==, 500);
+
+    // The last event is the start of the second round.
+    g_assert_cmpint(drained.last_event.type, ==, STARTFIX);
+    g_assert_cmpint(drained.last_event.eye, ==, RIGHT_EYE);
+    g_assert_cmpfloat(drained.last_event.sttime, ==, start + 270);
+    g_assert_cmpfloat(drained.last_event.gstx, ==, 500);
+
+    close_eyelink_connection();
+}
+
+static void
+fake_eyelink_saccade(void)
+{
+    const FakeEyelinkSegment script[] = {
+        {FAKE_EYELINK_FIXATION, 10, 0, 0},
+        {FAKE_EYELINK_SACCADE,  50, 350, 0},
+        {FAKE_EYELINK_FIXATION, 10, 350, 0}
+    };
+    Drained drained = {0};
+
+    fake_eyelink_reset();
+    fake_eyelink_set_manual_clock(TRUE);
+    fake_eyelink_set_script(script, G_N_ELEMENTS(script));
+    fake_eyelink_set_eye(RIGHT_EYE);
+    eyelink_open();
+    start_recording(0, 0, 0, 1);
+
+    fake_eyelink_advance_clock(60 * 1000);
+    drain(&drained);
+    g_assert_cmpuint(drained.samples, ==, 0);
+    g_assert_cmpuint(drained.types[ENDSACC], ==, 1);
+    g_assert_cmpint(drained.last_event.type, ==, STARTFIX);
+
+    close_eyelink_connection();
+
+    // The end of the saccade, 10 ° in 50 ms.
+    fake_eyelink_reset();
+    fake_eyelink_set_manual_clock(TRUE);
+    fake_eyelink_set_script(script, G_N_ELEMENTS(script));
+    fake_eyelink_set_eye(RIGHT_EYE);
+    eyelink_open();
+    start_recording(0, 0, 0, 1);
+    fake_eyelink_advance_clock(59 * 1000);
+    drain(&drained);
+    g_assert_cmpint(drained.last_event.type, ==, STARTSACC);
+    fake_eyelink_advance_clock(1000);
+    drain(&drained);
+    g_assert_cmpint(drained.last_event.type, ==, STARTFIX);
+
+    close_eyelink_connection();
+}
+
+typedef struct {
+    guint   setup_image;
+    guint   frames;
+    guint   exit_image;
+    guint   cal_setup;
+    guint   targets;
+    guint   erased;
+    guint   cal_clear;
+    gfloat  last_x, last_y;
+    guint   polls;
+} Hooks;
+
+static Hooks hooks_seen;
+
+static INT16
+hook_setup_image(void *data, INT16 width, INT16 height)
+{
+    Hooks *seen = data;
+    g_assert_cmpint(width, ==, 64);
+    g_assert_cmpint(height, ==, 48);
+    seen->setup_image++;
+    return 0;
+}
+
+static INT16
+hook_draw_image(void *data, INT16 width, INT16 height, byte *pixels)
+{
+    Hooks *seen = data;
+    g_assert_cmpint(width, ==, 64);
+    g_assert_cmpint(height, ==, 48);
+    g_assert_cmpuint(pixels[3], ==, 255);
+    seen->frames++;
+    return 0;
+}
+
+static INT16
+hook_exit_image(void *data)
+{
+    Hooks *seen = data;
+    seen->exit_image++;
+    return 0;
+}
+
+static INT16
+hook_setup_cal(void *data)
+{
+    Hooks *seen = data;
+    seen->cal_setup++;
+    return 0;
+}
+
+static INT16
+hook_draw_target(void *data, float x, float y)
+{
+    Hooks *seen = data;
+    seen->targets++;
+    seen->last_x = x;
+    seen->last_y = y;
+    return 0;
+}
+
+static INT16
+hook_erase_target(void *data)
+{
+    Hooks *seen = data;
+    seen->erased++;
+    return 0;
+}
+
+static INT16
+hook_clear_cal(void *data)
+{
+    Hooks *seen = data;
+    seen->cal_clear++;
+    return 0;
+}
+
+// Calibrates once, about 2.5 s, then leaves the setup after a few frames.
+static INT16
+hook_input_key(void *data, InputEvent *event)
+{
+    Hooks *seen = data;
+    (void) event;
+
+    if (seen->polls++ == 0)
+        eyelink_send_keybutton('c', 0, KB_PRESS);
+    else if (seen->cal_clear && seen->frames >= 3)
+        eyelink_send_keybutton(ESC_KEY, 0, KB_PRESS);
+    return 0;
+}
+
+static void
+fake_eyelink_setup(void)
+{
+    HOOKFCNS2 hooks = {
+        .major = 1,
+        .userData = &hooks_seen,
+        .setup_image_display_hook = hook_setup_image,
+        .draw_image = hook_draw_image,
+        .exit_image_display_hook = hook_exit_image,
+        .setup_cal_display_hook = hook_setup_cal,
+        .draw_cal_target_hook = hook_draw_target,
+        .erase_cal_target_hook = hook_erase_target,
+        .clear_cal_display_hook = hook_clear_cal,
+        .get_input_key_hook = hook_input_key
+    };
+    char message[256];
+
+    fake_eyelink_reset();
+    fake_eyelink_set_frame_rate(100);
+    g_assert_cmpint(setup_graphic_hook_functions_V2(&hooks), ==, OK_RESULT);
+    g_assert_cmpint(do_tracker_setup(), !=, OK_RESULT);
+
+    eyelink_open();
+    eyecmd_printf("screen_pixel_coords = 0 0 %d %d", 1000, 500);
+    eyecmd_printf("calibration_type = HV5");
+    eyelink_request_image(ELIMAGE_128HVX, 64, 48);
+    g_assert_cmpint(eyelink_cal_result(), ==, NO_REPLY);
+    g_assert_cmpint(do_tracker_setup(), ==, OK_RESULT);
+
+    g_assert_cmpuint(hooks_seen.setup_image, ==, 1);
+    g_assert_cmpuint(hooks_seen.exit_image, ==, 1);
+    g_assert_cmpuint(hooks_seen.frames, >=, 3);
+    g_assert_cmpuint(fake_eyelink_get_frames_sent(), ==, hooks_seen.frames);
+    g_assert_cmpuint(hooks_seen.cal_setup, ==, 1);
+    g_assert_cmpuint(hooks_seen.targets, ==, 5);
+    g_assert_cmpuint(hooks_seen.erased, ==, 5);
+    g_assert_cmpuint(hooks_seen.cal_clear, ==, 1);
+    g_assert_cmpfloat(hooks_seen.last_x, ==, 900);
+    g_assert_cmpfloat(hooks_seen.last_y, ==, 250);
+
+    g_assert_cmpint(eyelink_cal_result(), ==, OK_RESULT);
+    eyelink_cal_message(message);
+    g_assert_cmpstr(message, ==, "calibration HV5 done");
+    exit_calibration();
+    g_assert_cmpint(eyelink_cal_result(), ==, NO_REPLY);
+
+    close_eyelink_connection();
+}
+
+int main(int argc, char** argv)
+{
+    setlocale(LC_ALL, "");
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/FakeEyelink/connect", fake_eyelink_connect);
+    g_test_add_func("/FakeEyelink/samples", fake_eyelink_samples);
+    g_test_add_func("/FakeEyelink/script", fake_eyelink_script);
+    g_test_add_func("/FakeEyelink/saccade", fake_eyelink_saccade);
+    g_test_add_func("/FakeEyelink/setup", fake_eyelink_setup);
+
+    return g_test_run();
+}
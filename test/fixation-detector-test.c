@@ -0,0 +1,198 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <fixation-detector.h>
+#include <locale.h>
+#include <math.h>
+
+#define RATE 500.0
+
+/*
+ * A gaze trace of 500 Hz: a fixation at (100, 100) of 300 ms, a saccade of
+ * 20 ms and a fixation at (500, 300) of 300 ms, followed by another saccade.
+ */
+static void
+make_sample(guint i, GEyeSample *sample)
+{
+    gdouble time = i / RATE;
+    gdouble jitter = (i % 3) - 1.0;
+
+    sample->parent.type = GEYE_EVENT_SAMPLE;
+    sample->parent.eye = GEYE_LEFT;
+    sample->parent.time = time;
+    sample->parent.tracker_time = i * 2;
+
+    if (time < 0.3) {
+        sample->x = 100 + jitter;
+        sample->y = 100 - jitter;
+    }
+    else if (time < 0.32) {
+        sample->x = 100 + (time - 0.3) / 0.02 * 400;
+        sample->y = 100 + (time - 0.3) / 0.02 * 200;
+    }
+    else if (time < 0.62) {
+        sample->x = 500 + jitter;
+        sample->y = 300 - jitter;
+    }
+    else {
+        sample->x = 500 - (time - 0.62) / 0.02 * 400;
+        sample->y = 300;
+    }
+}
+
+static guint
+run_trace(GEyeFixationDetector *detector, GEyeFixation *events, guint max)
+{
+    GEyeFixation out[GEYE_FIXATION_DETECTOR_MAX_EVENTS];
+    GEyeSample sample;
+    guint i, j, n, total = 0;
+
+    for (i = 0; i < RATE * 0.63; i++) {
+        make_sample(i, &sample);
+        n = geye_fixation_detector_push(detector, &sample, out);
+        g_assert_cmpuint(n, <=, GEYE_FIXATION_DETECTOR_MAX_EVENTS);
+        for (j = 0; j < n; j++) {
+            g_assert_cmpuint(total, <, max);
+            events[total++] = out[j];
+            // At most one window of latency.
+            if (out[j].parent.type == GEYE_EVENT_FIX_START)
+                g_assert_cmpfloat(
+                        sample.parent.time - out[j].parent.time, <=, 0.1 + 0.01
+                        );
+        }
+    }
+    return total;
+}
+
+static void
+check_trace_events(GEyeFixation *events, guint n)
+{
+    g_assert_cmpuint(n, ==, 4);
+
+    g_assert_cmpint(events[0].parent.type, ==, GEYE_EVENT_FIX_START);
+    g_assert_cmpint(events[0].parent.eye, ==, GEYE_LEFT);
+    g_assert_cmpfloat(events[0].parent.time, <, 0.01);
+    g_assert_cmpfloat(fabs(events[0].x - 100), <, 1);
+
+    g_assert_cmpint(events[1].parent.type, ==, GEYE_EVENT_FIX_END);
+    g_assert_cmpfloat(events[1].parent.time, ==, events[0].parent.time);
+    g_assert_cmpfloat(fabs(events[1].end_time - 0.3), <, 0.01);
+    g_assert_cmpfloat(fabs(events[1].x - 100), <, 1);
+    g_assert_cmpfloat(fabs(events[1].y - 100), <, 1);
+
+    g_assert_cmpint(events[2].parent.type, ==, GEYE_EVENT_FIX_START);
+    g_assert_cmpfloat(fabs(events[2].parent.time - 0.32), <, 0.01);
+
+    g_assert_cmpint(events[3].parent.type, ==, GEYE_EVENT_FIX_END);
+    g_assert_cmpfloat(fabs(events[3].end_time - 0.62), <, 0.01);
+    g_assert_cmpfloat(fabs(events[3].x - 500), <, 1);
+    g_assert_cmpfloat(fabs(events[3].y - 300), <, 1);
+}
+
+static void
+fixation_detector_velocity(void)
+{
+    GEyeFixationDetector *detector = geye_fixation_detector_new(256);
+    GEyeFixation events[8];
+    guint n;
+
+    geye_fixation_detector_configure(
+            detector, GEYE_FIXATION_DETECTION_VELOCITY, 2000, 0, 0.1
+            );
+    n = run_trace(detector, events, G_N_ELEMENTS(events));
+    check_trace_events(events, n);
+
+    geye_fixation_detector_free(detector);
+}
+
+static void
+fixation_detector_dispersion(void)
+{
+    GEyeFixationDetector *detector = geye_fixation_detector_new(256);
+    GEyeFixation events[8];
+    guint n;
+
+    geye_fixation_detector_configure(
+            detector, GEYE_FIXATION_DETECTION_DISPERSION, 0, 25, 0.1
+            );
+    n = run_trace(detector, events, G_N_ELEMENTS(events));
+    check_trace_events(events, n);
+
+    geye_fixation_detector_free(detector);
+}
+
+static void
+fixation_detector_end(void)
+{
+    GEyeFixationDetector *detector = geye_fixation_detector_new(256);
+    GEyeFixation out[GEYE_FIXATION_DETECTOR_MAX_EVENTS], end;
+    GEyeSample sample;
+    guint i, n = 0;
+
+    geye_fixation_detector_configure(
+            detector, GEYE_FIXATION_DETECTION_DISPERSION, 0, 25, 0.1
+            );
+
+    // Shorter than the minimum duration, nothing to end.
+    for (i = 0; i < 40; i++) {
+        make_sample(i, &sample);
+        n += geye_fixation_detector_push(detector, &sample, out);
+    }
+    g_assert_cmpuint(n, ==, 0);
+    g_assert_false(geye_fixation_detector_end(detector, &end));
+
+    for (i = 0; i < 100; i++) {
+        make_sample(i, &sample);
+        n += geye_fixation_detector_push(detector, &sample, out);
+    }
+    g_assert_cmpuint(n, ==, 1);
+    g_assert_true(geye_fixation_detector_end(detector, &end));
+    g_assert_cmpint(end.parent.type, ==, GEYE_EVENT_FIX_END);
+    g_assert_cmpfloat(end.end_time, ==, 99 / RATE);
+
+    // Ending twice reports nothing.
+    g_assert_false(geye_fixation_detector_end(detector, &end));
+
+    geye_fixation_detector_configure(
+            detector, GEYE_FIXATION_DETECTION_NONE, 0, 0, 0.1
+            );
+    for (i = 0; i < 200; i++) {
+        make_sample(i, &sample);
+        g_assert_cmpuint(
+                geye_fixation_detector_push(detector, &sample, out), ==, 0
+                );
+    }
+
+    geye_fixation_detector_free(detector);
+}
+
+int main(int argc, char** argv)
+{
+    setlocale(LC_ALL, "");
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/FixationDetector/velocity", fixation_detector_velocity);
+    g_test_add_func(
+            "/FixationDetector/dispersion", fixation_detector_dispersion
+            );
+    g_test_add_func("/FixationDetector/end", fixation_detector_end);
+
+    return g_test_run();
+}
@@ -0,0 +1,189 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <gaze-filter.h>
+#include <locale.h>
+#include <math.h>
+
+#define RATE 500.0
+#define MAX_WINDOW 16
+#define N_SAMPLES 1000
+
+static void
+gaze_filter_moving_average(void)
+{
+    GEyeGazeFilter *filter = geye_gaze_filter_new(MAX_WINDOW);
+    guint i;
+
+    geye_gaze_filter_configure(filter, GEYE_SMOOTHING_MOVING_AVERAGE, 4, 1, 0);
+
+    // The average of the samples seen, followed by that of the last four.
+    for (i = 0; i < 10; i++) {
+        gdouble x = i, y = 2.0 * i;
+        gdouble expected = i < 4 ? i / 2.0 : i - 1.5;
+
+        geye_gaze_filter_step(filter, i / RATE, &x, &y);
+        g_assert_cmpfloat_with_epsilon(x, expected, 1e-9);
+        g_assert_cmpfloat_with_epsilon(y, 2 * expected, 1e-9);
+    }
+
+    // A new window starts over.
+    geye_gaze_filter_configure(filter, GEYE_SMOOTHING_MOVING_AVERAGE, 2, 1, 0);
+    for (i = 0; i < 3; i++) {
+        gdouble x = 10.0 * i, y = 0;
+
+        geye_gaze_filter_step(filter, i / RATE, &x, &y);
+        g_assert_cmpfloat_with_epsilon(x, i == 0 ? 0 : 10.0 * i - 5, 1e-9);
+    }
+
+    geye_gaze_filter_free(filter);
+}
+
+static void
+gaze_filter_savitzky_golay(void)
+{
+    GEyeGazeFilter *filter = geye_gaze_filter_new(MAX_WINDOW);
+    guint i;
+
+    geye_gaze_filter_configure(filter, GEYE_SMOOTHING_SAVITZKY_GOLAY, 7, 1, 0);
+
+    // A quadratic passes unchanged and without lag.
+    for (i = 0; i < 50; i++) {
+        gdouble t = i / RATE;
+        gdouble x = 3 + 400 * t - 2000 * t * t, y = 100 - 50 * t;
+        gdouble ex = x, ey = y;
+
+        geye_gaze_filter_step(filter, t, &x, &y);
+        g_assert_cmpfloat_with_epsilon(x, ex, 1e-6);
+        g_assert_cmpfloat_with_epsilon(y, ey, 1e-6);
+    }
+
+    // Noise around a constant is reduced.
+    geye_gaze_filter_reset(filter);
+    for (i = 0; i < 50; i++) {
+        gdouble x = 100 + (i % 2 ? 1.0 : -1.0), y = 0;
+
+        geye_gaze_filter_step(filter, i / RATE, &x, &y);
+        if (i >= 6)
+            g_assert_cmpfloat(fabs(x - 100), <, 1.0);
+    }
+
+    geye_gaze_filter_free(filter);
+}
+
+static void
+gaze_filter_one_euro(void)
+{
+    GEyeGazeFilter *filter = geye_gaze_filter_new(MAX_WINDOW);
+    gdouble x = 0, y = 0;
+    guint i;
+
+    geye_gaze_filter_configure(filter, GEYE_SMOOTHING_ONE_EURO, 1, 1, 0);
+
+    // The first sample passes, a step is followed slowly without a beta.
+    geye_gaze_filter_step(filter, 0, &x, &y);
+    g_assert_cmpfloat(x, ==, 0);
+    x = 100;
+    geye_gaze_filter_step(filter, 1 / RATE, &x, &y);
+    g_assert_cmpfloat(x, >, 0);
+    g_assert_cmpfloat(x, <, 5);
+    for (i = 2; i < 5 * RATE; i++) {
+        x = 100;
+        geye_gaze_filter_step(filter, i / RATE, &x, &y);
+    }
+    g_assert_cmpfloat_with_epsilon(x, 100, 1e-3);
+
+    // With a beta the cutoff rises with the velocity, so it follows faster.
+    geye_gaze_filter_configure(filter, GEYE_SMOOTHING_ONE_EURO, 1, 1, 0.1);
+    x = 200;
+    geye_gaze_filter_step(filter, i / RATE, &x, &y);
+    x = 200;
+    geye_gaze_filter_step(filter, (i + 1) / RATE, &x, &y);
+    g_assert_cmpfloat(x, >, 110);
+
+    geye_gaze_filter_free(filter);
+}
+
+static void
+gaze_filter_batch(void)
+{
+    const GEyeSmoothing methods[] = {
+        GEYE_SMOOTHING_NONE,
+        GEYE_SMOOTHING_MOVING_AVERAGE,
+        GEYE_SMOOTHING_SAVITZKY_GOLAY,
+        GEYE_SMOOTHING_ONE_EURO
+    };
+    gdouble *time = g_new(gdouble, N_SAMPLES);
+    gdouble *x = g_new(gdouble, N_SAMPLES);
+    gdouble *y = g_new(gdouble, N_SAMPLES);
+    guint m, i;
+
+    for (m = 0; m < G_N_ELEMENTS(methods); m++) {
+        GEyeGazeFilter *step = geye_gaze_filter_new(MAX_WINDOW);
+        GEyeGazeFilter *batch = geye_gaze_filter_new(MAX_WINDOW);
+        guint done = 0, size = 1;
+
+        geye_gaze_filter_configure(step, methods[m], 9, 2, 0.01);
+        geye_gaze_filter_configure(batch, methods[m], 9, 2, 0.01);
+
+        for (i = 0; i < N_SAMPLES; i++) {
+            time[i] = i / RATE;
+            x[i] = 300 + 100 * sin(i / 50.0) + (i % 5);
+            y[i] = 200 + (i < N_SAMPLES / 2 ? 0 : 150) - (i % 3);
+        }
+
+        // Batches of growing size, some larger than a chunk.
+        while (done < N_SAMPLES) {
+            guint n = MIN(size, N_SAMPLES - done);
+            geye_gaze_filter_run(batch, time + done, x + done, y + done, n);
+            done += n;
+            size = size * 3 + 1;
+        }
+
+        for (i = 0; i < N_SAMPLES; i++) {
+            gdouble sx = 300 + 100 * sin(i / 50.0) + (i % 5);
+            gdouble sy = 200 + (i < N_SAMPLES / 2 ? 0 : 150) - (i % 3);
+
+            geye_gaze_filter_step(step, time[i], &sx, &sy);
+            g_assert_cmpfloat_with_epsilon(x[i], sx, 1e-9);
+            g_assert_cmpfloat_with_epsilon(y[i], sy, 1e-9);
+        }
+
+        geye_gaze_filter_free(step);
+        geye_gaze_filter_free(batch);
+    }
+
+    g_free(time);
+    g_free(x);
+    g_free(y);
+}
+
+int main(int argc, char** argv)
+{
+    setlocale(LC_ALL, "");
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/GazeFilter/moving_average", gaze_filter_moving_average);
+    g_test_add_func("/GazeFilter/savitzky_golay", gaze_filter_savitzky_golay);
+    g_test_add_func("/GazeFilter/one_euro", gaze_filter_one_euro);
+    g_test_add_func("/GazeFilter/batch", gaze_filter_batch);
+
+    return g_test_run();
+}
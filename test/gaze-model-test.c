@@ -0,0 +1,316 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <gaze-model.h>
+#include <locale.h>
+#include <math.h>
+#include <string.h>
+
+static guint
+step_n(GEyeGazeModel *model, GArray *records, guint n_samples)
+{
+    GEyeRecord buffer[GEYE_GAZE_MODEL_MAX_RECORDS];
+    guint i, n = 0;
+
+    for (i = 0; i < n_samples; i++) {
+        guint step = geye_gaze_model_step(model, buffer);
+        g_assert_cmpuint(step, >=, 1);
+        g_assert_cmpuint(step, <=, GEYE_GAZE_MODEL_MAX_RECORDS);
+        g_assert_cmpuint(buffer[step - 1].type, ==, GEYE_RECORD_SAMPLE);
+        g_array_append_vals(records, buffer, step);
+        n += step;
+    }
+    return n;
+}
+
+static void
+gaze_model_deterministic(void)
+{
+    GEyeGazeModelParams params;
+    GEyeGazeModel *a, *b, *c;
+    GArray *ra = g_array_new(FALSE, FALSE, sizeof(GEyeRecord));
+    GArray *rb = g_array_new(FALSE, FALSE, sizeof(GEyeRecord));
+    GArray *rc = g_array_new(FALSE, FALSE, sizeof(GEyeRecord));
+
+    geye_gaze_model_params_init(&params);
+    params.seed = 7;
+    a = geye_gaze_model_new(&params);
+    b = geye_gaze_model_new(&params);
+    params.seed = 8;
+    c = geye_gaze_model_new(&params);
+
+    step_n(a, ra, 5000);
+    step_n(b, rb, 5000);
+    step_n(c, rc, 5000);
+
+    g_assert_cmpuint(ra->len, ==, rb->len);
+    g_assert_cmpmem(ra->data, ra->len * sizeof(GEyeRecord),
+                    rb->data, rb->len * sizeof(GEyeRecord));
+    g_assert_true(ra->len != rc->len ||
+                  memcmp(ra->data, rc->data, ra->len * sizeof(GEyeRecord)));
+    g_assert_cmpfloat(geye_gaze_model_get_time(a), ==, 5.0);
+
+    g_array_unref(ra);
+    g_array_unref(rb);
+    g_array_unref(rc);
+    geye_gaze_model_free(a);
+    geye_gaze_model_free(b);
+    geye_gaze_model_free(c);
+}
+
+typedef enum {
+    TRUTH_NONE,
+    TRUTH_FIXATION,
+    TRUTH_SACCADE,
+    TRUTH_BLINK
+} Truth;
+
+/*
+ * Follows the events of the left eye and checks the samples against them,
+ * without noise the gaze must be where the events say it is.
+ */
+static void
+gaze_model_ground_truth(void)
+{
+    const guint rate = 10000, seconds = 60;
+    GEyeGazeModelParams params;
+    GEyeGazeModel *model;
+    GArray *records = g_array_new(FALSE, FALSE, sizeof(GEyeRecord));
+    Truth truth = TRUTH_NONE;
+    GEyeRecord start = {0};
+    gdouble last_time = -1, fixation_time = 0, prev_x = NAN;
+    guint n_fixations = 0, n_saccades = 0, n_blinks = 0, n_samples = 0;
+    guint i;
+
+    geye_gaze_model_params_init(&params);
+    params.rate = rate;
+    params.noise = 0;
+    model = geye_gaze_model_new(&params);
+    step_n(model, records, rate * seconds);
+
+    for (i = 0; i < records->len; i++) {
+        const GEyeRecord *r = &g_array_index(records, GEyeRecord, i);
+
+        if (r->type == GEYE_RECORD_SAMPLE) {
+            g_assert_cmpfloat_with_epsilon(
+                    r->time, n_samples / (gdouble) rate, 1e-9
+                    );
+            g_assert_cmpfloat_with_epsilon(r->tracker_time, r->time * 1000, 1e-6);
+            g_assert_cmpuint(r->eye, ==, GEYE_BINOCULAR);
+            g_assert_cmpfloat(r->time, >, last_time);
+            last_time = r->time;
+            n_samples++;
+
+            switch (truth) {
+                case TRUTH_FIXATION:
+                    g_assert_cmpuint(r->valid, ==, GEYE_BINOCULAR);
+                    // The drift is slow, tremor and drift stay within 1°.
+                    g_assert_cmpfloat(
+                            hypot(r->data.sample.left_x - start.data.fixation.x,
+                                  r->data.sample.left_y - start.data.fixation.y),
+                            <, params.resolution
+                            );
+                    g_assert_cmpfloat(
+                            r->data.sample.right_x, >, r->data.sample.left_x
+                            );
+                    break;
+                case TRUTH_SACCADE:
+                    g_assert_cmpuint(r->valid, ==, GEYE_BINOCULAR);
+                    // It moves towards the end monotonically.
+                    if (!isnan(prev_x))
+                        g_assert_cmpfloat(
+                                (r->data.sample.left_x - prev_x) *
+                                (start.data.saccade.end_x -
+                                 start.data.saccade.start_x),
+                                >=, 0
+                                );
+                    prev_x = r->data.sample.left_x;
+                    break;
+                case TRUTH_BLINK:
+                    g_assert_cmpuint(r->valid, ==, GEYE_NONE);
+                    g_assert_true(isnan(r->data.sample.left_x));
+                    break;
+                case TRUTH_NONE:
+                    g_assert_not_reached();
+            }
+            continue;
+        }
+
+        if (r->eye != GEYE_LEFT)
+            continue;
+
+        switch (r->event) {
+            case GEYE_EVENT_FIX_START:
+                g_assert_true(truth == TRUTH_NONE || truth == TRUTH_BLINK ||
+                              truth == TRUTH_SACCADE);
+                g_assert_cmpfloat(r->time, ==, n_samples / (gdouble) rate);
+                if (truth == TRUTH_BLINK)
+                    n_blinks++;
+                start = *r;
+                truth = TRUTH_FIXATION;
+                break;
+            case GEYE_EVENT_FIX_END:
+                g_assert_true(truth == TRUTH_FIXATION);
+                g_assert_cmpfloat(r->time, ==, start.time);
+                g_assert_cmpfloat_with_epsilon(
+                        r->data.fixation.end_time,
+                        (n_samples - 1) / (gdouble) rate, 1e-9
+                        );
+                fixation_time += r->data.fixation.end_time - r->time +
+                    1.0 / rate;
+                n_fixations++;
+                // Until a saccade starts, it is a blink.
+                truth = TRUTH_BLINK;
+                break;
+            case GEYE_EVENT_SAC_START:
+                g_assert_true(truth == TRUTH_BLINK);
+                g_assert_cmpfloat(r->time, ==, n_samples / (gdouble) rate);
+                start = *r;
+                prev_x = NAN;
+                truth = TRUTH_SACCADE;
+                break;
+            case GEYE_EVENT_SAC_END:
+                {
+                    gdouble a = r->data.saccade.amplitude;
+                    g_assert_true(truth == TRUTH_SACCADE);
+                    g_assert_cmpfloat(r->time, ==, start.time);
+                    g_assert_cmpfloat(a, >=, 1.0);
+                    g_assert_cmpfloat_with_epsilon(
+                            a,
+                            hypot(r->data.saccade.end_x - r->data.saccade.start_x,
+                                  r->data.saccade.end_y - r->data.saccade.start_y) /
+                            params.resolution,
+                            1e-9
+                            );
+                    // The main sequence, within the rounding to samples.
+                    g_assert_cmpfloat_with_epsilon(
+                            r->data.saccade.peak_velocity / (
+                                600 * (1 - exp(-a / 10))
+                            ),
+                            1.0, 0.05
+                            );
+                    n_saccades++;
+                    truth = TRUTH_NONE;
+                }
+                break;
+            default:
+                g_assert_not_reached();
+        }
+    }
+
+    g_assert_cmpuint(n_samples, ==, rate * seconds);
+    g_assert_cmpuint(n_fixations, >, 100);
+    g_assert_cmpuint(n_saccades, >, 100);
+    g_assert_cmpuint(n_blinks, >, 0);
+    g_assert_cmpuint(n_blinks + n_saccades, <=, n_fixations);
+    g_assert_cmpfloat_with_epsilon(
+            fixation_time / n_fixations * 1000,
+            params.fixation_duration, params.fixation_duration * 0.2
+            );
+
+    g_array_unref(records);
+    geye_gaze_model_free(model);
+}
+
+/*
+ * The noise of both eyes is independent, so their difference has a standard
+ * deviation of √2 times the noise.
+ */
+static void
+gaze_model_noise(void)
+{
+    GEyeGazeModelParams params;
+    GEyeGazeModel *model;
+    GArray *records = g_array_new(FALSE, FALSE, sizeof(GEyeRecord));
+    gdouble sum = 0, sum2 = 0, mean, sd;
+    guint n = 0, i;
+
+    geye_gaze_model_params_init(&params);
+    params.noise = 0.5;
+    model = geye_gaze_model_new(&params);
+    step_n(model, records, 20000);
+
+    for (i = 0; i < records->len; i++) {
+        const GEyeRecord *r = &g_array_index(records, GEyeRecord, i);
+        gdouble d;
+
+        if (r->type != GEYE_RECORD_SAMPLE || r->valid != GEYE_BINOCULAR)
+            continue;
+        d = r->data.sample.right_y - r->data.sample.left_y;
+        sum += d;
+        sum2 += d * d;
+        n++;
+    }
+    mean = sum / n;
+    sd = sqrt(sum2 / n - mean * mean);
+    g_assert_cmpfloat_with_epsilon(mean, 0, 1.0);
+    g_assert_cmpfloat_with_epsilon(
+            sd, G_SQRT2 * params.noise * params.resolution,
+            0.05 * params.noise * params.resolution
+            );
+
+    g_array_unref(records);
+    geye_gaze_model_free(model);
+}
+
+static void
+gaze_model_monocular(void)
+{
+    GEyeGazeModelParams params;
+    GEyeGazeModel *model;
+    GArray *records = g_array_new(FALSE, FALSE, sizeof(GEyeRecord));
+    guint i, n_events = 0;
+
+    geye_gaze_model_params_init(&params);
+    params.binocular = FALSE;
+    params.rate = 500;
+    model = geye_gaze_model_new(&params);
+    step_n(model, records, 5000);
+
+    for (i = 0; i < records->len; i++) {
+        const GEyeRecord *r = &g_array_index(records, GEyeRecord, i);
+
+        g_assert_cmpuint(r->eye, ==, GEYE_LEFT);
+        if (r->type == GEYE_RECORD_SAMPLE) {
+            g_assert_true(isnan(r->data.sample.right_x));
+            g_assert_true(isnan(r->data.sample.right_y));
+            g_assert_cmpuint(r->valid & GEYE_RIGHT, ==, 0);
+        }
+        else
+            n_events++;
+    }
+    g_assert_cmpuint(n_events, >, 0);
+
+    g_array_unref(records);
+    geye_gaze_model_free(model);
+}
+
+int main(int argc, char** argv)
+{
+    setlocale(LC_ALL, "");
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/GazeModel/deterministic", gaze_model_deterministic);
+    g_test_add_func("/GazeModel/ground_truth", gaze_model_ground_truth);
+    g_test_add_func("/GazeModel/noise", gaze_model_noise);
+    g_test_add_func("/GazeModel/monocular", gaze_model_monocular);
+
+    return g_test_run();
+}
@@ -0,0 +1,139 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <gaze-velocity.h>
+#include <locale.h>
+#include <math.h>
+
+#define RATE 500.0
+#define INTERVAL (1 / RATE)
+
+/* A gaze with a constant acceleration of 4000 pixels/s² horizontally. */
+static gdouble
+position_x(gdouble t)
+{
+    return 10 + 300 * t + 2000 * t * t;
+}
+
+static gdouble
+velocity_x(gdouble t)
+{
+    return 300 + 4000 * t;
+}
+
+static gdouble
+position_y(gdouble t)
+{
+    return 50 - 100 * t;
+}
+
+/* Pushes the trace until the window is filled, returns the time. */
+static gdouble
+push_until_valid(GEyeGazeVelocity   *velocity,
+                 guint               window,
+                 gdouble            *v,
+                 gdouble            *a)
+{
+    guint i;
+
+    for (i = 0; i < window; i++) {
+        gdouble t = i * INTERVAL;
+        gboolean valid = geye_gaze_velocity_push(
+                velocity, t, position_x(t), position_y(t), v, a
+                );
+        g_assert_true(valid == (i == window - 1));
+        if (!valid)
+            g_assert_true(isnan(v[0]) && isnan(a[1]));
+    }
+    return (window - 1) * INTERVAL;
+}
+
+static void
+gaze_velocity_two_point(void)
+{
+    GEyeGazeVelocity *velocity = geye_gaze_velocity_new(16);
+    gdouble v[2], a[2], t;
+
+    geye_gaze_velocity_configure(velocity, GEYE_DIFFERENTIATOR_TWO_POINT, 0);
+    t = push_until_valid(velocity, 3, v, a);
+
+    // The difference is the velocity halfway the last two samples.
+    g_assert_cmpfloat_with_epsilon(v[0], velocity_x(t - INTERVAL / 2), 1e-6);
+    g_assert_cmpfloat_with_epsilon(v[1], -100, 1e-6);
+    g_assert_cmpfloat_with_epsilon(a[0], 4000, 1e-3);
+    g_assert_cmpfloat_with_epsilon(a[1], 0, 1e-3);
+
+    geye_gaze_velocity_free(velocity);
+}
+
+static void
+gaze_velocity_five_point(void)
+{
+    GEyeGazeVelocity *velocity = geye_gaze_velocity_new(16);
+    gdouble v[2], a[2], t;
+
+    geye_gaze_velocity_configure(velocity, GEYE_DIFFERENTIATOR_FIVE_POINT, 0);
+    t = push_until_valid(velocity, 5, v, a);
+
+    // The central difference describes the sample two samples ago.
+    g_assert_cmpfloat_with_epsilon(v[0], velocity_x(t - 2 * INTERVAL), 1e-6);
+    g_assert_cmpfloat_with_epsilon(v[1], -100, 1e-6);
+    g_assert_cmpfloat_with_epsilon(a[0], 4000, 1e-3);
+
+    geye_gaze_velocity_free(velocity);
+}
+
+static void
+gaze_velocity_savitzky_golay(void)
+{
+    GEyeGazeVelocity *velocity = geye_gaze_velocity_new(16);
+    gdouble v[2], a[2], t;
+
+    geye_gaze_velocity_configure(
+            velocity, GEYE_DIFFERENTIATOR_SAVITZKY_GOLAY, 9
+            );
+    t = push_until_valid(velocity, 9, v, a);
+
+    // The fit is exact for a quadratic, at the newest sample.
+    g_assert_cmpfloat_with_epsilon(v[0], velocity_x(t), 1e-6);
+    g_assert_cmpfloat_with_epsilon(v[1], -100, 1e-6);
+    g_assert_cmpfloat_with_epsilon(a[0], 4000, 1e-3);
+    g_assert_cmpfloat_with_epsilon(a[1], 0, 1e-3);
+
+    // After a reset the window fills again.
+    geye_gaze_velocity_reset(velocity);
+    push_until_valid(velocity, 9, v, a);
+
+    geye_gaze_velocity_free(velocity);
+}
+
+int main(int argc, char** argv)
+{
+    setlocale(LC_ALL, "");
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/GazeVelocity/two_point", gaze_velocity_two_point);
+    g_test_add_func("/GazeVelocity/five_point", gaze_velocity_five_point);
+    g_test_add_func(
+            "/GazeVelocity/savitzky_golay", gaze_velocity_savitzky_golay
+            );
+
+    return g_test_run();
+}
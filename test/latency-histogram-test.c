@@ -0,0 +1,142 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+
+#include <latency-histogram.h>
+#include <locale.h>
+
+static void
+latency_histogram_empty(void)
+{
+    GEyeLatencyHistogram *histogram = geye_latency_histogram_new();
+    GEyeLatencyStats stats = {.count = 7};
+
+    geye_latency_histogram_get_stats(histogram, &stats);
+    g_assert_cmpuint(stats.count, ==, 0);
+    g_assert_cmpint(stats.p50, ==, 0);
+    g_assert_cmpint(stats.max, ==, 0);
+
+    geye_latency_histogram_free(histogram);
+}
+
+static void
+latency_histogram_exact(void)
+{
+    GEyeLatencyHistogram *histogram = geye_latency_histogram_new();
+    GEyeLatencyStats stats;
+    gint64 i;
+
+    // Small latencies have a bucket each, a negative one counts as 0.
+    geye_latency_histogram_record(histogram, -3);
+    for (i = 1; i < 10; i++)
+        geye_latency_histogram_record(histogram, i);
+
+    geye_latency_histogram_get_stats(histogram, &stats);
+    g_assert_cmpuint(stats.count, ==, 10);
+    g_assert_cmpint(stats.p50, ==, 4);
+    g_assert_cmpint(stats.p99, ==, 9);
+    g_assert_cmpint(stats.max, ==, 9);
+
+    geye_latency_histogram_free(histogram);
+}
+
+static void
+latency_histogram_precision(void)
+{
+    GEyeLatencyHistogram *histogram = geye_latency_histogram_new();
+    GEyeLatencyStats stats;
+    gint64 latency;
+
+    // With a larger maximum, the median is the upper bound of its bucket.
+    for (latency = 1; latency < G_MAXUINT32; latency += latency / 7 + 1) {
+        geye_latency_histogram_reset(histogram);
+        geye_latency_histogram_record(histogram, latency);
+        geye_latency_histogram_record(histogram, G_MAXUINT32);
+
+        geye_latency_histogram_get_stats(histogram, &stats);
+        g_assert_cmpuint(stats.count, ==, 2);
+        g_assert_cmpint(stats.p50, >=, latency);
+        g_assert_cmpint(stats.p50, <=, latency + latency / 16);
+        g_assert_cmpint(stats.max, ==, G_MAXUINT32);
+    }
+
+    geye_latency_histogram_free(histogram);
+}
+
+static void
+latency_histogram_percentiles(void)
+{
+    GEyeLatencyHistogram *histogram = geye_latency_histogram_new();
+    GEyeLatencyStats stats;
+    gint64 i;
+
+    for (i = 1; i <= 1000; i++)
+        geye_latency_histogram_record(histogram, i);
+
+    geye_latency_histogram_get_stats(histogram, &stats);
+    g_assert_cmpuint(stats.count, ==, 1000);
+    g_assert_cmpint(stats.p50, >=, 500);
+    g_assert_cmpint(stats.p50, <=, 500 + 500 / 16);
+    g_assert_cmpint(stats.p99, >=, 990);
+    g_assert_cmpint(stats.p99, <=, 1000);
+    g_assert_cmpint(stats.max, ==, 1000);
+
+    geye_latency_histogram_free(histogram);
+}
+
+static void
+latency_histogram_reset(void)
+{
+    GEyeLatencyHistogram *histogram = geye_latency_histogram_new();
+    GEyeLatencyStats stats;
+
+    geye_latency_histogram_record(histogram, 1000);
+    geye_latency_histogram_reset(histogram);
+
+    // The recording thread hasn't cleared it yet, but it reads as empty.
+    geye_latency_histogram_get_stats(histogram, &stats);
+    g_assert_cmpuint(stats.count, ==, 0);
+
+    geye_latency_histogram_record(histogram, 5);
+    geye_latency_histogram_get_stats(histogram, &stats);
+    g_assert_cmpuint(stats.count, ==, 1);
+    g_assert_cmpint(stats.p50, ==, 5);
+    g_assert_cmpint(stats.max, ==, 5);
+
+    geye_latency_histogram_free(histogram);
+}
+
+int main(int argc, char** argv)
+{
+    setlocale(LC_ALL, "");
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/LatencyHistogram/empty", latency_histogram_empty);
+    g_test_add_func("/LatencyHistogram/exact", latency_histogram_exact);
+    g_test_add_func(
+            "/LatencyHistogram/precision", latency_histogram_precision
+            );
+    g_test_add_func(
+            "/LatencyHistogram/percentiles", latency_histogram_percentiles
+            );
+    g_test_add_func("/LatencyHistogram/reset", latency_histogram_reset);
+
+    return g_test_run();
+}
@@ -0,0 +1,181 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <recorder.h>
+#include <locale.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+static gchar*
+temp_recording(void)
+{
+    gchar *dir = g_dir_make_tmp("geye-recorder-XXXXXX", NULL);
+    gchar *filename;
+
+    g_assert_nonnull(dir);
+    filename = g_build_filename(dir, "session.geye", NULL);
+    g_free(dir);
+    return filename;
+}
+
+static void
+remove_recording(gchar *filename)
+{
+    gchar *dir = g_path_get_dirname(filename);
+    g_remove(filename);
+    g_remove(dir);
+    g_free(dir);
+    g_free(filename);
+}
+
+static void
+recorder_roundtrip(void)
+{
+    gchar *filename = temp_recording();
+    const gchar *long_message = "A message that doesn't fit in one record of "
+                                "the recording, so it continues in the next.";
+    GError *error = NULL;
+    GEyeRecorder *recorder;
+    GEyeRecordingHeader *header;
+    GEyeRecordingFooter *footer;
+    GEyeRecord *records;
+    gchar *contents, *message;
+    gsize length, n_records;
+    guint i, n_samples = 0;
+
+    recorder = geye_recorder_new(
+            filename, "EyeLink 3 version 5.0", 1920, 1080, 12345, &error
+            );
+    g_assert_no_error(error);
+    g_assert_nonnull(recorder);
+
+    // 1000 Hz with a gap of 10 ms in the middle.
+    for (i = 0; i < 20000; i++) {
+        if (i >= 10000 && i < 10010)
+            continue;
+        GEyeBinocularSample sample = {
+            .parent = {
+                .type = GEYE_EVENT_SAMPLE,
+                .eye = GEYE_BINOCULAR,
+                .time = i / 1000.0,
+                .tracker_time = i
+            },
+            .valid = GEYE_LEFT,
+            .left_x = i, .left_y = -(gdouble) i,
+            .right_x = 0, .right_y = 0
+        };
+        geye_recorder_sample(recorder, &sample);
+        n_samples++;
+        if (i % 100 == 0)
+            geye_recorder_commit(recorder);
+    }
+
+    GEyeFixation fixation = {
+        .parent = {.type = GEYE_EVENT_FIX_END, .eye = GEYE_LEFT, .time = 19.5},
+        .end_time = 19.75, .x = 10, .y = 20
+    };
+    geye_recorder_fixation(recorder, &fixation);
+    geye_recorder_message(recorder, 19.9, long_message);
+    geye_recorder_flush(recorder);
+
+    g_assert_true(geye_recorder_close(recorder, &error));
+    g_assert_no_error(error);
+
+    g_assert_true(g_file_get_contents(filename, &contents, &length, NULL));
+    g_assert_cmpuint(
+            (length - sizeof(GEyeRecordingHeader) - sizeof(GEyeRecordingFooter))
+            % sizeof(GEyeRecord), ==, 0
+            );
+    n_records = (length - sizeof(GEyeRecordingHeader) -
+                 sizeof(GEyeRecordingFooter)) / sizeof(GEyeRecord);
+
+    header = (GEyeRecordingHeader*) contents;
+    g_assert_cmpmem(header->magic, 8, GEYE_RECORDING_MAGIC, 8);
+    g_assert_cmpuint(header->version, ==, GEYE_RECORDING_VERSION);
+    g_assert_cmpuint(header->record_size, ==, sizeof(GEyeRecord));
+    g_assert_cmpint(header->start_time, ==, 12345);
+    g_assert_cmpfloat(header->disp_width, ==, 1920);
+    g_assert_cmpstr(header->tracker_info, ==, "EyeLink 3 version 5.0");
+
+    footer = (GEyeRecordingFooter*) (contents + length - sizeof(*footer));
+    g_assert_cmpmem(footer->magic, 8, GEYE_RECORDING_FOOTER_MAGIC, 8);
+    g_assert_cmpuint(footer->n_records, ==, n_records);
+    g_assert_cmpuint(footer->n_samples, ==, n_samples);
+    g_assert_cmpuint(footer->n_dropped, ==, 0);
+    g_assert_cmpuint(footer->n_gaps, ==, 1);
+    g_assert_cmpfloat_with_epsilon(footer->gap_time, 0.010, 1e-9);
+    g_assert_cmpfloat(footer->first_time, ==, 0);
+    g_assert_cmpfloat(footer->last_time, ==, 19.999);
+
+    records = (GEyeRecord*) (contents + sizeof(GEyeRecordingHeader));
+    for (i = 0; i < n_samples; i++) {
+        g_assert_cmpuint(records[i].type, ==, GEYE_RECORD_SAMPLE);
+        g_assert_cmpuint(records[i].valid, ==, GEYE_LEFT);
+        g_assert_cmpfloat(records[i].data.sample.left_x, ==,
+                          records[i].tracker_time);
+    }
+    g_assert_cmpuint(records[i].type, ==, GEYE_RECORD_FIXATION);
+    g_assert_cmpuint(records[i].event, ==, GEYE_EVENT_FIX_END);
+    g_assert_cmpfloat(records[i].data.fixation.end_time, ==, 19.75);
+
+    // Put the message back together.
+    message = g_strdup("");
+    do {
+        gchar *part;
+        i++;
+        g_assert_cmpuint(records[i].type, ==, GEYE_RECORD_MESSAGE);
+        g_assert_cmpfloat(records[i].time, ==, 19.9);
+        part = g_strndup(records[i].data.message, GEYE_RECORD_MESSAGE_SIZE);
+        gchar *joined = g_strconcat(message, part, NULL);
+        g_free(part);
+        g_free(message);
+        message = joined;
+    } while (records[i].flags & GEYE_RECORD_FLAG_MORE);
+    g_assert_cmpstr(message, ==, long_message);
+    g_assert_cmpuint(i + 1, ==, n_records);
+
+    g_free(message);
+    g_free(contents);
+    remove_recording(filename);
+}
+
+static void
+recorder_unwritable(void)
+{
+    GError *error = NULL;
+    GEyeRecorder *recorder = geye_recorder_new(
+            "/nonexistent-dir/session.geye", NULL, 0, 0, 0, &error
+            );
+
+    g_assert_null(recorder);
+    g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+    g_error_free(error);
+}
+
+int main(int argc, char** argv)
+{
+    setlocale(LC_ALL, "");
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/Recorder/roundtrip", recorder_roundtrip);
+    g_test_add_func("/Recorder/unwritable", recorder_unwritable);
+
+    return g_test_run();
+}
@@ -0,0 +1,269 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+
+#include <recorder.h>
+#include <recording.h>
+#include <locale.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+#define N_SAMPLES 5000
+
+static gchar*
+temp_filename(const gchar *name)
+{
+    gchar *dir = g_dir_make_tmp("geye-recording-XXXXXX", NULL);
+    gchar *filename;
+
+    g_assert_nonnull(dir);
+    filename = g_build_filename(dir, name, NULL);
+    g_free(dir);
+    return filename;
+}
+
+static void
+remove_file(gchar *filename)
+{
+    gchar *dir = g_path_get_dirname(filename);
+    gchar *index = g_strconcat(filename, ".idx", NULL);
+
+    g_remove(index);
+    g_remove(filename);
+    g_remove(dir);
+    g_free(index);
+    g_free(dir);
+    g_free(filename);
+}
+
+/*
+ * 1000 Hz samples with a fixation after every 100th sample.
+ */
+static gchar*
+write_recording(void)
+{
+    gchar *filename = temp_filename("session.geye");
+    GError *error = NULL;
+    GEyeRecorder *recorder;
+    guint i;
+
+    recorder = geye_recorder_new(
+            filename, "EyeLink 1000", 1920, 1080, 0, &error
+            );
+    g_assert_no_error(error);
+
+    for (i = 0; i < N_SAMPLES; i++) {
+        GEyeBinocularSample sample = {
+            .parent = {
+                .type = GEYE_EVENT_SAMPLE,
+                .eye = GEYE_LEFT,
+                .time = i / 1000.0,
+                .tracker_time = i
+            },
+            .valid = GEYE_LEFT,
+            .left_x = i
+        };
+        geye_recorder_sample(recorder, &sample);
+        if (i % 100 == 99) {
+            GEyeFixation fixation = {
+                .parent = {
+                    .type = GEYE_EVENT_FIX_END,
+                    .eye = GEYE_LEFT,
+                    .time = (i - 99) / 1000.0
+                },
+                .end_time = i / 1000.0
+            };
+            geye_recorder_fixation(recorder, &fixation);
+        }
+    }
+    geye_recorder_flush(recorder);
+    g_assert_true(geye_recorder_close(recorder, &error));
+    return filename;
+}
+
+/* The index of the first sample at or after time, by a scan. */
+static gsize
+scan_time(const GEyeRecord *records, gsize n_records, gdouble time)
+{
+    gsize i;
+    for (i = 0; i < n_records; i++)
+        if (records[i].type == GEYE_RECORD_SAMPLE && records[i].time >= time)
+            break;
+    return i;
+}
+
+static void
+check_find(GEyeRecording *recording)
+{
+    static const gdouble times[] = {
+        -1, 0, 0.0005, 0.099, 0.1, 0.2555, 1.0, 2.5, 4.999, 5.0, 100
+    };
+    const GEyeRecord *records;
+    gsize n_records, i;
+
+    records = geye_recording_get_records(recording, &n_records);
+    for (i = 0; i < G_N_ELEMENTS(times); i++)
+        g_assert_cmpuint(
+                geye_recording_find_time(recording, times[i]), ==,
+                scan_time(records, n_records, times[i])
+                );
+}
+
+static void
+recording_open(void)
+{
+    gchar *filename = write_recording();
+    GError *error = NULL;
+    GEyeRecording *recording;
+    const GEyeRecordingHeader *header;
+    const GEyeRecordingFooter *footer;
+    const GEyeRecord *records;
+    gsize n_records, first, empty, n, size;
+    GBytes *bytes;
+
+    recording = geye_recording_open(filename, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(recording);
+
+    header = geye_recording_get_header(recording);
+    g_assert_cmpstr(header->tracker_info, ==, "EyeLink 1000");
+    g_assert_cmpfloat(header->disp_height, ==, 1080);
+
+    footer = geye_recording_get_footer(recording);
+    g_assert_nonnull(footer);
+    g_assert_cmpuint(footer->n_samples, ==, N_SAMPLES);
+
+    records = geye_recording_get_records(recording, &n_records);
+    g_assert_cmpuint(n_records, ==, N_SAMPLES + N_SAMPLES / 100);
+    g_assert_cmpuint(footer->n_records, ==, n_records);
+
+    check_find(recording);
+
+    // One second of samples, with the fixations that ended in it.
+    n = geye_recording_find_range(recording, 1.0, 2.0, &first);
+    g_assert_cmpuint(n, ==, 1000 + 10);
+    g_assert_cmpuint(records[first].type, ==, GEYE_RECORD_SAMPLE);
+    g_assert_cmpfloat(records[first].time, ==, 1.0);
+    g_assert_cmpfloat(records[first + n - 1].data.fixation.end_time, ==, 1.999);
+
+    g_assert_cmpuint(geye_recording_find_range(recording, 2, 1, &empty), ==, 0);
+
+    // The bytes are a view on the same mapping.
+    bytes = geye_recording_get_bytes(recording, first, n);
+    g_assert_true(g_bytes_get_data(bytes, &size) == (gconstpointer) &records[first]);
+    g_assert_cmpuint(size, ==, n * sizeof(GEyeRecord));
+    g_object_unref(recording);
+    g_assert_cmpfloat(
+            ((const GEyeRecord*) g_bytes_get_data(bytes, NULL))->time, ==, 1.0
+            );
+    g_bytes_unref(bytes);
+
+    remove_file(filename);
+}
+
+static void
+recording_unclosed(void)
+{
+    gchar *filename = write_recording();
+    gchar *unclosed = temp_filename("unclosed.geye");
+    GError *error = NULL;
+    GEyeRecording *recording;
+    gchar *contents;
+    gsize length, n_records;
+
+    // Without the footer and with half a record at the end.
+    g_assert_true(g_file_get_contents(filename, &contents, &length, NULL));
+    length -= sizeof(GEyeRecordingFooter) + sizeof(GEyeRecord) / 2;
+    g_assert_true(g_file_set_contents(unclosed, contents, length, NULL));
+
+    recording = geye_recording_open(unclosed, &error);
+    g_assert_no_error(error);
+    g_assert_null(geye_recording_get_footer(recording));
+    geye_recording_get_records(recording, &n_records);
+    g_assert_cmpuint(n_records, ==, N_SAMPLES + N_SAMPLES / 100 - 1);
+    check_find(recording);
+    g_object_unref(recording);
+
+    g_free(contents);
+    remove_file(unclosed);
+    remove_file(filename);
+}
+
+static void
+recording_index(void)
+{
+    gchar *filename = write_recording();
+    gchar *index = g_strconcat(filename, ".idx", NULL);
+    GError *error = NULL;
+    GEyeRecording *recording;
+
+    recording = geye_recording_open(filename, &error);
+    g_assert_true(geye_recording_save_index(recording, &error));
+    g_assert_no_error(error);
+    g_assert_true(g_file_test(index, G_FILE_TEST_IS_REGULAR));
+    g_object_unref(recording);
+
+    // Loaded from the file.
+    recording = geye_recording_open(filename, &error);
+    g_assert_no_error(error);
+    check_find(recording);
+    g_object_unref(recording);
+
+    // An index that doesn't belong to the recording is rebuilt.
+    g_assert_true(g_file_set_contents(index, "GEYEIDX1", 8, NULL));
+    recording = geye_recording_open(filename, &error);
+    g_assert_no_error(error);
+    check_find(recording);
+    g_object_unref(recording);
+
+    g_free(index);
+    remove_file(filename);
+}
+
+static void
+recording_invalid(void)
+{
+    gchar *filename = temp_filename("invalid.geye");
+    GError *error = NULL;
+
+    g_assert_true(g_file_set_contents(filename, "not a recording", -1, NULL));
+    g_assert_null(geye_recording_open(filename, &error));
+    g_assert_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+    g_clear_error(&error);
+
+    g_assert_null(geye_recording_open("/nonexistent.geye", &error));
+    g_assert_nonnull(error);
+    g_clear_error(&error);
+
+    remove_file(filename);
+}
+
+int main(int argc, char** argv)
+{
+    setlocale(LC_ALL, "");
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/Recording/open", recording_open);
+    g_test_add_func("/Recording/unclosed", recording_unclosed);
+    g_test_add_func("/Recording/index", recording_index);
+    g_test_add_func("/Recording/invalid", recording_invalid);
+
+    return g_test_run();
+}
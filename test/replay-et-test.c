@@ -0,0 +1,371 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <geye.h>
+#include <glib/gstdio.h>
+#include <locale.h>
+
+typedef struct {
+    GMainContext   *context;
+    GMainLoop      *loop;
+    gchar          *filename;
+    GEyeReplayEt   *et;
+    guint           n_samples;
+    guint           n_fixations;
+    guint           n_finished;
+    gdouble         last_time;
+} ReplayFixture;
+
+/*
+ * Writes an ASC file with n_samples binocular samples at 1000 Hz and a
+ * fixation that starts at the first sample and ends at the last one.
+ */
+static gchar*
+write_asc(guint n_samples)
+{
+    GString *contents = g_string_new(
+            "** VERSION: EYELINK II 1\n"
+            "START\t1000 \tLEFT\tRIGHT\tSAMPLES\tEVENTS\n"
+            "SAMPLES\tGAZE\tLEFT\tRIGHT\tRATE\t1000.00\n"
+            "SFIX L   1000\n"
+            );
+    gchar *dir = g_dir_make_tmp("geye-replay-XXXXXX", NULL);
+    gchar *filename = g_build_filename(dir, "session.asc", NULL);
+    guint i;
+
+    for (i = 0; i < n_samples; i++)
+        g_string_append_printf(
+                contents, "%u\t%u.0\t100.0\t1000.0\t%u.0\t100.0\t1000.0\n",
+                1000 + i, i, i
+                );
+    g_string_append_printf(
+            contents, "EFIX L   1000\t%u\t%u\t100.0\t100.0\t1000\n",
+            1000 + n_samples - 1, n_samples
+            );
+    g_assert_true(g_file_set_contents(filename, contents->str, -1, NULL));
+
+    g_string_free(contents, TRUE);
+    g_free(dir);
+    return filename;
+}
+
+static gint
+quit_main_loop(gpointer data)
+{
+    GMainLoop *loop = data;
+    g_main_loop_quit(loop);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+on_binocular_sample(GEyeEyetracker *et, GEyeBinocularSample *sample, gpointer data)
+{
+    ReplayFixture *fix = data;
+    g_assert_cmpuint(sample->valid, ==, GEYE_BINOCULAR);
+    g_assert_cmpfloat(sample->parent.time, >=, fix->last_time);
+    fix->last_time = sample->parent.time;
+    fix->n_samples++;
+}
+
+static void
+on_fixation(GEyeEyetracker *et, GEyeFixation *fixation, gpointer data)
+{
+    ReplayFixture *fix = data;
+    fix->n_fixations++;
+}
+
+static void
+on_finished(GEyeReplayEt *et, gpointer data)
+{
+    ReplayFixture *fix = data;
+    fix->n_finished++;
+    g_main_loop_quit(fix->loop);
+}
+
+static void
+replay_fixture_setup(ReplayFixture *fix, gconstpointer data)
+{
+    const guint *n_samples = data;
+    GSource *timeout;
+
+    fix->context = g_main_context_new();
+    g_main_context_push_thread_default(fix->context);
+    fix->loop = g_main_loop_new(fix->context, FALSE);
+
+    timeout = g_timeout_source_new_seconds(10);
+    g_source_set_callback(timeout, quit_main_loop, fix->loop, NULL);
+    g_source_attach(timeout, fix->context);
+    g_source_unref(timeout);
+
+    fix->filename = write_asc(*n_samples);
+    fix->et = geye_replay_et_new(fix->filename);
+    g_object_set(fix->et, "sample-delivery", GEYE_DELIVER_BINOCULAR, NULL);
+    g_signal_connect(
+            fix->et, "binocular-sample", G_CALLBACK(on_binocular_sample), fix
+            );
+    g_signal_connect(fix->et, "fixation", G_CALLBACK(on_fixation), fix);
+    g_signal_connect(fix->et, "finished", G_CALLBACK(on_finished), fix);
+}
+
+static void
+replay_fixture_tear_down(ReplayFixture *fix, gconstpointer data)
+{
+    gchar *dir = g_path_get_dirname(fix->filename);
+
+    g_clear_object(&fix->et);
+    g_remove(fix->filename);
+    g_remove(dir);
+    g_free(dir);
+    g_free(fix->filename);
+    g_main_loop_unref(fix->loop);
+
+    g_main_context_pop_thread_default(fix->context);
+    g_main_context_unref(fix->context);
+}
+
+static void
+replay_connect_error(void)
+{
+    GEyeReplayEt *et = geye_replay_et_new("/nonexistent-dir/session.geye");
+    GError *error = NULL;
+
+    geye_eyetracker_connect(GEYE_EYETRACKER(et), &error);
+    g_assert_error(
+            error, GEYE_EYETRACKER_ERROR, GEYE_EYETRACKER_ERROR_UNABLE_TO_CONNECT
+            );
+    g_error_free(error);
+
+    geye_eyetracker_start_tracking(GEYE_EYETRACKER(et), &error);
+    g_assert_error(
+            error, GEYE_EYETRACKER_ERROR, GEYE_EYETRACKER_ERROR_INCORRECT_MODE
+            );
+    g_error_free(error);
+    g_object_unref(et);
+}
+
+static void
+replay_play(ReplayFixture *fix, gconstpointer data)
+{
+    GEyeEyetracker *et = GEYE_EYETRACKER(fix->et);
+    const guint *n_samples = data;
+    GError *error = NULL;
+    gboolean tracking;
+    gchar *info;
+
+    geye_replay_et_set_speed(fix->et, 0);
+    geye_eyetracker_connect(et, &error);
+    g_assert_no_error(error);
+    info = geye_eyetracker_get_tracker_info(et);
+    g_assert_cmpstr(info, ==, "EYELINK II 1");
+    g_free(info);
+
+    geye_eyetracker_start_tracking(et, &error);
+    g_assert_no_error(error);
+    g_main_loop_run(fix->loop);
+
+    g_assert_cmpuint(fix->n_finished, ==, 1);
+    g_assert_cmpuint(fix->n_samples, ==, *n_samples);
+    g_assert_cmpuint(fix->n_fixations, ==, 2);
+    g_object_get(fix->et, "tracking", &tracking, NULL);
+    g_assert_false(tracking);
+
+    // Starting again plays the recording from the start.
+    fix->last_time = 0;
+    geye_eyetracker_start_tracking(et, &error);
+    g_assert_no_error(error);
+    g_main_loop_run(fix->loop);
+    g_assert_cmpuint(fix->n_finished, ==, 2);
+    g_assert_cmpuint(fix->n_samples, ==, 2 * *n_samples);
+
+    geye_eyetracker_disconnect(et);
+}
+
+static void
+replay_speed(ReplayFixture *fix, gconstpointer data)
+{
+    GEyeEyetracker *et = GEYE_EYETRACKER(fix->et);
+    const guint *n_samples = data;
+    GError *error = NULL;
+    gint64 start, elapsed;
+
+    // The recording lasts n_samples ms, played at twice the speed.
+    geye_replay_et_set_speed(fix->et, 2);
+    geye_eyetracker_connect(et, &error);
+    g_assert_no_error(error);
+
+    start = g_get_monotonic_time();
+    geye_eyetracker_start_tracking(et, &error);
+    g_assert_no_error(error);
+    g_main_loop_run(fix->loop);
+    elapsed = g_get_monotonic_time() - start;
+
+    g_assert_cmpuint(fix->n_finished, ==, 1);
+    g_assert_cmpuint(fix->n_samples, ==, *n_samples);
+    g_assert_cmpint(elapsed, >=, *n_samples * 1000 / 2 - 10000);
+    g_assert_cmpint(elapsed, <, *n_samples * 1000);
+}
+
+static void
+replay_pause(ReplayFixture *fix, gconstpointer data)
+{
+    GEyeEyetracker *et = GEYE_EYETRACKER(fix->et);
+    const guint *n_samples = data;
+    GError *error = NULL;
+    GSource *timeout;
+    guint paused;
+
+    geye_eyetracker_connect(et, &error);
+    g_assert_no_error(error);
+    geye_eyetracker_start_tracking(et, &error);
+    g_assert_no_error(error);
+
+    // Stop halfway, tracking continues where it stopped.
+    timeout = g_timeout_source_new(*n_samples / 2);
+    g_source_set_callback(timeout, quit_main_loop, fix->loop, NULL);
+    g_source_attach(timeout, fix->context);
+    g_source_unref(timeout);
+    g_main_loop_run(fix->loop);
+    geye_eyetracker_stop_tracking(et);
+    while (g_main_context_iteration(fix->context, FALSE))
+        ;
+    paused = fix->n_samples;
+    g_assert_cmpuint(paused, >, 0);
+    g_assert_cmpuint(paused, <, *n_samples);
+
+    geye_eyetracker_start_tracking(et, &error);
+    g_assert_no_error(error);
+    g_main_loop_run(fix->loop);
+    g_assert_cmpuint(fix->n_finished, ==, 1);
+    g_assert_cmpuint(fix->n_samples, ==, *n_samples);
+}
+
+typedef struct {
+    guint   tracking;
+    guint   recording;
+    guint   connected;
+    guint   disconnected;
+} StateChanges;
+
+static void
+on_state_notify(GObject *et, GParamSpec *spec, gpointer data)
+{
+    StateChanges *changes = data;
+    (void) et;
+
+    if (g_strcmp0(spec->name, "tracking") == 0)
+        changes->tracking++;
+    else if (g_strcmp0(spec->name, "recording") == 0)
+        changes->recording++;
+}
+
+static void
+on_connected(GEyeEyetracker *et, gboolean connected, gpointer data)
+{
+    StateChanges *changes = data;
+    (void) et;
+
+    if (connected)
+        changes->connected++;
+    else
+        changes->disconnected++;
+}
+
+static void
+replay_disconnect(ReplayFixture *fix, gconstpointer data)
+{
+    GEyeEyetracker *et = GEYE_EYETRACKER(fix->et);
+    StateChanges changes = {0};
+    GError *error = NULL;
+    gboolean tracking, recording;
+    (void) data;
+
+    g_signal_connect(
+            fix->et, "notify", G_CALLBACK(on_state_notify), &changes
+            );
+    g_signal_connect(
+            fix->et, "connected", G_CALLBACK(on_connected), &changes
+            );
+
+    geye_eyetracker_connect(et, &error);
+    g_assert_no_error(error);
+    geye_eyetracker_start_tracking(et, &error);
+    g_assert_no_error(error);
+    geye_eyetracker_start_recording(et, &error);
+    g_assert_no_error(error);
+    while (g_main_context_iteration(fix->context, FALSE))
+        ;
+    g_assert_cmpuint(changes.connected, ==, 1);
+
+    // Every property that changes is notified.
+    geye_eyetracker_disconnect(et);
+    while (g_main_context_iteration(fix->context, FALSE))
+        ;
+    g_object_get(fix->et, "tracking", &tracking, "recording", &recording,
+                 NULL);
+    g_assert_false(tracking);
+    g_assert_false(recording);
+    g_assert_cmpuint(changes.tracking, ==, 2);
+    g_assert_cmpuint(changes.recording, ==, 2);
+    g_assert_cmpuint(changes.disconnected, ==, 1);
+
+    // Nothing changes the second time.
+    geye_eyetracker_disconnect(et);
+    geye_eyetracker_stop_recording(et);
+    while (g_main_context_iteration(fix->context, FALSE))
+        ;
+    g_assert_cmpuint(changes.recording, ==, 2);
+    g_assert_cmpuint(changes.disconnected, ==, 1);
+}
+
+int main(int argc, char** argv)
+{
+    static const guint n_fast = 5000, n_timed = 400;
+
+    setlocale(LC_ALL, "");
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/ReplayEt/connect_error", replay_connect_error);
+    g_test_add("/ReplayEt/play",
+               ReplayFixture,
+               &n_fast,
+               replay_fixture_setup,
+               replay_play,
+               replay_fixture_tear_down);
+    g_test_add("/ReplayEt/speed",
+               ReplayFixture,
+               &n_timed,
+               replay_fixture_setup,
+               replay_speed,
+               replay_fixture_tear_down);
+    g_test_add("/ReplayEt/pause",
+               ReplayFixture,
+               &n_timed,
+               replay_fixture_setup,
+               replay_pause,
+               replay_fixture_tear_down);
+    g_test_add("/ReplayEt/disconnect",
+               ReplayFixture,
+               &n_timed,
+               replay_fixture_setup,
+               replay_disconnect,
+               replay_fixture_tear_down);
+
+    return g_test_run();
+}
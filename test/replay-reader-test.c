@@ -0,0 +1,332 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <replay-reader.h>
+#include <recorder.h>
+#include <locale.h>
+#include <math.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+// Longer than all buffers of the reader together.
+#define N_SAMPLES 50000
+
+static gchar*
+temp_file(const gchar *name)
+{
+    gchar *dir = g_dir_make_tmp("geye-replay-XXXXXX", NULL);
+    gchar *filename;
+
+    g_assert_nonnull(dir);
+    filename = g_build_filename(dir, name, NULL);
+    g_free(dir);
+    return filename;
+}
+
+static void
+remove_file(gchar *filename)
+{
+    gchar *dir = g_path_get_dirname(filename);
+    g_remove(filename);
+    g_remove(dir);
+    g_free(dir);
+    g_free(filename);
+}
+
+/* Collects all records of the reader. */
+static GArray*
+read_all(GEyeReplayReader *reader)
+{
+    GArray *records = g_array_new(FALSE, FALSE, sizeof(GEyeRecord));
+
+    while (!geye_replay_reader_at_end(reader)) {
+        guint n;
+        const GEyeRecord *buffer = geye_replay_reader_next(
+                reader, &n, G_USEC_PER_SEC
+                );
+        if (!buffer)
+            continue;
+        g_array_append_vals(records, buffer, n);
+        geye_replay_reader_release(reader);
+    }
+    return records;
+}
+
+static void
+replay_reader_recording(void)
+{
+    gchar *filename = temp_file("session.geye");
+    GError *error = NULL;
+    GEyeRecorder *recorder;
+    GEyeReplayReader *reader;
+    const GEyeRecordingHeader *header;
+    GArray *records;
+    guint i;
+
+    recorder = geye_recorder_new(
+            filename, "EyeLink 3 version 5.0", 1920, 1080, 12345, &error
+            );
+    g_assert_no_error(error);
+
+    for (i = 0; i < N_SAMPLES; i++) {
+        GEyeBinocularSample sample = {
+            .parent = {
+                .type = GEYE_EVENT_SAMPLE,
+                .eye = GEYE_BINOCULAR,
+                .time = i / 1000.0,
+                .tracker_time = i
+            },
+            .valid = GEYE_BINOCULAR,
+            .left_x = i, .left_y = 1,
+            .right_x = 2, .right_y = 3
+        };
+        geye_recorder_sample(recorder, &sample);
+        if (i % 100 == 0)
+            geye_recorder_commit(recorder);
+    }
+    GEyeFixation fixation = {
+        .parent = {.type = GEYE_EVENT_FIX_END, .eye = GEYE_LEFT, .time = 49.5},
+        .end_time = 49.75, .x = 10, .y = 20
+    };
+    geye_recorder_fixation(recorder, &fixation);
+    geye_recorder_flush(recorder);
+    g_assert_true(geye_recorder_close(recorder, &error));
+
+    reader = geye_replay_reader_new(filename, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(reader);
+    g_assert_cmpint(
+            geye_replay_reader_get_format(reader), ==,
+            GEYE_REPLAY_FORMAT_RECORDING
+            );
+    header = geye_replay_reader_get_header(reader);
+    g_assert_cmpstr(header->tracker_info, ==, "EyeLink 3 version 5.0");
+    g_assert_cmpint(header->start_time, ==, 12345);
+
+    records = read_all(reader);
+    // The footer isn't taken for a record.
+    g_assert_cmpuint(records->len, ==, N_SAMPLES + 1);
+    for (i = 0; i < N_SAMPLES; i++) {
+        GEyeRecord *record = &g_array_index(records, GEyeRecord, i);
+        g_assert_cmpuint(record->type, ==, GEYE_RECORD_SAMPLE);
+        g_assert_cmpfloat(record->data.sample.left_x, ==, i);
+    }
+    g_assert_cmpuint(
+            g_array_index(records, GEyeRecord, i).type, ==,
+            GEYE_RECORD_FIXATION
+            );
+
+    g_assert_true(geye_replay_reader_close(reader, &error));
+    g_assert_no_error(error);
+    g_array_unref(records);
+    remove_file(filename);
+}
+
+static const gchar *asc_contents =
+    "** CONVERTED FROM session.edf using edfapi 4.2\n"
+    "** VERSION: EYELINK II 1\n"
+    "**\n"
+    "MSG\t1000 DISPLAY_COORDS 0 0 1919 1079\n"
+    "START\t2000 \tLEFT\tRIGHT\tSAMPLES\tEVENTS\n"
+    "SAMPLES\tGAZE\tLEFT\tRIGHT\tRATE\t1000.00\tTRACKING\tCR\n"
+    "SFIX L   2000\n"
+    "2000\t  100.0\t  200.0\t 1000.0\t  110.0\t  210.0\t 1000.0\t.....\n"
+    "2001\t  101.0\t  201.0\t 1000.0\t    .\t    .\t    0.0\t.....\n"
+    "EFIX L   2000\t2001\t2\t  100.5\t  200.5\t   1000\n"
+    "SSACC R  2002\n"
+    "ESACC R  2002\t2010\t9\t  110.0\t  210.0\t  500.0\t  210.0\t 10.5\t  400\n"
+    "MSG\t2011 a message\n"
+    "END\t2012 \tSAMPLES\tEVENTS\tRES\t 38.0\t 35.0\n";
+
+static void
+replay_reader_asc(void)
+{
+    gchar *filename = temp_file("session.asc");
+    GError *error = NULL;
+    GEyeReplayReader *reader;
+    const GEyeRecordingHeader *header;
+    GArray *records;
+    GEyeRecord *r;
+
+    g_assert_true(g_file_set_contents(filename, asc_contents, -1, NULL));
+
+    reader = geye_replay_reader_new(filename, &error);
+    g_assert_no_error(error);
+    g_assert_cmpint(
+            geye_replay_reader_get_format(reader), ==, GEYE_REPLAY_FORMAT_ASC
+            );
+    header = geye_replay_reader_get_header(reader);
+    g_assert_cmpstr(header->tracker_info, ==, "EYELINK II 1");
+    g_assert_cmpfloat(header->disp_width, ==, 1920);
+    g_assert_cmpfloat(header->disp_height, ==, 1080);
+
+    records = read_all(reader);
+    g_assert_cmpuint(records->len, ==, 6);
+    r = (GEyeRecord*) records->data;
+
+    g_assert_cmpuint(r[0].type, ==, GEYE_RECORD_FIXATION);
+    g_assert_cmpuint(r[0].event, ==, GEYE_EVENT_FIX_START);
+    g_assert_cmpuint(r[0].eye, ==, GEYE_LEFT);
+    g_assert_cmpfloat(r[0].time, ==, 0);
+
+    g_assert_cmpuint(r[1].type, ==, GEYE_RECORD_SAMPLE);
+    g_assert_cmpuint(r[1].eye, ==, GEYE_BINOCULAR);
+    g_assert_cmpuint(r[1].valid, ==, GEYE_BINOCULAR);
+    g_assert_cmpfloat(r[1].tracker_time, ==, 2000);
+    g_assert_cmpfloat(r[1].data.sample.right_x, ==, 110);
+    g_assert_cmpfloat(r[1].data.sample.right_y, ==, 210);
+
+    // The right eye is missing.
+    g_assert_cmpuint(r[2].valid, ==, GEYE_LEFT);
+    g_assert_cmpfloat(r[2].time, ==, 0.001);
+    g_assert_cmpfloat(r[2].data.sample.left_x, ==, 101);
+    g_assert_true(isnan(r[2].data.sample.right_x));
+
+    g_assert_cmpuint(r[3].event, ==, GEYE_EVENT_FIX_END);
+    g_assert_cmpfloat(r[3].data.fixation.end_time, ==, 0.001);
+    g_assert_cmpfloat(r[3].data.fixation.x, ==, 100.5);
+
+    g_assert_cmpuint(r[4].event, ==, GEYE_EVENT_SAC_START);
+    g_assert_cmpuint(r[4].eye, ==, GEYE_RIGHT);
+
+    g_assert_cmpuint(r[5].event, ==, GEYE_EVENT_SAC_END);
+    g_assert_cmpfloat(r[5].time, ==, 0.002);
+    g_assert_cmpfloat(r[5].data.saccade.end_time, ==, 0.010);
+    g_assert_cmpfloat(r[5].data.saccade.end_x, ==, 500);
+    g_assert_cmpfloat(r[5].data.saccade.amplitude, ==, 10.5);
+    g_assert_cmpfloat(r[5].data.saccade.peak_velocity, ==, 400);
+
+    g_assert_true(geye_replay_reader_close(reader, &error));
+    g_array_unref(records);
+    remove_file(filename);
+}
+
+// The velocity of both eyes and the resolution follow the gaze of both.
+static const gchar *asc_velocity_contents =
+    "** VERSION: EYELINK II 1\n"
+    "START\t2000 \tLEFT\tRIGHT\tSAMPLES\tEVENTS\n"
+    "SAMPLES\tGAZE\tLEFT\tRIGHT\tVEL\tRES\tRATE\t1000.00\tTRACKING\tCR\n"
+    "2000\t  100.0\t  200.0\t 1000.0\t  110.0\t  210.0\t 1000.0"
+    "\t   1.5\t   2.5\t   3.5\t   4.5\t  38.0\t  35.0\t.....\n"
+    "2001\t  101.0\t  201.0\t 1000.0\t    .\t    .\t    0.0"
+    "\t   1.5\t   2.5\t    .\t    .\t  38.0\t  35.0\t.....\n"
+    "2002\t  102.0\t  202.0\t 1000.0\t  112.0\t  212.0\t 1000.0\n";
+
+static void
+replay_reader_asc_velocity(void)
+{
+    gchar *filename = temp_file("velocity.asc");
+    GError *error = NULL;
+    GEyeReplayReader *reader;
+    GArray *records;
+    GEyeRecord *r;
+
+    g_assert_true(
+            g_file_set_contents(filename, asc_velocity_contents, -1, NULL)
+            );
+
+    reader = geye_replay_reader_new(filename, &error);
+    g_assert_no_error(error);
+
+    records = read_all(reader);
+    g_assert_cmpuint(records->len, ==, 2);
+    r = (GEyeRecord*) records->data;
+
+    g_assert_cmpuint(r[0].valid, ==, GEYE_BINOCULAR);
+    g_assert_cmpfloat(r[0].data.sample.left_x, ==, 100);
+    g_assert_cmpfloat(r[0].data.sample.left_y, ==, 200);
+    g_assert_cmpfloat(r[0].data.sample.right_x, ==, 110);
+    g_assert_cmpfloat(r[0].data.sample.right_y, ==, 210);
+
+    g_assert_cmpuint(r[1].valid, ==, GEYE_LEFT);
+    g_assert_cmpfloat(r[1].data.sample.left_x, ==, 101);
+    g_assert_true(isnan(r[1].data.sample.right_x));
+
+    // The last sample lacks the columns the SAMPLES line announced.
+    g_assert_false(geye_replay_reader_close(reader, &error));
+    g_assert_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+    g_error_free(error);
+    g_array_unref(records);
+    remove_file(filename);
+}
+
+static void
+replay_reader_close_early(void)
+{
+    gchar *filename = temp_file("session.geye");
+    GError *error = NULL;
+    GEyeRecorder *recorder;
+    GEyeReplayReader *reader;
+    guint i, n;
+
+    recorder = geye_recorder_new(filename, NULL, 0, 0, 0, &error);
+    g_assert_no_error(error);
+    for (i = 0; i < N_SAMPLES; i++) {
+        GEyeBinocularSample sample = {
+            .parent = {.eye = GEYE_LEFT, .time = i / 1000.0},
+            .valid = GEYE_LEFT
+        };
+        geye_recorder_sample(recorder, &sample);
+        if (i % 100 == 0)
+            geye_recorder_commit(recorder);
+    }
+    geye_recorder_flush(recorder);
+    g_assert_true(geye_recorder_close(recorder, &error));
+
+    // The reader waits for an empty buffer, closing must not hang.
+    reader = geye_replay_reader_new(filename, &error);
+    g_assert_no_error(error);
+    g_assert_nonnull(geye_replay_reader_next(reader, &n, G_USEC_PER_SEC));
+    geye_replay_reader_release(reader);
+    g_assert_false(geye_replay_reader_at_end(reader));
+    g_assert_true(geye_replay_reader_close(reader, &error));
+    remove_file(filename);
+}
+
+static void
+replay_reader_invalid(void)
+{
+    gchar *filename = temp_file("notes.txt");
+    GError *error = NULL;
+
+    g_assert_true(g_file_set_contents(filename, "Not a recording\n", -1, NULL));
+    g_assert_null(geye_replay_reader_new(filename, &error));
+    g_assert_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+    g_clear_error(&error);
+    remove_file(filename);
+
+    g_assert_null(geye_replay_reader_new("/nonexistent-dir/x.geye", &error));
+    g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+    g_error_free(error);
+}
+
+int main(int argc, char** argv)
+{
+    setlocale(LC_ALL, "");
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/ReplayReader/recording", replay_reader_recording);
+    g_test_add_func("/ReplayReader/asc", replay_reader_asc);
+    g_test_add_func("/ReplayReader/asc_velocity", replay_reader_asc_velocity);
+    g_test_add_func("/ReplayReader/close_early", replay_reader_close_early);
+    g_test_add_func("/ReplayReader/invalid", replay_reader_invalid);
+
+    return g_test_run();
+}
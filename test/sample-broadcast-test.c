@@ -0,0 +1,267 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <gio/gio.h>
+#include <sample-broadcast.h>
+#include <locale.h>
+
+#define RATE 500.0
+
+static GEyeBinocularSample
+make_sample(guint i)
+{
+    GEyeBinocularSample sample = {
+        .parent = {
+            .type = GEYE_EVENT_SAMPLE,
+            .eye = GEYE_BINOCULAR,
+            .time = i / RATE,
+            .tracker_time = i * 2
+        },
+        .valid = GEYE_BINOCULAR,
+        .left_x = i,
+        .left_y = -(gdouble) i,
+        .right_x = i,
+        .right_y = -(gdouble) i
+    };
+    return sample;
+}
+
+static void
+push_samples(GEyeSampleBroadcast *broadcast, guint first, guint n)
+{
+    guint i;
+
+    for (i = first; i < first + n; i++) {
+        GEyeBinocularSample sample = make_sample(i);
+        geye_sample_broadcast_push(broadcast, &sample);
+    }
+    geye_sample_broadcast_publish(broadcast);
+}
+
+static void
+sample_broadcast_decimation(void)
+{
+    GEyeSampleBroadcast *broadcast = geye_sample_broadcast_new(1024);
+    GEyeSubscriber *all, *fourth, *display;
+    GEyeBinocularSample samples[200];
+    guint n, i;
+
+    all = geye_sample_broadcast_subscribe(broadcast, 1, 0, NULL);
+    fourth = geye_sample_broadcast_subscribe(broadcast, 4, 0, NULL);
+    display = geye_sample_broadcast_subscribe(broadcast, 1, 1 / 60.0, NULL);
+    g_assert_cmpuint(geye_subscriber_get_decimation(fourth), ==, 4);
+    g_assert_cmpfloat(geye_subscriber_get_interval(display), ==, 1 / 60.0);
+
+    push_samples(broadcast, 0, 100);
+
+    n = geye_subscriber_read(all, samples, G_N_ELEMENTS(samples), 0);
+    g_assert_cmpuint(n, ==, 100);
+    for (i = 0; i < n; i++)
+        g_assert_cmpfloat(samples[i].left_x, ==, i);
+
+    n = geye_subscriber_read(fourth, samples, G_N_ELEMENTS(samples), 0);
+    g_assert_cmpuint(n, ==, 25);
+    for (i = 0; i < n; i++)
+        g_assert_cmpfloat(samples[i].left_x, ==, i * 4);
+
+    // The first sample at or after every 1/60 s of the 0.2 s.
+    n = geye_subscriber_read(display, samples, G_N_ELEMENTS(samples), 0);
+    g_assert_cmpuint(n, ==, 12);
+    for (i = 0; i < n; i++) {
+        g_assert_cmpfloat(samples[i].parent.time, >=, i / 60.0);
+        g_assert_cmpfloat(samples[i].parent.time, <, i / 60.0 + 1 / RATE);
+    }
+
+    // Everything was read.
+    g_assert_cmpuint(geye_subscriber_read(all, samples, 1, 0), ==, 0);
+    g_assert_cmpuint(geye_subscriber_get_lost(all), ==, 0);
+
+    g_object_unref(all);
+    g_object_unref(fourth);
+    g_object_unref(display);
+    geye_sample_broadcast_unref(broadcast);
+}
+
+static void
+sample_broadcast_slow_subscriber(void)
+{
+    GEyeSampleBroadcast *broadcast = geye_sample_broadcast_new(16);
+    GEyeSubscriber *fast, *slow;
+    GEyeBinocularSample samples[32];
+    guint n, i, received = 0;
+
+    fast = geye_sample_broadcast_subscribe(broadcast, 1, 0, NULL);
+    slow = geye_sample_broadcast_subscribe(broadcast, 1, 0, NULL);
+
+    for (i = 0; i < 100; i++) {
+        push_samples(broadcast, i, 1);
+        n = geye_subscriber_read(fast, samples, G_N_ELEMENTS(samples), 0);
+        g_assert_cmpuint(n, ==, 1);
+        g_assert_cmpfloat(samples[0].left_x, ==, i);
+        received += n;
+    }
+    g_assert_cmpuint(received, ==, 100);
+    g_assert_cmpuint(geye_subscriber_get_lost(fast), ==, 0);
+
+    // Only the slow one lost samples, it gets the newest ones.
+    n = geye_subscriber_read(slow, samples, G_N_ELEMENTS(samples), 0);
+    g_assert_cmpuint(n, ==, 16);
+    g_assert_cmpfloat(samples[0].left_x, ==, 84);
+    g_assert_cmpfloat(samples[15].left_x, ==, 99);
+    g_assert_cmpuint(geye_subscriber_get_lost(slow), ==, 84);
+
+    g_object_unref(fast);
+    g_object_unref(slow);
+    geye_sample_broadcast_unref(broadcast);
+}
+
+static gpointer
+producer_thread(gpointer data)
+{
+    GEyeSampleBroadcast *broadcast = data;
+
+    g_usleep(20000);
+    push_samples(broadcast, 0, 10);
+    return NULL;
+}
+
+static void
+sample_broadcast_wait(void)
+{
+    GEyeSampleBroadcast *broadcast = geye_sample_broadcast_new(64);
+    GEyeSubscriber *subscriber;
+    GEyeBinocularSample samples[16];
+    GThread *thread;
+    guint n;
+
+    subscriber = geye_sample_broadcast_subscribe(broadcast, 2, 0, NULL);
+    g_assert_cmpuint(geye_subscriber_read(subscriber, samples, 16, 1000), ==, 0);
+
+    thread = g_thread_new("producer", producer_thread, broadcast);
+    n = geye_subscriber_read(subscriber, samples, G_N_ELEMENTS(samples), -1);
+    g_assert_cmpuint(n, ==, 5);
+    g_assert_cmpfloat(samples[4].left_x, ==, 8);
+    g_thread_join(thread);
+
+    g_object_unref(subscriber);
+    geye_sample_broadcast_unref(broadcast);
+}
+
+static void
+sample_broadcast_subscribers(void)
+{
+    GEyeSampleBroadcast *broadcast = geye_sample_broadcast_new(64);
+    GEyeSubscriber *subscribers[GEYE_MAX_SUBSCRIBERS];
+    GEyeSubscriber *extra;
+    GError *error = NULL;
+    guint i;
+
+    for (i = 0; i < GEYE_MAX_SUBSCRIBERS; i++) {
+        subscribers[i] = geye_sample_broadcast_subscribe(broadcast, 1, 0, NULL);
+        g_assert_nonnull(subscribers[i]);
+    }
+    extra = geye_sample_broadcast_subscribe(broadcast, 1, 0, &error);
+    g_assert_null(extra);
+    g_assert_error(error, G_IO_ERROR, G_IO_ERROR_NO_SPACE);
+    g_clear_error(&error);
+
+    // A new subscriber only receives what is pushed after it subscribed.
+    push_samples(broadcast, 0, 10);
+    g_object_unref(subscribers[3]);
+    subscribers[3] = geye_sample_broadcast_subscribe(broadcast, 1, 0, NULL);
+    g_assert_nonnull(subscribers[3]);
+    push_samples(broadcast, 10, 5);
+    {
+        GEyeBinocularSample samples[32];
+        g_assert_cmpuint(
+                geye_subscriber_read(subscribers[3], samples, 32, 0), ==, 5
+                );
+        g_assert_cmpfloat(samples[0].left_x, ==, 10);
+        g_assert_cmpuint(
+                geye_subscriber_read(subscribers[4], samples, 32, 0), ==, 15
+                );
+    }
+
+    // The broadcast lives on as long as its subscribers.
+    geye_sample_broadcast_unref(broadcast);
+    for (i = 0; i < GEYE_MAX_SUBSCRIBERS; i++)
+        g_object_unref(subscribers[i]);
+}
+
+static void
+on_ready(GEyeSubscriber *subscriber, gpointer data)
+{
+    guint *n_read = data;
+    GEyeBinocularSample samples[16];
+
+    *n_read += geye_subscriber_read(subscriber, samples, 16, 0);
+}
+
+static void
+sample_broadcast_attach(void)
+{
+    GEyeSampleBroadcast *broadcast = geye_sample_broadcast_new(64);
+    GMainContext *context = g_main_context_new();
+    GEyeSubscriber *subscriber, *idle;
+    guint n_read = 0, n_idle = 0;
+
+    subscriber = geye_sample_broadcast_subscribe(broadcast, 1, 0, NULL);
+    idle = geye_sample_broadcast_subscribe(broadcast, 1000, 0, NULL);
+    geye_subscriber_attach(subscriber, context);
+    geye_subscriber_attach(idle, context);
+    g_signal_connect(subscriber, "ready", G_CALLBACK(on_ready), &n_read);
+    g_signal_connect(idle, "ready", G_CALLBACK(on_ready), &n_idle);
+
+    push_samples(broadcast, 0, 10);
+    while (g_main_context_iteration(context, FALSE))
+        ;
+    g_assert_cmpuint(n_read, ==, 10);
+    g_assert_cmpuint(n_idle, ==, 1);
+
+    // The decimated subscriber isn't woken without samples for it.
+    push_samples(broadcast, 10, 10);
+    while (g_main_context_iteration(context, FALSE))
+        ;
+    g_assert_cmpuint(n_read, ==, 20);
+    g_assert_cmpuint(n_idle, ==, 1);
+
+    g_object_unref(subscriber);
+    g_object_unref(idle);
+    geye_sample_broadcast_unref(broadcast);
+    g_main_context_unref(context);
+}
+
+int main(int argc, char** argv)
+{
+    setlocale(LC_ALL, "");
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/SampleBroadcast/decimation", sample_broadcast_decimation);
+    g_test_add_func(
+            "/SampleBroadcast/slow_subscriber", sample_broadcast_slow_subscriber
+            );
+    g_test_add_func("/SampleBroadcast/wait", sample_broadcast_wait);
+    g_test_add_func(
+            "/SampleBroadcast/subscribers", sample_broadcast_subscribers
+            );
+    g_test_add_func("/SampleBroadcast/attach", sample_broadcast_attach);
+
+    return g_test_run();
+}
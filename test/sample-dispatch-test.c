@@ -0,0 +1,515 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <geye.h>
+#include <sample-dispatch.h>
+#include <locale.h>
+#include "allocation-counter.h"
+
+#define WARM_UP_ROUNDS      100
+#define NUM_ROUNDS          50000
+#define SAMPLES_PER_ROUND   4
+
+/*
+ * A minimal eyetracker that only serves as the emitter of the signals of
+ * the dispatch, so the test doesn't need libgeye.
+ */
+#define TEST_TYPE_ET test_et_get_type()
+G_DECLARE_FINAL_TYPE(TestEt, test_et, TEST, ET, GObject)
+
+struct _TestEt {
+    GObject parent;
+};
+
+enum {
+    PROP_NULL,
+    PROP_CONNECTED,
+    PROP_TRACKING,
+    PROP_RECORDING,
+    PROP_NUM_CALPOINTS,
+    PROP_TRACKER_INFO,
+    PROP_SAMPLE_DELIVERY,
+    PROP_SAMPLE_FIELDS,
+    PROP_DROP_POLICY,
+    PROP_SAMPLES_DROPPED
+};
+
+static void
+test_et_interface_init(GEyeEyetrackerInterface *iface)
+{
+    (void) iface;
+}
+
+G_DEFINE_TYPE_WITH_CODE(TestEt, test_et, G_TYPE_OBJECT,
+        G_IMPLEMENT_INTERFACE(GEYE_TYPE_EYETRACKER, test_et_interface_init)
+        )
+
+static void
+test_et_init(TestEt *self)
+{
+    (void) self;
+}
+
+static void
+test_et_set_property(
+        GObject        *object,
+        guint           property_id,
+        const GValue   *value,
+        GParamSpec     *spec
+        )
+{
+    (void) value;
+    G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, spec);
+}
+
+static void
+test_et_get_property(
+        GObject        *object,
+        guint           property_id,
+        GValue         *value,
+        GParamSpec     *spec
+        )
+{
+    switch (property_id) {
+        case PROP_CONNECTED:
+        case PROP_TRACKING:
+        case PROP_RECORDING:
+            g_value_set_boolean(value, FALSE);
+            break;
+        case PROP_NUM_CALPOINTS:
+        case PROP_SAMPLES_DROPPED:
+            g_value_set_uint(value, 0);
+            break;
+        case PROP_TRACKER_INFO:
+            g_value_set_string(value, NULL);
+            break;
+        case PROP_SAMPLE_DELIVERY:
+        case PROP_SAMPLE_FIELDS:
+        case PROP_DROP_POLICY:
+            g_param_value_set_default(spec, value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, spec);
+    }
+}
+
+static void
+test_et_class_init(TestEtClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+
+    object_class->set_property = test_et_set_property;
+    object_class->get_property = test_et_get_property;
+
+    g_object_class_override_property(object_class, PROP_CONNECTED, "connected");
+    g_object_class_override_property(object_class, PROP_TRACKING, "tracking");
+    g_object_class_override_property(object_class, PROP_RECORDING, "recording");
+    g_object_class_override_property(
+            object_class, PROP_NUM_CALPOINTS, "num-calpoints"
+            );
+    g_object_class_override_property(
+            object_class, PROP_TRACKER_INFO, "tracker-info"
+            );
+    g_object_class_override_property(
+            object_class, PROP_SAMPLE_DELIVERY, "sample-delivery"
+            );
+    g_object_class_override_property(
+            object_class, PROP_SAMPLE_FIELDS, "sample-fields"
+            );
+    g_object_class_override_property(
+            object_class, PROP_DROP_POLICY, "drop-policy"
+            );
+    g_object_class_override_property(
+            object_class, PROP_SAMPLES_DROPPED, "samples-dropped"
+            );
+}
+
+typedef struct {
+    guint sample;
+    guint samples;
+    guint binocular;
+    gdouble last_time;
+} Received;
+
+static void
+on_sample(GEyeEyetracker* et, GEyeSample* sample, gpointer data)
+{
+    (void) et;
+    Received *received = data;
+    g_assert_cmpfloat(sample->x, ==, sample->parent.time);
+    received->last_time = sample->parent.time;
+    received->sample++;
+}
+
+static void
+on_samples(GEyeEyetracker* et, GArray* samples, gpointer data)
+{
+    (void) et;
+    Received *received = data;
+    g_assert_cmpuint(samples->len, ==, SAMPLES_PER_ROUND);
+    received->samples += samples->len;
+}
+
+static void
+on_binocular_sample(GEyeEyetracker* et, GEyeBinocularSample* sample, gpointer data)
+{
+    (void) et;
+    Received *received = data;
+    g_assert_cmpfloat(sample->right_x, ==, sample->parent.time);
+    received->binocular++;
+}
+
+static void
+run_rounds(GEyeSampleDispatch *dispatch, GMainContext *context, guint rounds)
+{
+    static guint t = 0;
+    guint i, j;
+
+    for (i = 0; i < rounds; i++) {
+        for (j = 0; j < SAMPLES_PER_ROUND; j++, t++) {
+            GEyeSample sample = {
+                .parent = {.type = GEYE_EVENT_SAMPLE, .eye = GEYE_LEFT, .time = t},
+                .x = t,
+                .y = t
+            };
+            GEyeBinocularSample binocular = {
+                .parent = {.type = GEYE_EVENT_SAMPLE, .eye = GEYE_BINOCULAR, .time = t},
+                .valid = GEYE_BINOCULAR,
+                .left_x = t, .left_y = t, .right_x = t, .right_y = t
+            };
+            geye_sample_dispatch_sample(dispatch, &sample);
+            geye_sample_dispatch_batch_sample(dispatch, &sample);
+            geye_sample_dispatch_binocular(dispatch, &binocular);
+        }
+        geye_sample_dispatch_flush(dispatch);
+        while (g_main_context_iteration(context, FALSE))
+            ;
+    }
+}
+
+static void
+dispatch_signals(void)
+{
+    TestEt *et = g_object_new(TEST_TYPE_ET, NULL);
+    GMainContext *context = g_main_context_new();
+    GEyeSampleDispatch *dispatch;
+    Received received = {0};
+
+    dispatch = geye_sample_dispatch_new(GEYE_EYETRACKER(et), context, 64);
+    g_signal_connect(et, "sample", G_CALLBACK(on_sample), &received);
+    g_signal_connect(et, "samples", G_CALLBACK(on_samples), &received);
+    g_signal_connect(
+            et, "binocular-sample", G_CALLBACK(on_binocular_sample), &received
+            );
+
+    run_rounds(dispatch, context, 3);
+
+    g_assert_cmpuint(received.sample, ==, 3 * SAMPLES_PER_ROUND);
+    g_assert_cmpuint(received.samples, ==, 3 * SAMPLES_PER_ROUND);
+    g_assert_cmpuint(received.binocular, ==, 3 * SAMPLES_PER_ROUND);
+    g_assert_cmpuint(geye_sample_dispatch_get_dropped(dispatch), ==, 0);
+
+    geye_sample_dispatch_free(dispatch);
+    g_main_context_unref(context);
+    g_object_unref(et);
+}
+
+static void
+dispatch_drops_when_full(void)
+{
+    TestEt *et = g_object_new(TEST_TYPE_ET, NULL);
+    GMainContext *context = g_main_context_new();
+    GEyeSampleDispatch *dispatch;
+    Received received = {0};
+    GEyeSample sample = {.parent = {.type = GEYE_EVENT_SAMPLE}};
+    guint i;
+
+    dispatch = geye_sample_dispatch_new(GEYE_EYETRACKER(et), context, 16);
+    g_signal_connect(et, "sample", G_CALLBACK(on_sample), &received);
+
+    for (i = 0; i < 20; i++) {
+        sample.parent.time = sample.x = i;
+        geye_sample_dispatch_sample(dispatch, &sample);
+    }
+    geye_sample_dispatch_flush(dispatch);
+    while (g_main_context_iteration(context, FALSE))
+        ;
+
+    // The oldest samples are kept.
+    g_assert_cmpuint(received.sample, ==, 16);
+    g_assert_cmpfloat(received.last_time, ==, 15);
+    g_assert_cmpuint(geye_sample_dispatch_get_dropped(dispatch), ==, 4);
+
+    geye_sample_dispatch_free(dispatch);
+    g_main_context_unref(context);
+    g_object_unref(et);
+}
+
+static void
+on_samples_dropped(GEyeEyetracker* et, guint n_dropped, gpointer data)
+{
+    (void) et;
+    guint *dropped = data;
+    g_assert_cmpuint(n_dropped, >, 0);
+    *dropped += n_dropped;
+}
+
+static void
+dispatch_drop_oldest(void)
+{
+    TestEt *et = g_object_new(TEST_TYPE_ET, NULL);
+    GMainContext *context = g_main_context_new();
+    GEyeSampleDispatch *dispatch;
+    Received received = {0};
+    GEyeSample sample = {.parent = {.type = GEYE_EVENT_SAMPLE}};
+    guint dropped = 0, i;
+
+    dispatch = geye_sample_dispatch_new(GEYE_EYETRACKER(et), context, 16);
+    geye_sample_dispatch_set_policy(dispatch, GEYE_DROP_OLDEST);
+    g_signal_connect(et, "sample", G_CALLBACK(on_sample), &received);
+    g_signal_connect(
+            et, "samples-dropped", G_CALLBACK(on_samples_dropped), &dropped
+            );
+
+    for (i = 0; i < 20; i++) {
+        sample.parent.time = sample.x = i;
+        geye_sample_dispatch_sample(dispatch, &sample);
+    }
+    geye_sample_dispatch_flush(dispatch);
+    while (g_main_context_iteration(context, FALSE))
+        ;
+
+    // The newest samples are kept.
+    g_assert_cmpuint(received.sample, ==, 16);
+    g_assert_cmpfloat(received.last_time, ==, 19);
+    g_assert_cmpuint(geye_sample_dispatch_get_dropped(dispatch), ==, 4);
+    g_assert_cmpuint(dropped, ==, 4);
+
+    geye_sample_dispatch_free(dispatch);
+    g_main_context_unref(context);
+    g_object_unref(et);
+}
+
+static void
+on_fixation(GEyeEyetracker* et, GEyeFixation* fixation, gpointer data)
+{
+    (void) et;
+    Received *received = data;
+    // The samples before the fixation were emitted first.
+    g_assert_cmpfloat(received->last_time, <, fixation->parent.time);
+}
+
+static void
+dispatch_coalesce(void)
+{
+    TestEt *et = g_object_new(TEST_TYPE_ET, NULL);
+    GMainContext *context = g_main_context_new();
+    GEyeSampleDispatch *dispatch;
+    Received received = {0};
+    GEyeSample sample = {.parent = {.type = GEYE_EVENT_SAMPLE}};
+    GEyeFixation fixation = {.parent = {.type = GEYE_EVENT_FIX_START}};
+    guint dropped = 0, i;
+
+    dispatch = geye_sample_dispatch_new(GEYE_EYETRACKER(et), context, 64);
+    geye_sample_dispatch_set_policy(dispatch, GEYE_DROP_COALESCE);
+    g_signal_connect(et, "sample", G_CALLBACK(on_sample), &received);
+    g_signal_connect(et, "fixation", G_CALLBACK(on_fixation), &received);
+    g_signal_connect(
+            et, "samples-dropped", G_CALLBACK(on_samples_dropped), &dropped
+            );
+
+    // Two runs of samples of both eyes, separated by a fixation.
+    for (i = 0; i < 20; i++) {
+        sample.parent.time = sample.x = i;
+        sample.parent.eye = GEYE_LEFT;
+        geye_sample_dispatch_stamp(dispatch, 0, g_get_monotonic_time());
+        geye_sample_dispatch_sample(dispatch, &sample);
+        sample.parent.eye = GEYE_RIGHT;
+        geye_sample_dispatch_sample(dispatch, &sample);
+        if (i == 9) {
+            fixation.parent.time = 9.5;
+            geye_sample_dispatch_fixation(dispatch, &fixation);
+        }
+    }
+    geye_sample_dispatch_flush(dispatch);
+    while (g_main_context_iteration(context, FALSE))
+        ;
+
+    // The newest sample of either eye of both runs.
+    g_assert_cmpuint(received.sample, ==, 4);
+    g_assert_cmpfloat(received.last_time, ==, 19);
+    g_assert_cmpuint(geye_sample_dispatch_get_dropped(dispatch), ==, 36);
+    g_assert_cmpuint(dropped, ==, 36);
+    // Only the stamped samples that were emitted count as dispatched.
+    g_assert_cmpuint(geye_sample_dispatch_get_dispatched(dispatch), ==, 2);
+
+    geye_sample_dispatch_free(dispatch);
+    g_main_context_unref(context);
+    g_object_unref(et);
+}
+
+static void
+dispatch_latency(void)
+{
+    TestEt *et = g_object_new(TEST_TYPE_ET, NULL);
+    GMainContext *context = g_main_context_new();
+    GEyeSampleDispatch *dispatch;
+    GEyeLatencyHistogram *queue = geye_latency_histogram_new();
+    GEyeLatencyHistogram *total = geye_latency_histogram_new();
+    GEyeLatencyStats stats;
+    Received received = {0};
+    GEyeSample sample = {.parent = {.type = GEYE_EVENT_SAMPLE}};
+    gint64 now = g_get_monotonic_time();
+
+    dispatch = geye_sample_dispatch_new(GEYE_EYETRACKER(et), context, 16);
+    geye_sample_dispatch_set_latency(dispatch, queue, total);
+    g_signal_connect(et, "sample", G_CALLBACK(on_sample), &received);
+
+    // A sample that is emitted twice is measured once.
+    geye_sample_dispatch_stamp(dispatch, now - 2000, now);
+    geye_sample_dispatch_sample(dispatch, &sample);
+    geye_sample_dispatch_batch_sample(dispatch, &sample);
+    // The clocks weren't mapped for this one.
+    geye_sample_dispatch_stamp(dispatch, 0, now);
+    geye_sample_dispatch_sample(dispatch, &sample);
+    geye_sample_dispatch_flush(dispatch);
+    while (g_main_context_iteration(context, FALSE))
+        ;
+    g_assert_cmpuint(received.sample, ==, 2);
+    g_assert_cmpuint(geye_sample_dispatch_get_dispatched(dispatch), ==, 2);
+
+    geye_latency_histogram_get_stats(queue, &stats);
+    g_assert_cmpuint(stats.count, ==, 2);
+    g_assert_cmpint(stats.max, >=, 0);
+    geye_latency_histogram_get_stats(total, &stats);
+    g_assert_cmpuint(stats.count, ==, 1);
+    g_assert_cmpint(stats.max, >=, 2000);
+    g_assert_cmpint(stats.p50, ==, stats.max);
+
+    geye_sample_dispatch_free(dispatch);
+    geye_latency_histogram_free(queue);
+    geye_latency_histogram_free(total);
+    g_main_context_unref(context);
+    g_object_unref(et);
+}
+
+static void
+on_extended_sample(GEyeEyetracker* et, GEyeExtendedSample* sample, gpointer data)
+{
+    (void) et;
+    Received *received = data;
+    gdouble size;
+
+    g_assert_true(geye_extended_sample_get_pupil(sample, GEYE_LEFT, &size));
+    g_assert_cmpfloat(size, ==, sample->parent.time);
+    g_assert_cmpfloat(sample->parent.time, ==, received->last_time + 1);
+    received->last_time = sample->parent.time;
+    received->sample++;
+}
+
+static void
+dispatch_extended(void)
+{
+    TestEt *et = g_object_new(TEST_TYPE_ET, NULL);
+    GMainContext *context = g_main_context_new();
+    GEyeSampleDispatch *dispatch;
+    Received received = {.last_time = -1};
+    GEyeExtendedSample sample = {
+        .parent = {.type = GEYE_EVENT_SAMPLE, .eye = GEYE_LEFT},
+        .valid = GEYE_LEFT,
+        .fields = GEYE_SAMPLE_FIELD_PUPIL
+    };
+    guint i, round;
+
+    dispatch = geye_sample_dispatch_new(GEYE_EYETRACKER(et), context, 16);
+    g_signal_connect(
+            et, "extended-sample", G_CALLBACK(on_extended_sample), &received
+            );
+
+    // The slots wrap around while the ring is full at times.
+    for (round = 0; round < 5; round++) {
+        for (i = 0; i < 20; i++) {
+            sample.parent.time = sample.values[2] = received.last_time + 1 + i;
+            geye_sample_dispatch_extended(dispatch, &sample);
+        }
+        geye_sample_dispatch_flush(dispatch);
+        while (g_main_context_iteration(context, FALSE))
+            ;
+    }
+
+    g_assert_cmpuint(received.sample, ==, 5 * 16);
+    g_assert_cmpuint(geye_sample_dispatch_get_dropped(dispatch), ==, 5 * 4);
+
+    geye_sample_dispatch_free(dispatch);
+    g_main_context_unref(context);
+    g_object_unref(et);
+}
+
+static void
+dispatch_allocation_free(void)
+{
+#if defined(HAVE_ALLOCATION_COUNTER)
+    TestEt *et = g_object_new(TEST_TYPE_ET, NULL);
+    GMainContext *context = g_main_context_new();
+    GEyeSampleDispatch *dispatch;
+    Received received = {0};
+
+    dispatch = geye_sample_dispatch_new(GEYE_EYETRACKER(et), context, 1024);
+    g_signal_connect(et, "sample", G_CALLBACK(on_sample), &received);
+    g_signal_connect(et, "samples", G_CALLBACK(on_samples), &received);
+    g_signal_connect(
+            et, "binocular-sample", G_CALLBACK(on_binocular_sample), &received
+            );
+
+    // Let GLib set up its caches first.
+    run_rounds(dispatch, context, WARM_UP_ROUNDS);
+
+    allocation_counter_start();
+    run_rounds(dispatch, context, NUM_ROUNDS);
+    g_assert_cmpuint(allocation_counter_stop(), ==, 0);
+    g_assert_cmpuint(
+            received.sample, ==, (WARM_UP_ROUNDS + NUM_ROUNDS) * SAMPLES_PER_ROUND
+            );
+    g_assert_cmpuint(received.samples, ==, received.sample);
+    g_assert_cmpuint(received.binocular, ==, received.sample);
+
+    geye_sample_dispatch_free(dispatch);
+    g_main_context_unref(context);
+    g_object_unref(et);
+#else
+    g_test_skip("Counting allocations is only supported with glibc");
+#endif
+}
+
+int main(int argc, char** argv)
+{
+    setlocale(LC_ALL, "");
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/SampleDispatch/signals", dispatch_signals);
+    g_test_add_func("/SampleDispatch/drops_when_full", dispatch_drops_when_full);
+    g_test_add_func("/SampleDispatch/drop_oldest", dispatch_drop_oldest);
+    g_test_add_func("/SampleDispatch/coalesce", dispatch_coalesce);
+    g_test_add_func("/SampleDispatch/latency", dispatch_latency);
+    g_test_add_func("/SampleDispatch/extended", dispatch_extended);
+    g_test_add_func("/SampleDispatch/allocation_free", dispatch_allocation_free);
+
+    return g_test_run();
+}
@@ -0,0 +1,172 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <sample-ring.h>
+#include <locale.h>
+
+static GEyeSample
+make_sample(guint i)
+{
+    GEyeSample sample = {
+        .parent = {.type = GEYE_EVENT_SAMPLE, .eye = GEYE_LEFT, .time = i},
+        .x = i,
+        .y = -(gdouble) i
+    };
+    return sample;
+}
+
+static void
+sample_ring_create(void)
+{
+    GEyeSampleRing *ring = geye_sample_ring_new(1000, sizeof(GEyeSample));
+    g_assert_nonnull(ring);
+    g_assert_cmpuint(geye_sample_ring_get_capacity(ring), ==, 1024);
+    g_assert_cmpuint(geye_sample_ring_get_overruns(ring), ==, 0);
+    geye_sample_ring_free(ring);
+}
+
+static void
+sample_ring_push_pop(void)
+{
+    GEyeSampleRing *ring = geye_sample_ring_new(8, sizeof(GEyeSample));
+    GEyeSample buffer[8];
+    guint n, next = 0, expected = 0;
+
+    // Run several times around the ring to test the wrap around.
+    for (guint round = 0; round < 10; round++) {
+        for (guint i = 0; i < 5; i++) {
+            GEyeSample s = make_sample(next++);
+            g_assert_true(geye_sample_ring_push(ring, &s));
+        }
+        n = geye_sample_ring_pop(ring, buffer, G_N_ELEMENTS(buffer));
+        g_assert_cmpuint(n, ==, 5);
+        for (guint i = 0; i < n; i++) {
+            g_assert_cmpfloat(buffer[i].x, ==, expected);
+            g_assert_cmpfloat(buffer[i].parent.time, ==, expected);
+            expected++;
+        }
+    }
+
+    n = geye_sample_ring_pop(ring, buffer, G_N_ELEMENTS(buffer));
+    g_assert_cmpuint(n, ==, 0);
+
+    geye_sample_ring_free(ring);
+}
+
+static void
+sample_ring_overrun(void)
+{
+    GEyeSampleRing *ring = geye_sample_ring_new(4, sizeof(GEyeSample));
+    GEyeSample buffer[4];
+    guint n;
+
+    for (guint i = 0; i < 10; i++) {
+        GEyeSample s = make_sample(i);
+        g_assert_true(geye_sample_ring_push(ring, &s) == (i < 4));
+    }
+    g_assert_cmpuint(geye_sample_ring_get_overruns(ring), ==, 6);
+
+    // The oldest samples are kept, the newest are dropped.
+    n = geye_sample_ring_pop(ring, buffer, G_N_ELEMENTS(buffer));
+    g_assert_cmpuint(n, ==, 4);
+    g_assert_cmpfloat(buffer[0].x, ==, 0);
+    g_assert_cmpfloat(buffer[3].x, ==, 3);
+
+    geye_sample_ring_free(ring);
+}
+
+static void
+sample_ring_timeout(void)
+{
+    GEyeSampleRing *ring = geye_sample_ring_new(4, sizeof(GEyeSample));
+    GEyeSample buffer[4];
+    gint64 start, duration;
+    guint n;
+
+    start = g_get_monotonic_time();
+    n = geye_sample_ring_pop_timeout(ring, buffer, G_N_ELEMENTS(buffer), 10000);
+    duration = g_get_monotonic_time() - start;
+
+    g_assert_cmpuint(n, ==, 0);
+    g_assert_cmpint(duration, >=, 10000);
+
+    geye_sample_ring_free(ring);
+}
+
+#define NUM_THREADED_SAMPLES 1000000
+
+static gpointer
+producer_thread(gpointer data)
+{
+    GEyeSampleRing *ring = data;
+    guint i = 0;
+
+    while (i < NUM_THREADED_SAMPLES) {
+        GEyeSample s = make_sample(i);
+        if (geye_sample_ring_push(ring, &s))
+            i++;
+        else
+            g_thread_yield();
+        if (i % 64 == 0)
+            geye_sample_ring_wake(ring);
+    }
+    geye_sample_ring_wake(ring);
+
+    return NULL;
+}
+
+static void
+sample_ring_threaded(void)
+{
+    GEyeSampleRing *ring = geye_sample_ring_new(256, sizeof(GEyeSample));
+    GEyeSample buffer[100];
+    GThread *producer;
+    guint expected = 0;
+
+    producer = g_thread_new("producer", producer_thread, ring);
+
+    while (expected < NUM_THREADED_SAMPLES) {
+        guint n = geye_sample_ring_pop_timeout(
+                ring, buffer, G_N_ELEMENTS(buffer), G_USEC_PER_SEC
+                );
+        g_assert_cmpuint(n, >, 0);
+        for (guint i = 0; i < n; i++) {
+            g_assert_cmpfloat(buffer[i].x, ==, expected);
+            expected++;
+        }
+    }
+
+    g_thread_join(producer);
+    geye_sample_ring_free(ring);
+}
+
+int main(int argc, char** argv)
+{
+    setlocale(LC_ALL, "");
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/SampleRing/create", sample_ring_create);
+    g_test_add_func("/SampleRing/push_pop", sample_ring_push_pop);
+    g_test_add_func("/SampleRing/overrun", sample_ring_overrun);
+    g_test_add_func("/SampleRing/timeout", sample_ring_timeout);
+    g_test_add_func("/SampleRing/threaded", sample_ring_threaded);
+
+    return g_test_run();
+}
@@ -0,0 +1,114 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <sample-slot.h>
+#include <locale.h>
+
+#define NUM_STORES 1000000
+
+static GEyeBinocularSample
+make_sample(guint i)
+{
+    GEyeBinocularSample sample = {
+        .parent = {
+            .type = GEYE_EVENT_SAMPLE,
+            .eye = GEYE_BINOCULAR,
+            .time = i,
+            .tracker_time = i
+        },
+        .valid = GEYE_BINOCULAR,
+        .left_x = i, .left_y = i, .right_x = i, .right_y = i
+    };
+    return sample;
+}
+
+static void
+sample_slot_empty(void)
+{
+    GEyeSampleSlot *slot = geye_sample_slot_new();
+    GEyeBinocularSample sample = make_sample(7);
+
+    g_assert_false(geye_sample_slot_load(slot, &sample));
+    g_assert_cmpfloat(sample.parent.time, ==, 7);
+
+    geye_sample_slot_free(slot);
+}
+
+static void
+sample_slot_latest(void)
+{
+    GEyeSampleSlot *slot = geye_sample_slot_new();
+    GEyeBinocularSample sample;
+
+    for (guint i = 1; i < 10; i++) {
+        GEyeBinocularSample s = make_sample(i);
+        geye_sample_slot_store(slot, &s);
+    }
+    g_assert_true(geye_sample_slot_load(slot, &sample));
+    g_assert_cmpfloat(sample.parent.time, ==, 9);
+    g_assert_cmpfloat(sample.right_y, ==, 9);
+
+    geye_sample_slot_free(slot);
+}
+
+static gpointer
+store_samples(gpointer data)
+{
+    GEyeSampleSlot *slot = data;
+    for (guint i = 1; i <= NUM_STORES; i++) {
+        GEyeBinocularSample s = make_sample(i);
+        geye_sample_slot_store(slot, &s);
+    }
+    return NULL;
+}
+
+static void
+sample_slot_threaded(void)
+{
+    GEyeSampleSlot *slot = geye_sample_slot_new();
+    GThread *writer = g_thread_new("writer", store_samples, slot);
+    GEyeBinocularSample sample;
+    gdouble previous = 0;
+
+    // A reader must never see a torn sample, nor go back in time.
+    do {
+        if (!geye_sample_slot_load(slot, &sample))
+            continue;
+        g_assert_cmpfloat(sample.left_x, ==, sample.parent.time);
+        g_assert_cmpfloat(sample.right_y, ==, sample.parent.time);
+        g_assert_cmpfloat(sample.parent.time, >=, previous);
+        previous = sample.parent.time;
+    } while (previous < NUM_STORES);
+
+    g_thread_join(writer);
+    geye_sample_slot_free(slot);
+}
+
+int main(int argc, char** argv)
+{
+    setlocale(LC_ALL, "");
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/SampleSlot/empty", sample_slot_empty);
+    g_test_add_func("/SampleSlot/latest", sample_slot_latest);
+    g_test_add_func("/SampleSlot/threaded", sample_slot_threaded);
+
+    return g_test_run();
+}
@@ -0,0 +1,290 @@
+/*
+ * A gobject style eyetracker library
+ * Copyright (C) 2021  Maarten Duijndam
+ * 
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ * 
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ * 
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+
+#include <geye.h>
+#include <locale.h>
+#include <math.h>
+#include <string.h>
+
+typedef struct {
+    GMainContext       *context;
+    GMainLoop          *loop;
+    GEyeSyntheticEt    *et;
+    guint               rate;
+    guint               n_samples;
+    guint               n_fixations;
+    guint               n_saccades;
+    guint               n_dropped;
+    gdouble             last_time;
+    gboolean            fixating;
+    gdouble             fix_x, fix_y;
+} SyntheticFixture;
+
+static gint
+quit_main_loop(gpointer data)
+{
+    GMainLoop *loop = data;
+    g_main_loop_quit(loop);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+run_for(SyntheticFixture *fix, guint ms)
+{
+    GSource *timeout = g_timeout_source_new(ms);
+
+    g_source_set_callback(timeout, quit_main_loop, fix->loop, NULL);
+    g_source_attach(timeout, fix->context);
+    g_source_unref(timeout);
+    g_main_loop_run(fix->loop);
+}
+
+/*
+ * Without noise the left eye stays within a degree of the start of the
+ * fixation it is in, and no sample is missing while the main loop runs.
+ */
+static void
+on_binocular_sample(GEyeEyetracker         *et,
+                    GEyeBinocularSample    *sample,
+                    gpointer                data)
+{
+    SyntheticFixture *fix = data;
+
+    g_assert_cmpuint(sample->parent.eye, ==, GEYE_BINOCULAR);
+    if (fix->n_samples)
+        g_assert_cmpfloat_with_epsilon(
+                sample->parent.time - fix->last_time, 1.0 / fix->rate, 1e-9
+                );
+    if (fix->fixating) {
+        g_assert_cmpuint(sample->valid, ==, GEYE_BINOCULAR);
+        g_assert_cmpfloat(
+                hypot(sample->left_x - fix->fix_x, sample->left_y - fix->fix_y),
+                <, 35
+                );
+    }
+    fix->last_time = sample->parent.time;
+    fix->n_samples++;
+}
+
+static void
+on_fixation(GEyeEyetracker *et, GEyeFixation *fixation, gpointer data)
+{
+    SyntheticFixture *fix = data;
+
+    if (fixation->parent.eye != GEYE_LEFT)
+        return;
+    if (fixation->parent.type == GEYE_EVENT_FIX_START) {
+        fix->fixating = TRUE;
+        fix->fix_x = fixation->x;
+        fix->fix_y = fixation->y;
+    }
+    else {
+        g_assert_true(fix->fixating);
+        g_assert_cmpfloat(fixation->end_time, >, fixation->parent.time);
+        fix->fixating = FALSE;
+        fix->n_fixations++;
+    }
+}
+
+static void
+on_saccade(GEyeEyetracker *et, GEyeSaccade *saccade, gpointer data)
+{
+    SyntheticFixture *fix = data;
+
+    g_assert_false(fix->fixating);
+    if (saccade->parent.eye != GEYE_LEFT ||
+            saccade->parent.type != GEYE_EVENT_SAC_END)
+        return;
+    g_assert_cmpfloat(saccade->amplitude, >=, 1.0);
+    g_assert_cmpfloat(saccade->peak_velocity, >, 0);
+    fix->n_saccades++;
+}
+
+static void
+on_samples_dropped(GEyeEyetracker *et, guint n_dropped, gpointer data)
+{
+    SyntheticFixture *fix = data;
+    fix->n_dropped += n_dropped;
+}
+
+static void
+synthetic_fixture_setup(SyntheticFixture *fix, gconstpointer data)
+{
+    fix->context = g_main_context_new();
+    g_main_context_push_thread_default(fix->context);
+    fix->loop = g_main_loop_new(fix->context, FALSE);
+
+    fix->rate = 2000;
+    fix->et = geye_synthetic_et_new();
+    g_object_set(fix->et,
+                 "sample-delivery", GEYE_DELIVER_BINOCULAR,
+                 "rate", fix->rate,
+                 "noise", 0.0,
+                 NULL);
+    g_signal_connect(
+            fix->et, "binocular-sample", G_CALLBACK(on_binocular_sample), fix
+            );
+    g_signal_connect(fix->et, "fixation", G_CALLBACK(on_fixation), fix);
+    g_signal_connect(fix->et, "saccade", G_CALLBACK(on_saccade), fix);
+    g_signal_connect(
+            fix->et, "samples-dropped", G_CALLBACK(on_samples_dropped), fix
+            );
+}
+
+static void
+synthetic_fixture_tear_down(SyntheticFixture *fix, gconstpointer data)
+{
+    g_clear_object(&fix->et);
+    g_main_loop_unref(fix->loop);
+
+    g_main_context_pop_thread_default(fix->context);
+    g_main_context_unref(fix->context);
+}
+
+static void
+synthetic_not_connected(void)
+{
+    GEyeSyntheticEt *et = geye_synthetic_et_new();
+    GError *error = NULL;
+
+    geye_eyetracker_start_tracking(GEYE_EYETRACKER(et), &error);
+    g_assert_error(
+            error, GEYE_EYETRACKER_ERROR, GEYE_EYETRACKER_ERROR_INCORRECT_MODE
+            );
+    g_clear_error(&error);
+
+    geye_eyetracker_connect(GEYE_EYETRACKER(et), &error);
+    g_assert_no_error(error);
+    geye_eyetracker_calibrate(GEYE_EYETRACKER(et), &error);
+    g_assert_error(
+            error, GEYE_EYETRACKER_ERROR, GEYE_EYETRACKER_ERROR_INCORRECT_MODE
+            );
+    g_error_free(error);
+    geye_eyetracker_disconnect(GEYE_EYETRACKER(et));
+    g_object_unref(et);
+}
+
+static void
+synthetic_ground_truth(SyntheticFixture *fix, gconstpointer data)
+{
+    GEyeEyetracker *et = GEYE_EYETRACKER(fix->et);
+    GError *error = NULL;
+    guint generated;
+    gchar *info;
+
+    geye_eyetracker_connect(et, &error);
+    g_assert_no_error(error);
+    info = geye_eyetracker_get_tracker_info(et);
+    g_assert_nonnull(strstr(info, "2000 Hz"));
+    g_free(info);
+
+    geye_eyetracker_start_tracking(et, &error);
+    g_assert_no_error(error);
+    run_for(fix, 2000);
+    geye_eyetracker_stop_tracking(et);
+    while (g_main_context_iteration(fix->context, FALSE))
+        ;
+
+    g_object_get(fix->et, "samples-generated", &generated, NULL);
+    g_assert_cmpuint(fix->n_dropped, ==, 0);
+    g_assert_cmpuint(fix->n_samples, ==, generated);
+    // Two seconds at 2 kHz, give or take the start and stop.
+    g_assert_cmpuint(generated, >, 3000);
+    g_assert_cmpuint(generated, <, 5000);
+    g_assert_cmpuint(fix->n_fixations, >, 0);
+    g_assert_cmpuint(fix->n_saccades, >, 0);
+
+    // Tracking again continues without a gap in the time.
+    geye_eyetracker_start_tracking(et, &error);
+    g_assert_no_error(error);
+    run_for(fix, 200);
+    geye_eyetracker_stop_tracking(et);
+    while (g_main_context_iteration(fix->context, FALSE))
+        ;
+    g_assert_cmpuint(fix->n_samples, >, generated);
+
+    geye_eyetracker_disconnect(et);
+}
+
+static gint
+stall_main_context(gpointer data)
+{
+    g_usleep(G_USEC_PER_SEC);
+    return G_SOURCE_REMOVE;
+}
+
+/* A main context that stalls can't keep up with 10 kHz of both eyes. */
+static void
+synthetic_load(SyntheticFixture *fix, gconstpointer data)
+{
+    GEyeEyetracker *et = GEYE_EYETRACKER(fix->et);
+    GError *error = NULL;
+    GSource *stall = g_idle_source_new();
+    guint generated, dropped;
+
+    fix->rate = 10000;
+    g_object_set(fix->et, "rate", fix->rate, NULL);
+    g_signal_handlers_disconnect_by_func(fix->et, on_binocular_sample, fix);
+    geye_eyetracker_connect(et, &error);
+    g_assert_no_error(error);
+    geye_eyetracker_start_tracking(et, &error);
+    g_assert_no_error(error);
+
+    g_source_set_callback(stall, stall_main_context, NULL, NULL);
+    g_source_attach(stall, fix->context);
+    g_source_unref(stall);
+    run_for(fix, 1500);
+    geye_eyetracker_stop_tracking(et);
+    while (g_main_context_iteration(fix->context, FALSE))
+        ;
+
+    g_object_get(fix->et,
+                 "samples-generated", &generated,
+                 "samples-dropped", &dropped,
+                 NULL);
+    g_assert_cmpuint(generated, >, 10000);
+    g_assert_cmpuint(dropped, >, 0);
+    g_assert_cmpuint(fix->n_dropped, >, 0);
+    g_assert_cmpuint(fix->n_dropped, <=, dropped);
+
+    geye_eyetracker_disconnect(et);
+}
+
+int main(int argc, char** argv)
+{
+    setlocale(LC_ALL, "");
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_func("/SyntheticEt/not_connected", synthetic_not_connected);
+    g_test_add("/SyntheticEt/ground_truth",
+               SyntheticFixture,
+               NULL,
+               synthetic_fixture_setup,
+               synthetic_ground_truth,
+               synthetic_fixture_tear_down);
+    g_test_add("/SyntheticEt/load",
+               SyntheticFixture,
+               NULL,
+               synthetic_fixture_setup,
+               synthetic_load,
+               synthetic_fixture_tear_down);
+
+    return g_test_run();
+}